@@ -3,6 +3,9 @@
 #include "imgui/imgui.h"
 #include <shellapi.h>
 #include "Utils/TexturePreprocessor.h"
+#include "Utils/Benchmarks.h"
+#include "Bindable/BindableCodex.h"
+#include <fstream>
 
 namespace dx = DirectX;
 
@@ -45,7 +48,142 @@ App::App(const std::string& commandLine)
 			                                                 );
 			throw std::runtime_error("Normal map validated successfully. Just kidding about that whole runtime error thing.");
 		}
+		else if (nArgs >= 2 && std::wstring(pArgs[1]) == L"--bench-modelcache")
+		{
+			benchmark_ = D3DEngine::Benchmarks::ModelCacheLoad({
+				{"Models\\Sponza\\sponza.obj", 1.0f / 20.0f},
+				{"Models\\nano_textured\\nanosuit.obj", 2.0f},
+			});
+		}
+		else if (nArgs >= 2 && std::wstring(pArgs[1]) == L"--bench-parallelload")
+		{
+			benchmark_ = D3DEngine::Benchmarks::ModelParallelLoad({
+				{"Models\\Sponza\\sponza.obj", 1.0f / 20.0f},
+				{"Models\\nano_textured\\nanosuit.obj", 2.0f},
+			});
+		}
+		else if (nArgs >= 2 && std::wstring(pArgs[1]) == L"--bench-indexwidth")
+		{
+			benchmark_ = D3DEngine::Benchmarks::IndexWidth();
+		}
+		else if (nArgs >= 2 && std::wstring(pArgs[1]) == L"--bench-meshopt")
+		{
+			benchmark_ = D3DEngine::Benchmarks::MeshOptimization({
+				{"Models\\Sponza\\sponza.obj", 1.0f / 20.0f},
+			});
+		}
+		else if (nArgs >= 2 && std::wstring(pArgs[1]) == L"--bench-lod")
+		{
+			benchmark_ = D3DEngine::Benchmarks::MeshLods({
+				{"Models\\Sponza\\sponza.obj", 1.0f / 20.0f},
+				{"Models\\nano_textured\\nanosuit.obj", 2.0f},
+			});
+		}
+		else if (nArgs >= 2 && std::wstring(pArgs[1]) == L"--bench-meshlets")
+		{
+			benchmark_ = D3DEngine::Benchmarks::Meshlets({
+				{"Models\\Sponza\\sponza.obj", 1.0f / 20.0f},
+			});
+		}
+		else if (nArgs >= 2 && std::wstring(pArgs[1]) == L"--bench-vertexpack")
+		{
+			benchmark_ = D3DEngine::Benchmarks::VertexCompression({
+				{"Models\\Sponza\\sponza.obj", 1.0f / 20.0f},
+				{"Models\\nano_textured\\nanosuit.obj", 2.0f},
+			});
+		}
+		else if (nArgs >= 2 && std::wstring(pArgs[1]) == L"--bench-objimport")
+		{
+			benchmark_ = D3DEngine::Benchmarks::ObjImport({
+				{"Models\\Sponza\\sponza.obj", 1.0f / 20.0f},
+				{"Models\\nano_textured\\nanosuit.obj", 2.0f},
+				{"Models\\gobber\\GoblinX.obj", 6.0f},
+			});
+		}
+		else if (nArgs >= 2 && std::wstring(pArgs[1]) == L"--bench-gltf")
+		{
+			benchmark_ = D3DEngine::Benchmarks::GltfImport({
+				{"Models\\boxy.gltf", 1.0f},
+				{"Models\\nano_hierarchy.gltf", 1.0f},
+			});
+		}
+		else if (nArgs >= 2 && std::wstring(pArgs[1]) == L"--bench-arena")
+		{
+			benchmark_ = D3DEngine::Benchmarks::GeometryArenas({
+				{"Models\\Sponza\\sponza.obj", 1.0f / 20.0f},
+				{"Models\\nano_textured\\nanosuit.obj", 2.0f},
+			});
+		}
+		else if (nArgs >= 2 && std::wstring(pArgs[1]) == L"--bench-materials")
+		{
+			benchmark_ = D3DEngine::Benchmarks::Materials({
+				{"Models\\Sponza\\sponza.obj", 1.0f / 20.0f},
+				{"Models\\nano_textured\\nanosuit.obj", 2.0f},
+			});
+		}
+		else if (nArgs >= 2 && std::wstring(pArgs[1]) == L"--bench-hotreload")
+		{
+			benchmark_ = D3DEngine::Benchmarks::HotReload();
+		}
+		else if (nArgs >= 2 && std::wstring(pArgs[1]) == L"--bench-bake")
+		{
+			benchmark_ = D3DEngine::Benchmarks::AssetBake("Models\\Sponza", 1.0f / 20.0f);
+		}
+		else if (nArgs >= 2 && std::wstring(pArgs[1]) == L"--bench-vertexlayout")
+		{
+			benchmark_ = D3DEngine::Benchmarks::VertexLayouts();
+		}
+		else if (nArgs >= 2 && std::wstring(pArgs[1]) == L"--bench-vertexstreams")
+		{
+			benchmark_ = D3DEngine::Benchmarks::VertexStorage({
+				{"Models\\Sponza\\sponza.obj", 1.0f / 20.0f},
+				{"Models\\nano_textured\\nanosuit.obj", 2.0f},
+			});
+		}
+		else if (nArgs >= 2 && std::wstring(pArgs[1]) == L"--bench-vertexconvert")
+		{
+			benchmark_ = D3DEngine::Benchmarks::VertexConversions();
+		}
+		else if (nArgs >= 2 && std::wstring(pArgs[1]) == L"--bench-ingest")
+		{
+			benchmark_ = D3DEngine::Benchmarks::VertexIngestion({{"Models\\nano_textured\\nanosuit.obj", 2.0f}});
+		}
+		else if (nArgs >= 2 && std::wstring(pArgs[1]) == L"--bench-codex")
+		{
+			benchmark_ = D3DEngine::Benchmarks::CodexLookups(wnd.Gfx());
+		}
+		else if (nArgs >= 2 && std::wstring(pArgs[1]) == L"--bench-codexthreads")
+		{
+			benchmark_ = D3DEngine::Benchmarks::CodexConcurrency(wnd.Gfx());
+		}
+		else if (nArgs >= 2 && std::wstring(pArgs[1]) == L"--bench-codexevict")
+		{
+			benchmark_ = D3DEngine::Benchmarks::CodexEviction(wnd.Gfx());
+		}
+		else if (nArgs >= 2 && std::wstring(pArgs[1]) == L"--bench-codexstats")
+		{
+			benchmark_ = D3DEngine::Benchmarks::CodexStats(wnd.Gfx());
+		}
+		else if (nArgs >= 2 && std::wstring(pArgs[1]) == L"--bench-prewarm")
+		{
+			benchmark_ = D3DEngine::Benchmarks::CodexPrewarm(wnd.Gfx());
+		}
+		else if (nArgs >= 2 && std::wstring(pArgs[1]) == L"--bench-statetracker")
+		{
+			benchmark_ = D3DEngine::Benchmarks::StateTracking();
+		}
+		else if (nArgs >= 2 && std::wstring(pArgs[1]) == L"--bench-drawablebinds")
+		{
+			benchmark_ = D3DEngine::Benchmarks::DrawableBindables(wnd.Gfx());
+		}
+		// Go reports it instead of running the app
+		if (benchmark_)
+		{
+			return;
+		}
 	}
+	// not before: its background import and texture decoding would compete with the benchmarks
+	sponza = std::make_unique<D3DEngine::Model>(wnd.Gfx(), "Models\\Sponza\\sponza.obj", 1.0f / 20.0f, D3DEngine::Model::LoadMode::Progressive);
 	//wall.SetRootTransform( dx::XMMatrixTranslation( -12.0f,0.0f,0.0f ) );
 	//tp.SetPos( { 12.0f,0.0f,0.0f } );
 	//gobber.SetRootTransform( dx::XMMatrixTranslation( 0.0f,0.0f,-4.0f ) );
@@ -53,7 +191,39 @@ App::App(const std::string& commandLine)
 	bluePlane.SetPos(cam.GetPos());
 	redPlane.SetPos(cam.GetPos());
 
+	assetWatcher_.Watch("Models");
+	assetWatcher_.Watch("Shaders\\cso");
+
 	wnd.Gfx().SetProjection(dx::XMMatrixPerspectiveLH(1.0f, 9.0f / 16.0f, 0.5f, 400.0f)); // adjust the draw distance based on your scene
+
+	// make what the last run resolved before the first frame, so that the frames only hit the Codex
+	prewarm_ = this->commandLine.find("--no-prewarm") == std::string::npos;
+	if (prewarm_)
+	{
+		const DXTimer prewarmTimer;
+		prewarmed_   = D3DEngine::Codex::Prewarm(wnd.Gfx(), manifestPath);
+		prewarmTime_ = prewarmTimer.Peek();
+	}
+	missesBeforeFrames_ = CodexMisses();
+}
+
+App::~App()
+{
+	// a benchmark run only made stand-ins, which are no use to the next run
+	if (!benchmark_)
+	{
+		D3DEngine::Codex::SaveManifest(manifestPath);
+	}
+}
+
+size_t App::CodexMisses()
+{
+	size_t misses = 0u;
+	for (const auto& t : D3DEngine::Codex::GetStats())
+	{
+		misses += t.misses;
+	}
+	return misses;
 }
 
 void App::DoFrame()
@@ -63,12 +233,23 @@ void App::DoFrame()
 	wnd.Gfx().SetCamera(cam.GetMatrix());
 	light_.Bind(wnd.Gfx(), cam.GetMatrix());
 
+	try
+	{
+		sponza->Update(wnd.Gfx());
+	}
+	catch (const std::exception& e)
+	{
+		// the model stays as it was (see Model::Update), fixing the file brings it in through a reload
+		OutputDebugStringA((std::string("Loading Sponza failed:\n") + e.what() + "\n").c_str());
+	}
+	ReloadChangedAssets();
+
 	// wall.Draw(wnd_.Gfx());
 	// tp.Draw(wnd_.Gfx());
 	// nano.Draw(wnd_.Gfx());
 	// gobber.Draw(wnd_.Gfx());
 	light_.Draw(wnd.Gfx());
-	sponza.Draw(wnd.Gfx());
+	sponza->Draw(wnd.Gfx());
 	bluePlane.Draw(wnd.Gfx());
 	redPlane.Draw(wnd.Gfx());
 
@@ -140,16 +321,194 @@ void App::DoFrame()
 	// wall.ShowWindow(wnd_.Gfx(), "Wall");
 	// tp.SpawnControlWindow(wnd_.Gfx());
 	// nano.ShowWindow(wnd_.Gfx(), "Nano");
-	sponza.ShowWindow(wnd.Gfx(), "Sponza");
+	sponza->ShowWindow(wnd.Gfx(), "Sponza");
 	bluePlane.SpawnControlWindow(wnd.Gfx(), "Blue Plane");
 	redPlane.SpawnControlWindow(wnd.Gfx(), "Red Plane");
+	SpawnLoadWindow();
+	SpawnFrameStatsWindow();
+	SpawnCodexWindow();
 
 	// present
 	wnd.Gfx().EndFrame();
+	if (firstFrameTime_ < 0.0f)
+	{
+		firstFrameTime_ = startupTimer_.Peek();
+	}
+	if (frameCount_ < startupFrames)
+	{
+		frameCount_++;
+		startupMisses_ = CodexMisses() - missesBeforeFrames_;
+	}
+}
+
+// time to the first presented frame (since the App was constructed) next to the load times of the progressive model
+void App::SpawnLoadWindow() noexcept
+{
+	if (ImGui::Begin("Loading"))
+	{
+		if (firstFrameTime_ >= 0.0f)
+		{
+			ImGui::Text("First frame: %.3f s", firstFrameTime_);
+		}
+		if (prewarm_)
+		{
+			ImGui::Text("Prewarmed: %zu bindables in %.3f s", prewarmed_, prewarmTime_);
+		}
+		else
+		{
+			ImGui::Text("Prewarm: off");
+		}
+		ImGui::Text("Codex misses in the first %zu frames: %zu%s", startupFrames, startupMisses_, frameCount_ < startupFrames ? " so far" : "");
+		const auto& status = sponza->GetLoadStatus();
+		ImGui::Text("Sponza meshes: %zu / %zu", status.finishedMeshes, status.meshCount);
+		if (status.geometryReady)
+		{
+			ImGui::Text("Sponza geometry: %.3f s", status.geometryTime);
+		}
+		if (status.complete)
+		{
+			ImGui::Text("Sponza fully loaded: %.3f s", status.completeTime);
+		}
+		if (status.failed)
+		{
+			ImGui::Text("Sponza failed to load (see the debugger output)");
+		}
+	}
+	ImGui::End();
+}
+
+// submissions to the context in the last frame, to see what sharing buffers and dropping redundant state changes saves
+void App::SpawnFrameStatsWindow() noexcept
+{
+	if (ImGui::Begin("Frame Stats"))
+	{
+		const auto& stats = wnd.Gfx().GetFrameStats();
+		ImGui::Text("Draw calls: %u", stats.drawCalls);
+		ImGui::Columns(3);
+		ImGui::Text("State");
+		ImGui::NextColumn();
+		ImGui::Text("Issued");
+		ImGui::NextColumn();
+		ImGui::Text("Skipped");
+		ImGui::NextColumn();
+		ImGui::Separator();
+		D3DEngine::StateCounter total;
+		for (size_t i = 0; i < stats.states.size(); i++)
+		{
+			ImGui::Text("%s", D3DEngine::ToString(D3DEngine::PipelineState(i)));
+			ImGui::NextColumn();
+			ImGui::Text("%u", stats.states[i].issued);
+			ImGui::NextColumn();
+			ImGui::Text("%u", stats.states[i].skipped);
+			ImGui::NextColumn();
+			total.issued += stats.states[i].issued;
+			total.skipped += stats.states[i].skipped;
+		}
+		ImGui::Separator();
+		ImGui::Text("Total");
+		ImGui::NextColumn();
+		ImGui::Text("%u", total.issued);
+		ImGui::NextColumn();
+		ImGui::Text("%u", total.skipped);
+		ImGui::NextColumn();
+		ImGui::Columns(1);
+	}
+	ImGui::End();
+}
+
+// what the Codex holds per type of bindable and how it got there, to find redundant and slow loads
+void App::SpawnCodexWindow()
+{
+	using D3DEngine::Codex;
+	if (ImGui::Begin("Codex"))
+	{
+		ImGui::Text("Memory: %.2f MB", double(Codex::GetMemoryCost()) / double(1u << 20));
+		if (ImGui::Button("Dump JSON"))
+		{
+			std::ofstream("codex_stats.json") << Codex::StatsToJson();
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Reset"))
+		{
+			Codex::ResetStats();
+		}
+
+		ImGui::Columns(7, "codex types");
+		for (const auto header : {"Type", "Hits", "Misses", "Live", "KB", "Create ms", "Max ms"})
+		{
+			ImGui::Text("%s", header);
+			ImGui::NextColumn();
+		}
+		for (const auto& t : Codex::GetStats())
+		{
+			ImGui::Text("%s", t.type.c_str());
+			ImGui::NextColumn();
+			ImGui::Text("%zu", t.hits);
+			ImGui::NextColumn();
+			ImGui::Text("%zu", t.misses);
+			ImGui::NextColumn();
+			ImGui::Text("%zu", t.live);
+			ImGui::NextColumn();
+			ImGui::Text("%.1f", double(t.bytes) / 1024.0);
+			ImGui::NextColumn();
+			ImGui::Text("%.2f", t.totalCreateMs);
+			ImGui::NextColumn();
+			ImGui::Text("%.2f", t.maxCreateMs);
+			ImGui::NextColumn();
+		}
+		ImGui::Columns(1);
+
+		// the keys loaded more than once are the suspicious ones
+		if (ImGui::TreeNodeEx("codex creations", 0, "Latest creations"))
+		{
+			const auto log = Codex::GetCreationLog();
+			for (auto i = log.rbegin(); i != log.rend() && i - log.rbegin() < 100; ++i)
+			{
+				const auto repeat = i->count > 1u ? "(x" + std::to_string(i->count) + ") " : std::string();
+				ImGui::Text("%s%.2f ms %s", repeat.c_str(), i->ms, i->key.c_str());
+			}
+			ImGui::TreePop();
+		}
+	}
+	ImGui::End();
+}
+
+// textures and shaders are reloaded in place through the Codex, models that use a changed file are imported again
+void App::ReloadChangedAssets()
+{
+	bool reloadSponza = false;
+	for (const auto& path : assetWatcher_.Poll())
+	{
+		D3DEngine::Codex::Reload(wnd.Gfx(), path);
+		reloadSponza |= sponza->DependsOn(path);
+	}
+
+	// once, however many of its files changed
+	if (reloadSponza)
+	{
+		try
+		{
+			sponza->Reload(wnd.Gfx());
+		}
+		catch (const std::exception& e)
+		{
+			// most likely the file is still being written, the next change to it brings the reload
+			OutputDebugStringA((std::string("Reloading Sponza failed:\n") + e.what() + "\n").c_str());
+		}
+	}
 }
 
 int App::Go()
 {
+	// exit with the benchmark's verdict, so that a script running it can tell a failed check (--quiet skips the report box)
+	if (benchmark_)
+	{
+		if (commandLine.find("--quiet") == std::string::npos)
+		{
+			MessageBox(nullptr, benchmark_->report.c_str(), "Benchmark", MB_OK | (benchmark_->passed ? MB_ICONINFORMATION : MB_ICONEXCLAMATION));
+		}
+		return benchmark_->passed ? 0 : 1;
+	}
 	while (true)
 	{
 		// process all pending messages, but do not block if there are no messages to process
@@ -1,6 +1,10 @@
 #pragma once
+#include <memory>
+#include <optional>
 #include "Window/DXWindow.h"
 #include "Utils/DXTimer.h"
+#include "Utils/FileWatcher.h"
+#include "Utils/Benchmarks.h"
 #include "Imgui/ImguiManager.h"
 #include "Camera.h"
 #include "PointLight.h"
@@ -17,23 +21,46 @@ class App
 		App(const std::string& commandLine = "");
 		// master frame / message loop
 		int Go();
-		~App() = default;
+		// writes the prewarm manifest for the next run
+		~App();
 	private:
 		void DoFrame();
+		void SpawnLoadWindow() noexcept;
+		void SpawnFrameStatsWindow() noexcept;
+		void SpawnCodexWindow();
+		static size_t CodexMisses();
+		// swap in the models, textures and shaders whose files changed on disk
+		void ReloadChangedAssets();
+
+		// the Codex misses counted in the load window, and where the Codex keys for prewarming are kept between runs
+		static constexpr size_t startupFrames = 300u;
+		static constexpr auto   manifestPath  = "codex_manifest.txt";
 
 		std::string         commandLine;
+		DXTimer             startupTimer_{};                         // runs from construction, for the startup metrics
+		float               firstFrameTime_{-1.0f};                  // seconds until the first frame was presented (< 0 before that)
+		bool                prewarm_{true};                          // off with --no-prewarm, to compare the startup misses
+		size_t              prewarmed_{0u};                          // bindables the Codex made from the manifest before the first frame
+		float               prewarmTime_{0.0f};
+		size_t              frameCount_{0u};
+		size_t              missesBeforeFrames_{0u};                 // Codex misses until the first frame, to count those during the first frames
+		size_t              startupMisses_{0u};                      // Codex misses during the first startupFrames frames (so far)
 		ImguiManager        imgui_{};                                // always first initialize IMGUI
 		D3DEngine::DXWindow wnd{1920, 1080, "The Donkey Fart Box"}; // Please specify a resolution with aspect ratio = 16:9
 		DXTimer             timer_{};
 		float               speedFactor_{1.f};
 
+		D3DEngine::FileWatcher assetWatcher_{}; // watches the models and compiled shaders, for hot reloading
+
+		std::optional<D3DEngine::Benchmarks::Result> benchmark_{}; // set if the command line ran a benchmark instead of the app
+
 		D3DEngine::Camera     cam{};
 		D3DEngine::PointLight light_{wnd.Gfx()};
 		// D3DEngine::Model      gobber{wnd_.Gfx(), "Models\\gobber\\GoblinX.obj", 6.0f};
 		// D3DEngine::Model      wall{wnd_.Gfx(), "Models\\brick_wall\\brick_wall.obj", 6.0f};
 		// D3DEngine::TestPlane  tp{wnd_.Gfx(), 6.0};
 		// D3DEngine::Model      nano{wnd_.Gfx(), "Models\\nano_textured\\nanosuit.obj", 2.0f};
-		D3DEngine::Model sponza{wnd.Gfx(), "Models\\sponza\\sponza.obj", 1.0f / 20.0f};
+		std::unique_ptr<D3DEngine::Model> sponza; // made once the command line is handled, so that benchmarks run without it loading
 
 		D3DEngine::TestPlane bluePlane{ wnd.Gfx(),6.0f,{ 0.3f,0.3f,1.0f,0.0f } };
 		D3DEngine::TestPlane redPlane{ wnd.Gfx(),6.0f,{ 1.0f,0.3f,0.3f,0.0f } };
@@ -1,4 +1,5 @@
 #include "Bindable.h"
+#include <atomic>
 
 namespace D3DEngine
 {
@@ -12,6 +13,24 @@ namespace D3DEngine
 		return gfx.pDevice_.Get();
 	}
 
+	std::mutex& Bindable::GetContextMutex(Graphics& gfx) noexcept
+	{
+		return gfx.contextMutex_;
+	}
+
+	StateTracker<ID3D11DeviceContext>& Bindable::GetState(Graphics& gfx) noexcept
+	{
+		return gfx.state_;
+	}
+
+	BindableTypeId Bindable::NextTypeId() noexcept
+	{
+		static std::atomic<BindableTypeId> next = 0u;
+		const auto                         id   = next.fetch_add(1u, std::memory_order_relaxed);
+		assert("Out of bindable type IDs" && id != noTypeId);
+		return id;
+	}
+
 	DxgiInfoManager& Bindable::GetInfoManager(Graphics& gfx)
 	{
 		#ifdef DX_DEBUG
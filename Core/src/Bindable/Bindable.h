@@ -1,24 +1,89 @@
 #pragma once
 #include "Graphics.h"
+#include "CodexKey.h"
+#include <limits>
 
 namespace D3DEngine
 {
+	// dense number of a bindable type, handed out on first use (so it may differ between runs), to index per-type slots without RTTI
+	using BindableTypeId = uint16_t;
+
 	/**
 	 * \brief An interface presenting all bindable objects (like pixel shader, input layout, etc)
 	 */
 	class Bindable
 	{
 		public:
+			static constexpr BindableTypeId noTypeId = std::numeric_limits<BindableTypeId>::max();
+
 			virtual void Bind(Graphics& gfx) noexcept = 0;
 
+			template <class T>
+			static BindableTypeId TypeIdOf() noexcept
+			{
+				static const BindableTypeId id = NextTypeId();
+				return id;
+			}
+
+			/**
+			 * \brief Mark bind as being of type T, unless it was marked already. Whoever makes a bindable as its own type marks it
+			 * (the Codex does for everything it makes), so that GetTypeId knows it wherever it is passed on as a plain Bindable.
+			 * An abstract T (such as Bindable itself) is never what a bindable really is, so it leaves bind as it is.
+			 */
+			template <class T>
+			static void Identify(T& bind) noexcept
+			{
+				static_assert(std::is_base_of_v<Bindable, T>);
+				auto& base = static_cast<Bindable&>(bind);
+				if constexpr (!std::is_abstract_v<T>)
+				{
+					if (base.typeId_ == noTypeId)
+					{
+						base.typeId_ = TypeIdOf<T>();
+					}
+				}
+			}
+
+			// TypeIdOf the bindable's type, noTypeId until it is identified
+			BindableTypeId GetTypeId() const noexcept
+			{
+				return typeId_;
+			}
+
 			/**
 			 * \brief Return the UID for this bindable
+			 * Keys with strings in them have to be made at construction and kept: interning a string may allocate.
 			 * \return Unique ID for this bindable
 			 */
-			virtual std::string GetUID() const noexcept
+			virtual CodexKey GetUID() const noexcept
 			{
 				assert(false);
-				return "";
+				return {};
+			}
+
+			/**
+			 * \brief Whether this bindable was made from the file at path (as FileWatcher::Normalize gives it), so changing that file calls for a Reload
+			 */
+			virtual bool DependsOn(const std::string& path) const noexcept
+			{
+				return false;
+			}
+
+			/**
+			 * \brief Remake the device objects from the files this bindable depends on, keeping this object (and its UID).
+			 * Whoever holds it binds the new version from the next Bind on. If it throws, the old version is kept.
+			 */
+			virtual void Reload(Graphics& gfx)
+			{
+			}
+
+			/**
+			 * \brief Approximate bytes of memory this bindable keeps alive (buffer, texture and bytecode sizes), which the Codex weighs
+			 * against its budget. Small state objects (samplers, blenders, ...) leave it at 0.
+			 */
+			virtual size_t GetMemoryCost() const noexcept
+			{
+				return 0u;
 			}
 
 			virtual ~Bindable() = default;
@@ -27,5 +92,13 @@ namespace D3DEngine
 			static ID3D11DeviceContext* GetContext(Graphics& gfx) noexcept;
 			static ID3D11Device*        GetDevice(Graphics& gfx) noexcept;
 			static DxgiInfoManager&     GetInfoManager(Graphics& gfx);
+			// hold it while using the context outside of Bind (e.g. uploading in a constructor), so that constructing on several threads is safe
+			static std::mutex&          GetContextMutex(Graphics& gfx) noexcept;
+			// bind through this rather than the context, so that setting what is bound already costs nothing
+			static StateTracker<ID3D11DeviceContext>& GetState(Graphics& gfx) noexcept;
+		private:
+			static BindableTypeId NextTypeId() noexcept;
+		private:
+			BindableTypeId typeId_ = noTypeId;
 	};
 }
@@ -0,0 +1,262 @@
+#include "BindableCodex.h"
+#include "Utils/Parallel.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace D3DEngine
+{
+	namespace
+	{
+		// type_info names as MSVC spells them, minus the "class " and "struct " in front of every type
+		std::string TypeName(const std::type_info& type)
+		{
+			std::string name = type.name();
+			for (const std::string_view prefix : {"class ", "struct "})
+			{
+				for (auto i = name.find(prefix); i != std::string::npos; i = name.find(prefix, i))
+				{
+					name.erase(i, prefix.size());
+				}
+			}
+			return name;
+		}
+
+		std::string Escape(const std::string& text)
+		{
+			std::string escaped;
+			escaped.reserve(text.size());
+			for (const char c : text)
+			{
+				switch (c)
+				{
+					case '"':
+						escaped += "\\\"";
+						break;
+					case '\\':
+						escaped += "\\\\";
+						break;
+					case '\n':
+						escaped += "\\n";
+						break;
+					default:
+						escaped += c;
+				}
+			}
+			return escaped;
+		}
+
+		double ToMs(uint64_t ns) noexcept
+		{
+			return double(ns) / 1e6;
+		}
+	}
+
+	Codex::Counters& Codex::Register(const std::type_info& type)
+	{
+		std::lock_guard lock(statsMutex);
+		return counters.emplace_back(type);
+	}
+
+	void Codex::LogCreation(Counters& typeCounters, const CodexKey& key, uint64_t createNs, size_t cost)
+	{
+		typeCounters.createNs += createNs;
+		for (auto max = typeCounters.maxCreateNs.load(); createNs > max && !typeCounters.maxCreateNs.compare_exchange_weak(max, createNs);)
+		{
+		}
+
+		auto            text = key.ToString();
+		std::lock_guard lock(statsMutex);
+		const auto      count = ++creationCounts[key];
+		if (creationLog.size() == maxLogged)
+		{
+			creationLog.pop_front();
+		}
+		creationLog.push_back({std::move(text), ToMs(createNs), cost, count});
+		// for the manifest, once per key
+		if (recipeNames.contains(key.Type()) && recordedKeys.TryEmplace(key).second)
+		{
+			recorded.push_back(key);
+		}
+	}
+
+	void Codex::AddRecipe(const std::type_info& type, const std::string& name, Recipe recipe)
+	{
+		std::lock_guard lock(statsMutex);
+		recipes[name]     = std::move(recipe);
+		recipeNames[type] = name;
+	}
+
+	std::vector<Codex::TypeStats> Codex::GetStats()
+	{
+		auto&                  codex = Get();
+		std::vector<TypeStats> stats;
+		{
+			std::lock_guard lock(codex.statsMutex);
+			for (const auto& c : codex.counters)
+			{
+				stats.push_back({
+					.type = TypeName(c.type),
+					.hits = c.hits,
+					.misses = c.misses,
+					.live = c.live,
+					.bytes = c.bytes,
+					.totalCreateMs = ToMs(c.createNs),
+					.maxCreateMs = ToMs(c.maxCreateNs)
+				});
+			}
+		}
+		std::ranges::sort(stats, {}, &TypeStats::type);
+		return stats;
+	}
+
+	std::vector<Codex::Creation> Codex::GetCreationLog()
+	{
+		auto&           codex = Get();
+		std::lock_guard lock(codex.statsMutex);
+		return {codex.creationLog.begin(), codex.creationLog.end()};
+	}
+
+	std::string Codex::StatsToJson()
+	{
+		std::ostringstream json;
+		json << std::fixed << std::setprecision(3);
+		json << "{\n  \"memoryCost\": " << GetMemoryCost() << ",\n  \"budget\": ";
+		// unlimited has no sensible number
+		if (GetBudget() == std::numeric_limits<size_t>::max())
+		{
+			json << "null";
+		}
+		else
+		{
+			json << GetBudget();
+		}
+
+		json << ",\n  \"types\": [";
+		const auto stats = GetStats();
+		for (size_t i = 0; i < stats.size(); i++)
+		{
+			const auto& t = stats[i];
+			json << (i ? "," : "") << "\n    {\"type\": \"" << Escape(t.type) << "\", \"hits\": " << t.hits << ", \"misses\": " << t.misses
+					<< ", \"live\": " << t.live << ", \"bytes\": " << t.bytes << ", \"totalCreateMs\": " << t.totalCreateMs
+					<< ", \"maxCreateMs\": " << t.maxCreateMs << "}";
+		}
+
+		json << "\n  ],\n  \"creations\": [";
+		const auto log = GetCreationLog();
+		for (size_t i = 0; i < log.size(); i++)
+		{
+			const auto& c = log[i];
+			json << (i ? "," : "") << "\n    {\"key\": \"" << Escape(c.key) << "\", \"ms\": " << c.ms << ", \"bytes\": " << c.bytes
+					<< ", \"count\": " << c.count << "}";
+		}
+		json << "\n  ]\n}\n";
+		return json.str();
+	}
+
+	void Codex::ResetStats()
+	{
+		auto&           codex = Get();
+		std::lock_guard lock(codex.statsMutex);
+		for (auto& c : codex.counters)
+		{
+			c.hits        = 0u;
+			c.misses      = 0u;
+			c.createNs    = 0u;
+			c.maxCreateNs = 0u;
+		}
+		codex.creationLog.clear();
+		codex.creationCounts.Clear();
+	}
+
+	size_t Codex::SaveManifest(const std::string& path)
+	{
+		auto&                    codex = Get();
+		std::vector<std::string> lines;
+		{
+			std::lock_guard lock(codex.statsMutex);
+			for (const auto& key : codex.recorded)
+			{
+				// one line per key: the recipe name and the parameters, tab separated
+				auto line = codex.recipeNames.at(key.Type());
+				for (const auto& param : key.GetParams())
+				{
+					line += '\t' + param;
+				}
+				if (line.find_first_of("\r\n") == std::string::npos)
+				{
+					lines.push_back(std::move(line));
+				}
+			}
+		}
+
+		std::ofstream file(path, std::ios::trunc);
+		if (!file)
+		{
+			return 0u;
+		}
+		for (const auto& line : lines)
+		{
+			file << line << '\n';
+		}
+		return lines.size();
+	}
+
+	size_t Codex::Prewarm(Graphics& gfx, const std::string& path, size_t nWorkers)
+	{
+		struct Line
+		{
+			std::string              text;
+			const Recipe*            pRecipe = nullptr;
+			std::vector<std::string> params;
+		};
+
+		auto&             codex = Get();
+		std::vector<Line> lines;
+		std::ifstream     file(path);
+		for (std::string text; std::getline(file, text);)
+		{
+			if (text.empty())
+			{
+				continue;
+			}
+			Line line{.text = text};
+			for (size_t begin = 0u, end; begin <= text.size(); begin = end + 1u)
+			{
+				end = std::min(text.find('\t', begin), text.size());
+				line.params.push_back(text.substr(begin, end - begin));
+			}
+			// the first field names the recipe, the rest are its parameters
+			{
+				std::lock_guard lock(codex.statsMutex);
+				if (const auto i = codex.recipes.find(line.params.front()); i != codex.recipes.end())
+				{
+					line.pRecipe = &i->second;
+				}
+			}
+			if (line.pRecipe == nullptr)
+			{
+				OutputDebugStringA(("Prewarm: no recipe for " + text + "\n").c_str());
+				continue;
+			}
+			line.params.erase(line.params.begin());
+			lines.push_back(std::move(line));
+		}
+
+		std::atomic<size_t> made = 0u;
+		ParallelFor(lines.size(), nWorkers, [&](size_t i)
+		{
+			try
+			{
+				(*lines[i].pRecipe)(gfx, lines[i].params);
+				made++;
+			}
+			catch (const std::exception& e)
+			{
+				OutputDebugStringA(("Prewarming " + lines[i].text + " failed:\n" + e.what() + "\n").c_str());
+			}
+		});
+		return made;
+	}
+}
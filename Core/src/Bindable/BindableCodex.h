@@ -1,13 +1,61 @@
 ﻿#pragma once
 #include "Bindable.h"
+#include "Utils/FlatHashMap.h"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <future>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+#include <typeindex>
 
 namespace D3DEngine
 {
 	/**
 	 * \brief A singleton central repository for all our binadable
+	 * Safe to use from several threads at once: the keys are spread over shards with a reader-writer lock each, so hits only take
+	 * a shared lock, and a bindable is constructed outside of any lock. When threads resolve the same missing key at once, the first
+	 * one constructs it and the others wait for its result; different keys are constructed in parallel.
+	 * Note that constructors run on whichever thread resolves, and the immediate context is not thread-safe: bindables that use it
+	 * while being constructed (Texture uploads and generates mips) do so under Bindable::GetContextMutex, which keeps them apart from
+	 * each other but not from drawing, so resolve those off the render thread only while nothing draws (as Prewarm does).
+	 * The Codex adds up what its bindables cost (Bindable::GetMemoryCost) and, once that exceeds the budget, evicts bindables nobody
+	 * but the Codex holds any more, with a second chance for those resolved again since the last sweep. Bindables in use are never
+	 * evicted, so the budget can only be kept as long as they fit.
+	 * Hits, misses, construction times and sizes are counted per type of bindable (GetStats), and every construction is logged with
+	 * its key (GetCreationLog), so redundant loads show up; StatsToJson writes both out.
+	 * Keys of types with a recipe (RegisterRecipe) are recorded as they are made; SaveManifest writes them to a file, and Prewarm
+	 * makes them all again on the next run before the first frame, so that the render loop only sees hits.
 	 */
 	class Codex
 	{
+		public:
+			// what the Codex did for one type of bindable so far
+			struct TypeStats
+			{
+				std::string type;
+				size_t      hits   = 0u;
+				size_t      misses = 0u;
+				size_t      live   = 0u; // in the Codex now
+				size_t      bytes  = 0u; // GetMemoryCost of those together
+				double      totalCreateMs = 0.0;
+				double      maxCreateMs   = 0.0;
+			};
+
+			// one construction in Resolve
+			struct Creation
+			{
+				std::string key;
+				double      ms    = 0.0;
+				size_t      bytes = 0u;
+				// how often this key has been constructed so far: more than once means it was evicted or failed and loaded again
+				size_t      count = 0u;
+			};
+
 		public:
 			/**
 			 * \brief Query for a bindable of type T and see if it exists in the central repository.
@@ -25,29 +73,428 @@ namespace D3DEngine
 				return Get().Resolve_<T>(gfx, std::forward<Params>(p)...);
 			}
 
+			/**
+			 * \brief Check whether a bindable of type T with these parameters is already in the central repository.
+			 * Unlike Resolve, this never creates anything.
+			 */
+			template <class T, typename...Params>
+			static bool Contains(Params&&...p) noxnd
+			{
+				static_assert(std::is_base_of<Bindable, T>::value, "Can only query classes derived from Bindable");
+				const auto       key   = T::GenerateUID(std::forward<Params>(p)...);
+				auto&            shard = Get().ShardOf(key);
+				std::shared_lock lock(shard.mutex);
+				const auto       pEntry = shard.binds.Find(key);
+				return pEntry != nullptr && pEntry->bind != nullptr;
+			}
+
+			/**
+			 * \brief Put a bindable into the central repository under its UID, replacing whatever was stored there.
+			 * Holders of the replaced bindable keep it, only later Resolves get the new one.
+			 */
+			template <class T>
+			static std::shared_ptr<T> Store(std::shared_ptr<T> bind) noxnd
+			{
+				static_assert(std::is_base_of<Bindable, T>::value, "Can only store classes derived from Bindable");
+				Bindable::Identify(*bind);
+				const auto key   = bind->GetUID();
+				auto&      shard = Get().ShardOf(key);
+				const auto cost  = bind->GetMemoryCost();
+				{
+					// a Resolve constructing under this key at the moment overwrites this once it is done
+					std::unique_lock lock(shard.mutex);
+					Get().Put(shard, key, bind, cost, CountersFor<T>());
+				}
+				Get().Trim();
+				return bind;
+			}
+
+			/**
+			 * \brief Reload every bindable in the repository that was made from the file at path (see Bindable::DependsOn).
+			 * They are reloaded in place, so every drawable holding one binds the new version from its next Bind on.
+			 * A bindable that fails to reload (e.g. because the file is still being written) keeps its old version.
+			 * \param path changed file, as FileWatcher::Normalize gives it
+			 * \return number of bindables reloaded
+			 */
+			static size_t Reload(Graphics& gfx, const std::string& path)
+			{
+				return Reload(path, [&gfx](Bindable& bind) { bind.Reload(gfx); });
+			}
+
+			// same as above, with reload doing the work for every dependent bindable instead of Bindable::Reload
+			template <class F>
+			static size_t Reload(const std::string& path, F&& reload)
+			{
+				// collect the dependents under the locks, but reload outside of them (reloading can take a while)
+				std::vector<std::pair<CodexKey, std::shared_ptr<Bindable>>> dependents;
+				for (auto& shard : Get().shards)
+				{
+					std::shared_lock lock(shard.mutex);
+					for (const auto& [key, entry] : shard.binds)
+					{
+						if (entry.bind != nullptr && entry.bind->DependsOn(path))
+						{
+							dependents.emplace_back(key, entry.bind);
+						}
+					}
+				}
+
+				size_t reloaded = 0u;
+				for (const auto& [key, bind] : dependents)
+				{
+					try
+					{
+						reload(*bind);
+						reloaded++;
+						// the new version may be bigger or smaller
+						const auto       cost  = bind->GetMemoryCost();
+						auto&            shard = Get().ShardOf(key);
+						std::unique_lock lock(shard.mutex);
+						if (const auto pEntry = shard.binds.Find(key); pEntry != nullptr && pEntry->bind == bind)
+						{
+							Get().memoryCost += cost;
+							pEntry->pCounters->bytes += cost;
+							Get().memoryCost -= pEntry->cost;
+							pEntry->pCounters->bytes -= std::exchange(pEntry->cost, cost);
+						}
+					}
+					catch (const std::exception& e)
+					{
+						OutputDebugStringA(("Reloading " + key.ToString() + " failed, keeping the old version:\n" + e.what() + "\n").c_str());
+					}
+				}
+				return reloaded;
+			}
+
+			/**
+			 * \brief Evict every bindable nobody but the Codex holds any more, whatever the budget. Call it at level transitions, once the
+			 * drawables of the old level are gone.
+			 * \return number of bindables evicted
+			 */
+			static size_t Collect()
+			{
+				return Get().Evict(0u, true);
+			}
+
+			/**
+			 * \brief Approximate bytes the Codex may keep alive (unlimited by default). Evicts right away if it holds more.
+			 */
+			static void SetBudget(size_t bytes)
+			{
+				Get().budget = bytes;
+				Get().Trim();
+			}
+
+			static size_t GetBudget() noexcept
+			{
+				return Get().budget;
+			}
+
+			// approximate bytes all bindables in the Codex cost together, in use or not
+			static size_t GetMemoryCost() noexcept
+			{
+				return Get().memoryCost;
+			}
+
+			// per type of bindable resolved so far, sorted by type name
+			static std::vector<TypeStats> GetStats();
+			// the latest constructions, oldest first
+			static std::vector<Creation>  GetCreationLog();
+			// GetStats, GetCreationLog, the memory cost and the budget as one JSON object
+			static std::string            StatsToJson();
+			// start counting hits, misses, construction times and constructions per key from zero again; live counts and bytes stay
+			static void                   ResetStats();
+
+			/**
+			 * \brief Let bindables of type T be written to prewarm manifests and made again from them. T's key has to hold exactly the
+			 * parameters its constructor takes after gfx, in order, each a string, integer, enum or float.
+			 * Call it once per type, from a static initializer next to the type.
+			 * \param name what the manifest calls T
+			 */
+			template <class T, typename...Params>
+			static bool RegisterRecipe(const std::string& name)
+			{
+				static_assert(std::is_base_of<Bindable, T>::value, "Can only prewarm classes derived from Bindable");
+				Get().AddRecipe(typeid(T), name, [](Graphics& gfx, const std::vector<std::string>& params)
+				{
+					if (params.size() != sizeof...(Params))
+					{
+						throw std::runtime_error("expected " + std::to_string(sizeof...(Params)) + " parameters, got " + std::to_string(params.size()));
+					}
+					// Resolve_ rather than Resolve: a failing line has to throw here, not terminate
+					[&]<size_t...I>(std::index_sequence<I...>)
+					{
+						Get().Resolve_<T>(gfx, ParseParam<Params>(params[I])...);
+					}(std::index_sequence_for<Params...>{});
+				});
+				return true;
+			}
+
+			// write every key made so far whose type has a recipe to a manifest, in the order they were first made; returns how many
+			static size_t SaveManifest(const std::string& path);
+
+			/**
+			 * \brief Make every bindable a manifest lists on nWorkers threads (0: one per hardware thread), so that Resolving them later hits.
+			 * Call it while nothing draws, e.g. before the first frame. Lines that fail (unknown type, missing file) are skipped.
+			 * \return number of listed bindables now in the Codex; 0 if there is no manifest at path
+			 */
+			static size_t Prewarm(Graphics& gfx, const std::string& path, size_t nWorkers = 0u);
+
 		private:
+			// updated from any thread, so all atomic; one per type, registered on its first Resolve or Store and kept for good
+			struct Counters
+			{
+				explicit Counters(const std::type_info& type) noexcept
+					: type(type)
+				{
+				}
+
+				const std::type_info& type;
+				std::atomic<size_t>   hits        = 0u;
+				std::atomic<size_t>   misses      = 0u;
+				std::atomic<size_t>   live        = 0u;
+				std::atomic<size_t>   bytes       = 0u;
+				std::atomic<uint64_t> createNs    = 0u;
+				std::atomic<uint64_t> maxCreateNs = 0u;
+			};
+
+			// a bindable, or while it is being constructed, where the threads waiting for it get it from
+			struct Entry
+			{
+				std::shared_ptr<Bindable>                     bind;
+				std::shared_future<std::shared_ptr<Bindable>> pending;
+				size_t                                        cost      = 0u;
+				Counters*                                     pCounters = nullptr; // of the bindable's type, once there is one
+				// resolved since the last eviction sweep went past (set under a shared lock, so through atomic_ref)
+				bool                                          used = false;
+			};
+
+			struct Shard
+			{
+				std::shared_mutex                              mutex;
+				FlatHashMap<CodexKey, Entry, CodexKey::Hasher> binds;
+			};
+
+			using Recipe = std::function<void(Graphics&, const std::vector<std::string>&)>;
+
 			template <class T, typename...Params>
-			std::shared_ptr<T> Resolve_(Graphics& gfx, Params&&...p) noxnd
+			std::shared_ptr<T> Resolve_(Graphics& gfx, Params&&...p)
 			{
 				// generate a unique ID based on the type T
-				const auto key = T::GenerateUID(std::forward<Params>(p)...);
+				const auto key      = T::GenerateUID(std::forward<Params>(p)...);
+				auto&      shard    = ShardOf(key);
+				auto&      counters = CountersFor<T>();
+
+				// does the bindable exist in the repo? Most of the time it does, and readers do not block each other
+				std::shared_future<std::shared_ptr<Bindable>> pending;
+				{
+					std::shared_lock lock(shard.mutex);
+					if (const auto pEntry = shard.binds.Find(key))
+					{
+						if (pEntry->bind != nullptr)
+						{
+							if (std::atomic_ref<bool> used(pEntry->used); !used.load(std::memory_order_relaxed))
+							{
+								used.store(true, std::memory_order_relaxed);
+							}
+							counters.hits.fetch_add(1u, std::memory_order_relaxed);
+							// The bindable does exist the repo. Return a copy of the shared pointer.
+							// We now have one additional shared pointer referring to the same bindable.
+							// PS: we cast the generic bindable pointer to our specific type T before returning it to the user
+							return std::static_pointer_cast<T>(pEntry->bind);
+						}
+						pending = pEntry->pending;
+					}
+				}
+
+				// not there: claim the key, unless another thread did so since we looked
+				std::promise<std::shared_ptr<Bindable>> promise;
+				if (!pending.valid())
+				{
+					std::unique_lock lock(shard.mutex);
+					auto [entry, inserted] = shard.binds.TryEmplace(key);
+					if (!inserted && entry.bind != nullptr)
+					{
+						entry.used = true;
+						counters.hits.fetch_add(1u, std::memory_order_relaxed);
+						return std::static_pointer_cast<T>(entry.bind);
+					}
+					if (inserted)
+					{
+						entry.pending = promise.get_future().share();
+					}
+					else
+					{
+						pending = entry.pending;
+					}
+				}
 
-				// does the bindable exist in the repo? 
-				const auto i = binds.find(key);
+				// someone else is constructing it: wait for theirs (rethrows if their constructor threw)
+				if (pending.valid())
+				{
+					counters.hits.fetch_add(1u, std::memory_order_relaxed);
+					return std::static_pointer_cast<T>(pending.get());
+				}
 
-				if (i == binds.end())
+				// create a new bindable, without holding the lock so that other keys can be created meanwhile
+				counters.misses.fetch_add(1u, std::memory_order_relaxed);
+				std::shared_ptr<Bindable> bind;
+				const auto                start = std::chrono::steady_clock::now();
+				try
+				{
+					auto made = std::make_shared<T>(gfx, std::forward<Params>(p)...);
+					Bindable::Identify(*made);
+					bind = std::move(made);
+				}
+				catch (...)
+				{
+					{
+						// leave the key free for the next try
+						std::unique_lock lock(shard.mutex);
+						if (const auto pEntry = shard.binds.Find(key))
+						{
+							Forget(*pEntry);
+							shard.binds.Erase(key);
+						}
+					}
+					promise.set_exception(std::current_exception());
+					throw;
+				}
+				const auto createNs = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+				const auto cost     = bind->GetMemoryCost();
 				{
-					// create a new bindable
-					auto bind  = std::make_shared<T>(gfx, std::forward<Params>(p)...);
-					binds[key] = bind;
 					// add one reference to this bindable in our repo
-					return bind;
+					std::unique_lock lock(shard.mutex);
+					Put(shard, key, bind, cost, counters);
+				}
+				LogCreation(counters, key, createNs, cost);
+				promise.set_value(bind);
+				// the new bindable is safe from eviction here, we still hold it
+				Trim();
+				return std::static_pointer_cast<T>(bind);
+			}
+
+			// key now maps to bind (call with shard locked exclusively)
+			void Put(Shard& shard, const CodexKey& key, std::shared_ptr<Bindable> bind, size_t cost, Counters& counters)
+			{
+				auto& entry = shard.binds[key];
+				Forget(entry);
+				memoryCost += cost;
+				counters.live++;
+				counters.bytes += cost;
+				entry = Entry{std::move(bind), {}, cost, &counters, false};
+			}
+
+			// take the entry's bindable out of the totals (it is about to be replaced or erased)
+			void Forget(const Entry& entry) noexcept
+			{
+				if (entry.pCounters != nullptr)
+				{
+					memoryCost -= entry.cost;
+					entry.pCounters->live--;
+					entry.pCounters->bytes -= entry.cost;
+				}
+			}
+
+			template <class T>
+			static Counters& CountersFor()
+			{
+				static Counters& counters = Get().Register(typeid(T));
+				return counters;
+			}
+
+			// a manifest parameter back as P, from the text CodexKey::GetParams gave it
+			template <class P>
+			static P ParseParam(const std::string& text)
+			{
+				if constexpr (std::is_same_v<P, std::string>)
+				{
+					return text;
+				}
+				else if constexpr (std::is_floating_point_v<P>)
+				{
+					return P(std::bit_cast<float>(uint32_t(std::stoull(text))));
+				}
+				else
+				{
+					return P(std::stoull(text));
 				}
+			}
+
+			Counters& Register(const std::type_info& type);
+			void      LogCreation(Counters& counters, const CodexKey& key, uint64_t createNs, size_t cost);
+			void      AddRecipe(const std::type_info& type, const std::string& name, Recipe recipe);
 
-				// The bindable does exist the repo. Return a copy of the shared pointer.
-				// We now have one additional shared pointer referring to the same bindable.
-				// PS: we cast the generic bindable pointer to our specific type T before returning it to the user
-				return std::static_pointer_cast<T>(i->second);
+			// evict down to the budget if over it, unless another thread is already evicting
+			void Trim()
+			{
+				if (memoryCost > budget)
+				{
+					Evict(budget, false);
+				}
+			}
+
+			/**
+			 * \brief Second-chance (clock) sweep over the shards, continuing where the last one stopped: bindables only the Codex holds
+			 * are evicted until the cost is down to target, those resolved since the last sweep are only unmarked the first time round.
+			 * \param collect evict every bindable only the Codex holds instead, waiting for a running sweep first
+			 * \return number of bindables evicted
+			 */
+			size_t Evict(size_t target, bool collect)
+			{
+				std::unique_lock sweep(sweepMutex, std::defer_lock);
+				if (collect)
+				{
+					sweep.lock();
+				}
+				else if (!sweep.try_lock())
+				{
+					return 0u;
+				}
+
+				// released once the shard locks are, releasing device objects can take a moment
+				std::vector<std::shared_ptr<Bindable>> evicted;
+				const auto                             done = [&] { return !collect && memoryCost <= target; };
+				for (int pass = 0; pass < (collect ? 1 : 2) && !done(); pass++)
+				{
+					for (size_t n = 0; n < shards.size() && !done(); n++, hand = (hand + 1u) % shards.size())
+					{
+						auto&                 shard = shards[hand];
+						std::unique_lock      lock(shard.mutex);
+						std::vector<CodexKey> victims;
+						for (const auto& [key, entry] : shard.binds)
+						{
+							// still being constructed, or someone besides the Codex holds it
+							if (entry.bind == nullptr || entry.bind.use_count() > 1)
+							{
+								continue;
+							}
+							if (entry.used && !collect)
+							{
+								entry.used = false;
+								continue;
+							}
+							victims.push_back(key);
+							Forget(entry);
+							if (done())
+							{
+								break;
+							}
+						}
+						for (const auto& key : victims)
+						{
+							evicted.push_back(std::move(shard.binds.Find(key)->bind));
+							shard.binds.Erase(key);
+						}
+					}
+				}
+				return evicted.size();
+			}
+
+			Shard& ShardOf(const CodexKey& key) noexcept
+			{
+				// the top bits: the low ones already pick the slot inside the shard's map
+				return shards[key.Hash() >> (64u - shardBits)];
 			}
 
 			static Codex& Get()
@@ -57,10 +504,29 @@ namespace D3DEngine
 			}
 
 		private:
-			// Every bindable has a unique string ID, which we use to lookup bindable to see if we have identical bindables so that we can share them
-			std::unordered_map<std::string, std::shared_ptr<Bindable>> binds;
+			static constexpr unsigned shardBits = 4u;
+
+			// Every bindable has a unique key (type + parameters), which we use to lookup bindable to see if we have identical bindables so that we can share them
+			std::array<Shard, size_t(1u) << shardBits> shards;
 
 			// Note: Codex itself will hold 1 ref count to the bindable. Thus, you would expect to see (number of expected references + 1)
-			// TODO: if you want to clean up bindables, it would need to write a garbage collector that loops through the bindable with ref == 1 and delete them
+			// Bindables with a ref count of 1 are only held by us, and are what Evict frees
+			std::atomic<size_t> memoryCost = 0u;
+			std::atomic<size_t> budget     = std::numeric_limits<size_t>::max();
+			std::mutex          sweepMutex;
+			size_t              hand = 0u; // shard the next sweep starts at (guarded by sweepMutex)
+
+			// statistics (see BindableCodex.cpp); the counters themselves are atomic, statsMutex guards the containers
+			static constexpr size_t                         maxLogged = 4096u;
+			std::mutex                                      statsMutex;
+			std::deque<Counters>                            counters;
+			std::deque<Creation>                            creationLog;    // the last maxLogged constructions
+			FlatHashMap<CodexKey, size_t, CodexKey::Hasher> creationCounts; // constructions per key, since the start or ResetStats
+
+			// prewarming (guarded by statsMutex as well)
+			std::unordered_map<std::string, Recipe>          recipes;     // by the name manifests use
+			std::unordered_map<std::type_index, std::string> recipeNames; // the other way round
+			std::vector<CodexKey>                            recorded;    // keys with a recipe, in the order they were first made
+			FlatHashMap<CodexKey, bool, CodexKey::Hasher>    recordedKeys;
 	};
 }
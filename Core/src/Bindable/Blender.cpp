@@ -39,7 +39,7 @@ namespace D3DEngine
 	void Blender::Bind(Graphics& gfx) noexcept
 	{
 		const float* data = factors ? factors->data() : nullptr;
-		GetContext(gfx)->OMSetBlendState(pBlender.Get(), data, 0xFFFFFFFFu);
+		GetState(gfx).SetBlendState(pBlender.Get(), data, 0xFFFFFFFFu);
 	}
 
 	void Blender::SetFactor(float factor) noxnd
@@ -59,13 +59,12 @@ namespace D3DEngine
 		return Codex::Resolve<Blender>(gfx, blending, factor);
 	}
 
-	std::string Blender::GenerateUID(bool blending, std::optional<float> factor)
+	CodexKey Blender::GenerateUID(bool blending, std::optional<float> factor)
 	{
-		using namespace std::string_literals;
-		return typeid(Blender).name() + "#"s + (blending ? "b"s : "n"s) + (factor ? "#f"s + std::to_string(*factor) : "");
+		return CodexKey::For<Blender>().Add(blending).Add(factor.has_value()).Add(factor.value_or(0.0f));
 	}
 
-	std::string Blender::GetUID() const noexcept
+	CodexKey Blender::GetUID() const noexcept
 	{
 		return GenerateUID(blending, factors ? factors->front() : std::optional<float>{});
 	}
@@ -11,8 +11,8 @@ namespace D3DEngine
 			void                            SetFactor(float factor) noxnd;
 			float                           GetFactor() const noxnd;
 			static std::shared_ptr<Blender> Resolve(Graphics& gfx, bool blending, std::optional<float> factor = {});
-			static std::string              GenerateUID(bool blending, std::optional<float> factor);
-			std::string                     GetUID() const noexcept override;
+			static CodexKey                 GenerateUID(bool blending, std::optional<float> factor);
+			CodexKey                        GetUID() const noexcept override;
 		protected:
 			Microsoft::WRL::ComPtr<ID3D11BlendState> pBlender;
 			bool                                     blending;
@@ -0,0 +1,166 @@
+#include "CodexKey.h"
+#include <bit>
+#include <cassert>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace D3DEngine
+{
+	namespace
+	{
+		// finalizer of MurmurHash3: every input bit affects every output bit, so the low bits FlatHashMap uses are well mixed
+		uint64_t Mix(uint64_t h) noexcept
+		{
+			h ^= h >> 33u;
+			h *= 0xff51afd7ed558ccdull;
+			h ^= h >> 33u;
+			h *= 0xc4ceb9fe1a85ec53ull;
+			h ^= h >> 33u;
+			return h;
+		}
+
+		// the hash travels with the text, so it is worked out before taking the lock rather than by the map under it
+		struct InternKey
+		{
+			std::string_view text;
+			size_t           hash;
+
+			bool operator==(const InternKey& other) const noexcept
+			{
+				return text == other.text;
+			}
+		};
+
+		struct InternKeyHasher
+		{
+			size_t operator()(const InternKey& key) const noexcept
+			{
+				return key.hash;
+			}
+		};
+
+		// interned strings live as long as the program; the deque keeps their addresses stable for the views the map is keyed on
+		struct InternTable
+		{
+			std::shared_mutex                                        mutex;
+			std::deque<std::string>                                  texts;
+			std::unordered_map<InternKey, uint32_t, InternKeyHasher> ids;
+		};
+
+		InternTable& GetInternTable()
+		{
+			static InternTable table;
+			return table;
+		}
+	}
+
+	CodexKey::CodexKey(const std::type_info& type) noexcept
+		: pType(&type),
+		  hash(Mix(type.hash_code()))
+	{
+	}
+
+	CodexKey& CodexKey::Add(std::string_view text)
+	{
+		Push(Intern(text), true);
+		return *this;
+	}
+
+	CodexKey& CodexKey::Add(uint64_t value) noexcept
+	{
+		Push(value, false);
+		return *this;
+	}
+
+	CodexKey& CodexKey::Add(float value) noexcept
+	{
+		Push(std::bit_cast<uint32_t>(value), false);
+		return *this;
+	}
+
+	void CodexKey::Push(uint64_t word, bool isText) noexcept
+	{
+		assert("Too many parameters for a CodexKey" && count < maxParams);
+		params[count] = word;
+		textMask |= uint8_t(isText) << count;
+		count++;
+		hash = Mix(hash ^ (word + 0x9e3779b97f4a7c15ull + (hash << 6u)));
+	}
+
+	uint64_t CodexKey::Hash() const noexcept
+	{
+		return hash;
+	}
+
+	const std::type_info& CodexKey::Type() const noexcept
+	{
+		assert(pType != nullptr);
+		return *pType;
+	}
+
+	bool CodexKey::operator==(const CodexKey& other) const noexcept
+	{
+		if (hash != other.hash || count != other.count || textMask != other.textMask)
+		{
+			return false;
+		}
+		// type_info objects of the same type may live at different addresses across modules
+		if (pType != other.pType && (pType == nullptr || other.pType == nullptr || *pType != *other.pType))
+		{
+			return false;
+		}
+		return params == other.params;
+	}
+
+	std::string CodexKey::ToString() const
+	{
+		std::string text = pType ? pType->name() : "?";
+		for (const auto& param : GetParams())
+		{
+			text += '#';
+			text += param;
+		}
+		return text;
+	}
+
+	std::vector<std::string> CodexKey::GetParams() const
+	{
+		std::vector<std::string> texts;
+		for (uint8_t i = 0; i < count; i++)
+		{
+			texts.push_back((textMask >> i) & 1u ? std::string(Interned(uint32_t(params[i]))) : std::to_string(params[i]));
+		}
+		return texts;
+	}
+
+	uint32_t CodexKey::Intern(std::string_view text)
+	{
+		auto&           table = GetInternTable();
+		const InternKey key{text, std::hash<std::string_view>{}(text)};
+		{
+			std::shared_lock lock{table.mutex};
+			if (const auto i = table.ids.find(key); i != table.ids.end())
+			{
+				return i->second;
+			}
+		}
+		std::unique_lock lock{table.mutex};
+		// another thread may have interned it between the two locks
+		if (const auto i = table.ids.find(key); i != table.ids.end())
+		{
+			return i->second;
+		}
+		const auto id = uint32_t(table.texts.size());
+		table.ids.emplace(InternKey{table.texts.emplace_back(text), key.hash}, id);
+		return id;
+	}
+
+	std::string_view CodexKey::Interned(uint32_t id) noexcept
+	{
+		auto&            table = GetInternTable();
+		std::shared_lock lock{table.mutex};
+		return id < table.texts.size() ? std::string_view{table.texts[id]} : std::string_view{};
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+
+namespace D3DEngine
+{
+	/**
+	 * \brief What the Codex finds a bindable under: the bindable's type and the parameters that make it unique, packed into a few
+	 * 64-bit words (strings such as paths and tags are interned, so a key holds their ID instead of a copy), plus a hash of both.
+	 * Making one costs no allocation once its strings are interned, and two keys are only equal if type and every word match,
+	 * so keys whose hashes collide are still told apart.
+	 */
+	class CodexKey
+	{
+		public:
+			static constexpr size_t maxParams = 4u;
+
+			struct Hasher
+			{
+				uint64_t operator()(const CodexKey& key) const noexcept
+				{
+					return key.hash;
+				}
+			};
+
+		public:
+			CodexKey() noexcept = default;
+			// a key for bindables of type T, without parameters yet
+			template <class T>
+			static CodexKey For() noexcept
+			{
+				return CodexKey{typeid(T)};
+			}
+
+			// append one parameter
+			CodexKey& Add(std::string_view text);
+			CodexKey& Add(uint64_t value) noexcept;
+			CodexKey& Add(float value) noexcept;
+
+			template <class T> requires std::is_integral_v<T> || std::is_enum_v<T>
+			CodexKey& Add(T value) noexcept
+			{
+				return Add(uint64_t(value));
+			}
+
+			uint64_t              Hash() const noexcept;
+			const std::type_info& Type() const noexcept;
+			bool                  operator==(const CodexKey& other) const noexcept;
+			// type name and parameters with interned strings spelled out again, for logs
+			std::string           ToString() const;
+			// the parameters alone, as ToString spells them (a float is the number its bits make)
+			std::vector<std::string> GetParams() const;
+
+			// the ID text is interned under (the same for equal texts), and the text back for an ID
+			static uint32_t         Intern(std::string_view text);
+			static std::string_view Interned(uint32_t id) noexcept;
+		private:
+			explicit CodexKey(const std::type_info& type) noexcept;
+			void     Push(uint64_t word, bool isText) noexcept;
+		private:
+			const std::type_info*           pType = nullptr;
+			uint64_t                        hash  = 0u;
+			std::array<uint64_t, maxParams> params{};
+			uint8_t                         count = 0u;
+			// bit i set: params[i] is an interned string
+			uint8_t                         textMask = 0u;
+	};
+}
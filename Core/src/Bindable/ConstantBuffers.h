@@ -87,6 +87,11 @@ namespace D3DEngine
 				GFX_THROW_INFO(GetDevice(gfx)->CreateBuffer(&cbd, nullptr, &pConstantBuffer_));
 			}
 
+			size_t GetMemoryCost() const noexcept override
+			{
+				return sizeof(C);
+			}
+
 		protected:
 			Microsoft::WRL::ComPtr<ID3D11Buffer> pConstantBuffer_;
 			UINT                                 slot_;
@@ -105,7 +110,7 @@ namespace D3DEngine
 			void Bind(Graphics& gfx) noexcept override
 			{
 				// "this->" is necessary in order to access parent's protected variables
-				this->GetContext(gfx)->VSSetConstantBuffers(this->slot_, 1u, this->pConstantBuffer_.GetAddressOf());
+				this->GetState(gfx).SetVSConstantBuffer(this->slot_, this->pConstantBuffer_.Get());
 			}
 
 			static std::shared_ptr<VertexConstantBuffer> Resolve(Graphics& gfx, const C& consts, UINT slot = 0)
@@ -118,21 +123,20 @@ namespace D3DEngine
 				return Codex::Resolve<VertexConstantBuffer>(gfx, slot);
 			}
 
-			static std::string GenerateUID(const C&, UINT slot)
+			static CodexKey GenerateUID(const C&, UINT slot)
 			{
 				return GenerateUID(slot);
 			}
 
-			static std::string GenerateUID(UINT slot = 0)
+			static CodexKey GenerateUID(UINT slot = 0)
 			{
-				using namespace std::string_literals;
-				// use the name of the constant buffer directly as the UID, b/c every constant buffer templated on different structures will have different names
+				// use the type of the constant buffer directly as the UID, b/c every constant buffer templated on different structures will be a different type
 				// Assume that if we request the constant buffer with the same structure, then you want to share it
 				// TODO: Sometimes you don't want to share the constant buffer even though they templated from the same structure. We may need to add a tag to this as well. 
-				return typeid(VertexConstantBuffer).name() + "#"s + std::to_string(slot);
+				return CodexKey::For<VertexConstantBuffer>().Add(slot);
 			}
 
-			std::string GetUID() const noexcept override
+			CodexKey GetUID() const noexcept override
 			{
 				return GenerateUID(this->slot_);
 			}
@@ -146,7 +150,7 @@ namespace D3DEngine
 
 			void Bind(Graphics& gfx) noexcept override
 			{
-				this->GetContext(gfx)->PSSetConstantBuffers(this->slot_, 1u, this->pConstantBuffer_.GetAddressOf());
+				this->GetState(gfx).SetPSConstantBuffer(this->slot_, this->pConstantBuffer_.Get());
 			}
 
 			static std::shared_ptr<PixelConstantBuffer> Resolve(Graphics& gfx, const C& consts, UINT slot = 0)
@@ -159,18 +163,17 @@ namespace D3DEngine
 				return Codex::Resolve<PixelConstantBuffer>(gfx, slot);
 			}
 
-			static std::string GenerateUID(const C&, UINT slot)
+			static CodexKey GenerateUID(const C&, UINT slot)
 			{
 				return GenerateUID(slot);
 			}
 
-			static std::string GenerateUID(UINT slot = 0)
+			static CodexKey GenerateUID(UINT slot = 0)
 			{
-				using namespace std::string_literals;
-				return typeid(PixelConstantBuffer).name() + "#"s + std::to_string(slot);
+				return CodexKey::For<PixelConstantBuffer>().Add(slot);
 			}
 
-			std::string GetUID() const noexcept override
+			CodexKey GetUID() const noexcept override
 			{
 				return GenerateUID(this->slot_);
 			}
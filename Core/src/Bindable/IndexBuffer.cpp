@@ -12,24 +12,57 @@ namespace D3DEngine
 	{
 	}
 
+	IndexBuffer::IndexBuffer(Graphics& gfx, const std::vector<unsigned int>& indices)
+		: IndexBuffer(gfx, "?", indices)
+	{
+	}
+
 	IndexBuffer::IndexBuffer(Graphics& gfx, const std::string& tag, const std::vector<unsigned short>& indices)
 		:
 		tag_(tag),
-		count_((UINT)indices.size())
+		count_((UINT)indices.size()),
+		format_(DXGI_FORMAT_R16_UINT),
+		key_(GenerateUID_(tag))
+	{
+		Create(gfx, indices.data());
+	}
+
+	IndexBuffer::IndexBuffer(Graphics& gfx, const std::string& tag, const std::vector<unsigned int>& indices)
+		:
+		tag_(tag),
+		count_((UINT)indices.size()),
+		format_(ChooseFormat(indices)),
+		key_(GenerateUID_(tag))
+	{
+		if (format_ == DXGI_FORMAT_R16_UINT)
+		{
+			// everything fits, so only upload half the bytes
+			const std::vector<unsigned short> narrow(indices.begin(), indices.end());
+			Create(gfx, narrow.data());
+		}
+		else
+		{
+			Create(gfx, indices.data());
+		}
+	}
+
+	void IndexBuffer::Create(Graphics& gfx, const void* pIndices) noxnd
 	{
 		INFOMAN(gfx);
 
+		const UINT indexSize = format_ == DXGI_FORMAT_R16_UINT ? sizeof(unsigned short) : sizeof(unsigned int);
+
 		D3D11_BUFFER_DESC ibd = {
-			.ByteWidth = UINT(count_ * sizeof(unsigned short)),
+			.ByteWidth = UINT(count_ * indexSize),
 			.Usage = D3D11_USAGE_DEFAULT,
 			.BindFlags = D3D11_BIND_INDEX_BUFFER,
 			.CPUAccessFlags = 0u,
 			.MiscFlags = 0u,
-			.StructureByteStride = sizeof(unsigned short),
+			.StructureByteStride = indexSize,
 		};
 
 		D3D11_SUBRESOURCE_DATA isd = {
-			.pSysMem = indices.data(),
+			.pSysMem = pIndices,
 		};
 
 		GFX_THROW_INFO(GetDevice(gfx)->CreateBuffer(&ibd, &isd, &pIndexBuffer_));
@@ -37,7 +70,7 @@ namespace D3DEngine
 
 	void IndexBuffer::Bind(Graphics& gfx) noexcept
 	{
-		GetContext(gfx)->IASetIndexBuffer(pIndexBuffer_.Get(), DXGI_FORMAT_R16_UINT, 0u);
+		GetState(gfx).SetIndexBuffer(pIndexBuffer_.Get(), format_);
 	}
 
 	UINT IndexBuffer::GetCount() const noexcept
@@ -45,6 +78,23 @@ namespace D3DEngine
 		return count_;
 	}
 
+	DXGI_FORMAT IndexBuffer::GetFormat() const noexcept
+	{
+		return format_;
+	}
+
+	size_t IndexBuffer::GetMemoryCost() const noexcept
+	{
+		return size_t(count_) * (format_ == DXGI_FORMAT_R16_UINT ? sizeof(unsigned short) : sizeof(unsigned int));
+	}
+
+	DXGI_FORMAT IndexBuffer::ChooseFormat(const std::vector<unsigned int>& indices) noexcept
+	{
+		// we only draw triangle lists, so 0xFFFF is an ordinary index here (the strip cut value does not apply)
+		const auto maxIndex = indices.empty() ? 0u : *std::max_element(indices.begin(), indices.end());
+		return maxIndex <= 0xFFFFu ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+	}
+
 	std::shared_ptr<IndexBuffer> IndexBuffer::Resolve(Graphics&                          gfx,
 	                                                  const std::string&                 tag,
 	                                                  const std::vector<unsigned short>& indices)
@@ -53,14 +103,21 @@ namespace D3DEngine
 		return Codex::Resolve<IndexBuffer>(gfx, tag, indices);
 	}
 
-	std::string IndexBuffer::GenerateUID_(const std::string& tag)
+	std::shared_ptr<IndexBuffer> IndexBuffer::Resolve(Graphics&                        gfx,
+	                                                  const std::string&               tag,
+	                                                  const std::vector<unsigned int>& indices)
+	{
+		assert(tag != "?");
+		return Codex::Resolve<IndexBuffer>(gfx, tag, indices);
+	}
+
+	CodexKey IndexBuffer::GenerateUID_(const std::string& tag)
 	{
-		using namespace std::string_literals;
-		return typeid(IndexBuffer).name() + "#"s + tag;
+		return CodexKey::For<IndexBuffer>().Add(tag);
 	}
 
-	std::string IndexBuffer::GetUID() const noexcept
+	CodexKey IndexBuffer::GetUID() const noexcept
 	{
-		return GenerateUID_(tag_);
+		return key_;
 	}
 }
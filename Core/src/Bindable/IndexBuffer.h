@@ -3,29 +3,46 @@
 
 namespace D3DEngine
 {
+	/**
+	 * \brief Index buffer that picks the narrowest index format able to address its vertices.
+	 * 32-bit indices are only uploaded as 32-bit if some index does not fit into 16 bits.
+	 */
 	class IndexBuffer : public Bindable
 	{
 		public:
 			IndexBuffer(Graphics& gfx, const std::vector<unsigned short>& indices);
+			IndexBuffer(Graphics& gfx, const std::vector<unsigned int>& indices);
 			IndexBuffer(Graphics& gfx, const std::string& tag, const std::vector<unsigned short>& indices);
+			IndexBuffer(Graphics& gfx, const std::string& tag, const std::vector<unsigned int>& indices);
 			void                                Bind(Graphics& gfx) noexcept override;
 			UINT                                GetCount() const noexcept;
+			DXGI_FORMAT                         GetFormat() const noexcept;
+			size_t                              GetMemoryCost() const noexcept override;
 			static std::shared_ptr<IndexBuffer> Resolve(Graphics&                          gfx,
 			                                            const std::string&                 tag,
 			                                            const std::vector<unsigned short>& indices);
+			static std::shared_ptr<IndexBuffer> Resolve(Graphics&                        gfx,
+			                                            const std::string&               tag,
+			                                            const std::vector<unsigned int>& indices);
+
+			// narrowest format that can hold every index in the list
+			static DXGI_FORMAT ChooseFormat(const std::vector<unsigned int>& indices) noexcept;
 
 			template <typename...Ignore>
-			static std::string GenerateUID(const std::string& tag, Ignore&&...ignore)
+			static CodexKey GenerateUID(const std::string& tag, Ignore&&...ignore)
 			{
 				return GenerateUID_(tag);
 			}
 
-			std::string GetUID() const noexcept override;
+			CodexKey GetUID() const noexcept override;
 		private:
-			static std::string GenerateUID_(const std::string& tag);
+			void               Create(Graphics& gfx, const void* pIndices) noxnd;
+			static CodexKey    GenerateUID_(const std::string& tag);
 		protected:
 			std::string                          tag_;
 			UINT                                 count_;
+			DXGI_FORMAT                          format_;
 			Microsoft::WRL::ComPtr<ID3D11Buffer> pIndexBuffer_;
+			CodexKey                             key_;
 	};
 }
@@ -8,7 +8,8 @@ namespace D3DEngine
 	InputLayout::InputLayout(Graphics&           gfx,
 	                         DynamicVertexLayout layout_in,
 	                         ID3DBlob*           pVertexShaderBytecode)
-		: layout_(std::move(layout_in))
+		: layout_(std::move(layout_in)),
+		  key_(GenerateUID(layout_))
 	{
 		INFOMAN(gfx);
 
@@ -25,7 +26,7 @@ namespace D3DEngine
 
 	void InputLayout::Bind(Graphics& gfx) noexcept
 	{
-		GetContext(gfx)->IASetInputLayout(pInputLayout_.Get());
+		GetState(gfx).SetInputLayout(pInputLayout_.Get());
 	}
 
 	std::shared_ptr<InputLayout> InputLayout::Resolve(Graphics&                  gfx,
@@ -35,14 +36,13 @@ namespace D3DEngine
 		return Codex::Resolve<InputLayout>(gfx, layout, pVertexShaderBytecode);
 	}
 
-	std::string InputLayout::GenerateUID(const DynamicVertexLayout& layout, ID3DBlob* pVertexShaderBytecode)
+	CodexKey InputLayout::GenerateUID(const DynamicVertexLayout& layout, ID3DBlob* pVertexShaderBytecode)
 	{
-		using namespace std::string_literals;
-		return typeid(InputLayout).name() + "#"s + layout.GetCode();
+		return CodexKey::For<InputLayout>().Add(layout.GetCode());
 	}
 
-	std::string InputLayout::GetUID() const noexcept
+	CodexKey InputLayout::GetUID() const noexcept
 	{
-		return GenerateUID(layout_);
+		return key_;
 	}
 }
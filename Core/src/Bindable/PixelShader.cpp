@@ -1,23 +1,56 @@
 #include "PixelShader.h"
 #include "BindableCodex.h"
+#include "Utils/FileWatcher.h"
 #include "Debug/GraphicsThrowMacros.h"
 
 namespace D3DEngine
 {
+	namespace
+	{
+		// manifests list pixel shaders by their .cso path
+		const bool recipe = Codex::RegisterRecipe<PixelShader, std::string>("PixelShader");
+	}
+
 	PixelShader::PixelShader(Graphics& gfx, const std::string& path)
 		:
-		path(path)
+		path(path),
+		key_(GenerateUID(path))
+	{
+		pPixelShader_ = Load(gfx);
+	}
+
+	Microsoft::WRL::ComPtr<ID3D11PixelShader> PixelShader::Load(Graphics& gfx) const
 	{
 		INFOMAN(gfx);
 
-		Microsoft::WRL::ComPtr<ID3DBlob> pBlob;
+		Microsoft::WRL::ComPtr<ID3DBlob>          pBlob;
+		Microsoft::WRL::ComPtr<ID3D11PixelShader> pPixelShader;
 		GFX_THROW_INFO(D3DReadFileToBlob(std::wstring{ path.begin(),path.end() }.c_str(), &pBlob));
-		GFX_THROW_INFO(GetDevice(gfx)->CreatePixelShader(pBlob->GetBufferPointer(), pBlob->GetBufferSize(), nullptr, &pPixelShader_));
+		GFX_THROW_INFO(GetDevice(gfx)->CreatePixelShader(pBlob->GetBufferPointer(), pBlob->GetBufferSize(), nullptr, &pPixelShader));
+		return pPixelShader;
 	}
 
 	void PixelShader::Bind(Graphics& gfx) noexcept
 	{
-		GetContext(gfx)->PSSetShader(pPixelShader_.Get(), nullptr, 0u);
+		GetState(gfx).SetPixelShader(pPixelShader_.Get());
+	}
+
+	bool PixelShader::DependsOn(const std::string& path) const noexcept
+	{
+		try
+		{
+			return FileWatcher::Normalize(this->path) == path;
+		}
+		catch (...)
+		{
+			return false;
+		}
+	}
+
+	void PixelShader::Reload(Graphics& gfx)
+	{
+		// only swapped in once the new shader exists, so a half-written file leaves the old one in place
+		pPixelShader_ = Load(gfx);
 	}
 
 	std::shared_ptr<PixelShader> PixelShader::Resolve(Graphics& gfx, const std::string& path)
@@ -25,14 +58,13 @@ namespace D3DEngine
 		return Codex::Resolve<PixelShader>(gfx, path);
 	}
 
-	std::string PixelShader::GenerateUID(const std::string& path)
+	CodexKey PixelShader::GenerateUID(const std::string& path)
 	{
-		using namespace std::string_literals;
-		return typeid(PixelShader).name() + "#"s + path;
+		return CodexKey::For<PixelShader>().Add(path);
 	}
 
-	std::string PixelShader::GetUID() const noexcept
+	CodexKey PixelShader::GetUID() const noexcept
 	{
-		return GenerateUID(path);
+		return key_;
 	}
 }
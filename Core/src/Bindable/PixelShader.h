@@ -9,10 +9,16 @@ namespace D3DEngine
 			PixelShader(Graphics& gfx, const std::string& path);
 			void                             Bind(Graphics& gfx) noexcept override;
 			static std::shared_ptr<PixelShader> Resolve(Graphics& gfx, const std::string& path);
-			static std::string               GenerateUID(const std::string& path);
-			std::string                      GetUID() const noexcept override;
+			static CodexKey                  GenerateUID(const std::string& path);
+			CodexKey                         GetUID() const noexcept override;
+			bool                             DependsOn(const std::string& path) const noexcept override;
+			void                             Reload(Graphics& gfx) override;
+		private:
+			// read the compiled shader at path and create a shader object from it
+			Microsoft::WRL::ComPtr<ID3D11PixelShader> Load(Graphics& gfx) const;
 		protected:
 			std::string                               path;
 			Microsoft::WRL::ComPtr<ID3D11PixelShader> pPixelShader_;
+			CodexKey                                  key_;
 	};
 }
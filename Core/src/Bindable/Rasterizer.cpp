@@ -4,6 +4,12 @@
 
 namespace D3DEngine
 {
+	namespace
+	{
+		// one per cull mode
+		const bool recipe = Codex::RegisterRecipe<Rasterizer, bool>("Rasterizer");
+	}
+
 	Rasterizer::Rasterizer(Graphics& gfx, bool twoSided)
 		:
 		twoSided(twoSided)
@@ -18,7 +24,7 @@ namespace D3DEngine
 
 	void Rasterizer::Bind(Graphics& gfx) noexcept
 	{
-		GetContext(gfx)->RSSetState(pRasterizer.Get());
+		GetState(gfx).SetRasterizerState(pRasterizer.Get());
 	}
 
 	std::shared_ptr<Rasterizer> Rasterizer::Resolve(Graphics& gfx, bool twoSided)
@@ -26,13 +32,12 @@ namespace D3DEngine
 		return Codex::Resolve<Rasterizer>(gfx, twoSided);
 	}
 
-	std::string Rasterizer::GenerateUID(bool twoSided)
+	CodexKey Rasterizer::GenerateUID(bool twoSided)
 	{
-		using namespace std::string_literals;
-		return typeid(Rasterizer).name() + "#"s + (twoSided ? "2s" : "1s");
+		return CodexKey::For<Rasterizer>().Add(twoSided);
 	}
 
-	std::string Rasterizer::GetUID() const noexcept
+	CodexKey Rasterizer::GetUID() const noexcept
 	{
 		return GenerateUID(twoSided);
 	}
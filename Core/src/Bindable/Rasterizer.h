@@ -9,8 +9,8 @@ namespace D3DEngine
 		Rasterizer( Graphics& gfx,bool twoSided );
 		void Bind( Graphics& gfx ) noexcept override;
 		static std::shared_ptr<Rasterizer> Resolve( Graphics& gfx,bool twoSided );
-		static std::string GenerateUID( bool twoSided );
-		std::string GetUID() const noexcept override;
+		static CodexKey GenerateUID( bool twoSided );
+		CodexKey GetUID() const noexcept override;
 	protected:
 		Microsoft::WRL::ComPtr<ID3D11RasterizerState> pRasterizer;
 		bool twoSided;
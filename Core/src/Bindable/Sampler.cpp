@@ -4,6 +4,12 @@
 
 namespace D3DEngine
 {
+	namespace
+	{
+		// the one sampler, no parameters to record
+		const bool recipe = Codex::RegisterRecipe<Sampler>("Sampler");
+	}
+
 	Sampler::Sampler(Graphics& gfx)
 	{
 		INFOMAN(gfx);
@@ -19,7 +25,7 @@ namespace D3DEngine
 
 	void Sampler::Bind(Graphics& gfx) noexcept
 	{
-		GetContext(gfx)->PSSetSamplers(0, 1, pSampler_.GetAddressOf());
+		GetState(gfx).SetPSSampler(0u, pSampler_.Get());
 	}
 
 	// call this function if you want to create a sampler
@@ -33,13 +39,13 @@ namespace D3DEngine
 	 * \brief  Generate a unique ID for this sampler
 	 * \return A UID for this sampler
 	 */
-	std::string Sampler::GenerateUID()
+	CodexKey Sampler::GenerateUID()
 	{
-		return typeid(Sampler).name();
+		return CodexKey::For<Sampler>();
 	}
 
 	// provide a way to get the UID from an existing bindable (useful if we want to query for specific bindables)
-	std::string Sampler::GetUID() const noexcept
+	CodexKey Sampler::GetUID() const noexcept
 	{
 		return GenerateUID();
 	}
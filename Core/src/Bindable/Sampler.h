@@ -12,8 +12,8 @@ namespace D3DEngine
 			Sampler(Graphics& gfx);
 			void                             Bind(Graphics& gfx) noexcept override;
 			static std::shared_ptr<Sampler> Resolve(Graphics& gfx);
-			static std::string               GenerateUID();
-			std::string                      GetUID() const noexcept override;
+			static CodexKey                  GenerateUID();
+			CodexKey                         GetUID() const noexcept override;
 		protected:
 			Microsoft::WRL::ComPtr<ID3D11SamplerState> pSampler_;
 	};
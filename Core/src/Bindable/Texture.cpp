@@ -2,21 +2,38 @@
 
 #include "BindableCodex.h"
 #include "Utils/Surface.h"
+#include "Utils/FileWatcher.h"
 #include "Debug/GraphicsThrowMacros.h"
 
 namespace D3DEngine
 {
 	namespace wrl = Microsoft::WRL;
 
-	Texture::Texture(Graphics& gfx, const std::string& path, UINT slot)
+	namespace
+	{
+		// textures are made again from their path and slot (decoding the file on the worker)
+		const bool recipe = Codex::RegisterRecipe<Texture, std::string, UINT>("Texture");
+	}
+
+	Texture::Texture(Graphics& gfx, const std::string& path, UINT slot, const Surface* pDecoded)
 		: path_(path),
-		  slot_(slot)
+		  slot_(slot),
+		  key_(GenerateUID(path, slot))
 	{
-		INFOMAN(gfx);
+		// load surface (unless the caller already decoded it for us)
+		std::optional<Surface> loaded;
+		if (pDecoded == nullptr)
+		{
+			loaded.emplace(Surface::FromFile(path));
+			pDecoded = &*loaded;
+		}
+		hasAlpha      = pDecoded->AlphaLoaded();
+		pTextureView_ = MakeView(gfx, *pDecoded);
+	}
 
-		// load surface
-		const auto s = Surface::FromFile(path);
-		hasAlpha     = s.AlphaLoaded();
+	wrl::ComPtr<ID3D11ShaderResourceView> Texture::MakeView(Graphics& gfx, const Surface& s)
+	{
+		INFOMAN(gfx);
 
 		// TODO: consider using a staging texture
 
@@ -46,6 +63,9 @@ namespace D3DEngine
 			               &pTexture
 		               ));
 
+		// the upload and the mip generation go through the immediate context, and textures may be made on several threads at once
+		std::lock_guard contextLock(GetContextMutex(gfx));
+
 		// since we are no longer providing a subresource when creating the texture, we need to update it ourselves
 		// manually write original image data into top/first mip level
 		GetContext(gfx)->UpdateSubresource(pTexture.Get(),
@@ -62,35 +82,78 @@ namespace D3DEngine
 		srvDesc.Texture2D.MostDetailedMip       = 0;
 		srvDesc.Texture2D.MipLevels             = -1; // use all the mip levels
 
+		wrl::ComPtr<ID3D11ShaderResourceView> pTextureView;
 		GFX_THROW_INFO(GetDevice(gfx)->CreateShaderResourceView(
-			               pTexture.Get(), &srvDesc, &pTextureView_
+			               pTexture.Get(), &srvDesc, &pTextureView
 		               ));
 
 		// generate the mipmap chain using the gpu rendering pipeline
-		GetContext(gfx)->GenerateMips(pTextureView_.Get());
+		GetContext(gfx)->GenerateMips(pTextureView.Get());
+		return pTextureView;
 	}
 
 	void Texture::Bind(Graphics& gfx) noexcept
 	{
 		// textures are used by pixel shaders
-		GetContext(gfx)->PSSetShaderResources(slot_, 1u, pTextureView_.GetAddressOf());
+		GetState(gfx).SetPSShaderResource(slot_, pTextureView_.Get());
+	}
+
+	size_t Texture::GetMemoryCost() const noexcept
+	{
+		wrl::ComPtr<ID3D11Resource>  pResource;
+		wrl::ComPtr<ID3D11Texture2D> pTexture;
+		pTextureView_->GetResource(&pResource);
+		if (FAILED(pResource.As(&pTexture)))
+		{
+			return 0u;
+		}
+		D3D11_TEXTURE2D_DESC desc;
+		pTexture->GetDesc(&desc);
+		// BGRA, and the mip chain adds about a third
+		return size_t(desc.Width) * desc.Height * sizeof(Surface::Color) * 4u / 3u;
+	}
+
+	std::shared_ptr<Texture> Texture::Resolve(Graphics& gfx, const std::string& path, UINT slot, const Surface* pDecoded)
+	{
+		return Codex::Resolve<Texture>(gfx, path, slot, pDecoded);
+	}
+
+	CodexKey Texture::GenerateUID(const std::string& path, UINT slot)
+	{
+		// a texture is uniquely defined by its path and slot
+		return CodexKey::For<Texture>().Add(path).Add(slot);
+	}
+
+	// where the pixels came from does not make a texture different
+	CodexKey Texture::GenerateUID(const std::string& path, UINT slot, const Surface*)
+	{
+		return GenerateUID(path, slot);
 	}
 
-	std::shared_ptr<Texture> Texture::Resolve(Graphics& gfx, const std::string& path, UINT slot)
+	CodexKey Texture::GetUID() const noexcept
 	{
-		return Codex::Resolve<Texture>(gfx, path, slot);
+		return key_;
 	}
 
-	std::string Texture::GenerateUID(const std::string& path, UINT slot)
+	bool Texture::DependsOn(const std::string& path) const noexcept
 	{
-		using namespace std::string_literals;
-		// a texture is uniquely defined by its the name, path, and slot
-		return typeid(Texture).name() + "#"s + path + "#" + std::to_string(slot);
+		try
+		{
+			return FileWatcher::Normalize(path_) == path;
+		}
+		catch (...)
+		{
+			return false;
+		}
 	}
 
-	std::string Texture::GetUID() const noexcept
+	void Texture::Reload(Graphics& gfx)
 	{
-		return GenerateUID(path_, slot_);
+		// decode and create everything before letting go of the old view, so a half-written image leaves the texture as it was
+		const auto s  = Surface::FromFile(path_);
+		pTextureView_ = MakeView(gfx, s);
+		// meshes picked their shaders by the alpha of the image they were made with, so a change of alpha needs a model reload
+		hasAlpha = s.AlphaLoaded();
 	}
 
 	bool Texture::HasAlpha() const noexcept
@@ -1,22 +1,32 @@
 #pragma once
 #include "Bindable.h"
 
+class Surface;
+
 namespace D3DEngine
 {
 	class Texture : public Bindable
 	{
 		public:
-			Texture(Graphics& gfx, const std::string& path, UINT slot = 0);
+			// pDecoded: optionally hand over an image that was already decoded (e.g. on a loader thread) instead of loading it from path
+			Texture(Graphics& gfx, const std::string& path, UINT slot = 0, const Surface* pDecoded = nullptr);
 			void                            Bind(Graphics& gfx) noexcept override;
-			static std::shared_ptr<Texture> Resolve(Graphics& gfx, const std::string& path, UINT slot = 0);
-			static std::string              GenerateUID(const std::string& path, UINT slot = 0);
-			std::string                     GetUID() const noexcept override;
+			static std::shared_ptr<Texture> Resolve(Graphics& gfx, const std::string& path, UINT slot = 0, const Surface* pDecoded = nullptr);
+			static CodexKey                 GenerateUID(const std::string& path, UINT slot = 0);
+			static CodexKey                 GenerateUID(const std::string& path, UINT slot, const Surface* pDecoded);
+			CodexKey                        GetUID() const noexcept override;
+			bool                            DependsOn(const std::string& path) const noexcept override;
+			void                            Reload(Graphics& gfx) override;
+			size_t                          GetMemoryCost() const noexcept override;
 			bool                            HasAlpha() const noexcept;
+		private:
+			static Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> MakeView(Graphics& gfx, const Surface& s);
 		private:
 			unsigned int slot_;
 		protected:
 			bool                                             hasAlpha = false;
 			std::string                                      path_;
 			Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> pTextureView_;
+			CodexKey                                         key_;
 	};
 }
@@ -4,6 +4,12 @@
 
 namespace D3DEngine
 {
+	namespace
+	{
+		// the primitive topology enum is all there is to it
+		const bool recipe = Codex::RegisterRecipe<Topology, D3D11_PRIMITIVE_TOPOLOGY>("Topology");
+	}
+
 	Topology::Topology(Graphics& gfx, D3D11_PRIMITIVE_TOPOLOGY type)
 		:
 		type_(type)
@@ -12,7 +18,7 @@ namespace D3DEngine
 
 	void Topology::Bind(Graphics& gfx) noexcept
 	{
-		GetContext(gfx)->IASetPrimitiveTopology(type_);
+		GetState(gfx).SetPrimitiveTopology(type_);
 	}
 
 	std::shared_ptr<Topology> Topology::Resolve(Graphics& gfx, D3D11_PRIMITIVE_TOPOLOGY type)
@@ -20,13 +26,12 @@ namespace D3DEngine
 		return Codex::Resolve<Topology>(gfx, type);
 	}
 
-	std::string Topology::GenerateUID(D3D11_PRIMITIVE_TOPOLOGY type)
+	CodexKey Topology::GenerateUID(D3D11_PRIMITIVE_TOPOLOGY type)
 	{
-		using namespace std::string_literals;
-		return typeid(Topology).name() + "#"s + std::to_string(type);
+		return CodexKey::For<Topology>().Add(type);
 	}
 
-	std::string Topology::GetUID() const noexcept
+	CodexKey Topology::GetUID() const noexcept
 	{
 		return GenerateUID(type_);
 	}
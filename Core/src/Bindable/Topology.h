@@ -9,8 +9,8 @@ namespace D3DEngine
 			Topology(Graphics& gfx, D3D11_PRIMITIVE_TOPOLOGY type);
 			void                             Bind(Graphics& gfx) noexcept override;
 			static std::shared_ptr<Topology> Resolve(Graphics& gfx, D3D11_PRIMITIVE_TOPOLOGY type);
-			static std::string               GenerateUID(D3D11_PRIMITIVE_TOPOLOGY type);
-			std::string                      GetUID() const noexcept override;
+			static CodexKey                  GenerateUID(D3D11_PRIMITIVE_TOPOLOGY type);
+			CodexKey                         GetUID() const noexcept override;
 		protected:
 			D3D11_PRIMITIVE_TOPOLOGY type_;
 	};                          
@@ -12,8 +12,28 @@ namespace D3DEngine
 
 	VertexBuffer::VertexBuffer(Graphics& gfx, const std::string& tag, const RawVertexBufferWithLayout& vbuf)
 		:
-		stride_((UINT)vbuf.GetLayout().Size()),
-		tag_(tag)
+		tag_(tag),
+		layout_(vbuf.GetLayout()),
+		key_(GenerateUID_(tag))
+	{
+		AddStream(gfx, vbuf.GetData(), vbuf.SizeBytes(), (UINT)layout_.Size());
+	}
+
+	VertexBuffer::VertexBuffer(Graphics& gfx, const std::string& tag, const VertexStreams& streams)
+		:
+		tag_(tag),
+		layout_(streams.GetLayout()),
+		key_(GenerateUID_(tag))
+	{
+		assert(streams.GetStreamCount() <= D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT);
+		for (size_t i = 0; i < streams.GetStreamCount(); i++)
+		{
+			const auto stride = streams.GetStreamStride(i);
+			AddStream(gfx, streams.GetStreamData(i), stride * streams.Size(), (UINT)stride);
+		}
+	}
+
+	void VertexBuffer::AddStream(Graphics& gfx, const char* pData, size_t sizeBytes, UINT stride)
 	{
 		INFOMAN(gfx);
 
@@ -22,17 +42,23 @@ namespace D3DEngine
 		bd.Usage                  = D3D11_USAGE_DEFAULT;
 		bd.CPUAccessFlags         = 0u;
 		bd.MiscFlags              = 0u;
-		bd.ByteWidth              = UINT(vbuf.SizeBytes());
-		bd.StructureByteStride    = stride_;
+		bd.ByteWidth              = UINT(sizeBytes);
+		bd.StructureByteStride    = stride;
 		D3D11_SUBRESOURCE_DATA sd = {};
-		sd.pSysMem                = vbuf.GetData();
-		GFX_THROW_INFO(GetDevice(gfx)->CreateBuffer(&bd, &sd, &pVertexBuffer_));
+		sd.pSysMem                = pData;
+		GFX_THROW_INFO(GetDevice(gfx)->CreateBuffer(&bd, &sd, &pVertexBuffers_.emplace_back()));
+		strides_.push_back(stride);
+		sizeBytes_ += sizeBytes;
 	}
 
 	void VertexBuffer::Bind(Graphics& gfx) noexcept
 	{
-		const UINT offset = 0u;
-		GetContext(gfx)->IASetVertexBuffers(0u, 1u, pVertexBuffer_.GetAddressOf(), &stride_, &offset);
+		ID3D11Buffer* pBuffers[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+		for (size_t i = 0; i < pVertexBuffers_.size(); i++)
+		{
+			pBuffers[i] = pVertexBuffers_[i].Get();
+		}
+		GetState(gfx).SetVertexBuffers((UINT)pVertexBuffers_.size(), pBuffers, strides_.data());
 	}
 
 	std::shared_ptr<VertexBuffer> VertexBuffer::Resolve(Graphics&                        gfx,
@@ -43,14 +69,29 @@ namespace D3DEngine
 		return Codex::Resolve<VertexBuffer>(gfx, tag, vbuf);
 	}
 
-	std::string VertexBuffer::GenerateUID_(const std::string& tag)
+	std::shared_ptr<VertexBuffer> VertexBuffer::Resolve(Graphics& gfx, const std::string& tag, const VertexStreams& streams)
+	{
+		assert(tag != "?");
+		return Codex::Resolve<VertexBuffer>(gfx, tag, streams);
+	}
+
+	const DynamicVertexLayout& VertexBuffer::GetLayout() const noexcept
+	{
+		return layout_;
+	}
+
+	size_t VertexBuffer::GetMemoryCost() const noexcept
+	{
+		return sizeBytes_;
+	}
+
+	CodexKey VertexBuffer::GenerateUID_(const std::string& tag)
 	{
-		using namespace std::string_literals;
-		return typeid(VertexBuffer).name() + "#"s + tag;
+		return CodexKey::For<VertexBuffer>().Add(tag);
 	}
 
-	std::string VertexBuffer::GetUID() const noexcept
+	CodexKey VertexBuffer::GetUID() const noexcept
 	{
-		return GenerateUID(tag_);
+		return key_;
 	}
 }
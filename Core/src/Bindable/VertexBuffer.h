@@ -10,21 +10,31 @@ namespace D3DEngine
 		public:
 			VertexBuffer(Graphics& gfx, const std::string& tag, const RawVertexBufferWithLayout& vbuf);
 			VertexBuffer(Graphics& gfx, const RawVertexBufferWithLayout& vbuf);
+			// one buffer per stream, all bound together (input slot i gets stream i)
+			VertexBuffer(Graphics& gfx, const std::string& tag, const VertexStreams& streams);
 			void                                 Bind(Graphics& gfx) noexcept override;
 			static std::shared_ptr<VertexBuffer> Resolve(Graphics& gfx, const std::string& tag, const RawVertexBufferWithLayout& vbuf);
+			static std::shared_ptr<VertexBuffer> Resolve(Graphics& gfx, const std::string& tag, const VertexStreams& streams);
+			// what the buffer was made from, for the input layout to match (interleaved or streams)
+			const DynamicVertexLayout&           GetLayout() const noexcept;
+			size_t                               GetMemoryCost() const noexcept override;
 
 			template <typename...Ignore>
-			static std::string GenerateUID(const std::string& tag, Ignore&&...ignore)
+			static CodexKey GenerateUID(const std::string& tag, Ignore&&...ignore)
 			{
 				return GenerateUID_(tag);
 			}
 
-			std::string GetUID() const noexcept override;
+			CodexKey GetUID() const noexcept override;
 		private:
-			static std::string GenerateUID_(const std::string& tag);
+			static CodexKey    GenerateUID_(const std::string& tag);
+			void               AddStream(Graphics& gfx, const char* pData, size_t sizeBytes, UINT stride);
 		protected:
-			std::string                          tag_; // this tag serves as UID for the vertex buffer
-			UINT                                 stride_;
-			Microsoft::WRL::ComPtr<ID3D11Buffer> pVertexBuffer_;
+			std::string                                       tag_; // this tag serves as UID for the vertex buffer
+			DynamicVertexLayout                               layout_;
+			std::vector<UINT>                                 strides_;        // one per stream
+			std::vector<Microsoft::WRL::ComPtr<ID3D11Buffer>> pVertexBuffers_; // one per stream
+			size_t                                            sizeBytes_ = 0u; // of all streams
+			CodexKey                                          key_;
 	};
 }
@@ -1,14 +1,27 @@
 #include "VertexShader.h"
 #include "BindableCodex.h"
+#include "Utils/FileWatcher.h"
 #include "Debug/GraphicsThrowMacros.h"
 
 namespace D3DEngine
 {
 	using namespace std::string_literals;
 
+	namespace
+	{
+		// made again from the .cso path alone (the bytecode comes with it)
+		const bool recipe = Codex::RegisterRecipe<VertexShader, std::string>("VertexShader");
+	}
+
 	VertexShader::VertexShader(Graphics& gfx, const std::string& path)
 		:
-		path(path)
+		path(path),
+		key_(GenerateUID(path))
+	{
+		Load(gfx, pBytecodeBlob_, pVertexShader_);
+	}
+
+	void VertexShader::Load(Graphics& gfx, Microsoft::WRL::ComPtr<ID3DBlob>& pBytecodeBlob, Microsoft::WRL::ComPtr<ID3D11VertexShader>& pVertexShader) const
 	{
 		INFOMAN(gfx);
 
@@ -18,30 +31,24 @@ namespace D3DEngine
 			               // This will work only for ASCII
 			               std::wstring{ path.begin(),path.end() }.c_str(),
 			               // output handle for the blob
-			               &pBytecodeBlob_));
+			               &pBytecodeBlob));
 
 
 		GFX_THROW_INFO(GetDevice(gfx)->CreateVertexShader(
 			               // A pointer to the compiled shader
-			               pBytecodeBlob_->GetBufferPointer(),
+			               pBytecodeBlob->GetBufferPointer(),
 			               // Size of the compiled vertex shader
-			               pBytecodeBlob_->GetBufferSize(),
+			               pBytecodeBlob->GetBufferSize(),
 			               // A pointer to a class linkage interface
 			               nullptr,
 			               // Address of a pointer to a ID3D11VertexShader interface
-			               &pVertexShader_));
+			               &pVertexShader));
 	}
 
 	void VertexShader::Bind(Graphics& gfx) noexcept
 	{
-		// Set a vertex shader to the device
-		GetContext(gfx)->VSSetShader(
-		                             // Pointer to a vertex shader
-		                             pVertexShader_.Get(),
-		                             // A pointer to an array of class-instance interfaces
-		                             nullptr,
-		                             // The number of class-instance interfaces in the array
-		                             0u);
+		// Set a vertex shader (without class-instance interfaces) to the device
+		GetState(gfx).SetVertexShader(pVertexShader_.Get());
 	}
 
 	ID3DBlob* VertexShader::GetBytecode() const noexcept
@@ -49,6 +56,12 @@ namespace D3DEngine
 		return pBytecodeBlob_.Get();
 	}
 
+	size_t VertexShader::GetMemoryCost() const noexcept
+	{
+		// the bytecode we keep for input layouts, and about as much again for the shader object
+		return 2u * pBytecodeBlob_->GetBufferSize();
+	}
+
 	// call this function if you want to create a VertexShader
 	// we will have a resolve function per bindable
 	std::shared_ptr<VertexShader> VertexShader::Resolve(Graphics& gfx, const std::string& path)
@@ -61,15 +74,37 @@ namespace D3DEngine
 	 * \param path Shader path
 	 * \return A UID for this vertex shader
 	 */
-	std::string VertexShader::GenerateUID(const std::string& path)
+	CodexKey VertexShader::GenerateUID(const std::string& path)
+	{
+		return CodexKey::For<VertexShader>().Add(path);
+	}
+
+	bool VertexShader::DependsOn(const std::string& path) const noexcept
+	{
+		try
+		{
+			return FileWatcher::Normalize(this->path) == path;
+		}
+		catch (...)
+		{
+			return false;
+		}
+	}
+
+	void VertexShader::Reload(Graphics& gfx)
 	{
-		using namespace std::string_literals;
-		return typeid(VertexShader).name() + "#"s + path;
+		// load into fresh pointers first, so a half-written file leaves the shader as it was
+		Microsoft::WRL::ComPtr<ID3DBlob>           pBytecodeBlob;
+		Microsoft::WRL::ComPtr<ID3D11VertexShader> pVertexShader;
+		Load(gfx, pBytecodeBlob, pVertexShader);
+		// input layouts made from the old bytecode stay as they are, so the new shader has to keep its input signature
+		pBytecodeBlob_ = std::move(pBytecodeBlob);
+		pVertexShader_ = std::move(pVertexShader);
 	}
 
 	// provide a way to get the UID from an existing bindable (useful if we want to query for specific bindables)
-	std::string VertexShader::GetUID() const noexcept
+	CodexKey VertexShader::GetUID() const noexcept
 	{
-		return GenerateUID(path);
+		return key_;
 	}
 }
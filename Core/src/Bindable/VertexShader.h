@@ -9,12 +9,19 @@ namespace D3DEngine
 			VertexShader(Graphics& gfx, const std::string& path);
 			void                             Bind(Graphics& gfx) noexcept override;
 			ID3DBlob*                        GetBytecode() const noexcept;
+			size_t                           GetMemoryCost() const noexcept override;
 			static std::shared_ptr<VertexShader> Resolve(Graphics& gfx, const std::string& path);
-			static std::string               GenerateUID(const std::string& path);
-			std::string                      GetUID() const noexcept override;
+			static CodexKey                  GenerateUID(const std::string& path);
+			CodexKey                         GetUID() const noexcept override;
+			bool                             DependsOn(const std::string& path) const noexcept override;
+			void                             Reload(Graphics& gfx) override;
+		private:
+			// read the compiled shader at path and create the shader object from it
+			void Load(Graphics& gfx, Microsoft::WRL::ComPtr<ID3DBlob>& pBytecodeBlob, Microsoft::WRL::ComPtr<ID3D11VertexShader>& pVertexShader) const;
 		protected:
 			std::string                                path;
 			Microsoft::WRL::ComPtr<ID3DBlob>           pBytecodeBlob_;
 			Microsoft::WRL::ComPtr<ID3D11VertexShader> pVertexShader_;
+			CodexKey                                   key_;
 	};
 }
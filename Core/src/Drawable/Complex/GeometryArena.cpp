@@ -0,0 +1,72 @@
+#include "GeometryArena.h"
+#include <cassert>
+#include <climits>
+#include <unordered_map>
+
+namespace D3DEngine
+{
+	GeometryArena GeometryArena::Build(const ModelData& model, const std::string& tag, const Options& options)
+	{
+		// arenas are grown as raw bytes and only turned into vertex buffers at the end
+		struct Pending
+		{
+			std::string               tag;
+			DynamicVertexLayout       layout;
+			std::vector<char>         vertices;
+			size_t                    vertexCount = 0u;
+			std::vector<unsigned int> indices;
+		};
+
+		// streamed and interleaved buffers of the same geometry are different buffers
+		const auto prefix = options.streams ? tag + "%streams" : tag;
+
+		std::vector<Pending>                    pending;
+		std::unordered_map<std::string, size_t> arenaOf; // layout code (and index width) -> arena
+
+		GeometryArena result;
+		result.slices.reserve(model.meshes.size());
+		for (const auto& mesh : model.meshes)
+		{
+			const auto& layout = mesh.vertices.GetLayout();
+
+			// keep the meshes whose indices fit into 16 bits out of the arenas that need 32, so their index buffers stay half the size
+			const bool wide = mesh.vertices.Size() > 0x10000u;
+			const auto key = options.shared ? layout.GetCode() + (wide ? "#32" : "#16") : mesh.tag;
+
+			const auto [i, added] = arenaOf.emplace(key, pending.size());
+			if (added)
+			{
+				pending.push_back({prefix + (options.shared ? "%arena#" : "%mesh#") + std::to_string(pending.size()), layout});
+			}
+			auto& arena = pending[i->second];
+
+			assert(arena.vertexCount + mesh.vertices.Size() <= (size_t)INT_MAX && "arena too large for a base vertex");
+			assert(arena.indices.size() + mesh.indices.size() <= (size_t)UINT_MAX && "arena too large for a start index");
+
+			Slice slice;
+			slice.arena      = i->second;
+			slice.baseVertex = (int)arena.vertexCount;
+			slice.indices    = {(unsigned int)arena.indices.size(), (unsigned int)mesh.indices.size()};
+			arena.indices.insert(arena.indices.end(), mesh.indices.begin(), mesh.indices.end());
+			for (const auto& lod : mesh.lods)
+			{
+				slice.lods.push_back({(unsigned int)arena.indices.size(), (unsigned int)lod.indices.size()});
+				arena.indices.insert(arena.indices.end(), lod.indices.begin(), lod.indices.end());
+			}
+			arena.vertices.insert(arena.vertices.end(), mesh.vertices.GetData(), mesh.vertices.GetData() + mesh.vertices.SizeBytes());
+			arena.vertexCount += mesh.vertices.Size();
+			result.slices.push_back(std::move(slice));
+		}
+
+		result.arenas.reserve(pending.size());
+		for (auto& arena : pending)
+		{
+			result.arenas.push_back({
+				std::move(arena.tag),
+				RawVertexBufferWithLayout{arena.layout, arena.vertices.data(), arena.vertexCount},
+				std::move(arena.indices)
+			});
+		}
+		return result;
+	}
+}
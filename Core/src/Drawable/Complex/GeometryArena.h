@@ -0,0 +1,55 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "MeshData.h"
+
+namespace D3DEngine
+{
+	/**
+	 * \brief Lays out the geometry of a whole model in a few shared lists, one vertex list and one index list per vertex layout.
+	 * Each mesh is drawn from its slice with a base vertex and a start index, so drawing the model binds one vertex/index
+	 * buffer pair per layout instead of one per mesh. Indices stay relative to the mesh's own first vertex, which keeps them
+	 * 16-bit; meshes that need 32-bit indices share arenas of their own.
+	 */
+	class GeometryArena
+	{
+		public:
+			struct Options
+			{
+				bool shared  = true;  // false gives every mesh an arena of its own (one buffer pair per mesh)
+				bool streams = false; // vertex buffers with a stream per element (VertexStreams) instead of interleaved vertices
+			};
+
+			// part of an arena's index list
+			struct Range
+			{
+				unsigned int start;
+				unsigned int count;
+			};
+
+			// where a mesh ended up
+			struct Slice
+			{
+				size_t             arena;
+				int                baseVertex; // position of the mesh's first vertex in the arena's vertex list
+				Range              indices;    // full detail
+				std::vector<Range> lods;       // in the order of MeshData::lods
+			};
+
+			struct Arena
+			{
+				std::string               tag; // Codex tag of the arena's vertex and index buffer
+				RawVertexBufferWithLayout vertices;
+				std::vector<unsigned int> indices;
+			};
+
+			/**
+			 * \brief Pack every mesh of a model, in mesh order (so the result does not depend on anything but the model).
+			 * \param tag prefix of the arenas' Codex tags, naming the import: the model's path, plus its scale and import settings
+			 */
+			static GeometryArena Build(const ModelData& model, const std::string& tag, const Options& options);
+
+			std::vector<Arena> arenas;
+			std::vector<Slice> slices; // one per mesh of the model
+	};
+}
@@ -0,0 +1,1187 @@
+#include "GltfImporter.h"
+#include "Mesh.h"
+#include "TangentSpace.h"
+#include "Utils/MappedFile.h"
+#include "Utils/Parallel.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+namespace D3DEngine
+{
+	namespace dx = DirectX;
+
+	namespace
+	{
+		// ---------------------------------------------------------------------------
+		// JSON, just as much of it as glTF needs
+
+		struct Json
+		{
+			enum class Kind
+			{
+				Null,
+				Bool,
+				Number,
+				String,
+				Array,
+				Object,
+			};
+
+			Kind                                      kind    = Kind::Null;
+			bool                                      boolean = false;
+			double                                    number  = 0.0;
+			std::string                               string;
+			std::vector<Json>                         array;
+			std::vector<std::pair<std::string, Json>> object; // in file order; glTF objects are small enough to search linearly
+
+			// member of an object, nullptr if there is none
+			const Json* Find(std::string_view key) const noexcept
+			{
+				for (const auto& [name, value] : object)
+				{
+					if (name == key)
+					{
+						return &value;
+					}
+				}
+				return nullptr;
+			}
+
+			double Number(std::string_view key, double fallback) const noexcept
+			{
+				const auto* pValue = Find(key);
+				return pValue && pValue->kind == Kind::Number ? pValue->number : fallback;
+			}
+
+			// index into one of the document's top level arrays, -1 if there is none
+			int Index(std::string_view key) const noexcept
+			{
+				return (int)Number(key, -1.0);
+			}
+
+			const std::string& String(std::string_view key) const noexcept
+			{
+				static const std::string none;
+				const auto*              pValue = Find(key);
+				return pValue && pValue->kind == Kind::String ? pValue->string : none;
+			}
+
+			// elements of an array member, empty if there is none
+			const std::vector<Json>& Array(std::string_view key) const noexcept
+			{
+				static const std::vector<Json> none;
+				const auto*                    pValue = Find(key);
+				return pValue && pValue->kind == Kind::Array ? pValue->array : none;
+			}
+		};
+
+		class JsonParser
+		{
+			public:
+				JsonParser(const char* pBegin, const char* pEnd) noexcept
+					:
+					p_(pBegin),
+					end_(pEnd)
+				{
+				}
+
+				Json Parse()
+				{
+					// some exporters start the file with a UTF-8 byte order mark
+					if (end_ - p_ >= 3 && std::memcmp(p_, "\xEF\xBB\xBF", 3u) == 0)
+					{
+						p_ += 3;
+					}
+					auto document = Value(0);
+					SkipWhitespace();
+					if (p_ != end_)
+					{
+						Fail("unexpected characters after the document");
+					}
+					return document;
+				}
+
+			private:
+				static constexpr int maxDepth = 256;
+
+				[[noreturn]] static void Fail(const char* what)
+				{
+					throw ModelException(__LINE__, __FILE__, std::string("Malformed glTF JSON: ") + what);
+				}
+
+				void SkipWhitespace() noexcept
+				{
+					while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r'))
+					{
+						p_++;
+					}
+				}
+
+				bool Consume(char c) noexcept
+				{
+					SkipWhitespace();
+					if (p_ < end_ && *p_ == c)
+					{
+						p_++;
+						return true;
+					}
+					return false;
+				}
+
+				void Expect(char c, const char* what)
+				{
+					if (!Consume(c))
+					{
+						Fail(what);
+					}
+				}
+
+				void ExpectWord(std::string_view word)
+				{
+					if (size_t(end_ - p_) < word.size() || std::string_view(p_, word.size()) != word)
+					{
+						Fail("expected a value");
+					}
+					p_ += word.size();
+				}
+
+				Json Value(int depth)
+				{
+					if (depth > maxDepth)
+					{
+						Fail("nested too deeply");
+					}
+					SkipWhitespace();
+					if (p_ == end_)
+					{
+						Fail("unexpected end of file");
+					}
+
+					Json value;
+					switch (*p_)
+					{
+						case '{':
+							p_++;
+							value.kind = Json::Kind::Object;
+							if (!Consume('}'))
+							{
+								do
+								{
+									SkipWhitespace();
+									auto key = String();
+									Expect(':', "expected ':' after an object key");
+									value.object.emplace_back(std::move(key), Value(depth + 1));
+								}
+								while (Consume(','));
+								Expect('}', "expected ',' or '}' in an object");
+							}
+							break;
+						case '[':
+							p_++;
+							value.kind = Json::Kind::Array;
+							if (!Consume(']'))
+							{
+								do
+								{
+									value.array.push_back(Value(depth + 1));
+								}
+								while (Consume(','));
+								Expect(']', "expected ',' or ']' in an array");
+							}
+							break;
+						case '"':
+							value.kind   = Json::Kind::String;
+							value.string = String();
+							break;
+						case 't':
+							ExpectWord("true");
+							value.kind    = Json::Kind::Bool;
+							value.boolean = true;
+							break;
+						case 'f':
+							ExpectWord("false");
+							value.kind = Json::Kind::Bool;
+							break;
+						case 'n':
+							ExpectWord("null");
+							break;
+						default:
+						{
+							value.kind              = Json::Kind::Number;
+							const auto [end, error] = std::from_chars(p_, end_, value.number);
+							if (error != std::errc{})
+							{
+								Fail("expected a value");
+							}
+							p_ = end;
+							break;
+						}
+					}
+					return value;
+				}
+
+				std::string String()
+				{
+					if (p_ == end_ || *p_ != '"')
+					{
+						Fail("expected a string");
+					}
+					p_++;
+
+					std::string result;
+					while (true)
+					{
+						// everything up to the next quote or escape in one go (embedded buffers make up most of many files)
+						const char* start = p_;
+						while (p_ < end_ && *p_ != '"' && *p_ != '\\')
+						{
+							p_++;
+						}
+						result.append(start, p_);
+						if (end_ - p_ < 2)
+						{
+							if (p_ < end_ && *p_ == '"')
+							{
+								p_++;
+								return result;
+							}
+							Fail("unterminated string");
+						}
+						if (*p_++ == '"')
+						{
+							return result;
+						}
+						switch (const char c = *p_++)
+						{
+							case '"':
+							case '\\':
+							case '/':
+								result.push_back(c);
+								break;
+							case 'b':
+								result.push_back('\b');
+								break;
+							case 'f':
+								result.push_back('\f');
+								break;
+							case 'n':
+								result.push_back('\n');
+								break;
+							case 'r':
+								result.push_back('\r');
+								break;
+							case 't':
+								result.push_back('\t');
+								break;
+							case 'u':
+								AppendUtf8(result, CodePoint());
+								break;
+							default:
+								Fail("invalid escape sequence");
+						}
+					}
+				}
+
+				uint32_t Hex4()
+				{
+					if (end_ - p_ < 4)
+					{
+						Fail("unterminated string");
+					}
+					uint32_t value = 0u;
+					for (int i = 0; i < 4; i++, p_++)
+					{
+						const char c = *p_;
+						value <<= 4;
+						if (c >= '0' && c <= '9')
+						{
+							value |= uint32_t(c - '0');
+						}
+						else if (c >= 'a' && c <= 'f')
+						{
+							value |= uint32_t(c - 'a' + 10);
+						}
+						else if (c >= 'A' && c <= 'F')
+						{
+							value |= uint32_t(c - 'A' + 10);
+						}
+						else
+						{
+							Fail("invalid \\u escape");
+						}
+					}
+					return value;
+				}
+
+				// \uXXXX, joined with the low surrogate that follows a high one
+				uint32_t CodePoint()
+				{
+					const auto high = Hex4();
+					if (high < 0xD800u || high > 0xDBFFu)
+					{
+						return high;
+					}
+					if (end_ - p_ < 2 || p_[0] != '\\' || p_[1] != 'u')
+					{
+						Fail("unpaired surrogate");
+					}
+					p_ += 2;
+					const auto low = Hex4();
+					if (low < 0xDC00u || low > 0xDFFFu)
+					{
+						Fail("unpaired surrogate");
+					}
+					return 0x10000u + ((high - 0xD800u) << 10) + (low - 0xDC00u);
+				}
+
+				static void AppendUtf8(std::string& out, uint32_t codePoint)
+				{
+					if (codePoint < 0x80u)
+					{
+						out.push_back(char(codePoint));
+					}
+					else if (codePoint < 0x800u)
+					{
+						out.push_back(char(0xC0u | (codePoint >> 6)));
+						out.push_back(char(0x80u | (codePoint & 0x3Fu)));
+					}
+					else if (codePoint < 0x10000u)
+					{
+						out.push_back(char(0xE0u | (codePoint >> 12)));
+						out.push_back(char(0x80u | ((codePoint >> 6) & 0x3Fu)));
+						out.push_back(char(0x80u | (codePoint & 0x3Fu)));
+					}
+					else
+					{
+						out.push_back(char(0xF0u | (codePoint >> 18)));
+						out.push_back(char(0x80u | ((codePoint >> 12) & 0x3Fu)));
+						out.push_back(char(0x80u | ((codePoint >> 6) & 0x3Fu)));
+						out.push_back(char(0x80u | (codePoint & 0x3Fu)));
+					}
+				}
+
+			private:
+				const char*       p_;
+				const char* const end_;
+		};
+
+		// ---------------------------------------------------------------------------
+		// buffers and accessors
+
+		std::vector<char> DecodeBase64(std::string_view text)
+		{
+			static const auto table = []
+			{
+				std::array<int8_t, 256> t{};
+				t.fill(-1);
+				for (int i = 0; i < 26; i++)
+				{
+					t['A' + i] = int8_t(i);
+					t['a' + i] = int8_t(26 + i);
+				}
+				for (int i = 0; i < 10; i++)
+				{
+					t['0' + i] = int8_t(52 + i);
+				}
+				// the URL-safe alphabet as well
+				t['+'] = t['-'] = 62;
+				t['/'] = t['_'] = 63;
+				return t;
+			}();
+
+			std::vector<char> bytes;
+			bytes.reserve(text.size() / 4u * 3u);
+			uint32_t bits  = 0u;
+			int      nBits = 0;
+			for (const char c : text)
+			{
+				if (c == '=')
+				{
+					break;
+				}
+				const auto value = table[(unsigned char)c];
+				if (value < 0)
+				{
+					throw ModelException(__LINE__, __FILE__, "glTF data URI is not valid base64");
+				}
+				bits = (bits << 6) | uint32_t(value);
+				nBits += 6;
+				if (nBits >= 8)
+				{
+					nBits -= 8;
+					bytes.push_back(char((bits >> nBits) & 0xFFu));
+				}
+			}
+			return bytes;
+		}
+
+		// URIs in glTF are percent-encoded
+		std::string DecodeUri(std::string_view uri)
+		{
+			std::string path;
+			path.reserve(uri.size());
+			for (size_t i = 0; i < uri.size(); i++)
+			{
+				int value = 0;
+				if (uri[i] == '%' && i + 2u < uri.size() && std::from_chars(&uri[i + 1u], &uri[i + 3u], value, 16).ptr == &uri[i + 3u])
+				{
+					path.push_back(char(value));
+					i += 2u;
+				}
+				else
+				{
+					path.push_back(uri[i]);
+				}
+			}
+			return path;
+		}
+
+		// bytes of a glTF buffer: inside a mapping (an external .bin, or the BIN chunk of a .glb) or decoded from a data URI
+		struct Buffer
+		{
+			const char*       pData = nullptr;
+			size_t            size  = 0u;
+			std::vector<char> decoded;
+		};
+
+		struct Document
+		{
+			Json                                     json;
+			std::vector<Buffer>                      buffers;
+			std::vector<std::unique_ptr<MappedFile>> files; // keeps external buffers mapped while accessors are read
+		};
+
+		// element of one of the document's top level arrays
+		const Json& Element(const Json& json, std::string_view array, int index)
+		{
+			const auto& elements = json.Array(array);
+			if (index < 0 || size_t(index) >= elements.size())
+			{
+				throw ModelException(__LINE__, __FILE__, "glTF refers to " + std::string(array) + "[" + std::to_string(index) + "], which does not exist");
+			}
+			return elements[index];
+		}
+
+		enum ComponentType
+		{
+			componentByte          = 5120,
+			componentUnsignedByte  = 5121,
+			componentShort         = 5122,
+			componentUnsignedShort = 5123,
+			componentUnsignedInt   = 5125,
+			componentFloat         = 5126,
+		};
+
+		size_t ComponentSize(int type)
+		{
+			switch (type)
+			{
+				case componentByte:
+				case componentUnsignedByte:
+					return 1u;
+				case componentShort:
+				case componentUnsignedShort:
+					return 2u;
+				case componentUnsignedInt:
+				case componentFloat:
+					return 4u;
+				default:
+					throw ModelException(__LINE__, __FILE__, "glTF accessor has unknown component type " + std::to_string(type));
+			}
+		}
+
+		size_t ComponentCount(const std::string& type)
+		{
+			constexpr std::pair<std::string_view, size_t> counts[] = {
+				{"SCALAR", 1u}, {"VEC2", 2u}, {"VEC3", 3u}, {"VEC4", 4u}, {"MAT2", 4u}, {"MAT3", 9u}, {"MAT4", 16u}
+			};
+			for (const auto& [name, count] : counts)
+			{
+				if (type == name)
+				{
+					return count;
+				}
+			}
+			throw ModelException(__LINE__, __FILE__, "glTF accessor has unknown type \"" + type + "\"");
+		}
+
+		// strided view of an accessor's elements, straight over the buffer they live in
+		struct AccessorView
+		{
+			const char* pData         = nullptr; // element 0, nullptr for an accessor without a buffer view (all zeros)
+			size_t      stride        = 0u;
+			size_t      count         = 0u;
+			int         componentType = componentFloat;
+			size_t      components    = 1u;
+			bool        normalized    = false;
+
+			template <typename T>
+			T Read(size_t i, size_t c) const noexcept
+			{
+				T value;
+				std::memcpy(&value, pData + i * stride + c * sizeof(T), sizeof(T));
+				return value;
+			}
+
+			// component c of element i as a float (normalized integers map onto [0, 1] or [-1, 1])
+			float Get(size_t i, size_t c) const noexcept
+			{
+				if (!pData || c >= components)
+				{
+					return 0.0f;
+				}
+				switch (componentType)
+				{
+					case componentFloat:
+						return Read<float>(i, c);
+					case componentByte:
+						return normalized ? std::max(Read<int8_t>(i, c) / 127.0f, -1.0f) : Read<int8_t>(i, c);
+					case componentUnsignedByte:
+						return normalized ? Read<uint8_t>(i, c) / 255.0f : Read<uint8_t>(i, c);
+					case componentShort:
+						return normalized ? std::max(Read<int16_t>(i, c) / 32767.0f, -1.0f) : Read<int16_t>(i, c);
+					case componentUnsignedShort:
+						return normalized ? Read<uint16_t>(i, c) / 65535.0f : Read<uint16_t>(i, c);
+					default:
+						return (float)Read<uint32_t>(i, c);
+				}
+			}
+
+			unsigned GetIndex(size_t i) const noexcept
+			{
+				if (!pData)
+				{
+					return 0u;
+				}
+				switch (componentType)
+				{
+					case componentUnsignedByte:
+						return Read<uint8_t>(i, 0u);
+					case componentUnsignedShort:
+						return Read<uint16_t>(i, 0u);
+					default:
+						return Read<uint32_t>(i, 0u);
+				}
+			}
+
+			// whether the elements are plain floats, n of them, as the vertex layout stores them
+			bool IsFloats(size_t n) const noexcept
+			{
+				return pData && componentType == componentFloat && components == n;
+			}
+		};
+
+		AccessorView MakeView(const Document& document, int index)
+		{
+			const auto& accessor = Element(document.json, "accessors", index);
+			if (accessor.Find("sparse"))
+			{
+				throw ModelException(__LINE__, __FILE__, "glTF sparse accessors are not supported");
+			}
+
+			AccessorView view;
+			view.count              = (size_t)accessor.Number("count", 0.0);
+			view.componentType      = accessor.Index("componentType");
+			view.components         = ComponentCount(accessor.String("type"));
+			const auto* pNormalized = accessor.Find("normalized");
+			view.normalized         = pNormalized && pNormalized->boolean;
+			const auto elemSize     = ComponentSize(view.componentType) * view.components;
+			view.stride             = elemSize;
+			const auto viewIndex    = accessor.Index("bufferView");
+			if (viewIndex < 0 || view.count == 0u)
+			{
+				return view;
+			}
+
+			const auto& bufferView = Element(document.json, "bufferViews", viewIndex);
+			const auto  bufferId   = bufferView.Index("buffer");
+			if (bufferId < 0 || size_t(bufferId) >= document.buffers.size())
+			{
+				throw ModelException(__LINE__, __FILE__, "glTF buffer view " + std::to_string(viewIndex) + " refers to a buffer that does not exist");
+			}
+			const auto& buffer     = document.buffers[bufferId];
+			const auto  viewOffset = (size_t)bufferView.Number("byteOffset", 0.0);
+			const auto  viewLength = (size_t)bufferView.Number("byteLength", 0.0);
+			const auto  offset     = (size_t)accessor.Number("byteOffset", 0.0);
+			view.stride            = (size_t)bufferView.Number("byteStride", (double)elemSize);
+			if (viewOffset + viewLength > buffer.size || view.stride < elemSize || offset + view.stride * (view.count - 1u) + elemSize > viewLength)
+			{
+				throw ModelException(__LINE__, __FILE__, "glTF accessor " + std::to_string(index) + " reaches outside of its buffer");
+			}
+			view.pData = buffer.pData + viewOffset + offset;
+			return view;
+		}
+
+		// ---------------------------------------------------------------------------
+		// materials and meshes
+
+		// file an image texture refers to; images embedded in the file are left out, as textures are loaded from files
+		std::string TexturePath(const Json& json, const Json* pTextureInfo, const std::string& rootPath)
+		{
+			if (!pTextureInfo)
+			{
+				return {};
+			}
+			const auto& texture = Element(json, "textures", pTextureInfo->Index("index"));
+			const auto  source  = texture.Index("source");
+			if (source < 0)
+			{
+				return {};
+			}
+			const auto& uri = Element(json, "images", source).String("uri");
+			if (uri.empty() || uri.rfind("data:", 0u) == 0u)
+			{
+				return {};
+			}
+			return rootPath + DecodeUri(uri);
+		}
+
+		void ReadColor(const Json& material, std::string_view key, DirectX::XMFLOAT4& color)
+		{
+			const auto& factor = material.Array(key);
+			if (factor.size() >= 3u)
+			{
+				// read as a 3-component color (alpha untouched), as Model::ParseMesh gets it from Assimp
+				color = {(float)factor[0].number, (float)factor[1].number, (float)factor[2].number, color.w};
+			}
+		}
+
+		// the MaterialDesc Assimp's glTF importer leads to: base color as diffuse, smoothness as Phong exponent
+		MaterialDesc Describe(const Json& json, const Json& material, const std::string& rootPath)
+		{
+			const Json  none;
+			const auto* pPbr       = material.Find("pbrMetallicRoughness");
+			const auto* pExtension = material.Find("extensions");
+			const auto* pSpecGloss = pExtension ? pExtension->Find("KHR_materials_pbrSpecularGlossiness") : nullptr;
+			const auto& pbr        = pPbr ? *pPbr : none;
+
+			MaterialDesc desc;
+			// untextured glTF materials default to white
+			desc.diffuseColor = {1.0f, 1.0f, 1.0f, desc.diffuseColor.w};
+			desc.diffusePath  = TexturePath(json, pSpecGloss ? pSpecGloss->Find("diffuseTexture") : pbr.Find("baseColorTexture"), rootPath);
+			if (!desc.diffusePath.empty())
+			{
+				desc.hasDiffuseMap = true;
+			}
+			else
+			{
+				ReadColor(pSpecGloss ? *pSpecGloss : pbr, pSpecGloss ? "diffuseFactor" : "baseColorFactor", desc.diffuseColor);
+			}
+
+			if (pSpecGloss)
+			{
+				desc.specularPath = TexturePath(json, pSpecGloss->Find("specularGlossinessTexture"), rootPath);
+				if (!desc.specularPath.empty())
+				{
+					desc.hasSpecularMap = true;
+				}
+				else
+				{
+					desc.specularColor = {1.0f, 1.0f, 1.0f, desc.specularColor.w};
+					ReadColor(*pSpecGloss, "specularFactor", desc.specularColor);
+				}
+				desc.shininess = (float)pSpecGloss->Number("glossinessFactor", 1.0) * 1000.0f;
+			}
+			else
+			{
+				const float smoothness = 1.0f - (float)pbr.Number("roughnessFactor", 1.0);
+				desc.shininess         = smoothness * smoothness * 1000.0f;
+			}
+
+			desc.normalPath = TexturePath(json, material.Find("normalTexture"), rootPath);
+			desc.hasNormalMap = !desc.normalPath.empty();
+			return desc;
+		}
+
+		// the triangles of a primitive with their winding flipped (as the left-handed conversion does)
+		std::vector<unsigned int> Triangles(const Document& document, const Json& primitive, size_t vertexCount)
+		{
+			std::vector<unsigned int> corners;
+			const auto                indexAccessor = primitive.Index("indices");
+			if (indexAccessor >= 0)
+			{
+				const auto view = MakeView(document, indexAccessor);
+				corners.resize(view.count);
+				for (size_t i = 0; i < view.count; i++)
+				{
+					corners[i] = view.GetIndex(i);
+					if (corners[i] >= vertexCount)
+					{
+						throw ModelException(__LINE__, __FILE__, "glTF index " + std::to_string(corners[i]) + " is out of range");
+					}
+				}
+			}
+			else
+			{
+				corners.resize(vertexCount);
+				for (size_t i = 0; i < vertexCount; i++)
+				{
+					corners[i] = unsigned(i);
+				}
+			}
+
+			std::vector<unsigned int> triangles;
+			const auto                emit = [&triangles](unsigned a, unsigned b, unsigned c)
+			{
+				triangles.insert(triangles.end(), {c, b, a});
+			};
+			switch (primitive.Index("mode") < 0 ? 4 : primitive.Index("mode"))
+			{
+				case 4: // triangles
+					triangles.reserve(corners.size());
+					for (size_t i = 0; i + 2u < corners.size(); i += 3u)
+					{
+						emit(corners[i], corners[i + 1u], corners[i + 2u]);
+					}
+					break;
+				case 5: // triangle strip, every other triangle turned around to keep the winding
+					for (size_t i = 0; i + 2u < corners.size(); i++)
+					{
+						if (i % 2u == 0u)
+						{
+							emit(corners[i], corners[i + 1u], corners[i + 2u]);
+						}
+						else
+						{
+							emit(corners[i + 1u], corners[i], corners[i + 2u]);
+						}
+					}
+					break;
+				case 6: // triangle fan
+					for (size_t i = 1; i + 1u < corners.size(); i++)
+					{
+						emit(corners[0], corners[i], corners[i + 1u]);
+					}
+					break;
+				default:
+					break;
+			}
+			return triangles;
+		}
+
+		// one attribute of every vertex, written straight into its column of the interleaved buffer
+		template <DynamicVertexLayout::ElementType Type, typename F>
+		void WriteColumn(RawVertexBufferWithLayout& vertices, F&& value)
+		{
+			using SysType      = typename DynamicVertexLayout::Map<Type>::SysType;
+			const auto& layout = vertices.GetLayout();
+			const auto  stride = layout.Size();
+			char*       pData  = vertices.GetData() + layout.Resolve<Type>().GetOffset();
+			for (size_t i = 0; i < vertices.Size(); i++)
+			{
+				const SysType element = value(i);
+				std::memcpy(pData + i * stride, &element, sizeof(SysType));
+			}
+		}
+
+		// mirror of a glTF direction in the left-handed convention
+		dx::XMFLOAT3 Mirrored(const AccessorView& view, size_t i) noexcept
+		{
+			return {view.Get(i, 0u), view.Get(i, 1u), -view.Get(i, 2u)};
+		}
+
+		MeshData BuildMesh(const Document& document, const Json& primitive, MaterialDesc material, std::string tag, float scale)
+		{
+			const auto* pAttributes = primitive.Find("attributes");
+			const auto  attribute   = [&](std::string_view name) -> std::optional<AccessorView>
+			{
+				const auto index = pAttributes ? pAttributes->Index(name) : -1;
+				return index >= 0 ? std::optional<AccessorView>(MakeView(document, index)) : std::nullopt;
+			};
+			const auto position = attribute("POSITION");
+			if (!position)
+			{
+				throw ModelException(__LINE__, __FILE__, "glTF primitive of " + tag + " has no positions");
+			}
+			const auto normal   = attribute("NORMAL");
+			const auto texcoord = attribute("TEXCOORD_0");
+			const auto tangent  = attribute("TANGENT");
+			const auto count    = position->count;
+			for (const auto* pView : {&normal, &texcoord, &tangent})
+			{
+				if (*pView && (*pView)->count != count)
+				{
+					throw ModelException(__LINE__, __FILE__, "glTF primitive of " + tag + " has attributes of different lengths");
+				}
+			}
+			auto indices = Triangles(document, primitive, count);
+
+			// same layouts as Model::ParseMesh picks
+			const bool          tangentFrame = material.hasDiffuseMap && material.hasNormalMap;
+			DynamicVertexLayout layout;
+			layout.Append(DynamicVertexLayout::Position3D).Append(DynamicVertexLayout::Normal);
+			if (tangentFrame)
+			{
+				layout.Append(DynamicVertexLayout::Tangent).Append(DynamicVertexLayout::Bitangent).Append(DynamicVertexLayout::Texture2D);
+			}
+			else if (material.hasDiffuseMap)
+			{
+				layout.Append(DynamicVertexLayout::Texture2D);
+			}
+			else if (material.hasNormalMap || material.hasSpecularMap)
+			{
+				throw std::runtime_error("terrible combination of textures in material smh");
+			}
+
+			// positions, normals (and texcoords) interleaved exactly like the layout: take the block over as it is and only
+			// fix up handedness and scale in place
+			const auto sits = [&](const std::optional<AccessorView>& view, size_t n, size_t element)
+			{
+				return view && view->IsFloats(n) && view->stride == layout.Size() &&
+				       view->pData - position->pData == ptrdiff_t(layout.ResolveByIndex(element).GetOffset());
+			};
+			if (!tangentFrame && count > 0u && sits(position, 3u, 0u) && sits(normal, 3u, 1u) && (!material.hasDiffuseMap || sits(texcoord, 2u, 2u)))
+			{
+				RawVertexBufferWithLayout vbuf(std::move(layout), position->pData, count);
+				for (size_t i = 0; i < count; i++)
+				{
+					auto  vertex = vbuf[i];
+					auto& p      = vertex.Attr<DynamicVertexLayout::Position3D>();
+					p            = {p.x * scale, p.y * scale, -p.z * scale};
+					vertex.Attr<DynamicVertexLayout::Normal>().z *= -1.0f;
+				}
+				return {std::move(tag), std::move(material), std::move(vbuf), std::move(indices)};
+			}
+
+			// everything else is transcoded one attribute at a time
+			RawVertexBufferWithLayout vbuf(std::move(layout), count);
+			WriteColumn<DynamicVertexLayout::Position3D>(vbuf, [&](size_t i)
+			{
+				const auto p = Mirrored(*position, i);
+				return dx::XMFLOAT3{p.x * scale, p.y * scale, p.z * scale};
+			});
+
+			// flat normals for primitives that come without any (a vertex shared by several faces keeps its last one)
+			std::vector<dx::XMFLOAT3> normals(count);
+			if (normal)
+			{
+				for (size_t i = 0; i < count; i++)
+				{
+					normals[i] = Mirrored(*normal, i);
+				}
+			}
+			else
+			{
+				for (size_t t = 0; t < indices.size(); t += 3u)
+				{
+					const auto p0 = dx::XMLoadFloat3(&vbuf[indices[t]].Attr<DynamicVertexLayout::Position3D>());
+					const auto p1 = dx::XMLoadFloat3(&vbuf[indices[t + 1u]].Attr<DynamicVertexLayout::Position3D>());
+					const auto p2 = dx::XMLoadFloat3(&vbuf[indices[t + 2u]].Attr<DynamicVertexLayout::Position3D>());
+					dx::XMFLOAT3 n;
+					dx::XMStoreFloat3(&n, dx::XMVector3Normalize(dx::XMVector3Cross(p1 - p0, p2 - p0)));
+					for (size_t k = 0; k < 3u; k++)
+					{
+						normals[indices[t + k]] = n;
+					}
+				}
+			}
+			WriteColumn<DynamicVertexLayout::Normal>(vbuf, [&](size_t i) { return normals[i]; });
+
+			if (material.hasDiffuseMap)
+			{
+				// Assimp flips v on the way in and the left-handed conversion flips it back
+				WriteColumn<DynamicVertexLayout::Texture2D>(vbuf, [&](size_t i)
+				{
+					return texcoord ? dx::XMFLOAT2{texcoord->Get(i, 0u), texcoord->Get(i, 1u)} : dx::XMFLOAT2{};
+				});
+			}
+
+			if (tangentFrame)
+			{
+				std::vector<dx::XMFLOAT3> tangents(count), bitangents(count);
+				if (tangent)
+				{
+					// the bitangent follows from the normal and the handedness in w, taken in glTF's own convention and then mirrored
+					for (size_t i = 0; i < count; i++)
+					{
+						const auto   n = dx::XMVectorSet(normals[i].x, normals[i].y, -normals[i].z, 0.0f);
+						const auto   t = dx::XMVectorSet(tangent->Get(i, 0u), tangent->Get(i, 1u), tangent->Get(i, 2u), 0.0f);
+						dx::XMFLOAT3 b;
+						dx::XMStoreFloat3(&b, dx::XMVector3Cross(n, t) * tangent->Get(i, 3u));
+						tangents[i]   = Mirrored(*tangent, i);
+						bitangents[i] = {b.x, b.y, -b.z};
+					}
+				}
+				else
+				{
+					std::vector<dx::XMFLOAT3> positions(count);
+					std::vector<dx::XMFLOAT2> texcoords(count);
+					for (size_t i = 0; i < count; i++)
+					{
+						positions[i] = vbuf[i].Attr<DynamicVertexLayout::Position3D>();
+						texcoords[i] = vbuf[i].Attr<DynamicVertexLayout::Texture2D>();
+					}
+					TangentSpace::Compute(positions, normals, texcoords, indices, tangents, bitangents);
+				}
+				WriteColumn<DynamicVertexLayout::Tangent>(vbuf, [&](size_t i) { return tangents[i]; });
+				WriteColumn<DynamicVertexLayout::Bitangent>(vbuf, [&](size_t i) { return bitangents[i]; });
+			}
+			return {std::move(tag), std::move(material), std::move(vbuf), std::move(indices)};
+		}
+
+		// ---------------------------------------------------------------------------
+		// nodes
+
+		// the node's matrix, or T * R * S, in DirectXMath's row-vector convention and mirrored into the left-handed one
+		dx::XMFLOAT4X4 LocalTransform(const Json& node)
+		{
+			dx::XMMATRIX transform;
+			if (const auto& matrix = node.Array("matrix"); matrix.size() == 16u)
+			{
+				// column-major storage of a column-vector matrix is row-major storage of its transpose
+				dx::XMFLOAT4X4 m;
+				for (size_t i = 0; i < 16u; i++)
+				{
+					(&m._11)[i] = (float)matrix[i].number;
+				}
+				transform = dx::XMLoadFloat4x4(&m);
+			}
+			else
+			{
+				const auto vector = [&node](std::string_view key, dx::XMFLOAT4 value)
+				{
+					const auto& elements = node.Array(key);
+					float*      pValue   = &value.x;
+					for (size_t i = 0; i < std::min<size_t>(elements.size(), 4u); i++)
+					{
+						pValue[i] = (float)elements[i].number;
+					}
+					return dx::XMLoadFloat4(&value);
+				};
+				transform = dx::XMMatrixScalingFromVector(vector("scale", {1.0f, 1.0f, 1.0f, 0.0f})) *
+				            dx::XMMatrixRotationQuaternion(vector("rotation", {0.0f, 0.0f, 0.0f, 1.0f})) *
+				            dx::XMMatrixTranslationFromVector(vector("translation", {0.0f, 0.0f, 0.0f, 0.0f}));
+			}
+			const auto     mirror = dx::XMMatrixScaling(1.0f, 1.0f, -1.0f);
+			dx::XMFLOAT4X4 result;
+			dx::XMStoreFloat4x4(&result, mirror * transform * mirror);
+			return result;
+		}
+	}
+
+	bool GltfImporter::CanImport(const std::string& pathString) noexcept
+	{
+		auto extension = std::filesystem::path(pathString).extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](char c)
+		{
+			return c >= 'A' && c <= 'Z' ? char(c - 'A' + 'a') : c;
+		});
+		return extension == ".gltf" || extension == ".glb";
+	}
+
+	ModelData GltfImporter::Import(const std::string& pathString, float scale, size_t nWorkers)
+	{
+		const MappedFile file{pathString};
+		if (!file.IsOpen())
+		{
+			throw ModelException(__LINE__, __FILE__, "Unable to open file \"" + pathString + "\".");
+		}
+		const std::filesystem::path path     = pathString;
+		const auto                  rootPath = path.parent_path().string() + "\\";
+
+		// a .glb is a 12 byte header and chunks: the JSON, then optionally the binary data of the first buffer
+		const char* pJson    = file.GetData();
+		size_t      jsonSize = file.GetSize();
+		const char* pBin     = nullptr;
+		size_t      binSize  = 0u;
+		if (file.GetSize() >= 12u && std::memcmp(file.GetData(), "glTF", 4u) == 0)
+		{
+			const auto word = [&file](size_t offset)
+			{
+				uint32_t value;
+				std::memcpy(&value, file.GetData() + offset, sizeof(value));
+				return value;
+			};
+			const size_t length = std::min<size_t>(word(8u), file.GetSize());
+			pJson               = nullptr;
+			for (size_t offset = 12u; offset + 8u <= length;)
+			{
+				const size_t chunkSize = word(offset);
+				const auto   chunkType = word(offset + 4u);
+				if (chunkSize > length - offset - 8u)
+				{
+					throw ModelException(__LINE__, __FILE__, "GLB chunk runs past the end of \"" + pathString + "\"");
+				}
+				if (chunkType == 0x4E4F534Au && !pJson)
+				{
+					pJson    = file.GetData() + offset + 8u;
+					jsonSize = chunkSize;
+				}
+				else if (chunkType == 0x004E4942u && !pBin)
+				{
+					pBin    = file.GetData() + offset + 8u;
+					binSize = chunkSize;
+				}
+				// chunks are padded to 4 bytes
+				offset += 8u + (chunkSize + 3u) / 4u * 4u;
+			}
+			if (!pJson)
+			{
+				throw ModelException(__LINE__, __FILE__, "GLB \"" + pathString + "\" has no JSON chunk");
+			}
+		}
+
+		Document document;
+		document.json = JsonParser(pJson, pJson + jsonSize).Parse();
+
+		const auto& bufferList = document.json.Array("buffers");
+		document.buffers.resize(bufferList.size());
+		for (size_t i = 0; i < bufferList.size(); i++)
+		{
+			auto&       buffer = document.buffers[i];
+			const auto& uri    = bufferList[i].String("uri");
+			if (uri.empty())
+			{
+				if (i != 0u || !pBin)
+				{
+					throw ModelException(__LINE__, __FILE__, "glTF buffer " + std::to_string(i) + " has neither a URI nor a GLB chunk");
+				}
+				buffer.pData = pBin;
+				buffer.size  = binSize;
+			}
+			else if (uri.rfind("data:", 0u) == 0u)
+			{
+				const auto comma = uri.find(";base64,");
+				if (comma == std::string::npos)
+				{
+					throw ModelException(__LINE__, __FILE__, "glTF buffer " + std::to_string(i) + " is a data URI without base64 data");
+				}
+				buffer.decoded = DecodeBase64(std::string_view(uri).substr(comma + 8u));
+				buffer.pData   = buffer.decoded.data();
+				buffer.size    = buffer.decoded.size();
+			}
+			else
+			{
+				const auto& bin = document.files.emplace_back(std::make_unique<MappedFile>((path.parent_path() / DecodeUri(uri)).string()));
+				if (!bin->IsOpen())
+				{
+					throw ModelException(__LINE__, __FILE__, "Unable to open glTF buffer \"" + uri + "\".");
+				}
+				buffer.pData = bin->GetData();
+				buffer.size  = bin->GetSize();
+			}
+			if (buffer.size < (size_t)bufferList[i].Number("byteLength", 0.0))
+			{
+				throw ModelException(__LINE__, __FILE__, "glTF buffer " + std::to_string(i) + " is shorter than its byteLength");
+			}
+		}
+
+		// one mesh per triangle primitive, named like Assimp names them; points and lines do not make it into triangle lists
+		struct Primitive
+		{
+			const Json* pPrimitive;
+			std::string tag;
+		};
+		const auto&                        meshes = document.json.Array("meshes");
+		std::vector<Primitive>             primitives;
+		std::vector<std::vector<unsigned>> meshPrimitives(meshes.size());
+		for (size_t m = 0; m < meshes.size(); m++)
+		{
+			const auto  name = meshes[m].String("name").empty() ? "meshes_" + std::to_string(m) : meshes[m].String("name");
+			const auto& list = meshes[m].Array("primitives");
+			for (size_t p = 0; p < list.size(); p++)
+			{
+				if (list[p].Index("mode") >= 0 && list[p].Index("mode") < 4)
+				{
+					continue;
+				}
+				meshPrimitives[m].push_back(unsigned(primitives.size()));
+				primitives.push_back({&list[p], path.string() + "%" + name + (list.size() > 1u ? "-" + std::to_string(p) : "")});
+			}
+		}
+
+		std::vector<std::optional<MeshData>> built(primitives.size());
+		ParallelFor(built.size(), nWorkers, [&](size_t i)
+		{
+			const auto& primitive = *primitives[i].pPrimitive;
+			const auto  index     = primitive.Index("material");
+			const auto  material  = Describe(document.json, index >= 0 ? Element(document.json, "materials", index) : Json{}, rootPath);
+			built[i].emplace(BuildMesh(document, primitive, material, primitives[i].tag, scale));
+		});
+
+		ModelData data;
+		data.meshes.reserve(built.size());
+		for (auto& mesh : built)
+		{
+			data.meshes.push_back(std::move(*mesh));
+		}
+
+		const auto&       nodes = document.json.Array("nodes");
+		std::vector<char> visiting(nodes.size(), false);
+		const auto        makeNode = [&](auto& self, int index) -> NodeData
+		{
+			const auto& node = Element(document.json, "nodes", index);
+			// a cycle would recurse forever
+			if (visiting[index])
+			{
+				throw ModelException(__LINE__, __FILE__, "glTF node " + std::to_string(index) + " is its own ancestor");
+			}
+			visiting[index] = true;
+
+			NodeData result;
+			result.name      = node.String("name").empty() ? "nodes_" + std::to_string(index) : node.String("name");
+			result.transform = LocalTransform(node);
+			if (const auto mesh = node.Index("mesh"); mesh >= 0)
+			{
+				Element(document.json, "meshes", mesh);
+				result.meshIndices = meshPrimitives[mesh];
+			}
+			for (const auto& child : node.Array("children"))
+			{
+				result.children.push_back(self(self, (int)child.number));
+			}
+
+			visiting[index] = false;
+			return result;
+		};
+
+		// the scene's nodes (every node nobody parents if there is no scene); several of them go under a common root
+		std::vector<int> roots;
+		if (const auto& scenes = document.json.Array("scenes"); !scenes.empty())
+		{
+			for (const auto& node : Element(document.json, "scenes", std::max(document.json.Index("scene"), 0)).Array("nodes"))
+			{
+				roots.push_back((int)node.number);
+			}
+		}
+		else
+		{
+			std::vector<char> isChild(nodes.size(), false);
+			for (const auto& node : nodes)
+			{
+				for (const auto& child : node.Array("children"))
+				{
+					isChild.at((size_t)child.number) = true;
+				}
+			}
+			for (size_t i = 0; i < nodes.size(); i++)
+			{
+				if (!isChild[i])
+				{
+					roots.push_back(int(i));
+				}
+			}
+		}
+		if (roots.size() == 1u)
+		{
+			data.root = makeNode(makeNode, roots[0]);
+		}
+		else
+		{
+			data.root.name = "ROOT";
+			dx::XMStoreFloat4x4(&data.root.transform, dx::XMMatrixIdentity());
+			for (const auto root : roots)
+			{
+				data.root.children.push_back(makeNode(makeNode, root));
+			}
+		}
+		return data;
+	}
+}
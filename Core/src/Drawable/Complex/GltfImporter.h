@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+#include "MeshData.h"
+
+namespace D3DEngine
+{
+	/**
+	 * \brief glTF 2.0 reader (.gltf with external or embedded buffers, and binary .glb), used instead of Assimp for those files.
+	 * Binary buffers are memory mapped and accessors are read in place through strided views. Vertices whose attributes are
+	 * already interleaved like the layout we upload are taken over as one block; anything else is transcoded a column at a time.
+	 * It yields the meshes and nodes Assimp gives us with the flags Model::Import uses, like ObjImporter does for .obj files.
+	 */
+	class GltfImporter
+	{
+		public:
+			// judged by the extension alone (.gltf or .glb)
+			static bool CanImport(const std::string& pathString) noexcept;
+			/**
+			 * \brief Parse a glTF file into raw (unoptimized) meshes and its node hierarchy.
+			 * Every triangle primitive becomes a mesh, in the order Assimp produces them, and nodes keep their matrix (or
+			 * TRS) transform relative to their parent. Errors are thrown as ModelException.
+			 */
+			static ModelData Import(const std::string& pathString, float scale, size_t nWorkers);
+	};
+}
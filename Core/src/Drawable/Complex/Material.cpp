@@ -0,0 +1,214 @@
+#include "Material.h"
+#include "Bindable/ConstantBuffers.h"
+#include <cassert>
+#include <cstring>
+
+namespace D3DEngine
+{
+	namespace
+	{
+		// FNV-1a
+		void HashBytes(size_t& hash, const void* pData, size_t size) noexcept
+		{
+			const auto pBytes = static_cast<const unsigned char*>(pData);
+			for (size_t i = 0; i < size; i++)
+			{
+				hash = (hash ^ pBytes[i]) * 1099511628211ull;
+			}
+		}
+
+		float Average(const DirectX::XMFLOAT4& color) noexcept
+		{
+			return (color.x + color.y + color.z) / 3.0f;
+		}
+	}
+
+	Material Material::FromDesc(const MaterialDesc& desc)
+	{
+		// gloss in the specular map's alpha overrides the material's Ns
+		const float shininess = desc.hasAlphaGloss ? 2.0f : desc.shininess;
+
+		Material material;
+		material.hasAlphaDiffuse = desc.hasAlphaDiffuse;
+		material.diffusePath     = desc.hasDiffuseMap ? desc.diffusePath : "";
+		material.specularPath    = desc.hasSpecularMap ? desc.specularPath : "";
+		material.normalPath      = desc.hasNormalMap ? desc.normalPath : "";
+
+		if (desc.hasDiffuseMap && desc.hasNormalMap && desc.hasSpecularMap)
+		{
+			PhongConstants::Fullmonte pmc;
+			pmc.specularPower  = shininess;
+			pmc.hasGlossMap    = desc.hasAlphaGloss ? TRUE : FALSE;
+			material.constants = pmc;
+		}
+		else if (desc.hasDiffuseMap && desc.hasNormalMap)
+		{
+			PhongConstants::DiffuseNormal pmc;
+			pmc.specularPower     = shininess;
+			pmc.specularIntensity = Average(desc.specularColor);
+			material.constants    = pmc;
+		}
+		else if (desc.hasDiffuseMap && desc.hasSpecularMap)
+		{
+			PhongConstants::DiffuseSpecular pmc;
+			pmc.specularPowerConst = shininess;
+			pmc.hasGloss           = desc.hasAlphaGloss ? TRUE : FALSE;
+			material.constants     = pmc;
+		}
+		else if (desc.hasDiffuseMap)
+		{
+			PhongConstants::Diffuse pmc;
+			pmc.specularPower     = shininess;
+			pmc.specularIntensity = Average(desc.specularColor);
+			material.constants    = pmc;
+		}
+		else if (!desc.hasNormalMap && !desc.hasSpecularMap)
+		{
+			PhongConstants::Untextured pmc;
+			pmc.specularPower  = shininess;
+			pmc.specularColor  = desc.specularColor;
+			pmc.materialColor  = desc.diffuseColor;
+			material.constants = pmc;
+		}
+		else
+		{
+			throw std::runtime_error("terrible combination of textures in material smh");
+		}
+		return material;
+	}
+
+	size_t Material::Hash() const noexcept
+	{
+		size_t     hash  = 14695981039346656037ull;
+		const auto index = constants.index();
+		HashBytes(hash, &index, sizeof(index));
+		std::visit([&hash](const auto& c) { HashBytes(hash, &c, sizeof(c)); }, constants);
+		HashBytes(hash, &hasAlphaDiffuse, sizeof(hasAlphaDiffuse));
+		for (const auto* pPath : {&diffusePath, &specularPath, &normalPath})
+		{
+			// the length keeps ("ab", "c") apart from ("a", "bc")
+			const auto length = pPath->size();
+			HashBytes(hash, &length, sizeof(length));
+			HashBytes(hash, pPath->data(), length);
+		}
+		return hash;
+	}
+
+	bool Material::operator==(const Material& other) const noexcept
+	{
+		if (constants.index() != other.constants.index())
+		{
+			return false;
+		}
+		const bool sameConstants = std::visit([&other](const auto& c)
+		{
+			return memcmp(&c, &std::get<std::decay_t<decltype(c)>>(other.constants), sizeof(c)) == 0;
+		}, constants);
+		return sameConstants && hasAlphaDiffuse == other.hasAlphaDiffuse &&
+		       diffusePath == other.diffusePath && specularPath == other.specularPath && normalPath == other.normalPath;
+	}
+
+	MaterialTable::Id MaterialTable::Intern(const Material& material)
+	{
+		auto&      table = Instance();
+		const auto hash  = material.Hash();
+		for (auto [i, end] = table.byHash_.equal_range(hash); i != end; ++i)
+		{
+			if (table.materials_[i->second] == material)
+			{
+				return i->second;
+			}
+		}
+
+		const auto id = (Id)table.materials_.size();
+		table.materials_.push_back(material);
+		table.constants_.emplace_back();
+		table.owned_.push_back(false);
+		table.byHash_.emplace(hash, id);
+		return id;
+	}
+
+	MaterialTable::Id MaterialTable::Own(const Material& material)
+	{
+		auto& table = Instance();
+		if (!table.freeOwned_.empty())
+		{
+			const auto id = table.freeOwned_.back();
+			table.freeOwned_.pop_back();
+			table.materials_[id] = material;
+			return id;
+		}
+
+		const auto id = (Id)table.materials_.size();
+		table.materials_.push_back(material);
+		table.constants_.emplace_back();
+		table.owned_.push_back(true);
+		return id;
+	}
+
+	bool MaterialTable::IsOwned(Id id) noxnd
+	{
+		return Instance().owned_.at(id);
+	}
+
+	void MaterialTable::SetConstants(Graphics& gfx, Id id, const Material::Constants& constants)
+	{
+		auto& table    = Instance();
+		auto& material = table.materials_.at(id);
+		assert("Only owned materials can change" && table.owned_[id]);
+		assert("Material of another permutation" && constants.index() == material.constants.index());
+		material.constants = constants;
+		if (const auto& pConstant = table.constants_[id])
+		{
+			// ResolveConstants made it from the same alternative
+			std::visit([&gfx, &pConstant](const auto& c)
+			{
+				static_cast<PixelConstantBuffer<std::decay_t<decltype(c)>>&>(*pConstant).Update(gfx, c);
+			}, constants);
+		}
+	}
+
+	void MaterialTable::Release(Id id) noexcept
+	{
+		auto& table = Instance();
+		if (id < table.owned_.size() && table.owned_[id])
+		{
+			// the buffer goes once the last mesh drawing with it lets go
+			table.constants_[id].reset();
+			table.freeOwned_.push_back(id);
+		}
+	}
+
+	const Material& MaterialTable::Get(Id id) noxnd
+	{
+		return Instance().materials_.at(id);
+	}
+
+	std::shared_ptr<Bindable> MaterialTable::ResolveConstants(Graphics& gfx, Id id)
+	{
+		auto& table     = Instance();
+		auto& pConstant = table.constants_.at(id);
+		if (!pConstant)
+		{
+			pConstant = std::visit([&gfx](const auto& c) -> std::shared_ptr<Bindable>
+			{
+				auto pConstants = std::make_shared<PixelConstantBuffer<std::decay_t<decltype(c)>>>(gfx, c, 1u);
+				// passed on as a plain Bindable, so the mesh's QueryBindable finds it by this type
+				Bindable::Identify(*pConstants);
+				return pConstants;
+			}, table.materials_[id].constants);
+		}
+		return pConstant;
+	}
+
+	size_t MaterialTable::Size() noexcept
+	{
+		return Instance().materials_.size();
+	}
+
+	MaterialTable& MaterialTable::Instance()
+	{
+		static MaterialTable table;
+		return table;
+	}
+}
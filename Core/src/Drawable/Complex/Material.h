@@ -0,0 +1,130 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+#include "MeshData.h"
+#include "Bindable/Bindable.h"
+
+namespace D3DEngine
+{
+	/**
+	 * \brief Pixel constant buffers (slot 1) of the Phong permutations, one for every combination of maps we can draw
+	 */
+	struct PhongConstants
+	{
+		// diffuse, specular and normal map
+		struct Fullmonte
+		{
+			BOOL              normalMapEnabled   = TRUE;
+			BOOL              specularMapEnabled = TRUE;
+			BOOL              hasGlossMap        = FALSE;
+			float             specularPower      = 3.1f;
+			DirectX::XMFLOAT3 specularColor      = {0.75f, 0.75f, 0.75f};
+			float             specularMapWeight  = 0.671f;
+		};
+
+		// diffuse and normal map
+		struct DiffuseNormal
+		{
+			float specularIntensity = 0.18f;
+			float specularPower     = 2.0f;
+			BOOL  normalMapEnabled  = TRUE;
+			float padding[1]        = {};
+		};
+
+		// diffuse and specular map
+		struct DiffuseSpecular
+		{
+			float specularPowerConst = 2.0f;
+			BOOL  hasGloss           = FALSE;
+			float specularMapWeight  = 1.0f;
+			float padding            = 0.0f;
+		};
+
+		// diffuse map only
+		struct Diffuse
+		{
+			float specularIntensity = 0.18f;
+			float specularPower     = 2.0f;
+			float padding[2]        = {};
+		};
+
+		// no maps at all
+		struct Untextured
+		{
+			DirectX::XMFLOAT4 materialColor = {0.447970f, 0.327254f, 0.176283f, 1.0f};
+			DirectX::XMFLOAT4 specularColor = {0.65f, 0.65f, 0.65f, 1.0f};
+			float             specularPower = 120.0f;
+			float             padding[3]    = {};
+		};
+	};
+
+	/**
+	 * \brief Everything a mesh is drawn with besides its geometry, worked out from its MaterialDesc: the shader permutation,
+	 * the images it samples and the contents of its pixel constant buffer.
+	 * Two materials with the same contents are the same material, whichever mesh, model or file they came from.
+	 */
+	class Material
+	{
+		public:
+			// the alternative held also names the shader permutation
+			using Constants = std::variant<PhongConstants::Fullmonte,
+			                               PhongConstants::DiffuseNormal,
+			                               PhongConstants::DiffuseSpecular,
+			                               PhongConstants::Diffuse,
+			                               PhongConstants::Untextured>;
+
+			// the alpha flags have to be known already (from the decoded textures or the model cache)
+			static Material FromDesc(const MaterialDesc& desc);
+
+			// over every member, constants compared as bytes (so hashing and equality always agree)
+			size_t Hash() const noexcept;
+			bool   operator==(const Material& other) const noexcept;
+
+			Constants   constants;
+			bool        hasAlphaDiffuse = false; // pixels are masked by the diffuse alpha and the mesh is drawn two-sided
+			std::string diffusePath;             // paths of the maps the permutation samples, empty for the ones it does not
+			std::string specularPath;
+			std::string normalPath;
+	};
+
+	/**
+	 * \brief Interns materials by content. Each distinct material gets a small ID, shared by every mesh drawn with it,
+	 * and exactly one pixel constant buffer, made the first time a mesh with the material is made.
+	 * Materials being edited are owned by a single mesh instead, so that their constants can change in place.
+	 */
+	class MaterialTable
+	{
+		public:
+			using Id = uint32_t;
+
+			static constexpr Id none = std::numeric_limits<Id>::max();
+
+			// ID of the material with these contents, registering it if it is new
+			static Id Intern(const Material& material);
+			// ID of a copy of the material that Intern never hands out, for a single owner to edit; give it back with Release
+			static Id   Own(const Material& material);
+			static bool IsOwned(Id id) noxnd;
+			// change the constants of an owned material (keeping its permutation), along with its constant buffer if it has one
+			static void SetConstants(Graphics& gfx, Id id, const Material::Constants& constants);
+			// the entry of an owned material is reused by the next Own
+			static void Release(Id id) noexcept;
+			// the reference is good until the next Intern or Own
+			static const Material& Get(Id id) noxnd;
+			// pixel constant buffer of the material (slot 1), created on first use and shared by every mesh that draws with it
+			static std::shared_ptr<Bindable> ResolveConstants(Graphics& gfx, Id id);
+			static size_t                    Size() noexcept;
+		private:
+			static MaterialTable& Instance();
+		private:
+			std::vector<Material>                  materials_;
+			std::vector<std::shared_ptr<Bindable>> constants_; // by ID, null until first resolved
+			std::unordered_multimap<size_t, Id>    byHash_;
+			std::vector<bool>                      owned_;     // by ID
+			std::vector<Id>                        freeOwned_; // released owned IDs
+	};
+}
@@ -2,7 +2,16 @@
 #include "imgui/imgui.h"
 #include "Utils/D3DXM.h"
 #include "Utils/Surface.h"
+#include "ModelCache.h"
+#include "ObjImporter.h"
+#include "GltfImporter.h"
+#include "Drawable/Geometry/IndexedTriangleList.h"
+#include "Utils/Parallel.h"
+#include "Utils/DXTimer.h"
+#include "Utils/FileWatcher.h"
+#include <bit>
 #include <filesystem>
+#include <utility>
 
 namespace D3DEngine
 {
@@ -37,8 +46,25 @@ namespace D3DEngine
 	// ---------------------------------------------------------------------------
 
 	// by passing in a vector of bindables, we want to the user to decide which bindable this mesh has
-	Mesh::Mesh(Graphics& gfx, std::vector<std::shared_ptr<Bindable>> bindPtrs)
+	Mesh::Mesh(Graphics&                              gfx,
+	           std::vector<std::shared_ptr<Bindable>> bindPtrs,
+	           IndexRange                             indices,
+	           INT                                    baseVertex,
+	           std::vector<Lod>                       lods,
+	           DirectX::XMFLOAT4                      bounds,
+	           std::vector<Meshlet>                   meshlets,
+	           MaterialTable::Id                      materialId)
+		:
+		indices_(indices),
+		baseVertex_(baseVertex),
+		lods_(std::move(lods)),
+		bounds_(bounds),
+		meshlets_(std::move(meshlets)),
+		materialId_(materialId)
 	{
+		// at most one range per meshlet, so culling never has to allocate
+		drawRanges_.reserve(meshlets_.size());
+
 		AddBind(Topology::Resolve(gfx, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST));
 
 		for (auto& pb : bindPtrs)
@@ -49,11 +75,37 @@ namespace D3DEngine
 		AddBind(std::make_shared<TransformCbuf>(gfx, *this));
 	}
 
+	Mesh::~Mesh()
+	{
+		// a material of its own (from EditMaterial) has no other user
+		MaterialTable::Release(materialId_);
+	}
+
 	// accumulatedTransform: we need to apply accumulated transform along the tree to the mesh
 	void Mesh::Draw(Graphics& gfx, DirectX::FXMMATRIX accumulatedTransform) const noxnd
 	{
+		const auto lod = SelectLod(gfx, accumulatedTransform);
+		if (lod == culled)
+		{
+			return;
+		}
+
 		XMStoreFloat4x4(&finalTransform_, accumulatedTransform);
-		Drawable::Draw(gfx);
+		if (lod == 0u && meshletSettings_.enabled && !meshlets_.empty())
+		{
+			if (CullMeshlets(gfx, accumulatedTransform) > 0u)
+			{
+				DrawRanges(gfx, drawRanges_, indices_.start, baseVertex_);
+			}
+		}
+		else if (lod == 0u)
+		{
+			DrawRange(gfx, indices_, baseVertex_);
+		}
+		else
+		{
+			DrawRange(gfx, lods_[lod - 1u].indices, baseVertex_);
+		}
 	}
 
 	DirectX::XMMATRIX Mesh::GetTransformXM() const noexcept
@@ -61,6 +113,172 @@ namespace D3DEngine
 		return XMLoadFloat4x4(&finalTransform_);
 	}
 
+	MaterialTable::Id Mesh::GetMaterialId() const noexcept
+	{
+		return materialId_;
+	}
+
+	void Mesh::EditMaterial(Graphics& gfx, const Material::Constants& constants)
+	{
+		if (MaterialTable::IsOwned(materialId_))
+		{
+			MaterialTable::SetConstants(gfx, materialId_, constants);
+			return;
+		}
+
+		auto material = MaterialTable::Get(materialId_);
+		assert("Material of another permutation" && constants.index() == material.constants.index());
+		material.constants = constants;
+		const auto id      = MaterialTable::Own(material);
+		ReplaceBindable(MaterialTable::ResolveConstants(gfx, id));
+		materialId_ = id;
+	}
+
+	size_t Mesh::SelectLod(Graphics& gfx, DirectX::FXMMATRIX transform) const noexcept
+	{
+		if (!lodSettings_.enabled || bounds_.w <= 0.0f)
+		{
+			return 0u;
+		}
+
+		const auto modelView = transform * gfx.GetCamera();
+		const auto center    = dx::XMVector3Transform(dx::XMVectorSet(bounds_.x, bounds_.y, bounds_.z, 1.0f), modelView);
+		const auto scale     = std::sqrt(std::max({
+			dx::XMVectorGetX(dx::XMVector3LengthSq(modelView.r[0])),
+			dx::XMVectorGetX(dx::XMVector3LengthSq(modelView.r[1])),
+			dx::XMVectorGetX(dx::XMVector3LengthSq(modelView.r[2])),
+		}));
+
+		dx::XMFLOAT4X4 projection;
+		dx::XMStoreFloat4x4(&projection, gfx.GetProjection());
+		// the projection maps a length l at view depth z to l * _22 / z in NDC, which spans half the viewport height per unit
+		const auto pixelScale = projection._22 * (float)gfx.GetHeight() * 0.5f;
+
+		return SelectLod(lods_, bounds_.w, scale, dx::XMVectorGetX(dx::XMVector3Length(center)), pixelScale, lodSettings_);
+	}
+
+	size_t Mesh::SelectLod(const std::vector<Lod>& lods,
+	                       float                   radius,
+	                       float                   scale,
+	                       float                   distance,
+	                       float                   pixelScale,
+	                       const LodSettings&      settings) noexcept
+	{
+		// inside the bounds (or right at them) nothing can be judged from size, so draw everything
+		const auto viewRadius = radius * scale;
+		if (distance <= viewRadius)
+		{
+			return 0u;
+		}
+
+		// measured at the nearest point of the bounds, so both choices stay on the safe side
+		const auto pixelsPerUnit = pixelScale * scale / (distance - viewRadius);
+		if (2.0f * radius * pixelsPerUnit < settings.cullSizePixels)
+		{
+			return culled;
+		}
+
+		size_t lod = 0u;
+		while (lod < lods.size() && lods[lod].error * pixelsPerUnit <= settings.maxErrorPixels)
+		{
+			lod++;
+		}
+		return lod;
+	}
+
+	void Mesh::SetLodSettings(const LodSettings& settings) noexcept
+	{
+		lodSettings_ = settings;
+	}
+
+	size_t Mesh::CullMeshlets(Graphics& gfx, DirectX::FXMMATRIX transform) const noxnd
+	{
+		const auto modelView = transform * gfx.GetCamera();
+
+		// clip volume planes pulled back into object space (Gribb & Hartmann), for D3D's 0 <= z <= w
+		const auto         columns = dx::XMMatrixTranspose(modelView * gfx.GetProjection());
+		const auto&        c       = columns.r;
+		const dx::XMVECTOR clip[6] = {c[3] + c[0], c[3] - c[0], c[3] + c[1], c[3] - c[1], c[2], c[3] - c[2]};
+		dx::XMFLOAT4       planes[6];
+		for (size_t i = 0; i < 6; i++)
+		{
+			dx::XMStoreFloat4(&planes[i], dx::XMPlaneNormalize(clip[i]));
+		}
+
+		dx::XMFLOAT3 eye;
+		dx::XMStoreFloat3(&eye, dx::XMMatrixInverse(nullptr, modelView).r[3]);
+
+		// cones measure angles in object space, which only carry over to the screen under uniform scale without mirroring
+		const auto& r          = modelView.r;
+		const float lengths[3] = {
+			dx::XMVectorGetX(dx::XMVector3Length(r[0])),
+			dx::XMVectorGetX(dx::XMVector3Length(r[1])),
+			dx::XMVectorGetX(dx::XMVector3Length(r[2])),
+		};
+		const auto [lo, hi] = std::minmax({lengths[0], lengths[1], lengths[2]});
+		const bool cones    = hi <= lo * 1.01f && dx::XMVectorGetX(dx::XMVector3Dot(dx::XMVector3Cross(r[0], r[1]), r[2])) > 0.0f;
+
+		return CullMeshlets(meshlets_, eye, planes, cones, meshletSettings_.minSkipTriangles, drawRanges_);
+	}
+
+	size_t Mesh::CullMeshlets(const std::vector<Meshlet>& meshlets,
+	                          const DirectX::XMFLOAT3&    eye,
+	                          const DirectX::XMFLOAT4     (&planes)[6],
+	                          bool                        cones,
+	                          UINT                        minSkipTriangles,
+	                          std::vector<IndexRange>&    ranges)
+	{
+		ranges.clear();
+		size_t visible = 0u;
+		for (const auto& m : meshlets)
+		{
+			const auto& s      = m.sphere;
+			bool        inside = true;
+			for (const auto& p : planes)
+			{
+				if (p.x * s.x + p.y * s.y + p.z * s.z + p.w < -s.w)
+				{
+					inside = false;
+					break;
+				}
+			}
+			if (!inside)
+			{
+				continue;
+			}
+
+			if (cones)
+			{
+				// back-facing from the eye if the direction to the apex lies inside the cone (without normalizing it)
+				const dx::XMFLOAT3 d = {m.coneApex.x - eye.x, m.coneApex.y - eye.y, m.coneApex.z - eye.z};
+				const auto         t = d.x * m.coneAxis.x + d.y * m.coneAxis.y + d.z * m.coneAxis.z;
+				if (t > 0.0f && t * t >= m.coneCutoff * m.coneCutoff * (d.x * d.x + d.y * d.y + d.z * d.z))
+				{
+					continue;
+				}
+			}
+
+			visible++;
+			if (!ranges.empty() && m.indexOffset - (ranges.back().start + ranges.back().count) <= minSkipTriangles * 3u)
+			{
+				ranges.back().count = m.indexOffset + m.indexCount - ranges.back().start;
+			}
+			else
+			{
+				ranges.push_back({m.indexOffset, m.indexCount});
+			}
+		}
+		return visible;
+	}
+
+	void Mesh::SetMeshletSettings(const MeshletSettings& settings) noexcept
+	{
+		meshletSettings_ = settings;
+	}
+
+	Mesh::LodSettings     Mesh::lodSettings_;
+	Mesh::MeshletSettings Mesh::meshletSettings_;
+
 	// ---------------------------------------------------------------------------
 
 	// each node has its own name (for identifying it in the tree), a set of meshes, and its transform
@@ -227,6 +445,12 @@ namespace D3DEngine
 				return pSelectedNode_;
 			}
 
+			// the nodes are about to be replaced (the transforms stay, they are kept by node ID)
+			void ClearSelection() noexcept
+			{
+				pSelectedNode_ = nullptr;
+			}
+
 		private:
 			Node* pSelectedNode_;
 
@@ -247,10 +471,435 @@ namespace D3DEngine
 			std::unordered_map<int, TransformParameters> transforms_;
 	};
 
-	Model::Model(Graphics& gfx, const std::string& pathString, const float scale)
+	namespace
+	{
+		// untextured stand-in drawn until a mesh's images are decoded
+		constexpr dx::XMFLOAT4 placeholderColor = {0.5f, 0.5f, 0.5f, 1.0f};
+	}
+
+	/**
+	 * \brief What a progressive load shares between the background worker and Update.
+	 * The worker publishes the prepared geometry once and then every image as soon as it is decoded, all under the mutex.
+	 * Once geometryReady is seen, model and arena belong to the main thread; the rest below the mutex is main thread only.
+	 */
+	struct Model::ProgressiveLoad
+	{
+		std::string       path;
+		float             scale;
+		uint64_t          settings; // import settings the model is made with, for the cache
+		DXTimer           timer; // started with the load, for the LoadStatus times
+		std::atomic<bool> cancel{false};
+		std::thread       worker;
+
+		std::mutex                                   mutex;
+		bool                                         geometryReady = false;
+		bool                                         decodingDone  = false;
+		std::exception_ptr                           error;
+		ModelData                                    model;
+		GeometryArena                                arena;
+		bool                                         fromCache = false;
+		std::vector<std::pair<std::string, Surface>> decoded; // images decoded since the last Update
+
+		std::vector<ArenaBuffers>     buffers;
+		DecodedTextures               textures;      // every image that arrived so far
+		std::vector<size_t>           waiting;       // meshes still drawn with the placeholder, in mesh order
+		std::optional<dx::XMFLOAT4X4> rootTransform; // set before there were any nodes to apply it to
+	};
+
+	Model::Model(Graphics& gfx, const std::string& pathString, const float scale, LoadMode mode)
 		:
+		path_(pathString),
+		scale_(scale),
 		pWindow_(std::make_unique<ModelWindow>())
 	{
+		if (mode == LoadMode::Progressive)
+		{
+			pLoad_           = std::make_unique<ProgressiveLoad>();
+			pLoad_->path     = pathString;
+			pLoad_->scale    = scale;
+			pLoad_->settings = GetImportSettingsHash();
+			pLoad_->worker = std::thread([&load = *pLoad_]
+			{
+				try
+				{
+					bool       fromCache = false;
+					auto       model     = Prepare(load.path, load.scale, fromCache);
+					auto       arena     = GeometryArena::Build(model, GetArenaTag(load.path, load.scale, load.settings), geometryArena_);
+					// images already in the Codex (prewarmed, or used by another model) are not decoded a second time
+					const auto paths     = ReferencedImages(model, true);
+					{
+						std::lock_guard lock{load.mutex};
+						load.model         = std::move(model);
+						load.arena         = std::move(arena);
+						load.fromCache     = fromCache;
+						load.geometryReady = true;
+					}
+					// images are handed out in the order the meshes first use them, so the first meshes finish first
+					ParallelFor(paths.size(), workerCount_, [&](size_t i)
+					{
+						if (load.cancel)
+						{
+							return;
+						}
+						auto            surface = Surface::FromFile(paths[i]);
+						std::lock_guard lock{load.mutex};
+						load.decoded.emplace_back(paths[i], std::move(surface));
+					});
+				}
+				catch (...)
+				{
+					std::lock_guard lock{load.mutex};
+					load.error = std::current_exception();
+				}
+				std::lock_guard lock{load.mutex};
+				load.decodingDone = true;
+			});
+			return;
+		}
+
+		const DXTimer timer;
+		bool          fromCache = false;
+		auto          data      = Prepare(pathString, scale, fromCache);
+
+		// image decoding is the expensive part of making the textures, so do all of it up front and in parallel
+		// only the device objects are created serially below, in mesh order, exactly like a fully serial load
+		const auto textures = DecodeTextures(data);
+		const auto arena    = GeometryArena::Build(data, GetArenaTag(pathString, scale, GetImportSettingsHash()), geometryArena_);
+		const auto buffers  = ResolveArenas(gfx, arena);
+
+		meshPtrs_.reserve(data.meshes.size());
+		for (size_t i = 0; i < data.meshes.size(); i++)
+		{
+			const auto& slice = arena.slices[i];
+			meshPtrs_.push_back(MakeMesh(gfx, data.meshes[i], textures, buffers[slice.arena], slice));
+		}
+
+		int nextId = 0;
+		pRoot_     = MakeNode(nextId, data.root);
+
+		// bake only after the meshes are made, so that the alpha flags learned from the textures end up in the cache
+		if (!fromCache)
+		{
+			ModelCache::Save(pathString, scale, GetImportSettingsHash(), data);
+		}
+
+		status_.geometryReady  = true;
+		status_.complete       = true;
+		status_.meshCount      = meshPtrs_.size();
+		status_.finishedMeshes = meshPtrs_.size();
+		status_.geometryTime   = timer.Peek();
+		status_.completeTime   = status_.geometryTime;
+	}
+
+	bool Model::Update(Graphics& gfx, size_t maxUpgrades)
+	{
+		if (!pLoad_ || status_.complete)
+		{
+			return status_.complete;
+		}
+		auto& load = *pLoad_;
+
+		std::vector<std::pair<std::string, Surface>> decoded;
+		bool                                         geometryReady;
+		bool                                         decodingDone;
+		std::exception_ptr                           error;
+		{
+			std::lock_guard lock{load.mutex};
+			decoded.swap(load.decoded);
+			geometryReady = load.geometryReady;
+			decodingDone  = load.decodingDone;
+			error         = load.error;
+		}
+		if (error)
+		{
+			load.worker.join();
+			// an empty tree if the geometry never arrived, so that drawing, transforming and reloading the model still work
+			if (!pRoot_)
+			{
+				pRoot_ = std::make_unique<Node>(0, "", std::vector<Mesh*>{}, dx::XMMatrixIdentity());
+				if (load.rootTransform)
+				{
+					pRoot_->SetAppliedTransform(dx::XMLoadFloat4x4(&*load.rootTransform));
+				}
+			}
+			status_.failed = true;
+			pLoad_.reset();
+			std::rethrow_exception(error);
+		}
+		if (!geometryReady)
+		{
+			return false;
+		}
+
+		for (auto& [path, surface] : decoded)
+		{
+			load.textures.emplace(std::move(path), std::move(surface));
+		}
+		// an image is ready once it is decoded, or if the worker skipped it because it was resident already
+		const auto imageReady = [&textures = load.textures](const std::string& path, UINT slot)
+		{
+			return textures.contains(path) || Codex::Contains<Texture>(path, slot);
+		};
+		const auto imagesReady = [&imageReady](const MaterialDesc& material)
+		{
+			return (!material.hasDiffuseMap || imageReady(material.diffusePath, 0u)) &&
+			       (!material.hasSpecularMap || imageReady(material.specularPath, 1u)) &&
+			       (!material.hasNormalMap || imageReady(material.normalPath, 2u));
+		};
+
+		// the geometry just arrived: make every mesh so the model draws from this frame on
+		if (!pRoot_)
+		{
+			// only the slices are needed from here on, the arena's vertices and indices live on the device now
+			load.buffers = ResolveArenas(gfx, load.arena);
+			load.arena.arenas.clear();
+
+			auto& meshes = load.model.meshes;
+			meshPtrs_.reserve(meshes.size());
+			for (size_t i = 0; i < meshes.size(); i++)
+			{
+				const auto& slice = load.arena.slices[i];
+				if (imagesReady(meshes[i].material))
+				{
+					meshPtrs_.push_back(MakeMesh(gfx, meshes[i], load.textures, load.buffers[slice.arena], slice));
+				}
+				else
+				{
+					meshPtrs_.push_back(MakePlaceholderMesh(gfx, meshes[i], load.buffers[slice.arena], slice));
+					load.waiting.push_back(i);
+				}
+			}
+
+			int nextId = 0;
+			pRoot_     = MakeNode(nextId, load.model.root);
+			if (load.rootTransform)
+			{
+				pRoot_->SetAppliedTransform(dx::XMLoadFloat4x4(&*load.rootTransform));
+			}
+
+			status_.geometryReady = true;
+			status_.meshCount     = meshPtrs_.size();
+			status_.geometryTime  = load.timer.Peek();
+		}
+
+		// trade placeholders for the real meshes as their images come in (once decoding is over, a missing image is loaded by the texture itself)
+		std::vector<std::unique_ptr<Mesh>>     retired;
+		std::unordered_map<const Mesh*, Mesh*> replacements;
+		for (auto i = load.waiting.begin(); i != load.waiting.end() && retired.size() < maxUpgrades;)
+		{
+			auto& mesh = load.model.meshes[*i];
+			if (!decodingDone && !imagesReady(mesh.material))
+			{
+				++i;
+				continue;
+			}
+			const auto& slice = load.arena.slices[*i];
+			auto        pMesh = MakeMesh(gfx, mesh, load.textures, load.buffers[slice.arena], slice);
+			replacements.emplace(meshPtrs_[*i].get(), pMesh.get());
+			retired.push_back(std::exchange(meshPtrs_[*i], std::move(pMesh)));
+			i = load.waiting.erase(i);
+		}
+
+		// the nodes only hold raw pointers, point them at the new meshes before the placeholders go away
+		if (!replacements.empty())
+		{
+			const auto relink = [&replacements](auto& self, Node& node) -> void
+			{
+				for (auto& pMesh : node.meshPtrs_)
+				{
+					if (const auto r = replacements.find(pMesh); r != replacements.end())
+					{
+						pMesh = r->second;
+					}
+				}
+				for (auto& pChild : node.childPtrs_)
+				{
+					self(self, *pChild);
+				}
+			};
+			relink(relink, *pRoot_);
+		}
+		status_.finishedMeshes = status_.meshCount - load.waiting.size();
+
+		if (!decodingDone || !load.waiting.empty())
+		{
+			return false;
+		}
+
+		load.worker.join();
+		load.textures.clear();
+		load.buffers.clear();
+		status_.complete     = true;
+		status_.completeTime = load.timer.Peek();
+
+		// bake on the worker thread, now that the meshes are made and the alpha flags learned from the textures are known
+		if (!load.fromCache)
+		{
+			load.worker = std::thread([&load]
+			{
+				try
+				{
+					ModelCache::Save(load.path, load.scale, load.settings, load.model);
+				}
+				catch (...)
+				{
+					// a failed bake only costs the next load its shortcut
+				}
+				load.model = {};
+			});
+		}
+		else
+		{
+			load.model = {};
+		}
+		return true;
+	}
+
+	const Model::LoadStatus& Model::GetLoadStatus() const noexcept
+	{
+		return status_;
+	}
+
+	bool Model::DependsOn(const std::string& path) const noexcept
+	{
+		try
+		{
+			const std::filesystem::path source{FileWatcher::Normalize(path_)};
+			const std::filesystem::path changed{path};
+			if (changed == source)
+			{
+				return true;
+			}
+			// the .mtl or .bin files a model names need not be named after it
+			const auto extension = changed.extension();
+			return changed.parent_path() == source.parent_path() && (extension == ".mtl" || extension == ".bin");
+		}
+		catch (...)
+		{
+			return false;
+		}
+	}
+
+	bool Model::Reload(Graphics& gfx)
+	{
+		if (pLoad_)
+		{
+			if (!status_.complete)
+			{
+				return false;
+			}
+			// the worker may still be baking the cache of the first load
+			if (pLoad_->worker.joinable())
+			{
+				pLoad_->worker.join();
+			}
+			pLoad_.reset();
+		}
+
+		// the same steps as a blocking load, into locals so that a failed import leaves the model as it was
+		const DXTimer timer;
+		ModelCache::Invalidate(path_);
+		bool       fromCache = false;
+		auto       data      = Prepare(path_, scale_, fromCache);
+		const auto textures  = DecodeTextures(data);
+		const auto arena     = GeometryArena::Build(data, GetArenaTag(path_, scale_, GetImportSettingsHash()), geometryArena_);
+		const auto buffers   = ResolveArenas(gfx, arena, true);
+
+		std::vector<std::unique_ptr<Mesh>> meshPtrs;
+		meshPtrs.reserve(data.meshes.size());
+		for (size_t i = 0; i < data.meshes.size(); i++)
+		{
+			const auto& slice = arena.slices[i];
+			meshPtrs.push_back(MakeMesh(gfx, data.meshes[i], textures, buffers[slice.arena], slice));
+		}
+
+		// the old nodes point at the old meshes, so both go together
+		dx::XMFLOAT4X4 rootTransform;
+		dx::XMStoreFloat4x4(&rootTransform, dx::XMMatrixIdentity());
+		if (pRoot_)
+		{
+			rootTransform = pRoot_->GetAppliedTransform();
+		}
+		pWindow_->ClearSelection();
+		meshPtrs_.swap(meshPtrs);
+		int nextId = 0;
+		pRoot_     = MakeNode(nextId, data.root);
+		pRoot_->SetAppliedTransform(dx::XMLoadFloat4x4(&rootTransform));
+
+		ModelCache::Save(path_, scale_, GetImportSettingsHash(), data);
+
+		status_.geometryReady  = true;
+		status_.complete       = true;
+		status_.failed         = false;
+		status_.meshCount      = meshPtrs_.size();
+		status_.finishedMeshes = meshPtrs_.size();
+		status_.geometryTime   = timer.Peek();
+		status_.completeTime   = status_.geometryTime;
+		return true;
+	}
+
+	ModelData Model::Prepare(const std::string& pathString, float scale, bool& fromCache)
+	{
+		// prefer the baked cache, only fall back to Assimp if it is missing or stale
+		auto data = ModelCache::Load(pathString, scale, GetImportSettingsHash());
+		fromCache = data.has_value();
+		if (!fromCache)
+		{
+			return Process(pathString, scale);
+		}
+
+		if (splitLargeMeshes_)
+		{
+			SplitForShortIndices(*data);
+		}
+		return std::move(*data);
+	}
+
+	ModelData Model::Process(const std::string& pathString, float scale)
+	{
+		auto data = Import(pathString, scale);
+
+		if (splitLargeMeshes_)
+		{
+			SplitForShortIndices(data);
+		}
+
+		// last step on the CPU data, every pass before it works on float vertices (cached meshes are stored packed already)
+		ParallelFor(data.meshes.size(), workerCount_, [&](size_t i)
+		{
+			auto& mesh    = data.meshes[i];
+			mesh.vertices = VertexPacking::Compress(mesh.vertices, vertexPacking_);
+		});
+		return data;
+	}
+
+	ModelData Model::Import(const std::string& pathString, float scale)
+	{
+		auto data = Parse(pathString, scale);
+
+		// every mesh is processed in its own slot, so the result does not depend on the number of workers
+		ParallelFor(data.meshes.size(), workerCount_, [&](size_t i)
+		{
+			auto& mesh = data.meshes[i];
+			MeshOptimizer::Optimize(mesh.vertices, mesh.indices, optimization_);
+			mesh.lods = MeshSimplifier::GenerateLods(mesh.vertices, mesh.indices, lodOptions_);
+			// last, since it reorders the triangles of the full detail mesh
+			mesh.meshlets = MeshletBuilder::Build(mesh.vertices, mesh.indices, meshletOptions_);
+		});
+		return data;
+	}
+
+	ModelData Model::Parse(const std::string& pathString, float scale, bool forceAssimp)
+	{
+		if (objImporter_ && !forceAssimp && ObjImporter::CanImport(pathString))
+		{
+			return ObjImporter::Import(pathString, scale, workerCount_);
+		}
+		if (gltfImporter_ && !forceAssimp && GltfImporter::CanImport(pathString))
+		{
+			return GltfImporter::Import(pathString, scale, workerCount_);
+		}
+
 		Assimp::Importer imp;
 		const auto       pScene = imp.ReadFile(pathString.c_str(),
 		                                       aiProcess_Triangulate |
@@ -265,17 +914,229 @@ namespace D3DEngine
 			throw ModelException(__LINE__, __FILE__, imp.GetErrorString());
 		}
 
-		for (size_t i = 0; i < pScene->mNumMeshes; i++)
+		// pack the meshes in parallel; every mesh gets its own slot so the result is in the same order as a serial load
+		std::vector<std::optional<MeshData>> parsed(pScene->mNumMeshes);
+		ParallelFor(parsed.size(), workerCount_, [&](size_t i)
 		{
-			meshPtrs_.push_back(ParseMesh(gfx, *pScene->mMeshes[i], pScene->mMaterials, pathString, scale));
+			parsed[i].emplace(ParseMesh(*pScene->mMeshes[i], pScene->mMaterials, pathString, scale));
+		});
+
+		ModelData data;
+		data.meshes.reserve(parsed.size());
+		for (auto& mesh : parsed)
+		{
+			data.meshes.push_back(std::move(*mesh));
 		}
+		data.root = ParseNode(*pScene->mRootNode);
+		return data;
+	}
 
-		int nextId = 0;
-		pRoot_     = ParseNode(nextId, *pScene->mRootNode);
+	// every image the model references once, in the order the meshes first use them
+	std::vector<std::string> Model::ReferencedImages(const ModelData& data, bool skipResident)
+	{
+		std::vector<std::string> paths;
+		std::set<std::string>    seen;
+		const auto               add = [&](const std::string& path, UINT slot)
+		{
+			if (skipResident && Codex::Contains<Texture>(path, slot))
+			{
+				return;
+			}
+			if (seen.insert(path).second)
+			{
+				paths.push_back(path);
+			}
+		};
+		for (const auto& mesh : data.meshes)
+		{
+			const auto& material = mesh.material;
+			if (material.hasDiffuseMap)
+			{
+				add(material.diffusePath, 0u);
+			}
+			if (material.hasSpecularMap)
+			{
+				add(material.specularPath, 1u);
+			}
+			if (material.hasNormalMap)
+			{
+				add(material.normalPath, 2u);
+			}
+		}
+		return paths;
+	}
+
+	Model::DecodedTextures Model::DecodeTextures(const ModelData& data, bool skipResident)
+	{
+		auto paths = ReferencedImages(data, skipResident);
+
+		std::vector<std::optional<Surface>> surfaces(paths.size());
+		ParallelFor(paths.size(), workerCount_, [&](size_t i)
+		{
+			surfaces[i].emplace(Surface::FromFile(paths[i]));
+		});
+
+		DecodedTextures decoded;
+		for (size_t i = 0; i < paths.size(); i++)
+		{
+			decoded.emplace(std::move(paths[i]), std::move(*surfaces[i]));
+		}
+		return decoded;
+	}
+
+	void Model::SplitForShortIndices(ModelData& data)
+	{
+		// where each of the original meshes ended up
+		std::vector<std::vector<unsigned>> meshMap(data.meshes.size());
+		std::vector<MeshData>              meshes;
+		meshes.reserve(data.meshes.size());
+		for (size_t i = 0; i < data.meshes.size(); i++)
+		{
+			auto& mesh = data.meshes[i];
+			if (mesh.vertices.Size() <= IndexedTriangleList::maxShortIndexedVertices)
+			{
+				meshMap[i].push_back((unsigned)meshes.size());
+				meshes.push_back(std::move(mesh));
+				continue;
+			}
+
+			auto pieces = IndexedTriangleList{std::move(mesh.vertices), std::move(mesh.indices)}.SplitForShortIndices();
+			for (size_t k = 0; k < pieces.size(); k++)
+			{
+				meshMap[i].push_back((unsigned)meshes.size());
+				// each piece needs its own geometry tag, everything else but the LODs (which index the unsplit vertices) is shared
+				auto meshlets = MeshletBuilder::Build(pieces[k].vertices, pieces[k].indices, meshletOptions_);
+				meshes.push_back({
+					mesh.tag + "#" + std::to_string(k),
+					mesh.material,
+					std::move(pieces[k].vertices),
+					std::move(pieces[k].indices),
+					{},
+					std::move(meshlets)
+				});
+			}
+		}
+		data.meshes = std::move(meshes);
+
+		// point the nodes at the pieces instead of the original meshes
+		const auto remapNode = [&meshMap](auto& self, NodeData& node) -> void
+		{
+			std::vector<unsigned> meshIndices;
+			for (const auto i : node.meshIndices)
+			{
+				meshIndices.insert(meshIndices.end(), meshMap[i].begin(), meshMap[i].end());
+			}
+			node.meshIndices = std::move(meshIndices);
+			for (auto& child : node.children)
+			{
+				self(self, child);
+			}
+		};
+		remapNode(remapNode, data.root);
+	}
+
+	void Model::SetSplitLargeMeshes(bool split) noexcept
+	{
+		splitLargeMeshes_ = split;
+	}
+
+	void Model::SetMeshOptimization(const MeshOptimizer::Options& options) noexcept
+	{
+		optimization_ = options;
+	}
+
+	MeshOptimizer::Options Model::GetMeshOptimization() noexcept
+	{
+		return optimization_;
+	}
+
+	void Model::SetLodOptions(const MeshSimplifier::LodOptions& options) noexcept
+	{
+		lodOptions_ = options;
+	}
+
+	void Model::SetMeshletOptions(const MeshletBuilder::Options& options) noexcept
+	{
+		meshletOptions_ = options;
+	}
+
+	void Model::SetVertexCompression(const VertexPacking::Options& options) noexcept
+	{
+		vertexPacking_ = options;
+	}
+
+	void Model::SetGeometryArena(const GeometryArena::Options& options) noexcept
+	{
+		geometryArena_ = options;
+	}
+
+	void Model::SetObjImporter(bool enabled) noexcept
+	{
+		objImporter_ = enabled;
+	}
+
+	void Model::SetGltfImporter(bool enabled) noexcept
+	{
+		gltfImporter_ = enabled;
+	}
+
+	std::string Model::GetArenaTag(const std::string& pathString, float scale, uint64_t settings)
+	{
+		// the scale by its bits, like the model cache compares it
+		return pathString + "%" + std::to_string(std::bit_cast<uint32_t>(scale)) + "%" + std::to_string(settings);
+	}
+
+	uint64_t Model::GetImportSettingsHash() noexcept
+	{
+		// FNV-1a over the fields one by one, so that padding in the option structs never counts
+		uint64_t   hash = 14695981039346656037ull;
+		const auto add  = [&hash](const auto& value)
+		{
+			const auto pBytes = reinterpret_cast<const unsigned char*>(&value);
+			for (size_t i = 0; i < sizeof(value); i++)
+			{
+				hash = (hash ^ pBytes[i]) * 1099511628211ull;
+			}
+		};
+		add(splitLargeMeshes_);
+		add(optimization_.vertexCache);
+		add(optimization_.overdraw);
+		add(optimization_.vertexFetch);
+		add(optimization_.overdrawThreshold);
+		add(lodOptions_.maxLods);
+		add(lodOptions_.reduction);
+		add(lodOptions_.maxRelativeError);
+		add(lodOptions_.minTriangles);
+		add(meshletOptions_.maxVertices);
+		add(meshletOptions_.maxTriangles);
+		add(meshletOptions_.minMeshlets);
+		add(vertexPacking_.positions);
+		add(vertexPacking_.maxPositionError);
+		add(vertexPacking_.texcoords);
+		add(vertexPacking_.maxTexcoordError);
+		add(vertexPacking_.normals);
+		add(objImporter_);
+		add(gltfImporter_);
+		return hash;
+	}
+
+	void Model::SetWorkerCount(size_t count) noexcept
+	{
+		workerCount_ = count;
+	}
+
+	size_t Model::GetWorkerCount() noexcept
+	{
+		return ResolveWorkerCount(workerCount_);
 	}
 
 	void Model::Draw(Graphics& gfx) const noxnd
 	{
+		// nothing to draw until a progressive load has its geometry
+		if (!pRoot_)
+		{
+			return;
+		}
 		if (auto node = pWindow_->GetSelectedNode())
 		{
 			node->SetAppliedTransform(pWindow_->GetTransform());
@@ -287,33 +1148,42 @@ namespace D3DEngine
 	// show the final tree window using IMGUI
 	void Model::ShowWindow(Graphics& gfx, const char* windowName) noexcept
 	{
-		pWindow_->Show(gfx, windowName, *pRoot_);
+		if (pRoot_)
+		{
+			pWindow_->Show(gfx, windowName, *pRoot_);
+		}
 	}
 
 	void Model::SetRootTransform(DirectX::FXMMATRIX tf) noexcept
 	{
-		pRoot_->SetAppliedTransform(tf);
+		if (pRoot_)
+		{
+			pRoot_->SetAppliedTransform(tf);
+		}
+		else if (pLoad_)
+		{
+			// the geometry of a progressive load has not arrived yet, Update applies it to the root once it does
+			pLoad_->rootTransform.emplace();
+			dx::XMStoreFloat4x4(&*pLoad_->rootTransform, tf);
+		}
 	}
 
 	Model::~Model() noxnd
 	{
+		// the worker may still be decoding (or baking the cache), it has to be done with the shared state before it goes
+		if (pLoad_ && pLoad_->worker.joinable())
+		{
+			pLoad_->cancel = true;
+			pLoad_->worker.join();
+		}
 	}
 
-	std::unique_ptr<Mesh> Model::ParseMesh(Graphics& gfx, const aiMesh& mesh, const aiMaterial* const* pMaterials, const std::filesystem::path& path, float scale)
+	// CPU half of mesh loading: gather the material and pack the vertices/indices in the layout its shaders expect
+	MeshData Model::ParseMesh(const aiMesh& mesh, const aiMaterial* const* pMaterials, const std::filesystem::path& path, float scale)
 	{
-		using namespace std::string_literals;
-		std::vector<std::shared_ptr<Bindable>> bindablePtrs;
-
 		const auto rootPath = path.parent_path().string() + "\\";
 
-		bool         hasSpecularMap  = false;
-		bool         hasAlphaGloss   = false;
-		bool         hasAlphaDiffuse = false;
-		bool         hasNormalMap    = false;
-		bool         hasDiffuseMap   = false;
-		float        shininess       = 2.0f;
-		dx::XMFLOAT4 specularColor   = {0.18f, 0.18f, 0.18f, 1.0f};
-		dx::XMFLOAT4 diffuseColor    = {0.45f, 0.45f, 0.85f, 1.0f};
+		MaterialDesc desc;
 		if (mesh.mMaterialIndex >= 0)
 		{
 			auto& material = *pMaterials[mesh.mMaterialIndex];
@@ -322,50 +1192,50 @@ namespace D3DEngine
 
 			if (material.GetTexture(aiTextureType_DIFFUSE, 0, &texFileName) == aiReturn_SUCCESS)
 			{
-				auto tex        = Texture::Resolve(gfx, rootPath + texFileName.C_Str());
-				hasAlphaDiffuse = tex->HasAlpha();
-				bindablePtrs.push_back(std::move(tex));
-				hasDiffuseMap = true;
+				desc.diffusePath   = rootPath + texFileName.C_Str();
+				desc.hasDiffuseMap = true;
 			}
 			else
 			{
-				material.Get(AI_MATKEY_COLOR_DIFFUSE, reinterpret_cast<aiColor3D&>(diffuseColor));
+				material.Get(AI_MATKEY_COLOR_DIFFUSE, reinterpret_cast<aiColor3D&>(desc.diffuseColor));
 			}
 
 			if (material.GetTexture(aiTextureType_SPECULAR, 0, &texFileName) == aiReturn_SUCCESS)
 			{
-				auto tex      = Texture::Resolve(gfx, rootPath + texFileName.C_Str(), 1);
-				hasAlphaGloss = tex->HasAlpha();
-				bindablePtrs.push_back(std::move(tex));
-				hasSpecularMap = true;
+				desc.specularPath   = rootPath + texFileName.C_Str();
+				desc.hasSpecularMap = true;
 			}
 			else
 			{
-				material.Get(AI_MATKEY_COLOR_SPECULAR, reinterpret_cast<aiColor3D&>(specularColor));
+				material.Get(AI_MATKEY_COLOR_SPECULAR, reinterpret_cast<aiColor3D&>(desc.specularColor));
 			}
 
-			if (!hasAlphaGloss)
-			{
-				material.Get(AI_MATKEY_SHININESS, shininess);
-			}
+			// whether the gloss actually comes from the specular map's alpha is only known once it is decoded (see MakeMesh)
+			material.Get(AI_MATKEY_SHININESS, desc.shininess);
 
 			if (material.GetTexture(aiTextureType_NORMALS, 0, &texFileName) == aiReturn_SUCCESS)
 			{
-				auto tex = Texture::Resolve(gfx, rootPath + texFileName.C_Str(), 2);
-				bindablePtrs.push_back(std::move(tex));
-				hasNormalMap = true;
+				desc.normalPath   = rootPath + texFileName.C_Str();
+				desc.hasNormalMap = true;
 			}
+		}
 
-			if (hasDiffuseMap || hasSpecularMap || hasNormalMap)
-			{
-				bindablePtrs.push_back(Sampler::Resolve(gfx));
-			}
+		// always gathered as 32-bit; the index buffer narrows them to 16-bit when they all fit
+		std::vector<unsigned int> indices;
+		indices.reserve(mesh.mNumFaces * 3);
+		for (unsigned int i = 0; i < mesh.mNumFaces; i++)
+		{
+			const auto& face = mesh.mFaces[i];
+			assert(face.mNumIndices == 3);
+			indices.push_back(face.mIndices[0]);
+			indices.push_back(face.mIndices[1]);
+			indices.push_back(face.mIndices[2]);
 		}
 
 		// want the full path here
-		const auto meshTag = path.string() + "%" + mesh.mName.C_Str();
+		auto meshTag = path.string() + "%" + mesh.mName.C_Str();
 
-		if (hasDiffuseMap && hasNormalMap && hasSpecularMap)
+		if (desc.hasDiffuseMap && desc.hasNormalMap)
 		{
 			RawVertexBufferWithLayout vbuf(std::move(
 			                                         DynamicVertexLayout{}
@@ -376,297 +1246,301 @@ namespace D3DEngine
 			                                         .Append(DynamicVertexLayout::Texture2D)
 			                                        ));
 
-			for (unsigned int i = 0; i < mesh.mNumVertices; i++)
-			{
-				vbuf.EmplaceBack(
-				                 dx::XMFLOAT3(mesh.mVertices[i].x * scale, mesh.mVertices[i].y * scale, mesh.mVertices[i].z * scale),
-				                 *reinterpret_cast<dx::XMFLOAT3*>(&mesh.mNormals[i]),
-				                 *reinterpret_cast<dx::XMFLOAT3*>(&mesh.mTangents[i]),
-				                 *reinterpret_cast<dx::XMFLOAT3*>(&mesh.mBitangents[i]),
-				                 *reinterpret_cast<dx::XMFLOAT2*>(&mesh.mTextureCoords[0][i])
-				                );
-			}
-
-			std::vector<unsigned short> indices;
-			indices.reserve(mesh.mNumFaces * 3);
-			for (unsigned int i = 0; i < mesh.mNumFaces; i++)
-			{
-				const auto& face = mesh.mFaces[i];
-				assert(face.mNumIndices == 3);
-				indices.push_back(face.mIndices[0]);
-				indices.push_back(face.mIndices[1]);
-				indices.push_back(face.mIndices[2]);
-			}
-
-			bindablePtrs.push_back(VertexBuffer::Resolve(gfx, meshTag, vbuf));
+			// Assimp keeps every attribute in an array of its own, texcoords as 3D
+			vbuf.Append(mesh.mNumVertices, {
+				{DynamicVertexLayout::Position3D, mesh.mVertices, sizeof(aiVector3D), scale},
+				{DynamicVertexLayout::Normal, mesh.mNormals, sizeof(aiVector3D)},
+				{DynamicVertexLayout::Tangent, mesh.mTangents, sizeof(aiVector3D)},
+				{DynamicVertexLayout::Bitangent, mesh.mBitangents, sizeof(aiVector3D)},
+				{DynamicVertexLayout::Texture2D, mesh.mTextureCoords[0], sizeof(aiVector3D)},
+			});
 
-			bindablePtrs.push_back(IndexBuffer::Resolve(gfx, meshTag, indices));
-
-			auto pvs   = VertexShader::Resolve(gfx, "Shaders/cso/PhongVSNormalMap.cso");
-			auto pvsbc = pvs->GetBytecode();
-			bindablePtrs.push_back(std::move(pvs));
-
-			bindablePtrs.push_back(PixelShader::Resolve(gfx,
-			                                            hasAlphaDiffuse ? "Shaders/cso/PhongPSSpecNormMask.cso" : "Shaders/cso/PhongPSSpecNormalMap.cso"
-			                                           ));
-
-			bindablePtrs.push_back(InputLayout::Resolve(gfx, vbuf.GetLayout(), pvsbc));
-
-			Node::PSMaterialConstantFullmonte pmc;
-			pmc.specularPower = shininess;
-			pmc.hasGlossMap   = hasAlphaGloss ? TRUE : FALSE;
-			// this is CLEARLY an issue... all meshes will share same mat const, but may have different
-			// Ns (specular power) specified for each in the material properties... bad conflict
-			bindablePtrs.push_back(PixelConstantBuffer<Node::PSMaterialConstantFullmonte>::Resolve(gfx, pmc, 1u));
+			return {std::move(meshTag), std::move(desc), std::move(vbuf), std::move(indices)};
 		}
-		else if (hasDiffuseMap && hasNormalMap)
+		else if (desc.hasDiffuseMap)
 		{
 			RawVertexBufferWithLayout vbuf(std::move(
 			                                         DynamicVertexLayout{}
 			                                         .Append(DynamicVertexLayout::Position3D)
 			                                         .Append(DynamicVertexLayout::Normal)
-			                                         .Append(DynamicVertexLayout::Tangent)
-			                                         .Append(DynamicVertexLayout::Bitangent)
 			                                         .Append(DynamicVertexLayout::Texture2D)
 			                                        ));
 
-			for (unsigned int i = 0; i < mesh.mNumVertices; i++)
-			{
-				vbuf.EmplaceBack(
-				                 dx::XMFLOAT3(mesh.mVertices[i].x * scale, mesh.mVertices[i].y * scale, mesh.mVertices[i].z * scale),
-				                 *reinterpret_cast<dx::XMFLOAT3*>(&mesh.mNormals[i]),
-				                 *reinterpret_cast<dx::XMFLOAT3*>(&mesh.mTangents[i]),
-				                 *reinterpret_cast<dx::XMFLOAT3*>(&mesh.mBitangents[i]),
-				                 *reinterpret_cast<dx::XMFLOAT2*>(&mesh.mTextureCoords[0][i])
-				                );
-			}
-
-			std::vector<unsigned short> indices;
-			indices.reserve(mesh.mNumFaces * 3);
-			for (unsigned int i = 0; i < mesh.mNumFaces; i++)
-			{
-				const auto& face = mesh.mFaces[i];
-				assert(face.mNumIndices == 3);
-				indices.push_back(face.mIndices[0]);
-				indices.push_back(face.mIndices[1]);
-				indices.push_back(face.mIndices[2]);
-			}
-
-			bindablePtrs.push_back(VertexBuffer::Resolve(gfx, meshTag, vbuf));
-
-			bindablePtrs.push_back(IndexBuffer::Resolve(gfx, meshTag, indices));
-
-			auto pvs   = VertexShader::Resolve(gfx, "Shaders/cso/PhongVSNormalMap.cso");
-			auto pvsbc = pvs->GetBytecode();
-			bindablePtrs.push_back(std::move(pvs));
+			vbuf.Append(mesh.mNumVertices, {
+				{DynamicVertexLayout::Position3D, mesh.mVertices, sizeof(aiVector3D), scale},
+				{DynamicVertexLayout::Normal, mesh.mNormals, sizeof(aiVector3D)},
+				{DynamicVertexLayout::Texture2D, mesh.mTextureCoords[0], sizeof(aiVector3D)},
+			});
 
-			bindablePtrs.push_back(PixelShader::Resolve(gfx, "Shaders/cso/PhongPSNormalMap.cso"));
-
-			bindablePtrs.push_back(InputLayout::Resolve(gfx, vbuf.GetLayout(), pvsbc));
-
-			struct PSMaterialConstantDiffnorm
-			{
-				float specularIntensity;
-				float specularPower;
-				BOOL  normalMapEnabled = TRUE;
-				float padding[1];
-			}         pmc;
-			pmc.specularPower     = shininess;
-			pmc.specularIntensity = (specularColor.x + specularColor.y + specularColor.z) / 3.0f;
-			// this is CLEARLY an issue... all meshes will share same mat const, but may have different
-			// Ns (specular power) specified for each in the material properties... bad conflict
-			bindablePtrs.push_back(PixelConstantBuffer<PSMaterialConstantDiffnorm>::Resolve(gfx, pmc, 1u));
+			return {std::move(meshTag), std::move(desc), std::move(vbuf), std::move(indices)};
 		}
-		else if (hasDiffuseMap && !hasNormalMap && hasSpecularMap)
+		else if (!desc.hasNormalMap && !desc.hasSpecularMap)
 		{
 			RawVertexBufferWithLayout vbuf(std::move(
 			                                         DynamicVertexLayout{}
 			                                         .Append(DynamicVertexLayout::Position3D)
 			                                         .Append(DynamicVertexLayout::Normal)
-			                                         .Append(DynamicVertexLayout::Texture2D)
 			                                        ));
 
-			for (unsigned int i = 0; i < mesh.mNumVertices; i++)
-			{
-				vbuf.EmplaceBack(
-				                 dx::XMFLOAT3(mesh.mVertices[i].x * scale, mesh.mVertices[i].y * scale, mesh.mVertices[i].z * scale),
-				                 *reinterpret_cast<dx::XMFLOAT3*>(&mesh.mNormals[i]),
-				                 *reinterpret_cast<dx::XMFLOAT2*>(&mesh.mTextureCoords[0][i])
-				                );
-			}
-
-			std::vector<unsigned short> indices;
-			indices.reserve(mesh.mNumFaces * 3);
-			for (unsigned int i = 0; i < mesh.mNumFaces; i++)
-			{
-				const auto& face = mesh.mFaces[i];
-				assert(face.mNumIndices == 3);
-				indices.push_back(face.mIndices[0]);
-				indices.push_back(face.mIndices[1]);
-				indices.push_back(face.mIndices[2]);
-			}
+			vbuf.Append(mesh.mNumVertices, {
+				{DynamicVertexLayout::Position3D, mesh.mVertices, sizeof(aiVector3D), scale},
+				{DynamicVertexLayout::Normal, mesh.mNormals, sizeof(aiVector3D)},
+			});
 
-			bindablePtrs.push_back(VertexBuffer::Resolve(gfx, meshTag, vbuf));
+			return {std::move(meshTag), std::move(desc), std::move(vbuf), std::move(indices)};
+		}
 
-			bindablePtrs.push_back(IndexBuffer::Resolve(gfx, meshTag, indices));
+		throw std::runtime_error("terrible combination of textures in material smh");
+	}
 
-			auto pvs   = VertexShader::Resolve(gfx, "Shaders/cso/PhongPosNormTexVS.cso");
-			auto pvsbc = pvs->GetBytecode();
-			bindablePtrs.push_back(std::move(pvs));
+	// bounding sphere around the box of the vertices, good enough to judge the size of a mesh on screen
+	DirectX::XMFLOAT4 Model::ComputeBounds(const RawVertexBufferWithLayout& vertices) noxnd
+	{
+		if (vertices.Size() == 0u)
+		{
+			return {0.0f, 0.0f, 0.0f, 0.0f};
+		}
 
-			bindablePtrs.push_back(PixelShader::Resolve(gfx, "Shaders/cso/PhongPSSpec.cso"));
-			bindablePtrs.push_back(InputLayout::Resolve(gfx, vbuf.GetLayout(), pvsbc));
+		// positions may be packed already, decode them once
+		std::vector<dx::XMFLOAT3> positions(vertices.Size());
+		for (size_t i = 0; i < vertices.Size(); i++)
+		{
+			positions[i] = vertices[i].Position();
+		}
 
-			struct PSMaterialConstantDiffuseSpec
-			{
-				float specularPowerConst;
-				BOOL  hasGloss;
-				float specularMapWeight;
-				float padding;
-			}         pmc;
-			pmc.specularPowerConst = shininess;
-			pmc.hasGloss           = hasAlphaGloss ? TRUE : FALSE;
-			pmc.specularMapWeight  = 1.0f;
-			// this is CLEARLY an issue... all meshes will share same mat const, but may have different
-			// Ns (specular power) specified for each in the material properties... bad conflict
-			bindablePtrs.push_back(PixelConstantBuffer<PSMaterialConstantDiffuseSpec>::Resolve(gfx, pmc, 1u));
+		auto lo = dx::XMLoadFloat3(&positions[0]);
+		auto hi = lo;
+		for (size_t i = 1; i < positions.size(); i++)
+		{
+			const auto p = dx::XMLoadFloat3(&positions[i]);
+			lo           = dx::XMVectorMin(lo, p);
+			hi           = dx::XMVectorMax(hi, p);
 		}
-		else if (hasDiffuseMap)
+		const auto center = (lo + hi) * 0.5f;
+
+		float radiusSq = 0.0f;
+		for (const auto& position : positions)
 		{
-			RawVertexBufferWithLayout vbuf(std::move(
-			                                         DynamicVertexLayout{}
-			                                         .Append(DynamicVertexLayout::Position3D)
-			                                         .Append(DynamicVertexLayout::Normal)
-			                                         .Append(DynamicVertexLayout::Texture2D)
-			                                        ));
+			const auto p = dx::XMLoadFloat3(&position);
+			radiusSq     = std::max(radiusSq, dx::XMVectorGetX(dx::XMVector3LengthSq(p - center)));
+		}
+
+		dx::XMFLOAT4 bounds;
+		dx::XMStoreFloat4(&bounds, center);
+		bounds.w = std::sqrt(radiusSq);
+		return bounds;
+	}
 
-			for (unsigned int i = 0; i < mesh.mNumVertices; i++)
+	std::vector<Model::ArenaBuffers> Model::ResolveArenas(Graphics& gfx, const GeometryArena& arena, bool replace)
+	{
+		std::vector<ArenaBuffers> buffers;
+		buffers.reserve(arena.arenas.size());
+		for (const auto& a : arena.arenas)
+		{
+			// the arenas are built interleaved, streams are split off only for the device
+			std::shared_ptr<VertexBuffer> pVertices;
+			if (geometryArena_.streams)
 			{
-				vbuf.EmplaceBack(
-				                 dx::XMFLOAT3(mesh.mVertices[i].x * scale, mesh.mVertices[i].y * scale, mesh.mVertices[i].z * scale),
-				                 *reinterpret_cast<dx::XMFLOAT3*>(&mesh.mNormals[i]),
-				                 *reinterpret_cast<dx::XMFLOAT2*>(&mesh.mTextureCoords[0][i])
-				                );
+				const VertexStreams streams{a.vertices};
+				pVertices = replace ? Codex::Store(std::make_shared<VertexBuffer>(gfx, a.tag, streams)) : VertexBuffer::Resolve(gfx, a.tag, streams);
 			}
-
-			std::vector<unsigned short> indices;
-			indices.reserve(mesh.mNumFaces * 3);
-			for (unsigned int i = 0; i < mesh.mNumFaces; i++)
+			else
 			{
-				const auto& face = mesh.mFaces[i];
-				assert(face.mNumIndices == 3);
-				indices.push_back(face.mIndices[0]);
-				indices.push_back(face.mIndices[1]);
-				indices.push_back(face.mIndices[2]);
+				pVertices = replace ? Codex::Store(std::make_shared<VertexBuffer>(gfx, a.tag, a.vertices)) : VertexBuffer::Resolve(gfx, a.tag, a.vertices);
 			}
+			buffers.push_back({
+				std::move(pVertices),
+				replace ? Codex::Store(std::make_shared<IndexBuffer>(gfx, a.tag, a.indices)) : IndexBuffer::Resolve(gfx, a.tag, a.indices)
+			});
+		}
+		return buffers;
+	}
 
-			bindablePtrs.push_back(VertexBuffer::Resolve(gfx, meshTag, vbuf));
-
-			bindablePtrs.push_back(IndexBuffer::Resolve(gfx, meshTag, indices));
-
-			auto pvs   = VertexShader::Resolve(gfx, "Shaders/cso/PhongPosNormTexVS.cso");
-			auto pvsbc = pvs->GetBytecode();
-			bindablePtrs.push_back(std::move(pvs));
+	// GPU half of mesh loading: resolve the textures and shaders for a parsed (or cached) mesh and draw it from its slice of the arena
+	std::unique_ptr<Mesh> Model::MakeMesh(Graphics&                   gfx,
+	                                      MeshData&                   data,
+	                                      const DecodedTextures&      textures,
+	                                      const ArenaBuffers&         buffers,
+	                                      const GeometryArena::Slice& slice)
+	{
+		std::vector<std::shared_ptr<Bindable>> bindablePtrs;
 
-			bindablePtrs.push_back(PixelShader::Resolve(gfx, "Shaders/cso/PhongPosNormTexPS.cso"));
+		// image decoded ahead of time by DecodeTextures (nullptr lets the texture load it itself)
+		const auto decoded = [&textures](const std::string& path) -> const Surface*
+		{
+			const auto i = textures.find(path);
+			return i != textures.end() ? &i->second : nullptr;
+		};
 
-			bindablePtrs.push_back(InputLayout::Resolve(gfx, vbuf.GetLayout(), pvsbc));
+		auto& material = data.material;
 
-			struct PSMaterialConstantDiffuse
-			{
-				float specularIntensity;
-				float specularPower;
-				float padding[2];
-			}         pmc;
-			pmc.specularPower     = shininess;
-			pmc.specularIntensity = (specularColor.x + specularColor.y + specularColor.z) / 3.0f;
-			// this is CLEARLY an issue... all meshes will share same mat const, but may have different
-			// Ns (specular power) specified for each in the material properties... bad conflict
-			bindablePtrs.push_back(PixelConstantBuffer<PSMaterialConstantDiffuse>::Resolve(gfx, pmc, 1u));
-		}
-		else if (!hasDiffuseMap && !hasNormalMap && !hasSpecularMap)
+		if (material.hasDiffuseMap)
 		{
-			RawVertexBufferWithLayout vbuf(std::move(
-			                                         DynamicVertexLayout{}
-			                                         .Append(DynamicVertexLayout::Position3D)
-			                                         .Append(DynamicVertexLayout::Normal)
-			                                        ));
+			auto tex                 = Texture::Resolve(gfx, material.diffusePath, 0u, decoded(material.diffusePath));
+			material.hasAlphaDiffuse = tex->HasAlpha();
+			bindablePtrs.push_back(std::move(tex));
+		}
 
-			for (unsigned int i = 0; i < mesh.mNumVertices; i++)
-			{
-				vbuf.EmplaceBack(
-				                 dx::XMFLOAT3(mesh.mVertices[i].x * scale, mesh.mVertices[i].y * scale, mesh.mVertices[i].z * scale),
-				                 *reinterpret_cast<dx::XMFLOAT3*>(&mesh.mNormals[i])
-				                );
-			}
+		if (material.hasSpecularMap)
+		{
+			auto tex               = Texture::Resolve(gfx, material.specularPath, 1u, decoded(material.specularPath));
+			material.hasAlphaGloss = tex->HasAlpha();
+			bindablePtrs.push_back(std::move(tex));
+		}
 
-			std::vector<unsigned short> indices;
-			indices.reserve(mesh.mNumFaces * 3);
-			for (unsigned int i = 0; i < mesh.mNumFaces; i++)
-			{
-				const auto& face = mesh.mFaces[i];
-				assert(face.mNumIndices == 3);
-				indices.push_back(face.mIndices[0]);
-				indices.push_back(face.mIndices[1]);
-				indices.push_back(face.mIndices[2]);
-			}
+		if (material.hasNormalMap)
+		{
+			bindablePtrs.push_back(Texture::Resolve(gfx, material.normalPath, 2u, decoded(material.normalPath)));
+		}
 
-			bindablePtrs.push_back(VertexBuffer::Resolve(gfx, meshTag, vbuf));
+		if (material.hasDiffuseMap || material.hasSpecularMap || material.hasNormalMap)
+		{
+			bindablePtrs.push_back(Sampler::Resolve(gfx));
+		}
 
-			bindablePtrs.push_back(IndexBuffer::Resolve(gfx, meshTag, indices));
+		bindablePtrs.push_back(buffers.pVertices);
 
-			auto pvs   = VertexShader::Resolve(gfx, "Shaders/cso/PhongVSNotex.cso");
-			auto pvsbc = pvs->GetBytecode();
-			bindablePtrs.push_back(std::move(pvs));
+		bindablePtrs.push_back(buffers.pIndices);
 
-			bindablePtrs.push_back(PixelShader::Resolve(gfx, "Shaders/cso/PhongPSNotex.cso"));
+		// the alpha flags are known now, so the material is complete; meshes with identical materials share its constant buffer
+		const auto  materialId = MaterialTable::Intern(Material::FromDesc(material));
+		const auto& constants  = MaterialTable::Get(materialId).constants;
 
-			bindablePtrs.push_back(InputLayout::Resolve(gfx, vbuf.GetLayout(), pvsbc));
+		// vertices packed by VertexPacking need the variant that decodes the normal (and rebuilds the bitangent)
+		const bool octNormals   = data.vertices.GetLayout().Has(DynamicVertexLayout::NormalOct);
+		const auto vertexShader = [octNormals](const std::string& name)
+		{
+			return "Shaders/cso/" + name + (octNormals ? "Oct.cso" : ".cso");
+		};
 
-			Node::PSMaterialConstantNotex pmc;
-			pmc.specularPower = shininess;
-			pmc.specularColor = specularColor;
-			pmc.materialColor = diffuseColor;
-			// this is CLEARLY an issue... all meshes will share same mat const, but may have different
-			// Ns (specular power) specified for each in the material properties... bad conflict
-			bindablePtrs.push_back(PixelConstantBuffer<Node::PSMaterialConstantNotex>::Resolve(gfx, pmc, 1u));
+		std::string vsName, psName;
+		if (std::holds_alternative<PhongConstants::Fullmonte>(constants))
+		{
+			vsName = "PhongVSNormalMap";
+			psName = material.hasAlphaDiffuse ? "PhongPSSpecNormMask" : "PhongPSSpecNormalMap";
+		}
+		else if (std::holds_alternative<PhongConstants::DiffuseNormal>(constants))
+		{
+			vsName = "PhongVSNormalMap";
+			psName = "PhongPSNormalMap";
+		}
+		else if (std::holds_alternative<PhongConstants::DiffuseSpecular>(constants))
+		{
+			vsName = "PhongPosNormTexVS";
+			psName = "PhongPSSpec";
+		}
+		else if (std::holds_alternative<PhongConstants::Diffuse>(constants))
+		{
+			vsName = "PhongPosNormTexVS";
+			psName = "PhongPosNormTexPS";
 		}
 		else
 		{
-			throw std::runtime_error("terrible combination of textures in material smh");
+			vsName = "PhongVSNotex";
+			psName = "PhongPSNotex";
 		}
 
+		auto pvs   = VertexShader::Resolve(gfx, vertexShader(vsName));
+		auto pvsbc = pvs->GetBytecode();
+		bindablePtrs.push_back(std::move(pvs));
+
+		bindablePtrs.push_back(PixelShader::Resolve(gfx, "Shaders/cso/" + psName + ".cso"));
+
+		// the buffer's layout, which knows whether the arena went to the device interleaved or in streams
+		bindablePtrs.push_back(InputLayout::Resolve(gfx, buffers.pVertices->GetLayout(), pvsbc));
+
+		bindablePtrs.push_back(MaterialTable::ResolveConstants(gfx, materialId));
+
 		// anything with alpha diffuse is 2-sided IN SPONZA, need a better way
 		// of signalling 2-sidedness to be more general in the future
-		bindablePtrs.push_back(Rasterizer::Resolve(gfx, hasAlphaDiffuse));
+		bindablePtrs.push_back(Rasterizer::Resolve(gfx, material.hasAlphaDiffuse));
 
 		bindablePtrs.push_back(Blender::Resolve(gfx, false));
 
-		return std::make_unique<Mesh>(gfx, std::move(bindablePtrs));
+		// coarser LODs are just other ranges of the same index buffer
+		std::vector<Mesh::Lod> lods;
+		for (size_t i = 0; i < data.lods.size(); i++)
+		{
+			lods.push_back({{slice.lods[i].start, slice.lods[i].count}, data.lods[i].error});
+		}
+
+		// back faces of two-sided materials are drawn as well, so their meshlets can only be culled against the frustum
+		auto meshlets = data.meshlets;
+		if (material.hasAlphaDiffuse)
+		{
+			for (auto& meshlet : meshlets)
+			{
+				meshlet.coneAxis   = {0.0f, 0.0f, 0.0f};
+				meshlet.coneCutoff = 1.0f;
+			}
+		}
+
+		return std::make_unique<Mesh>(gfx,
+		                              std::move(bindablePtrs),
+		                              Mesh::IndexRange{slice.indices.start, slice.indices.count},
+		                              slice.baseVertex,
+		                              std::move(lods),
+		                              ComputeBounds(data.vertices),
+		                              std::move(meshlets),
+		                              materialId);
 	}
 
-	std::unique_ptr<Node> Model::ParseNode(int& nextId, const aiNode& node) noexcept
+	std::unique_ptr<Mesh> Model::MakePlaceholderMesh(Graphics& gfx, MeshData& mesh, const ArenaBuffers& buffers, const GeometryArena::Slice& slice)
 	{
-		namespace dx = DirectX;
-		// parse this node
-		const auto transform = dx::XMMatrixTranspose(dx::XMLoadFloat4x4(
-		                                                                reinterpret_cast<const dx::XMFLOAT4X4*>(&node.mTransformation)
-		                                                               ));
+		// nothing of the real material is kept, so that every placeholder interns the same material (one-sided, default specular)
+		MaterialDesc placeholder;
+		placeholder.diffuseColor = placeholderColor;
+		auto material            = std::exchange(mesh.material, std::move(placeholder));
+		auto pMesh               = MakeMesh(gfx, mesh, {}, buffers, slice);
+		mesh.material            = std::move(material);
+		return pMesh;
+	}
+
+	NodeData Model::ParseNode(const aiNode& node)
+	{
+		NodeData data;
+		data.name = node.mName.C_Str();
+		XMStoreFloat4x4(&data.transform, dx::XMMatrixTranspose(dx::XMLoadFloat4x4(
+		                                                                          reinterpret_cast<const dx::XMFLOAT4X4*>(&node.mTransformation)
+		                                                                         )));
+		data.meshIndices.assign(node.mMeshes, node.mMeshes + node.mNumMeshes);
+
+		// parse its children nodes
+		data.children.reserve(node.mNumChildren);
+		for (size_t i = 0; i < node.mNumChildren; i++)
+		{
+			data.children.push_back(ParseNode(*node.mChildren[i]));
+		}
+		return data;
+	}
+
+	std::unique_ptr<Node> Model::MakeNode(int& nextId, const NodeData& node) noexcept
+	{
+		// build this node
 		std::vector<Mesh*> curMeshPtrs;
-		curMeshPtrs.reserve(node.mNumMeshes);
-		for (size_t i = 0; i < node.mNumMeshes; i++)
+		curMeshPtrs.reserve(node.meshIndices.size());
+		for (const auto meshIdx : node.meshIndices)
 		{
-			const auto meshIdx = node.mMeshes[i];
 			curMeshPtrs.push_back(meshPtrs_.at(meshIdx).get());
 		}
-		auto pNode = std::make_unique<Node>(nextId++, node.mName.C_Str(), std::move(curMeshPtrs), transform);
+		auto pNode = std::make_unique<Node>(nextId++, node.name, std::move(curMeshPtrs), XMLoadFloat4x4(&node.transform));
 
-		// parse its children nodes
-		for (size_t i = 0; i < node.mNumChildren; i++)
+		// build its children nodes
+		for (const auto& child : node.children)
 		{
-			pNode->AddChild(ParseNode(nextId, *node.mChildren[i]));
+			pNode->AddChild(MakeNode(nextId, child));
 		}
 
 		return pNode;
 	}
+
+	size_t                     Model::workerCount_      = 0u;
+	bool                       Model::splitLargeMeshes_ = false;
+	MeshOptimizer::Options     Model::optimization_;
+	MeshSimplifier::LodOptions Model::lodOptions_;
+	MeshletBuilder::Options    Model::meshletOptions_;
+	VertexPacking::Options     Model::vertexPacking_;
+	bool                       Model::objImporter_      = true;
+	bool                       Model::gltfImporter_     = true;
+	GeometryArena::Options     Model::geometryArena_;
 }
@@ -1,13 +1,22 @@
 ﻿#pragma once
+#include <cstring>
 #include <filesystem>
 
 #include "Drawable/Drawable.h"
 #include "Bindable/BindableCommon.h"
 #include "VertexView.h"
+#include "MeshData.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+#include "VertexPacking.h"
+#include "GeometryArena.h"
+#include "Material.h"
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include "Debug/ConditionalNoexcept.h"
+#include "Utils/Surface.h"
 #include "imgui/imgui.h"
 
 namespace D3DEngine
@@ -26,34 +35,101 @@ namespace D3DEngine
 	class Mesh : public Drawable
 	{
 		public:
-			Mesh(Graphics& gfx, std::vector<std::shared_ptr<Bindable>> bindPtrs);
+			struct Lod
+			{
+				IndexRange indices; // part of the mesh's index buffer
+				float      error;   // object-space deviation from the full detail mesh
+			};
+
+			struct LodSettings
+			{
+				bool  enabled        = true;
+				float maxErrorPixels = 1.0f; // coarsest LOD whose error stays below this on screen is drawn
+				float cullSizePixels = 1.0f; // meshes whose bounds cover less than this are not drawn at all
+			};
+
+			struct MeshletSettings
+			{
+				bool enabled          = true;
+				UINT minSkipTriangles = 96u;  // culled stretches of up to this many triangles are drawn anyway instead of splitting the draw
+			};
+
+			// SelectLod result for a mesh that should not be drawn
+			static constexpr size_t culled = std::numeric_limits<size_t>::max();
+
+			// indices: the mesh's part of its index buffer, which may be shared with other meshes; baseVertex is added to every index
+			// bounds: object-space bounding sphere (center, radius); a radius <= 0 turns LOD selection and culling off
+			// meshlets: ranges of the full detail indices that are culled on their own (only while drawing full detail)
+			// materialId: the MaterialTable entry the material bindables among bindPtrs were made from
+			Mesh(Graphics&                              gfx,
+			     std::vector<std::shared_ptr<Bindable>> bindPtrs,
+			     IndexRange                             indices,
+			     INT                                    baseVertex = 0,
+			     std::vector<Lod>                       lods       = {},
+			     DirectX::XMFLOAT4                      bounds     = {0.0f, 0.0f, 0.0f, 0.0f},
+			     std::vector<Meshlet>                   meshlets   = {},
+			     MaterialTable::Id                      materialId = MaterialTable::none);
+			~Mesh() override;
 			void              Draw(Graphics& gfx, DirectX::FXMMATRIX accumulatedTransform) const noxnd;
 			DirectX::XMMATRIX GetTransformXM() const noexcept override;
+			// meshes with the same ID bind the same material, so drawing them one after another could skip rebinding it
+			MaterialTable::Id GetMaterialId() const noexcept;
+			// new constants for the mesh's material (same permutation): the first edit gives the mesh a material of its own,
+			// so that the meshes it shared the old one with keep theirs, and later edits update that one in place
+			void EditMaterial(Graphics& gfx, const Material::Constants& constants);
+
+			/**
+			 * \brief Pick the LOD to draw: 0 is full detail, i is lods[i - 1], or culled.
+			 * \param radius bounding sphere radius (object space)
+			 * \param scale largest scale factor of the object to view transform
+			 * \param distance distance from the eye to the bounding sphere's center (view space)
+			 * \param pixelScale pixels covered by one view-space unit at a distance of one unit
+			 */
+			static size_t SelectLod(const std::vector<Lod>& lods,
+			                        float                   radius,
+			                        float                   scale,
+			                        float                   distance,
+			                        float                   pixelScale,
+			                        const LodSettings&      settings) noexcept;
+			static void SetLodSettings(const LodSettings& settings) noexcept;
+
+			/**
+			 * \brief Collect the index ranges of the meshlets that are neither entirely back-facing nor outside the frustum.
+			 * Neighboring survivors share a range, as do survivors at most minSkipTriangles apart.
+			 * \param eye eye position (object space)
+			 * \param planes frustum planes (object space, normalized, normals pointing inwards)
+			 * \param cones whether the normal cones may be used, which needs back faces culled and no non-uniform scale or mirroring
+			 * \return number of meshlets that survived
+			 */
+			static size_t CullMeshlets(const std::vector<Meshlet>& meshlets,
+			                           const DirectX::XMFLOAT3&    eye,
+			                           const DirectX::XMFLOAT4     (&planes)[6],
+			                           bool                        cones,
+			                           UINT                        minSkipTriangles,
+			                           std::vector<IndexRange>&    ranges);
+			static void SetMeshletSettings(const MeshletSettings& settings) noexcept;
+		private:
+			size_t SelectLod(Graphics& gfx, DirectX::FXMMATRIX transform) const noexcept;
+			size_t CullMeshlets(Graphics& gfx, DirectX::FXMMATRIX transform) const noxnd;
 		private:
-			mutable DirectX::XMFLOAT4X4 finalTransform_;
+			mutable DirectX::XMFLOAT4X4     finalTransform_;
+			IndexRange                      indices_;
+			INT                             baseVertex_;
+			std::vector<Lod>                lods_;
+			DirectX::XMFLOAT4               bounds_;
+			std::vector<Meshlet>            meshlets_;
+			MaterialTable::Id               materialId_;
+			mutable std::vector<IndexRange> drawRanges_; // survivors of the last cull, kept to reuse the allocation
+			static LodSettings              lodSettings_;
+			static MeshletSettings          meshletSettings_;
 	};
 
 	class Node
 	{
 		friend class Model;
 		public:
-			struct PSMaterialConstantFullmonte
-			{
-				BOOL              normalMapEnabled   = TRUE;
-				BOOL              specularMapEnabled = TRUE;
-				BOOL              hasGlossMap        = FALSE;
-				float             specularPower      = 3.1f;
-				DirectX::XMFLOAT3 specularColor      = {0.75f, 0.75f, 0.75f};
-				float             specularMapWeight  = 0.671f;
-			};
-
-			struct PSMaterialConstantNotex
-			{
-				DirectX::XMFLOAT4 materialColor = {0.447970f, 0.327254f, 0.176283f, 1.0f};
-				DirectX::XMFLOAT4 specularColor = {0.65f, 0.65f, 0.65f, 1.0f};
-				float             specularPower = 120.0f;
-				float             padding[3];
-			};
+			using PSMaterialConstantFullmonte = PhongConstants::Fullmonte;
+			using PSMaterialConstantNotex     = PhongConstants::Untextured;
 
 			Node(int id, const std::string& name, std::vector<Mesh*> meshPtrs, const DirectX::XMMATRIX& transform) noxnd;
 			void Draw(Graphics& gfx, DirectX::FXMMATRIX accumulatedTransform) const noxnd;
@@ -62,59 +138,60 @@ namespace D3DEngine
 			int  GetId() const noexcept;
 			void ShowTree(Node*& pSelectedNode) const noexcept;
 
+			// edits the material of the node's first mesh, which gets a material of its own instead of changing every mesh it
+			// shared the old one with; c only holds the values being edited
 			template <class T>
 			bool ControlMeDaddy(Graphics& gfx, T& c)
 			{
-				if (meshPtrs_.empty())
+				if (meshPtrs_.empty() || meshPtrs_.front()->GetMaterialId() == MaterialTable::none)
 				{
 					return false;
 				}
 
-				if constexpr (std::is_same<T, PSMaterialConstantFullmonte>::value)
+				auto&      mesh       = *meshPtrs_.front();
+				const auto pConstants = std::get_if<T>(&MaterialTable::Get(mesh.GetMaterialId()).constants);
+				if (pConstants == nullptr)
 				{
-					if (auto pcb = meshPtrs_.front()->QueryBindable<PixelConstantBuffer<T>>())
-					{
-						ImGui::Text("Material");
-
-						bool normalMapEnabled = (bool)c.normalMapEnabled;
-						ImGui::Checkbox("Norm Map", &normalMapEnabled);
-						c.normalMapEnabled = normalMapEnabled ? TRUE : FALSE;
+					return false;
+				}
+				c = *pConstants;
 
-						bool specularMapEnabled = (bool)c.specularMapEnabled;
-						ImGui::Checkbox("Spec Map", &specularMapEnabled);
-						c.specularMapEnabled = specularMapEnabled ? TRUE : FALSE;
+				ImGui::Text("Material");
+				if constexpr (std::is_same<T, PSMaterialConstantFullmonte>::value)
+				{
+					bool normalMapEnabled = (bool)c.normalMapEnabled;
+					ImGui::Checkbox("Norm Map", &normalMapEnabled);
+					c.normalMapEnabled = normalMapEnabled ? TRUE : FALSE;
 
-						bool hasGlossMap = (bool)c.hasGlossMap;
-						ImGui::Checkbox("Gloss Alpha", &hasGlossMap);
-						c.hasGlossMap = hasGlossMap ? TRUE : FALSE;
+					bool specularMapEnabled = (bool)c.specularMapEnabled;
+					ImGui::Checkbox("Spec Map", &specularMapEnabled);
+					c.specularMapEnabled = specularMapEnabled ? TRUE : FALSE;
 
-						ImGui::SliderFloat("Spec Weight", &c.specularMapWeight, 0.0f, 2.0f);
+					bool hasGlossMap = (bool)c.hasGlossMap;
+					ImGui::Checkbox("Gloss Alpha", &hasGlossMap);
+					c.hasGlossMap = hasGlossMap ? TRUE : FALSE;
 
-						ImGui::SliderFloat("Spec Pow", &c.specularPower, 0.0f, 1000.0f, "%f");
+					ImGui::SliderFloat("Spec Weight", &c.specularMapWeight, 0.0f, 2.0f);
 
-						ImGui::ColorPicker3("Spec Color", reinterpret_cast<float*>(&c.specularColor));
+					ImGui::SliderFloat("Spec Pow", &c.specularPower, 0.0f, 1000.0f, "%f");
 
-						pcb->Update(gfx, c);
-						return true;
-					}
+					ImGui::ColorPicker3("Spec Color", reinterpret_cast<float*>(&c.specularColor));
 				}
 				else if constexpr (std::is_same<T, PSMaterialConstantNotex>::value)
 				{
-					if (auto pcb = meshPtrs_.front()->QueryBindable<PixelConstantBuffer<T>>())
-					{
-						ImGui::Text("Material");
+					ImGui::ColorPicker3("Spec Color", reinterpret_cast<float*>(&c.specularColor));
 
-						ImGui::ColorPicker3("Spec Color", reinterpret_cast<float*>(&c.specularColor));
+					ImGui::SliderFloat("Spec Pow", &c.specularPower, 0.0f, 1000.0f, "%f");
 
-						ImGui::SliderFloat("Spec Pow", &c.specularPower, 0.0f, 1000.0f, "%f");
-
-						ImGui::ColorPicker3("Diff Color", reinterpret_cast<float*>(&c.materialColor));
+					ImGui::ColorPicker3("Diff Color", reinterpret_cast<float*>(&c.materialColor));
+				}
 
-						pcb->Update(gfx, c);
-						return true;
-					}
+				// compared like the table compares materials, as bytes (c started as a copy, so the padding matches)
+				if (memcmp(&c, pConstants, sizeof(T)) != 0)
+				{
+					mesh.EditMaterial(gfx, c);
 				}
-				return false;
+				return true;
 			}
 
 		private:
@@ -131,18 +208,132 @@ namespace D3DEngine
 	class Model
 	{
 		public:
-			Model(Graphics& gfx, const std::string& pathString, float scale = 1.0f);
+			enum class LoadMode
+			{
+				Blocking,    // everything is on the device by the time the constructor returns
+				Progressive, // the constructor returns right away, Update brings the model in over the following frames
+			};
+
+			// progress of a progressive load (a blocking load is complete as soon as it is constructed)
+			struct LoadStatus
+			{
+				bool   geometryReady  = false; // the model draws, meshes whose images are still being decoded with a placeholder material
+				bool   complete       = false; // every mesh has its own material
+				bool   failed         = false; // the background load threw (Update rethrew it), the model keeps what it had until Reload
+				size_t meshCount      = 0u;
+				size_t finishedMeshes = 0u;    // meshes that have their own material
+				float  geometryTime   = 0.0f;  // seconds from construction until geometryReady
+				float  completeTime   = 0.0f;  // seconds from construction until complete
+			};
+
+			Model(Graphics& gfx, const std::string& pathString, float scale = 1.0f, LoadMode mode = LoadMode::Blocking);
+			/**
+			 * \brief Move what the background load of a progressive model finished since the last call onto the device.
+			 * Call it once per frame from the thread that owns the device. The call after the geometry arrives creates every
+			 * mesh, after that at most maxUpgrades meshes per call trade their placeholder for their own material.
+			 * Errors of the background load are rethrown here, once; the model is then marked failed and keeps what it had (an empty
+			 * tree if the geometry never arrived), so it can still be drawn and reloaded.
+			 * \return whether the model is completely loaded
+			 */
+			bool              Update(Graphics& gfx, size_t maxUpgrades = 16u);
+			const LoadStatus& GetLoadStatus() const noexcept;
+			// whether the model is read from the file at path (as FileWatcher::Normalize gives it): the model itself, or a material
+			// library or buffer next to it
+			bool              DependsOn(const std::string& path) const noexcept;
+			/**
+			 * \brief Import the model file again (skipping the model cache) and swap the new meshes and nodes in, keeping the root transform.
+			 * If the import fails (e.g. because the file is still being written), the model stays as it was and the error is thrown.
+			 * \return false if a progressive load is still running, in which case nothing is reloaded
+			 */
+			bool              Reload(Graphics& gfx);
 			void Draw(Graphics& gfx) const noxnd;
 			void ShowWindow(Graphics& gfx, const char* windowName = nullptr) noexcept;
 			void SetRootTransform(DirectX::FXMMATRIX tf) noexcept;
 			// we must define this destructor in .cpp file o.w. we won't be able to declare unique_ptr to a forward declared ModelWindow
 			~Model() noxnd;
+			// import a model file (parse, then optimize, simplify and partition every mesh), without touching the device or the model cache
+			static ModelData Import(const std::string& pathString, float scale = 1.0f);
+			// what a load that misses the model cache does before the device gets involved: import, then split and compress
+			// (the alpha flags are only learned from the images)
+			static ModelData Process(const std::string& pathString, float scale = 1.0f);
+			// parse a model file into raw meshes and nodes, through ObjImporter for .obj and GltfImporter for .gltf/.glb files unless
+			// forceAssimp (or they are turned off)
+			static ModelData Parse(const std::string& pathString, float scale = 1.0f, bool forceAssimp = false);
+
+			using DecodedTextures = std::unordered_map<std::string, Surface>;
+			// decode every image the model references; images whose textures the Codex already holds are skipped if skipResident
+			static DecodedTextures DecodeTextures(const ModelData& data, bool skipResident = true);
+
+			// number of threads used for the CPU side of model loading (0 = one per hardware thread)
+			static void   SetWorkerCount(size_t count) noexcept;
+			static size_t GetWorkerCount() noexcept;
+
+			// split meshes with more than 65536 vertices so every index buffer stays 16-bit (otherwise such meshes get 32-bit indices)
+			static void SetSplitLargeMeshes(bool split) noexcept;
+			// reordering passes Import runs on every mesh (all of them by default)
+			static void SetMeshOptimization(const MeshOptimizer::Options& options) noexcept;
+			static MeshOptimizer::Options GetMeshOptimization() noexcept;
+			// simplified LODs Import generates for every mesh (maxLods = 0 turns it off)
+			static void SetLodOptions(const MeshSimplifier::LodOptions& options) noexcept;
+			// meshlets Import partitions every mesh into (maxVertices = 0 turns it off)
+			static void SetMeshletOptions(const MeshletBuilder::Options& options) noexcept;
+			// read .obj files with ObjImporter rather than Assimp (on by default)
+			static void SetObjImporter(bool enabled) noexcept;
+			// read .gltf/.glb files with GltfImporter rather than Assimp (on by default)
+			static void SetGltfImporter(bool enabled) noexcept;
+			// compact vertex formats imported meshes are switched to before upload and baking (all flags off keeps floats)
+			static void SetVertexCompression(const VertexPacking::Options& options) noexcept;
+			// whether the meshes of a model share vertex/index buffers (one pair per layout, on by default) or get a pair each
+			static void SetGeometryArena(const GeometryArena::Options& options) noexcept;
+			// hash of the options above that change what Process makes (all but the worker count and the geometry arena), which the
+			// model cache is stored under
+			static uint64_t GetImportSettingsHash() noexcept;
 		private:
-			static std::unique_ptr<Mesh> ParseMesh(Graphics& gfx, const aiMesh& mesh, const aiMaterial* const* pMaterials, const std::filesystem::path& path, float scale);
-			std::unique_ptr<Node>        ParseNode(int& nextId, const aiNode& node) noexcept;
+			struct ProgressiveLoad;
+
+			// device side of a GeometryArena::Arena
+			struct ArenaBuffers
+			{
+				std::shared_ptr<VertexBuffer> pVertices;
+				std::shared_ptr<IndexBuffer>  pIndices;
+			};
+
+			// everything before the device gets involved: cache or import, then split and compress
+			static ModelData                 Prepare(const std::string& pathString, float scale, bool& fromCache);
+			static std::vector<std::string>  ReferencedImages(const ModelData& data, bool skipResident);
+			// what the arenas' Codex tags start with: the same file imported at another scale or with other settings gets its own buffers
+			static std::string               GetArenaTag(const std::string& pathString, float scale, uint64_t settings);
+			static MeshData                  ParseMesh(const aiMesh& mesh, const aiMaterial* const* pMaterials, const std::filesystem::path& path, float scale);
+			static NodeData                  ParseNode(const aiNode& node);
+			static void                      SplitForShortIndices(ModelData& data);
+			static DirectX::XMFLOAT4         ComputeBounds(const RawVertexBufferWithLayout& vertices) noxnd;
+			// replace: make new buffers even if the Codex holds some under the arenas' tags (which stale ones do after a reload)
+			static std::vector<ArenaBuffers> ResolveArenas(Graphics& gfx, const GeometryArena& arena, bool replace = false);
+			static std::unique_ptr<Mesh>     MakeMesh(Graphics&                   gfx,
+			                                          MeshData&                   mesh,
+			                                          const DecodedTextures&      textures,
+			                                          const ArenaBuffers&         buffers,
+			                                          const GeometryArena::Slice& slice);
+			// same geometry as MakeMesh, with an untextured material in place of the mesh's own
+			static std::unique_ptr<Mesh>     MakePlaceholderMesh(Graphics& gfx, MeshData& mesh, const ArenaBuffers& buffers, const GeometryArena::Slice& slice);
+			std::unique_ptr<Node>            MakeNode(int& nextId, const NodeData& node) noexcept;
 		private:
+			static size_t                     workerCount_;
+			static bool                       splitLargeMeshes_;
+			static MeshOptimizer::Options     optimization_;
+			static MeshSimplifier::LodOptions lodOptions_;
+			static MeshletBuilder::Options    meshletOptions_;
+			static VertexPacking::Options     vertexPacking_;
+			static bool                       objImporter_;
+			static bool                       gltfImporter_;
+			static GeometryArena::Options     geometryArena_;
+
+			std::string                        path_;
+			float                              scale_;
 			std::unique_ptr<Node>              pRoot_;    // we only need to store the root pointer, which will lead us to the rest of the nodes
 			std::vector<std::unique_ptr<Mesh>> meshPtrs_; // Model owns the meshes (thus, we use unique pointers here)
 			std::unique_ptr<class ModelWindow> pWindow_;
+			std::unique_ptr<ProgressiveLoad>   pLoad_;    // state shared with the background worker, only while a progressive load runs
+			LoadStatus                         status_;
 	};
 }
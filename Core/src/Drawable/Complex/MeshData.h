@@ -0,0 +1,80 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "VertexView.h"
+
+namespace D3DEngine
+{
+	/**
+	 * \brief Everything we learn about a mesh's material from the importer, without any GPU objects attached
+	 */
+	struct MaterialDesc
+	{
+		bool              hasDiffuseMap   = false;
+		bool              hasSpecularMap  = false;
+		bool              hasNormalMap    = false;
+		bool              hasAlphaDiffuse = false; // only known once the diffuse map has been decoded
+		bool              hasAlphaGloss   = false; // only known once the specular map has been decoded
+		float             shininess       = 2.0f;  // Ns from the material (ignored when the specular map carries gloss in alpha)
+		DirectX::XMFLOAT4 specularColor   = {0.18f, 0.18f, 0.18f, 1.0f};
+		DirectX::XMFLOAT4 diffuseColor    = {0.45f, 0.45f, 0.85f, 1.0f};
+		std::string       diffusePath;
+		std::string       specularPath;
+		std::string       normalPath;
+	};
+
+	/**
+	 * \brief Coarser version of a mesh, indexing into the same vertices as the full detail mesh
+	 */
+	struct MeshLod
+	{
+		std::vector<unsigned int> indices;
+		float                     error; // object-space deviation from the full detail mesh
+	};
+
+	/**
+	 * \brief Small cluster of a mesh's triangles, with the bounds used to cull it as a whole
+	 */
+	struct Meshlet
+	{
+		unsigned int      indexOffset; // first index of the meshlet's triangles in the mesh's index list
+		unsigned int      indexCount;
+		DirectX::XMFLOAT4 sphere;      // bounding sphere (center, radius)
+		// every triangle faces away from an eye e with dot(normalize(coneApex - e), coneAxis) >= coneCutoff
+		// a zero axis (with cutoff 1) marks meshlets whose normals spread too far to ever be culled that way
+		DirectX::XMFLOAT3 coneApex;
+		DirectX::XMFLOAT3 coneAxis;
+		float             coneCutoff;
+	};
+
+	/**
+	 * \brief CPU-side result of importing a single mesh: final vertex/index data plus its material.
+	 * Turning this into bindables is the only part of model loading that needs the device.
+	 */
+	struct MeshData
+	{
+		std::string               tag; // full path + "%" + mesh name, used as the Codex tag of the geometry
+		MaterialDesc              material;
+		RawVertexBufferWithLayout vertices;
+		std::vector<unsigned int> indices;  // uploaded as 16-bit whenever every index fits
+		std::vector<MeshLod>      lods;     // from finer to coarser, may be empty
+		std::vector<Meshlet>      meshlets; // ranges of indices covering them exactly once, empty if the mesh is drawn whole
+	};
+
+	struct NodeData
+	{
+		std::string           name;
+		DirectX::XMFLOAT4X4   transform; // relative to the parent, already in DirectXMath (row-major) convention
+		std::vector<unsigned> meshIndices;
+		std::vector<NodeData> children;
+	};
+
+	/**
+	 * \brief CPU-side result of importing an entire model file
+	 */
+	struct ModelData
+	{
+		std::vector<MeshData> meshes;
+		NodeData              root;
+	};
+}
@@ -0,0 +1,415 @@
+#include "MeshOptimizer.h"
+#include <cmath>
+#include <limits>
+
+namespace D3DEngine
+{
+	namespace
+	{
+		constexpr size_t noTriangle = std::numeric_limits<size_t>::max();
+
+		// tuning from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+		constexpr size_t maxCacheSize      = 32u;
+		constexpr float  cacheDecayPower   = 1.5f;
+		constexpr float  lastTriScore      = 0.75f;
+		constexpr float  valenceBoostScale = 2.0f;
+		constexpr float  valenceBoostPower = 0.5f;
+
+		float VertexScore(int cachePosition, unsigned int remainingTriangles) noexcept
+		{
+			// vertices without triangles left to draw must never attract anything
+			if (remainingTriangles == 0u)
+			{
+				return -1.0f;
+			}
+			float score = 0.0f;
+			if (cachePosition >= 0)
+			{
+				// the three vertices of the last triangle get a fixed score so that strips are not favored over fans
+				score = cachePosition < 3
+					        ? lastTriScore
+					        : std::pow(1.0f - float(cachePosition - 3) / float(maxCacheSize - 3), cacheDecayPower);
+			}
+			// boost vertices with few triangles left, so that lone triangles get drawn instead of left behind
+			return score + valenceBoostScale * std::pow(float(remainingTriangles), -valenceBoostPower);
+		}
+
+		/**
+		 * \brief Simulated FIFO post-transform cache. A vertex is in the cache if it missed within the last cacheSize misses.
+		 */
+		class FifoCache
+		{
+			public:
+				FifoCache(size_t vertexCount, size_t cacheSize)
+					:
+					timestamps(vertexCount, 0u),
+					cacheSize(cacheSize),
+					time(cacheSize + 1u)
+				{
+				}
+
+				// returns true on a miss (which also puts the vertex into the cache)
+				bool Access(unsigned int v) noexcept
+				{
+					if (time - timestamps[v] > cacheSize)
+					{
+						timestamps[v] = time++;
+						return true;
+					}
+					return false;
+				}
+
+				void Flush() noexcept
+				{
+					time += cacheSize + 1u;
+				}
+
+			private:
+				std::vector<size_t> timestamps;
+				size_t              cacheSize;
+				size_t              time;
+		};
+
+		struct Float3
+		{
+			float x, y, z;
+
+			Float3 operator+(const Float3& rhs) const noexcept
+			{
+				return {x + rhs.x, y + rhs.y, z + rhs.z};
+			}
+
+			Float3 operator-(const Float3& rhs) const noexcept
+			{
+				return {x - rhs.x, y - rhs.y, z - rhs.z};
+			}
+
+			Float3 operator*(float s) const noexcept
+			{
+				return {x * s, y * s, z * s};
+			}
+
+			float Dot(const Float3& rhs) const noexcept
+			{
+				return x * rhs.x + y * rhs.y + z * rhs.z;
+			}
+
+			Float3 Cross(const Float3& rhs) const noexcept
+			{
+				return {y * rhs.z - z * rhs.y, z * rhs.x - x * rhs.z, x * rhs.y - y * rhs.x};
+			}
+		};
+	}
+
+	void MeshOptimizer::Optimize(RawVertexBufferWithLayout& vertices, std::vector<unsigned int>& indices, const Options& options)
+	{
+		if (indices.empty())
+		{
+			return;
+		}
+		if (options.vertexCache)
+		{
+			indices = OptimizeVertexCache(indices, vertices.Size());
+			// clustering relies on the cache-optimized order to find its cluster boundaries
+			if (options.overdraw && vertices.GetLayout().Has(DynamicVertexLayout::Position3D))
+			{
+				indices = OptimizeOverdraw(indices, vertices, options.overdrawThreshold);
+			}
+		}
+		if (options.vertexFetch)
+		{
+			OptimizeVertexFetch(vertices, indices);
+		}
+	}
+
+	std::vector<unsigned int> MeshOptimizer::OptimizeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount)
+	{
+		const size_t triangleCount = indices.size() / 3u;
+
+		// triangles using each vertex, packed into one array (the live ones are kept at the front of each vertex's range)
+		std::vector<unsigned int> remaining(vertexCount, 0u);
+		for (const auto v : indices)
+		{
+			remaining[v]++;
+		}
+		std::vector<size_t> offsets(vertexCount + 1u, 0u);
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			offsets[v + 1u] = offsets[v] + remaining[v];
+		}
+		std::vector<size_t> adjacency(indices.size());
+		{
+			std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+			for (size_t i = 0; i < indices.size(); i++)
+			{
+				adjacency[fill[indices[i]]++] = i / 3u;
+			}
+		}
+
+		std::vector<int>   cachePositions(vertexCount, -1);
+		std::vector<float> vertexScores(vertexCount);
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			vertexScores[v] = VertexScore(-1, remaining[v]);
+		}
+		std::vector<float> triangleScores(triangleCount, 0.0f);
+		std::vector<bool>  emitted(triangleCount, false);
+		size_t             best = noTriangle;
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			for (size_t k = 0; k < 3u; k++)
+			{
+				triangleScores[t] += vertexScores[indices[t * 3u + k]];
+			}
+			if (best == noTriangle || triangleScores[t] > triangleScores[best])
+			{
+				best = t;
+			}
+		}
+
+		std::vector<unsigned int> result;
+		result.reserve(indices.size());
+		std::vector<unsigned int> cache;
+		std::vector<unsigned int> newCache;
+		cache.reserve(maxCacheSize + 3u);
+		newCache.reserve(maxCacheSize + 3u);
+		size_t cursor = 0u;
+
+		for (size_t n = 0; n < triangleCount; n++)
+		{
+			// nothing in the cache touches a triangle that is left, so just continue with the next one in input order
+			if (best == noTriangle)
+			{
+				while (emitted[cursor])
+				{
+					cursor++;
+				}
+				best = cursor;
+			}
+
+			const auto pTriangle = &indices[best * 3u];
+			result.insert(result.end(), pTriangle, pTriangle + 3);
+			emitted[best] = true;
+
+			newCache.clear();
+			for (size_t k = 0; k < 3u; k++)
+			{
+				const auto v = pTriangle[k];
+				// take the triangle out of the vertex's live range
+				const auto first = adjacency.begin() + offsets[v];
+				const auto last  = first + remaining[v];
+				std::iter_swap(std::find(first, last, best), last - 1);
+				remaining[v]--;
+
+				if (std::find(newCache.begin(), newCache.end(), v) == newCache.end())
+				{
+					newCache.push_back(v);
+				}
+			}
+			for (const auto v : cache)
+			{
+				if (std::find(newCache.begin(), newCache.end(), v) == newCache.end())
+				{
+					newCache.push_back(v);
+				}
+			}
+
+			// rescore everything that moved in or out of the cache and pass the change on to its triangles
+			for (size_t i = 0; i < newCache.size(); i++)
+			{
+				const auto v        = newCache[i];
+				cachePositions[v]   = i < maxCacheSize ? (int)i : -1;
+				const auto newScore = VertexScore(cachePositions[v], remaining[v]);
+				const auto delta    = newScore - vertexScores[v];
+				vertexScores[v]     = newScore;
+				for (size_t a = offsets[v]; a < offsets[v] + remaining[v]; a++)
+				{
+					triangleScores[adjacency[a]] += delta;
+				}
+			}
+			newCache.resize(std::min(newCache.size(), maxCacheSize));
+			std::swap(cache, newCache);
+
+			// the next triangle is the best one that touches the cache
+			best = noTriangle;
+			for (const auto v : cache)
+			{
+				for (size_t a = offsets[v]; a < offsets[v] + remaining[v]; a++)
+				{
+					const auto t = adjacency[a];
+					if (best == noTriangle || triangleScores[t] > triangleScores[best])
+					{
+						best = t;
+					}
+				}
+			}
+		}
+
+		return result;
+	}
+
+	std::vector<unsigned int> MeshOptimizer::OptimizeOverdraw(const std::vector<unsigned int>& indices,
+	                                                          const RawVertexBufferWithLayout& vertices,
+	                                                          float threshold)
+	{
+		const size_t triangleCount = indices.size() / 3u;
+		if (triangleCount == 0u)
+		{
+			return indices;
+		}
+
+		// hard boundaries: wherever the cache-optimized order had to start over (a triangle missing all three vertices)
+		FifoCache           cache{vertices.Size(), analyzeCacheSize};
+		std::vector<size_t> hardStarts;
+		size_t              totalMisses = 0u;
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			size_t misses = 0u;
+			for (size_t k = 0; k < 3u; k++)
+			{
+				misses += cache.Access(indices[t * 3u + k]) ? 1u : 0u;
+			}
+			if (t == 0u || misses == 3u)
+			{
+				hardStarts.push_back(t);
+			}
+			totalMisses += misses;
+		}
+		hardStarts.push_back(triangleCount);
+		const float meshAcmr = float(totalMisses) / float(triangleCount);
+
+		// soft boundaries: cut a cluster as soon as it is about as cache-friendly as the mesh as a whole,
+		// so clusters stay small enough to sort usefully without hurting the cache much
+		std::vector<size_t> starts;
+		for (size_t h = 0; h + 1u < hardStarts.size(); h++)
+		{
+			size_t start  = hardStarts[h];
+			size_t misses = 0u;
+			starts.push_back(start);
+			cache.Flush();
+			for (size_t t = start; t < hardStarts[h + 1u]; t++)
+			{
+				for (size_t k = 0; k < 3u; k++)
+				{
+					misses += cache.Access(indices[t * 3u + k]) ? 1u : 0u;
+				}
+				const float clusterAcmr = float(misses) / float(t + 1u - start);
+				if (clusterAcmr <= meshAcmr * threshold && t + 1u < hardStarts[h + 1u])
+				{
+					start  = t + 1u;
+					misses = 0u;
+					starts.push_back(start);
+					cache.Flush();
+				}
+			}
+		}
+		starts.push_back(triangleCount);
+
+		// sort clusters so that the ones facing away from the middle of the mesh (which tend to occlude the rest) come first
+		const auto positionOffset = vertices.GetLayout().Resolve<DynamicVertexLayout::Position3D>().GetOffset();
+		const auto stride         = vertices.GetLayout().Size();
+		const auto position       = [&](unsigned int v)
+		{
+			Float3 p;
+			memcpy(&p, vertices.GetData() + v * stride + positionOffset, sizeof(Float3));
+			return p;
+		};
+
+		const size_t        clusterCount = starts.size() - 1u;
+		std::vector<Float3> centroids(clusterCount, {0.0f, 0.0f, 0.0f});
+		std::vector<Float3> normals(clusterCount, {0.0f, 0.0f, 0.0f});
+		Float3              meshCentroid = {0.0f, 0.0f, 0.0f};
+		float               meshArea     = 0.0f;
+		for (size_t c = 0; c < clusterCount; c++)
+		{
+			float area = 0.0f;
+			for (size_t t = starts[c]; t < starts[c + 1u]; t++)
+			{
+				const auto p0 = position(indices[t * 3u]);
+				const auto p1 = position(indices[t * 3u + 1u]);
+				const auto p2 = position(indices[t * 3u + 2u]);
+				// the cross product's length is twice the triangle's area, so the sum is already area weighted
+				const auto n            = (p1 - p0).Cross(p2 - p0);
+				const auto triangleArea = std::sqrt(n.Dot(n)) * 0.5f;
+				centroids[c]            = centroids[c] + (p0 + p1 + p2) * (triangleArea / 3.0f);
+				normals[c]              = normals[c] + n;
+				area += triangleArea;
+			}
+			meshCentroid = meshCentroid + centroids[c];
+			meshArea += area;
+			centroids[c] = area > 0.0f ? centroids[c] * (1.0f / area) : position(indices[starts[c] * 3u]);
+		}
+		meshCentroid = meshArea > 0.0f ? meshCentroid * (1.0f / meshArea) : Float3{0.0f, 0.0f, 0.0f};
+
+		std::vector<float> sortKeys(clusterCount);
+		for (size_t c = 0; c < clusterCount; c++)
+		{
+			const auto length = std::sqrt(normals[c].Dot(normals[c]));
+			sortKeys[c]       = length > 0.0f ? (centroids[c] - meshCentroid).Dot(normals[c]) / length : 0.0f;
+		}
+		std::vector<size_t> order(clusterCount);
+		for (size_t c = 0; c < clusterCount; c++)
+		{
+			order[c] = c;
+		}
+		std::stable_sort(order.begin(), order.end(), [&sortKeys](size_t a, size_t b)
+		{
+			return sortKeys[a] > sortKeys[b];
+		});
+
+		std::vector<unsigned int> result;
+		result.reserve(indices.size());
+		for (const auto c : order)
+		{
+			result.insert(result.end(), indices.begin() + starts[c] * 3u, indices.begin() + starts[c + 1u] * 3u);
+		}
+		return result;
+	}
+
+	void MeshOptimizer::OptimizeVertexFetch(RawVertexBufferWithLayout& vertices, std::vector<unsigned int>& indices)
+	{
+		constexpr auto unused = std::numeric_limits<unsigned int>::max();
+		const auto     stride = vertices.GetLayout().Size();
+
+		std::vector<unsigned int> remap(vertices.Size(), unused);
+		std::vector<char>         bytes;
+		bytes.reserve(vertices.SizeBytes());
+		unsigned int nextVertex = 0u;
+		for (auto& i : indices)
+		{
+			if (remap[i] == unused)
+			{
+				remap[i]           = nextVertex++;
+				const auto pVertex = vertices.GetData() + i * stride;
+				bytes.insert(bytes.end(), pVertex, pVertex + stride);
+			}
+			i = remap[i];
+		}
+		vertices = RawVertexBufferWithLayout{vertices.GetLayout(), bytes.data(), nextVertex};
+	}
+
+	MeshOptimizer::CacheStats MeshOptimizer::AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, size_t cacheSize)
+	{
+		FifoCache         cache{vertexCount, cacheSize};
+		std::vector<bool> used(vertexCount, false);
+		size_t            misses = 0u;
+		size_t            unique = 0u;
+		for (const auto v : indices)
+		{
+			misses += cache.Access(v) ? 1u : 0u;
+			if (!used[v])
+			{
+				used[v] = true;
+				unique++;
+			}
+		}
+
+		CacheStats stats;
+		if (!indices.empty())
+		{
+			stats.acmr = float(misses) / float(indices.size() / 3u);
+			stats.atvr = float(misses) / float(unique);
+		}
+		return stats;
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <vector>
+#include "VertexView.h"
+
+namespace D3DEngine
+{
+	/**
+	 * \brief Reorders triangle lists for the GPU: post-transform vertex cache locality, overdraw and vertex fetch locality.
+	 * None of the passes change what gets drawn, only the order in which it is drawn (and stored).
+	 */
+	class MeshOptimizer
+	{
+		public:
+			struct Options
+			{
+				bool  vertexCache = true;
+				bool  overdraw    = true;
+				bool  vertexFetch = true;
+				// how much worse than the cache-optimal order (in ACMR) the overdraw pass may make things
+				float overdrawThreshold = 1.05f;
+			};
+
+			struct CacheStats
+			{
+				float acmr = 0.0f; // average cache miss ratio: transformed vertices per triangle (0.5 is ideal, 3 is worst)
+				float atvr = 0.0f; // average transform to vertex ratio: transformed vertices per unique vertex (1 is ideal)
+			};
+
+			// size of the FIFO post-transform cache the metrics are simulated with
+			static constexpr size_t analyzeCacheSize = 16u;
+
+			// runs every pass enabled in options over the mesh
+			static void Optimize(RawVertexBufferWithLayout& vertices, std::vector<unsigned int>& indices, const Options& options);
+
+			// Forsyth's linear-speed vertex cache optimization
+			static std::vector<unsigned int> OptimizeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount);
+			// Tipsify-style clustering of a cache-optimized list, drawing clusters that face outwards first
+			static std::vector<unsigned int> OptimizeOverdraw(const std::vector<unsigned int>& indices,
+			                                                  const RawVertexBufferWithLayout& vertices,
+			                                                  float threshold);
+			// renumber vertices in order of first use (vertices no triangle refers to are dropped)
+			static void OptimizeVertexFetch(RawVertexBufferWithLayout& vertices, std::vector<unsigned int>& indices);
+
+			static CacheStats AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, size_t cacheSize = analyzeCacheSize);
+	};
+}
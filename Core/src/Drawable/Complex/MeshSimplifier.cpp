@@ -0,0 +1,586 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_set>
+
+namespace D3DEngine
+{
+	namespace
+	{
+		constexpr unsigned int none = std::numeric_limits<unsigned int>::max();
+
+		// how strongly open borders resist moving away from their original line
+		constexpr double borderWeight = 10.0;
+
+		struct Position
+		{
+			float x, y, z;
+		};
+
+		/**
+		 * \brief Sum of squared distances to a set of planes, weighted by the area they came from
+		 */
+		struct Quadric
+		{
+			double a00 = 0.0, a11 = 0.0, a22 = 0.0, a01 = 0.0, a02 = 0.0, a12 = 0.0;
+			double b0  = 0.0, b1  = 0.0, b2  = 0.0;
+			double c   = 0.0;
+			double weight = 0.0; // area of the triangles only, so errors can be normalized back to distances
+
+			void AddPlane(double nx, double ny, double nz, double d, double w) noexcept
+			{
+				a00 += w * nx * nx;
+				a11 += w * ny * ny;
+				a22 += w * nz * nz;
+				a01 += w * nx * ny;
+				a02 += w * nx * nz;
+				a12 += w * ny * nz;
+				b0 += w * nx * d;
+				b1 += w * ny * d;
+				b2 += w * nz * d;
+				c += w * d * d;
+			}
+
+			Quadric& operator+=(const Quadric& rhs) noexcept
+			{
+				a00 += rhs.a00;
+				a11 += rhs.a11;
+				a22 += rhs.a22;
+				a01 += rhs.a01;
+				a02 += rhs.a02;
+				a12 += rhs.a12;
+				b0 += rhs.b0;
+				b1 += rhs.b1;
+				b2 += rhs.b2;
+				c += rhs.c;
+				weight += rhs.weight;
+				return *this;
+			}
+
+			// mean squared distance of p to the planes
+			double Evaluate(const Position& p) const noexcept
+			{
+				const double x  = p.x, y = p.y, z = p.z;
+				const double rx = a00 * x + a01 * y + a02 * z + b0;
+				const double ry = a01 * x + a11 * y + a12 * z + b1;
+				const double rz = a02 * x + a12 * y + a22 * z + b2;
+				const double e  = x * rx + y * ry + z * rz + b0 * x + b1 * y + b2 * z + c;
+				return std::max(weight > 0.0 ? e / weight : e, 0.0);
+			}
+		};
+
+		// what a vertex is allowed to collapse onto
+		enum class Kind : unsigned char
+		{
+			Manifold, // anywhere
+			Border,   // only along an open border, onto another border vertex
+			Seam,     // only along the seam, together with its twin on the other side
+			Locked,   // never (e.g. where a seam meets a border, or more than two vertices share a position)
+		};
+
+		uint64_t EdgeKey(unsigned int a, unsigned int b) noexcept
+		{
+			return (uint64_t)a << 32u | b;
+		}
+
+		uint64_t UndirectedEdgeKey(unsigned int a, unsigned int b) noexcept
+		{
+			return a < b ? EdgeKey(a, b) : EdgeKey(b, a);
+		}
+
+		Position Sub(const Position& a, const Position& b) noexcept
+		{
+			return {a.x - b.x, a.y - b.y, a.z - b.z};
+		}
+
+		Position Cross(const Position& a, const Position& b) noexcept
+		{
+			return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+		}
+
+		float Dot(const Position& a, const Position& b) noexcept
+		{
+			return a.x * b.x + a.y * b.y + a.z * b.z;
+		}
+
+		std::vector<Position> ReadPositions(const RawVertexBufferWithLayout& vertices)
+		{
+			const auto offset = vertices.GetLayout().Resolve<DynamicVertexLayout::Position3D>().GetOffset();
+			const auto stride = vertices.GetLayout().Size();
+
+			std::vector<Position> positions(vertices.Size());
+			for (size_t i = 0; i < positions.size(); i++)
+			{
+				memcpy(&positions[i], vertices.GetData() + i * stride + offset, sizeof(Position));
+			}
+			return positions;
+		}
+	}
+
+	MeshSimplifier::Result MeshSimplifier::Simplify(const RawVertexBufferWithLayout& vertices,
+	                                                const std::vector<unsigned int>& indices,
+	                                                size_t                           targetIndexCount,
+	                                                float                            maxError)
+	{
+		const auto positions   = ReadPositions(vertices);
+		const auto vertexCount = (unsigned int)positions.size();
+
+		// vertices sharing a position form a group; quadrics and borders live on groups, not on vertices
+		std::vector<unsigned int> group(vertexCount);
+		std::vector<unsigned int> groupSize;
+		std::vector<unsigned int> twin(vertexCount, none);
+		{
+			struct PositionHash
+			{
+				size_t operator()(const Position& p) const noexcept
+				{
+					uint32_t h[3];
+					memcpy(h, &p, sizeof(h));
+					return std::hash<uint64_t>{}(((uint64_t)h[0] << 32u | h[1]) ^ (uint64_t)h[2] * 0x9E3779B97F4A7C15ull);
+				}
+			};
+			struct PositionEqual
+			{
+				bool operator()(const Position& a, const Position& b) const noexcept
+				{
+					return memcmp(&a, &b, sizeof(Position)) == 0;
+				}
+			};
+			std::unordered_map<Position, unsigned int, PositionHash, PositionEqual> groups;
+			groups.reserve(vertexCount);
+			std::vector<unsigned int> first;
+			for (unsigned int v = 0; v < vertexCount; v++)
+			{
+				const auto [i, inserted] = groups.try_emplace(positions[v], (unsigned int)groupSize.size());
+				group[v]                 = i->second;
+				if (inserted)
+				{
+					groupSize.push_back(1u);
+					first.push_back(v);
+				}
+				else if (++groupSize[i->second] == 2u)
+				{
+					twin[v]                = first[i->second];
+					twin[first[i->second]] = v;
+				}
+				else
+				{
+					twin[first[i->second]] = none;
+				}
+			}
+		}
+		const auto groupCount = (unsigned int)groupSize.size();
+
+		// directed edges between groups; an edge without its reverse is an open border
+		std::unordered_set<uint64_t> groupEdges;
+		groupEdges.reserve(indices.size());
+		const auto buildGroupEdges = [&](const std::vector<unsigned int>& list)
+		{
+			groupEdges.clear();
+			for (size_t i = 0; i < list.size(); i += 3)
+			{
+				for (size_t k = 0; k < 3; k++)
+				{
+					const auto a = group[list[i + k]];
+					const auto b = group[list[i + (k + 1) % 3]];
+					if (a != b)
+					{
+						groupEdges.insert(EdgeKey(a, b));
+					}
+				}
+			}
+		};
+		const auto isBorder = [&](unsigned int a, unsigned int b)
+		{
+			return groupEdges.contains(EdgeKey(a, b)) != groupEdges.contains(EdgeKey(b, a));
+		};
+
+		// classify every group once, on the full detail mesh
+		buildGroupEdges(indices);
+		std::vector<bool> onBorder(groupCount, false);
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			for (size_t k = 0; k < 3; k++)
+			{
+				const auto a = group[indices[i + k]];
+				const auto b = group[indices[i + (k + 1) % 3]];
+				if (a != b && isBorder(a, b))
+				{
+					onBorder[a] = true;
+					onBorder[b] = true;
+				}
+			}
+		}
+		std::vector<Kind> kind(groupCount);
+		for (unsigned int g = 0; g < groupCount; g++)
+		{
+			if (groupSize[g] == 1u)
+			{
+				kind[g] = onBorder[g] ? Kind::Border : Kind::Manifold;
+			}
+			else
+			{
+				kind[g] = groupSize[g] == 2u && !onBorder[g] ? Kind::Seam : Kind::Locked;
+			}
+		}
+
+		// every group starts out with the planes of the triangles around it, plus planes holding borders in place
+		std::vector<Quadric> quadrics(groupCount);
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			const auto& p0     = positions[indices[i]];
+			const auto& p1     = positions[indices[i + 1]];
+			const auto& p2     = positions[indices[i + 2]];
+			auto        normal = Cross(Sub(p1, p0), Sub(p2, p0));
+			const auto  length = std::sqrt(Dot(normal, normal));
+			if (length == 0.0f)
+			{
+				continue;
+			}
+			normal           = {normal.x / length, normal.y / length, normal.z / length};
+			const auto area  = 0.5 * length;
+			const auto plane = -(double)Dot(normal, p0);
+			for (size_t k = 0; k < 3; k++)
+			{
+				auto& q = quadrics[group[indices[i + k]]];
+				q.AddPlane(normal.x, normal.y, normal.z, plane, area);
+				q.weight += area;
+			}
+
+			for (size_t k = 0; k < 3; k++)
+			{
+				const auto a = indices[i + k];
+				const auto b = indices[i + (k + 1) % 3];
+				if (group[a] == group[b] || !isBorder(group[a], group[b]))
+				{
+					continue;
+				}
+				// plane through the border edge, perpendicular to the triangle
+				const auto edge       = Sub(positions[b], positions[a]);
+				auto       borderNorm = Cross(edge, normal);
+				const auto borderLen  = std::sqrt(Dot(borderNorm, borderNorm));
+				if (borderLen == 0.0f)
+				{
+					continue;
+				}
+				borderNorm        = {borderNorm.x / borderLen, borderNorm.y / borderLen, borderNorm.z / borderLen};
+				const auto w      = borderWeight * Dot(edge, edge);
+				const auto bPlane = -(double)Dot(borderNorm, positions[a]);
+				quadrics[group[a]].AddPlane(borderNorm.x, borderNorm.y, borderNorm.z, bPlane, w);
+				quadrics[group[b]].AddPlane(borderNorm.x, borderNorm.y, borderNorm.z, bPlane, w);
+			}
+		}
+
+		Result result;
+		result.indices         = indices;
+		auto&        list      = result.indices;
+		const double maxCost   = (double)maxError * maxError;
+		double       worstCost = 0.0;
+
+		std::unordered_set<uint64_t> vertexEdges;
+		std::vector<unsigned int>    remap(vertexCount);
+		std::vector<bool>            touched(vertexCount);
+		std::vector<unsigned int>    bestTarget(vertexCount);
+		std::vector<double>          bestCost(vertexCount);
+		std::vector<size_t>          adjacencyOffsets(vertexCount + 1u);
+		std::vector<size_t>          adjacency;
+
+		while (list.size() > targetIndexCount)
+		{
+			buildGroupEdges(list);
+			vertexEdges.clear();
+			for (size_t i = 0; i < list.size(); i += 3)
+			{
+				for (size_t k = 0; k < 3; k++)
+				{
+					vertexEdges.insert(UndirectedEdgeKey(list[i + k], list[i + (k + 1) % 3]));
+				}
+			}
+
+			const auto canCollapse = [&](unsigned int v, unsigned int u)
+			{
+				const auto gv = group[v];
+				const auto gu = group[u];
+				if (gv == gu)
+				{
+					return false;
+				}
+				switch (kind[gv])
+				{
+					case Kind::Manifold:
+						return true;
+					case Kind::Border:
+						return kind[gu] == Kind::Border && isBorder(gv, gu);
+					case Kind::Seam:
+						// the twins on the other side of the seam have to share an edge as well, so both sides collapse the same way
+						return kind[gu] == Kind::Seam && twin[u] != none &&
+						       vertexEdges.contains(UndirectedEdgeKey(twin[v], twin[u]));
+					default:
+						return false;
+				}
+			};
+
+			// cheapest collapse for every vertex
+			std::fill(bestTarget.begin(), bestTarget.end(), none);
+			std::fill(bestCost.begin(), bestCost.end(), std::numeric_limits<double>::max());
+			for (size_t i = 0; i < list.size(); i += 3)
+			{
+				for (size_t k = 0; k < 3; k++)
+				{
+					const auto a = list[i + k];
+					const auto b = list[i + (k + 1) % 3];
+					for (const auto [v, u] : {std::pair{a, b}, std::pair{b, a}})
+					{
+						if (!canCollapse(v, u))
+						{
+							continue;
+						}
+						const auto cost = quadrics[group[v]].Evaluate(positions[u]);
+						if (cost < bestCost[v])
+						{
+							bestCost[v]   = cost;
+							bestTarget[v] = u;
+						}
+					}
+				}
+			}
+
+			std::vector<unsigned int> candidates;
+			for (unsigned int v = 0; v < vertexCount; v++)
+			{
+				// only one twin of a seam pair is a candidate, the other one follows it
+				if (bestTarget[v] != none && bestCost[v] <= maxCost && (kind[group[v]] != Kind::Seam || v < twin[v]))
+				{
+					candidates.push_back(v);
+				}
+			}
+			if (candidates.empty())
+			{
+				break;
+			}
+			std::sort(candidates.begin(), candidates.end(), [&bestCost](unsigned int a, unsigned int b)
+			{
+				return bestCost[a] < bestCost[b];
+			});
+
+			// triangles around every vertex, for the flip test
+			std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0u);
+			for (const auto v : list)
+			{
+				adjacencyOffsets[v + 1u]++;
+			}
+			for (unsigned int v = 0; v < vertexCount; v++)
+			{
+				adjacencyOffsets[v + 1u] += adjacencyOffsets[v];
+			}
+			adjacency.resize(list.size());
+			{
+				std::vector<size_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+				for (size_t i = 0; i < list.size(); i++)
+				{
+					adjacency[fill[list[i]]++] = i / 3u;
+				}
+			}
+
+			for (unsigned int v = 0; v < vertexCount; v++)
+			{
+				remap[v] = v;
+			}
+			std::fill(touched.begin(), touched.end(), false);
+
+			// moving v onto u must not turn any surviving triangle around v inside out
+			const auto flips = [&](unsigned int v, unsigned int u)
+			{
+				for (size_t a = adjacencyOffsets[v]; a < adjacencyOffsets[v + 1u]; a++)
+				{
+					const auto   pTriangle = &list[adjacency[a] * 3u];
+					unsigned int t[3];
+					for (size_t k = 0; k < 3; k++)
+					{
+						t[k] = remap[pTriangle[k]];
+					}
+					// triangles on the edge (or already collapsed this pass) disappear anyway
+					if (t[0] == u || t[1] == u || t[2] == u || t[0] == t[1] || t[1] == t[2] || t[0] == t[2])
+					{
+						continue;
+					}
+					Position before[3];
+					Position after[3];
+					for (size_t k = 0; k < 3; k++)
+					{
+						before[k] = positions[t[k]];
+						after[k]  = t[k] == v ? positions[u] : positions[t[k]];
+					}
+					const auto n0 = Cross(Sub(before[1], before[0]), Sub(before[2], before[0]));
+					const auto n1 = Cross(Sub(after[1], after[0]), Sub(after[2], after[0]));
+					// squashing a triangle flat counts as well, a sliver can flip unnoticed on the next collapse
+					if (Dot(n0, n1) <= 0.25f * std::sqrt(Dot(n0, n0) * Dot(n1, n1)))
+					{
+						return true;
+					}
+				}
+				return false;
+			};
+
+			// the vertices next to both v and u have to be exactly the ones opposite the edge, or the collapse folds the surface over
+			std::vector<unsigned int> ring;
+			std::vector<unsigned int> opposite;
+			const auto linkHolds = [&](unsigned int v, unsigned int u)
+			{
+				ring.clear();
+				opposite.clear();
+				for (const auto w : {v, u})
+				{
+					for (size_t a = adjacencyOffsets[w]; a < adjacencyOffsets[w + 1u]; a++)
+					{
+						const auto   pTriangle = &list[adjacency[a] * 3u];
+						unsigned int t[3];
+						for (size_t k = 0; k < 3; k++)
+						{
+							t[k] = remap[pTriangle[k]];
+						}
+						if (t[0] == t[1] || t[1] == t[2] || t[0] == t[2])
+						{
+							continue;
+						}
+						const bool onEdge = (t[0] == v || t[1] == v || t[2] == v) && (t[0] == u || t[1] == u || t[2] == u);
+						for (const auto x : t)
+						{
+							if (x != v && x != u)
+							{
+								ring.push_back(x << 1u | (w == u ? 1u : 0u));
+								if (onEdge)
+								{
+									opposite.push_back(x);
+								}
+							}
+						}
+					}
+				}
+				if (opposite.empty())
+				{
+					return false;
+				}
+				std::sort(ring.begin(), ring.end());
+				ring.erase(std::unique(ring.begin(), ring.end()), ring.end());
+				for (size_t i = 1; i < ring.size(); i++)
+				{
+					const auto x = ring[i] >> 1u;
+					if (x == ring[i - 1u] >> 1u && std::find(opposite.begin(), opposite.end(), x) == opposite.end())
+					{
+						return false;
+					}
+				}
+				return true;
+			};
+
+			// collapses roughly remove two triangles each; stop once that would be enough to hit the target
+			const size_t trianglesToRemove = (list.size() - targetIndexCount) / 3u;
+			size_t       removed           = 0u;
+			size_t       collapses         = 0u;
+			for (const auto v : candidates)
+			{
+				if (removed >= trianglesToRemove)
+				{
+					break;
+				}
+				const auto u    = bestTarget[v];
+				const bool seam = kind[group[v]] == Kind::Seam;
+				if (touched[v] || touched[u] || (seam && (touched[twin[v]] || touched[twin[u]])))
+				{
+					continue;
+				}
+				if (!linkHolds(v, u) || flips(v, u) || (seam && (!linkHolds(twin[v], twin[u]) || flips(twin[v], twin[u]))))
+				{
+					continue;
+				}
+
+				remap[v]   = u;
+				touched[v] = touched[u] = true;
+				if (seam)
+				{
+					remap[twin[v]]   = twin[u];
+					touched[twin[v]] = touched[twin[u]] = true;
+				}
+				quadrics[group[u]] += quadrics[group[v]];
+				worstCost = std::max(worstCost, bestCost[v]);
+				removed += seam ? 4u : 2u;
+				collapses++;
+			}
+			if (collapses == 0u)
+			{
+				break;
+			}
+
+			// rewrite the list, dropping the triangles that collapsed away
+			size_t write = 0u;
+			for (size_t i = 0; i < list.size(); i += 3)
+			{
+				const auto a = remap[list[i]];
+				const auto b = remap[list[i + 1]];
+				const auto c = remap[list[i + 2]];
+				if (a != b && b != c && a != c)
+				{
+					list[write++] = a;
+					list[write++] = b;
+					list[write++] = c;
+				}
+			}
+			list.resize(write);
+		}
+
+		result.error = (float)std::sqrt(worstCost);
+		return result;
+	}
+
+	std::vector<MeshLod> MeshSimplifier::GenerateLods(const RawVertexBufferWithLayout& vertices,
+	                                                  const std::vector<unsigned int>& indices,
+	                                                  const LodOptions&                options)
+	{
+		std::vector<MeshLod> lods;
+		if (options.maxLods == 0u || indices.size() / 3u < options.minTriangles)
+		{
+			return lods;
+		}
+
+		// bounding radius of what is actually drawn, to turn the relative error budget into a distance
+		const auto positions = ReadPositions(vertices);
+		Position   lo        = positions[indices.front()];
+		Position   hi        = lo;
+		for (const auto i : indices)
+		{
+			const auto& p = positions[i];
+			lo            = {std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z)};
+			hi            = {std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z)};
+		}
+		const auto extent   = Sub(hi, lo);
+		const auto maxError = options.maxRelativeError * 0.5f * std::sqrt(Dot(extent, extent));
+
+		// each LOD is simplified from the previous one, so its error is at most the sum of the errors along the chain
+		const std::vector<unsigned int>* pPrevious = &indices;
+		float                            error     = 0.0f;
+		for (size_t l = 0; l < options.maxLods; l++)
+		{
+			const auto triangles = pPrevious->size() / 3u;
+			const auto target    = (size_t)((float)triangles * options.reduction);
+			if (target < options.minTriangles || error >= maxError)
+			{
+				break;
+			}
+
+			auto simplified = Simplify(vertices, *pPrevious, target * 3u, maxError - error);
+			// not worth an extra index buffer if the budget ran out before getting anywhere
+			if (simplified.indices.empty() || simplified.indices.size() / 3u > triangles * 9u / 10u)
+			{
+				break;
+			}
+			error += simplified.error;
+			lods.push_back({MeshOptimizer::OptimizeVertexCache(simplified.indices, vertices.Size()), error});
+			pPrevious = &lods.back().indices;
+		}
+		return lods;
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include "MeshData.h"
+
+namespace D3DEngine
+{
+	/**
+	 * \brief Quadric error edge-collapse simplification producing index lists over the mesh's original vertices.
+	 * Vertices never move (a collapse always snaps onto an existing vertex), so every LOD can share one vertex buffer.
+	 * Attribute seams (several vertices at one position) only collapse in pairs along the seam, and open borders only
+	 * collapse along the border, so neither ever tears.
+	 */
+	class MeshSimplifier
+	{
+		public:
+			struct Result
+			{
+				std::vector<unsigned int> indices;
+				float                     error = 0.0f; // largest object-space deviation any collapse introduced
+			};
+
+			struct LodOptions
+			{
+				size_t maxLods          = 4u;    // 0 disables LOD generation
+				float  reduction        = 0.5f;  // triangle count of each LOD relative to the previous one
+				float  maxRelativeError = 0.1f;  // error budget of the whole chain, relative to the mesh's bounding radius
+				size_t minTriangles     = 64u;   // no LODs are made below this many triangles
+			};
+
+			// collapse edges until at most targetIndexCount indices are left or the next collapse would exceed maxError
+			static Result Simplify(const RawVertexBufferWithLayout& vertices,
+			                       const std::vector<unsigned int>& indices,
+			                       size_t                           targetIndexCount,
+			                       float                            maxError);
+
+			// chain of successively coarser LODs, not including the full detail mesh itself
+			static std::vector<MeshLod> GenerateLods(const RawVertexBufferWithLayout& vertices,
+			                                         const std::vector<unsigned int>& indices,
+			                                         const LodOptions&                options);
+	};
+}
@@ -0,0 +1,282 @@
+#include "MeshletBuilder.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace D3DEngine
+{
+	namespace dx = DirectX;
+
+	namespace
+	{
+		constexpr unsigned int noMeshlet = std::numeric_limits<unsigned int>::max();
+
+		// normals spreading further than this from the average (cosine) are not worth a cone
+		constexpr float minConeSpread = 0.1f;
+	}
+
+	std::vector<Meshlet> MeshletBuilder::Build(const RawVertexBufferWithLayout& vertices,
+	                                           std::vector<unsigned int>&       indices,
+	                                           const Options&                   options)
+	{
+		const size_t triangleCount = indices.size() / 3u;
+		if (options.maxVertices < 3u || options.maxTriangles == 0u ||
+		    triangleCount < (options.minMeshlets > 0u ? options.minMeshlets - 1u : 0u) * options.maxTriangles + 1u)
+		{
+			return {};
+		}
+
+		// triangles around every vertex
+		const auto                vertexCount = vertices.Size();
+		std::vector<unsigned int> adjacencyOffsets(vertexCount + 1u, 0u);
+		for (const auto v : indices)
+		{
+			adjacencyOffsets[v + 1u]++;
+		}
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			adjacencyOffsets[v + 1u] += adjacencyOffsets[v];
+		}
+		std::vector<unsigned int> adjacency(indices.size());
+		{
+			std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < indices.size(); i++)
+			{
+				adjacency[fill[indices[i]]++] = (unsigned int)(i / 3u);
+			}
+		}
+
+		// triangle centers, to keep meshlets round instead of letting them run along strips
+		std::vector<dx::XMFLOAT3> centers(triangleCount);
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			auto sum = dx::XMVectorZero();
+			for (size_t k = 0; k < 3; k++)
+			{
+				const auto p = vertices[indices[t * 3u + k]].Position();
+				sum          = sum + dx::XMLoadFloat3(&p);
+			}
+			dx::XMStoreFloat3(&centers[t], sum * (1.0f / 3.0f));
+		}
+
+		std::vector<bool>         used(triangleCount, false);
+		std::vector<unsigned int> vertexMeshlet(vertexCount, noMeshlet); // last meshlet each vertex was added to
+		std::vector<unsigned int> order;                                 // triangles, meshlet after meshlet
+		std::vector<unsigned int> meshletEnds;                           // one past each meshlet's last triangle in order
+		order.reserve(triangleCount);
+
+		std::vector<unsigned int> candidates;
+		size_t                    seed = 0u;
+		while (order.size() < triangleCount)
+		{
+			const auto   meshlet       = (unsigned int)meshletEnds.size();
+			const size_t first         = order.size();
+			size_t       meshletVerts  = 0u;
+			dx::XMFLOAT3 centerSum     = {0.0f, 0.0f, 0.0f};
+			candidates.clear();
+
+			const auto newVertices = [&](unsigned int t)
+			{
+				size_t n = 0u;
+				for (size_t k = 0; k < 3; k++)
+				{
+					n += vertexMeshlet[indices[t * 3u + k]] != meshlet ? 1u : 0u;
+				}
+				return n;
+			};
+			const auto add = [&](unsigned int t)
+			{
+				used[t] = true;
+				order.push_back(t);
+				centerSum = {centerSum.x + centers[t].x, centerSum.y + centers[t].y, centerSum.z + centers[t].z};
+				for (size_t k = 0; k < 3; k++)
+				{
+					const auto v = indices[t * 3u + k];
+					if (vertexMeshlet[v] == meshlet)
+					{
+						continue;
+					}
+					vertexMeshlet[v] = meshlet;
+					meshletVerts++;
+					for (auto a = adjacencyOffsets[v]; a < adjacencyOffsets[v + 1u]; a++)
+					{
+						if (!used[adjacency[a]])
+						{
+							candidates.push_back(adjacency[a]);
+						}
+					}
+				}
+			};
+
+			while (order.size() - first < options.maxTriangles)
+			{
+				// prefer the neighbor adding the fewest vertices, and the one closest to the meshlet's center among those
+				const auto   scale    = 1.0f / (float)std::max<size_t>(order.size() - first, 1u);
+				const auto   center   = dx::XMFLOAT3{centerSum.x * scale, centerSum.y * scale, centerSum.z * scale};
+				auto         best     = noMeshlet;
+				size_t       bestNew  = 4u;
+				float        bestDist = 0.0f;
+				size_t       write    = 0u;
+				for (const auto t : candidates)
+				{
+					if (used[t])
+					{
+						continue;
+					}
+					candidates[write++] = t;
+					const auto n        = newVertices(t);
+					if (n > bestNew)
+					{
+						continue;
+					}
+					const auto& c    = centers[t];
+					const auto  dist = (c.x - center.x) * (c.x - center.x) + (c.y - center.y) * (c.y - center.y) + (c.z - center.z) * (c.z - center.z);
+					if (n < bestNew || dist < bestDist || (dist == bestDist && t < best))
+					{
+						best     = t;
+						bestNew  = n;
+						bestDist = dist;
+					}
+				}
+				candidates.resize(write);
+
+				// nothing connected left: carry on with the next triangle in order
+				if (best == noMeshlet)
+				{
+					while (used[seed])
+					{
+						seed++;
+					}
+					if (seed >= triangleCount)
+					{
+						break;
+					}
+					best    = (unsigned int)seed;
+					bestNew = newVertices(best);
+				}
+				if (meshletVerts + bestNew > options.maxVertices)
+				{
+					break;
+				}
+				add(best);
+				if (order.size() == triangleCount)
+				{
+					break;
+				}
+			}
+			std::sort(order.begin() + first, order.end());
+			meshletEnds.push_back((unsigned int)order.size());
+		}
+
+		if (meshletEnds.size() < options.minMeshlets)
+		{
+			return {};
+		}
+
+		std::vector<unsigned int> reordered;
+		reordered.reserve(indices.size());
+		for (const auto t : order)
+		{
+			reordered.insert(reordered.end(), indices.begin() + t * 3u, indices.begin() + t * 3u + 3u);
+		}
+		indices = std::move(reordered);
+
+		std::vector<Meshlet> meshlets;
+		meshlets.reserve(meshletEnds.size());
+		unsigned int begin = 0u;
+		for (const auto end : meshletEnds)
+		{
+			meshlets.push_back(ComputeBounds(vertices, indices, begin * 3u, (end - begin) * 3u));
+			begin = end;
+		}
+		return meshlets;
+	}
+
+	Meshlet MeshletBuilder::ComputeBounds(const RawVertexBufferWithLayout& vertices,
+	                                      const std::vector<unsigned int>& indices,
+	                                      unsigned int                     offset,
+	                                      unsigned int                     count)
+	{
+		Meshlet meshlet = {};
+		meshlet.indexOffset = offset;
+		meshlet.indexCount  = count;
+		meshlet.coneCutoff  = 1.0f;
+
+		const auto position = [&](size_t i)
+		{
+			const auto p = vertices[indices[i]].Position();
+			return dx::XMLoadFloat3(&p);
+		};
+
+		// sphere around the box of the vertices
+		auto lo = position(offset);
+		auto hi = lo;
+		for (size_t i = offset; i < offset + count; i++)
+		{
+			lo = dx::XMVectorMin(lo, position(i));
+			hi = dx::XMVectorMax(hi, position(i));
+		}
+		const auto center   = (lo + hi) * 0.5f;
+		float      radiusSq = 0.0f;
+		for (size_t i = offset; i < offset + count; i++)
+		{
+			radiusSq = std::max(radiusSq, dx::XMVectorGetX(dx::XMVector3LengthSq(position(i) - center)));
+		}
+		dx::XMStoreFloat4(&meshlet.sphere, center);
+		meshlet.sphere.w = std::sqrt(radiusSq);
+		dx::XMStoreFloat3(&meshlet.coneApex, center);
+
+		// cone around the average normal; cross(p1 - p0, p2 - p0) points out of the front face (clockwise, left-handed)
+		std::vector<dx::XMVECTOR> normals;
+		normals.reserve(count / 3u);
+		auto axis = dx::XMVectorZero();
+		for (size_t i = offset; i < offset + count; i += 3)
+		{
+			const auto p0     = position(i);
+			const auto normal = dx::XMVector3Cross(position(i + 1u) - p0, position(i + 2u) - p0);
+			if (dx::XMVectorGetX(dx::XMVector3LengthSq(normal)) == 0.0f)
+			{
+				continue;
+			}
+			normals.push_back(dx::XMVector3Normalize(normal));
+			axis = axis + normals.back();
+		}
+		if (normals.empty() || dx::XMVectorGetX(dx::XMVector3LengthSq(axis)) < 1e-12f)
+		{
+			return meshlet;
+		}
+		axis = dx::XMVector3Normalize(axis);
+
+		float minDot = 1.0f;
+		for (const auto& n : normals)
+		{
+			minDot = std::min(minDot, dx::XMVectorGetX(dx::XMVector3Dot(n, axis)));
+		}
+		if (minDot <= minConeSpread)
+		{
+			return meshlet;
+		}
+
+		// move the apex back along the axis until it is behind every triangle's plane, so the test holds for eyes near the meshlet
+		float maxT = 0.0f;
+		size_t n   = 0u;
+		for (size_t i = offset; i < offset + count; i += 3)
+		{
+			const auto p0     = position(i);
+			const auto normal = dx::XMVector3Cross(position(i + 1u) - p0, position(i + 2u) - p0);
+			if (dx::XMVectorGetX(dx::XMVector3LengthSq(normal)) == 0.0f)
+			{
+				continue;
+			}
+			const auto& unit = normals[n++];
+			const auto  dc   = dx::XMVectorGetX(dx::XMVector3Dot(center - p0, unit));
+			const auto  dn   = dx::XMVectorGetX(dx::XMVector3Dot(axis, unit));
+			maxT             = std::max(maxT, dc / dn);
+		}
+
+		dx::XMStoreFloat3(&meshlet.coneApex, center - axis * maxT);
+		dx::XMStoreFloat3(&meshlet.coneAxis, axis);
+		meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+		return meshlet;
+	}
+}
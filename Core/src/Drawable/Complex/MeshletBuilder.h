@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+#include "MeshData.h"
+
+namespace D3DEngine
+{
+	/**
+	 * \brief Partitions a mesh's triangles into small clusters (meshlets) that can be culled on their own.
+	 * Every meshlet is a contiguous range of the mesh's index list, so the survivors of a cull are drawn straight from the
+	 * mesh's one index buffer.
+	 */
+	class MeshletBuilder
+	{
+		public:
+			struct Options
+			{
+				size_t maxVertices  = 64u;  // 0 disables meshlet building
+				size_t maxTriangles = 124u;
+				size_t minMeshlets  = 4u;   // meshes that would make fewer meshlets than this are always drawn whole
+			};
+
+			/**
+			 * \brief Grow meshlets over shared vertices, then reorder indices so each meshlet's triangles are contiguous.
+			 * Triangles keep their relative order inside a meshlet (and meshlets are seeded in triangle order), so most of the
+			 * locality from MeshOptimizer survives.
+			 */
+			static std::vector<Meshlet> Build(const RawVertexBufferWithLayout& vertices,
+			                                  std::vector<unsigned int>&       indices,
+			                                  const Options&                   options);
+
+			// bounding sphere and normal cone of the triangles in indices[offset, offset + count)
+			static Meshlet ComputeBounds(const RawVertexBufferWithLayout& vertices,
+			                             const std::vector<unsigned int>& indices,
+			                             unsigned int                     offset,
+			                             unsigned int                     count);
+	};
+}
@@ -0,0 +1,635 @@
+#include "ModelCache.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+#include "Utils/MappedFile.h"
+#include "Utils/FileWatcher.h"
+
+// Cache file layout (native endianness, everything tightly packed unless noted):
+//
+//   header       char[4] magic "D3MC", uint32 version, float scale, uint64 import settings hash (Model::GetImportSettingsHash)
+//   dependencies uint32 count, then per file: string path, uint64 size, int64 last write time
+//   meshes       uint32 count, then per mesh:
+//                  string tag
+//                  material: uint8 flags[5], float shininess, float4 specular, float4 diffuse, string paths[3]
+//                  uint32 element count, uint8 element types[]
+//                  uint32 vertex count, <pad to 16> vertex data
+//                  index list
+//                  uint32 lod count, then per LOD: float error, index list
+//                  uint32 meshlet count, Meshlet meshlets[]
+//   index list   uint32 count, uint8 index size (2 or 4), <pad to 16> indices (16-bit whenever they all fit)
+//   nodes        pre-order: string name, float4x4 transform, uint32 mesh count, uint32 mesh indices[], uint32 child count
+//
+// strings are stored as uint32 length followed by the characters (no terminator)
+// vertex and index blobs are 16-byte aligned so they can be consumed straight from the mapped view
+
+namespace D3DEngine
+{
+	namespace
+	{
+		constexpr char   magic[4]  = {'D', '3', 'M', 'C'};
+		constexpr size_t alignment = 16u;
+
+		struct FileStamp
+		{
+			uint64_t size;
+			int64_t  time;
+		};
+
+		std::optional<FileStamp> StampFile(const std::string& path)
+		{
+			std::error_code ec;
+			const auto      size = std::filesystem::file_size(path, ec);
+			if (ec)
+			{
+				return std::nullopt;
+			}
+			const auto time = std::filesystem::last_write_time(path, ec);
+			if (ec)
+			{
+				return std::nullopt;
+			}
+			return FileStamp{(uint64_t)size, (int64_t)time.time_since_epoch().count()};
+		}
+
+		// file names are case-insensitive here, so "Models\Sponza" and "models/sponza" name the same dependency
+		bool SamePath(const std::string& a, const std::string& b) noexcept
+		{
+			try
+			{
+				return a == b || FileWatcher::Normalize(a) == FileWatcher::Normalize(b);
+			}
+			catch (...)
+			{
+				return false;
+			}
+		}
+
+		class Writer
+		{
+			public:
+				template <typename T>
+				void Write(const T& value)
+				{
+					static_assert(std::is_trivially_copyable<T>::value, "Can only write trivially copyable types");
+					Write(&value, sizeof(T));
+				}
+
+				void Write(const void* pData, size_t size)
+				{
+					const auto pBytes = static_cast<const char*>(pData);
+					bytes.insert(bytes.end(), pBytes, pBytes + size);
+				}
+
+				void WriteString(const std::string& s)
+				{
+					Write((uint32_t)s.size());
+					Write(s.data(), s.size());
+				}
+
+				void Align()
+				{
+					bytes.resize((bytes.size() + alignment - 1u) / alignment * alignment, 0);
+				}
+
+				const std::vector<char>& GetBytes() const noexcept
+				{
+					return bytes;
+				}
+
+			private:
+				std::vector<char> bytes;
+		};
+
+		// reads from the mapped view with bounds checking; any overrun marks the whole read as failed
+		class Reader
+		{
+			public:
+				Reader(const char* pData, size_t size) noexcept
+					:
+					pData(pData),
+					size(size)
+				{
+				}
+
+				template <typename T>
+				T Read() noexcept
+				{
+					T value{};
+					if (const auto p = Take(sizeof(T)))
+					{
+						memcpy(&value, p, sizeof(T));
+					}
+					return value;
+				}
+
+				std::string ReadString()
+				{
+					const auto length = Read<uint32_t>();
+					const auto p      = Take(length);
+					return p ? std::string(p, length) : std::string{};
+				}
+
+				// returns a pointer into the mapped view (nullptr on overrun)
+				const char* Take(size_t n) noexcept
+				{
+					if (!ok || size - cursor < n)
+					{
+						ok = false;
+						return nullptr;
+					}
+					const auto p = pData + cursor;
+					cursor += n;
+					return p;
+				}
+
+				void Align() noexcept
+				{
+					Take((alignment - cursor % alignment) % alignment);
+				}
+
+				bool Ok() const noexcept
+				{
+					return ok;
+				}
+
+				bool AtEnd() const noexcept
+				{
+					return cursor == size;
+				}
+
+			private:
+				const char* pData;
+				size_t      size;
+				size_t      cursor = 0u;
+				bool        ok     = true;
+		};
+
+		void WriteIndices(Writer& w, const std::vector<unsigned int>& indices)
+		{
+			const bool shortIndices = indices.empty() || *std::max_element(indices.begin(), indices.end()) <= 0xFFFFu;
+			w.Write((uint32_t)indices.size());
+			w.Write((uint8_t)(shortIndices ? sizeof(uint16_t) : sizeof(uint32_t)));
+			w.Align();
+			if (shortIndices)
+			{
+				const std::vector<uint16_t> narrow(indices.begin(), indices.end());
+				w.Write(narrow.data(), narrow.size() * sizeof(uint16_t));
+			}
+			else
+			{
+				w.Write(indices.data(), indices.size() * sizeof(uint32_t));
+			}
+		}
+
+		// indices must all be below vertexCount, anything else means the file is corrupt
+		std::optional<std::vector<unsigned int>> ReadIndices(Reader& r, size_t vertexCount)
+		{
+			const auto count     = r.Read<uint32_t>();
+			const auto indexSize = r.Read<uint8_t>();
+			if (!r.Ok() || (indexSize != sizeof(uint16_t) && indexSize != sizeof(uint32_t)))
+			{
+				return std::nullopt;
+			}
+			r.Align();
+			const auto pIndices = r.Take((size_t)count * indexSize);
+			if (!r.Ok())
+			{
+				return std::nullopt;
+			}
+
+			std::vector<unsigned int> indices(count);
+			if (indexSize == sizeof(uint16_t))
+			{
+				const auto pShort = reinterpret_cast<const uint16_t*>(pIndices);
+				std::copy(pShort, pShort + count, indices.begin());
+			}
+			else
+			{
+				memcpy(indices.data(), pIndices, count * sizeof(uint32_t));
+			}
+			if (std::any_of(indices.begin(), indices.end(), [vertexCount](unsigned int i) { return i >= vertexCount; }))
+			{
+				return std::nullopt;
+			}
+			return indices;
+		}
+
+		void WriteNode(Writer& w, const NodeData& node)
+		{
+			w.WriteString(node.name);
+			w.Write(node.transform);
+			w.Write((uint32_t)node.meshIndices.size());
+			w.Write(node.meshIndices.data(), node.meshIndices.size() * sizeof(unsigned));
+			w.Write((uint32_t)node.children.size());
+			for (const auto& child : node.children)
+			{
+				WriteNode(w, child);
+			}
+		}
+
+		bool ReadNode(Reader& r, NodeData& node, size_t meshCount)
+		{
+			node.name      = r.ReadString();
+			node.transform = r.Read<DirectX::XMFLOAT4X4>();
+			const auto n   = r.Read<uint32_t>();
+			if (const auto p = r.Take(n * sizeof(uint32_t)))
+			{
+				node.meshIndices.resize(n);
+				memcpy(node.meshIndices.data(), p, n * sizeof(uint32_t));
+			}
+			// a node referencing a mesh that isn't there means the file is corrupt
+			for (const auto i : node.meshIndices)
+			{
+				if (i >= meshCount)
+				{
+					return false;
+				}
+			}
+			const auto childCount = r.Read<uint32_t>();
+			for (uint32_t i = 0; i < childCount && r.Ok(); i++)
+			{
+				if (!ReadNode(r, node.children.emplace_back(), meshCount))
+				{
+					return false;
+				}
+			}
+			return r.Ok();
+		}
+	}
+
+	std::string ModelCache::GetCachePath(const std::string& sourcePath)
+	{
+		return sourcePath + ".d3dcache";
+	}
+
+	std::vector<std::string> ModelCache::GetSideFiles(const std::string& modelPath)
+	{
+		const MappedFile file{modelPath};
+		if (!file.IsOpen())
+		{
+			return {};
+		}
+		const std::string_view text{file.GetData(), file.GetSize()};
+		const auto             directory = std::filesystem::path{modelPath}.parent_path();
+		const auto             extension = std::filesystem::path{modelPath}.extension().string();
+
+		std::vector<std::string> names;
+		if (extension == ".obj" || extension == ".OBJ")
+		{
+			// the rest of every "mtllib" line, like ObjImporter reads it
+			for (size_t start = 0u; start < text.size();)
+			{
+				auto end = text.find('\n', start);
+				end      = end == std::string_view::npos ? text.size() : end;
+				auto ln  = text.substr(start, end - start);
+				start    = end + 1u;
+
+				ln.remove_prefix(std::min(ln.find_first_not_of(" \t"), ln.size()));
+				if (ln.starts_with("mtllib") && ln.size() > 6u && (ln[6] == ' ' || ln[6] == '\t'))
+				{
+					ln.remove_prefix(6u);
+					ln.remove_prefix(std::min(ln.find_first_not_of(" \t"), ln.size()));
+					ln = ln.substr(0u, ln.find_last_not_of(" \t\r") + 1u);
+					names.emplace_back(ln);
+				}
+			}
+		}
+		else
+		{
+			// every "uri" in the JSON (of a .glb as well, its JSON chunk is plain text) that is not embedded data
+			for (auto i = text.find("\"uri\""); i != std::string_view::npos; i = text.find("\"uri\"", i + 1u))
+			{
+				const auto colon = text.find_first_not_of(" \t\r\n", i + 5u);
+				const auto quote = colon == std::string_view::npos ? colon : text.find_first_not_of(" \t\r\n", colon + 1u);
+				if (colon == std::string_view::npos || text[colon] != ':' || quote == std::string_view::npos || text[quote] != '"')
+				{
+					continue;
+				}
+				const auto close = text.find('"', quote + 1u);
+				const auto uri   = text.substr(quote + 1u, close - quote - 1u);
+				if (close != std::string_view::npos && !uri.starts_with("data:"))
+				{
+					names.emplace_back(uri);
+				}
+			}
+		}
+
+		std::vector<std::string> paths;
+		for (const auto& name : names)
+		{
+			auto path = (directory / name).string();
+			if (std::filesystem::exists(path) && std::ranges::find(paths, path) == paths.end())
+			{
+				paths.push_back(std::move(path));
+			}
+		}
+		return paths;
+	}
+
+	std::vector<std::string> ModelCache::GetAlphaImages(const ModelData& data)
+	{
+		std::vector<std::string> paths;
+		const auto               add = [&paths](const std::string& path)
+		{
+			if (std::ranges::find(paths, path) == paths.end())
+			{
+				paths.push_back(path);
+			}
+		};
+		for (const auto& mesh : data.meshes)
+		{
+			if (mesh.material.hasDiffuseMap)
+			{
+				add(mesh.material.diffusePath);
+			}
+			if (mesh.material.hasSpecularMap)
+			{
+				add(mesh.material.specularPath);
+			}
+		}
+		return paths;
+	}
+
+	// the cache has to be rebuilt whenever the model file or any file that went into it changes, these are the same inputs the AssetBaker checks
+	std::vector<std::string> ModelCache::GetDependencies(const std::string& sourcePath, const ModelData& model)
+	{
+		std::vector<std::string> deps = {sourcePath};
+		for (auto& path : GetSideFiles(sourcePath))
+		{
+			deps.push_back(std::move(path));
+		}
+		for (auto& path : GetAlphaImages(model))
+		{
+			deps.push_back(std::move(path));
+		}
+		return deps;
+	}
+
+	std::optional<ModelData> ModelCache::Load(const std::string& sourcePath, float scale, uint64_t settings)
+	{
+		const MappedFile file{GetCachePath(sourcePath)};
+		if (!file.IsOpen())
+		{
+			return std::nullopt;
+		}
+
+		Reader r{file.GetData(), file.GetSize()};
+
+		// header
+		const auto pMagic = r.Take(sizeof(magic));
+		if (pMagic == nullptr || memcmp(pMagic, magic, sizeof(magic)) != 0 ||
+		    r.Read<uint32_t>() != version ||
+		    r.Read<float>() != scale ||
+		    r.Read<uint64_t>() != settings)
+		{
+			return std::nullopt;
+		}
+
+		// stale if any dependency was removed or touched since the cache was baked (which files those are depends on the
+		// imported model, so the list stored by Save is checked; naming other files takes an edit to the source, the first entry)
+		const auto depCount = r.Read<uint32_t>();
+		if (depCount == 0u)
+		{
+			return std::nullopt;
+		}
+		for (uint32_t i = 0; i < depCount; i++)
+		{
+			const auto path = r.ReadString();
+			const auto size = r.Read<uint64_t>();
+			const auto time = r.Read<int64_t>();
+			if (!r.Ok() || (i == 0u && !SamePath(path, sourcePath)))
+			{
+				return std::nullopt;
+			}
+			const auto stamp = StampFile(path);
+			if (!stamp || stamp->size != size || stamp->time != time)
+			{
+				return std::nullopt;
+			}
+		}
+
+		ModelData  model;
+		const auto meshCount = r.Read<uint32_t>();
+		model.meshes.reserve(meshCount);
+		for (uint32_t m = 0; m < meshCount && r.Ok(); m++)
+		{
+			auto tag = r.ReadString();
+
+			MaterialDesc material;
+			material.hasDiffuseMap   = r.Read<uint8_t>() != 0;
+			material.hasSpecularMap  = r.Read<uint8_t>() != 0;
+			material.hasNormalMap    = r.Read<uint8_t>() != 0;
+			material.hasAlphaDiffuse = r.Read<uint8_t>() != 0;
+			material.hasAlphaGloss   = r.Read<uint8_t>() != 0;
+			material.shininess       = r.Read<float>();
+			material.specularColor   = r.Read<DirectX::XMFLOAT4>();
+			material.diffuseColor    = r.Read<DirectX::XMFLOAT4>();
+			material.diffusePath     = r.ReadString();
+			material.specularPath    = r.ReadString();
+			material.normalPath      = r.ReadString();
+
+			DynamicVertexLayout layout;
+			const auto          elementCount = r.Read<uint32_t>();
+			for (uint32_t e = 0; e < elementCount && r.Ok(); e++)
+			{
+				const auto type = r.Read<uint8_t>();
+				if (type >= DynamicVertexLayout::Count)
+				{
+					return std::nullopt;
+				}
+				layout.Append((DynamicVertexLayout::ElementType)type);
+			}
+			const auto vertexCount = r.Read<uint32_t>();
+			if (!r.Ok() || layout.Size() == 0u)
+			{
+				return std::nullopt;
+			}
+			r.Align();
+			const auto pVertices = r.Take(layout.Size() * vertexCount);
+
+			auto indices = ReadIndices(r, vertexCount);
+			if (!indices)
+			{
+				return std::nullopt;
+			}
+
+			std::vector<MeshLod> lods;
+			const auto           lodCount = r.Read<uint32_t>();
+			for (uint32_t l = 0; l < lodCount && r.Ok(); l++)
+			{
+				const auto error      = r.Read<float>();
+				auto       lodIndices = ReadIndices(r, vertexCount);
+				if (!lodIndices)
+				{
+					return std::nullopt;
+				}
+				lods.push_back({std::move(*lodIndices), error});
+			}
+
+			// meshlets have to be whole triangles inside the index list
+			const auto meshletCount = r.Read<uint32_t>();
+			const auto pMeshlets    = r.Take((size_t)meshletCount * sizeof(Meshlet));
+			if (!r.Ok())
+			{
+				return std::nullopt;
+			}
+			std::vector<Meshlet> meshlets(meshletCount);
+			memcpy(meshlets.data(), pMeshlets, meshletCount * sizeof(Meshlet));
+			for (const auto& meshlet : meshlets)
+			{
+				if (meshlet.indexCount % 3u != 0u || (size_t)meshlet.indexOffset + meshlet.indexCount > indices->size())
+				{
+					return std::nullopt;
+				}
+			}
+
+			model.meshes.push_back({
+				std::move(tag),
+				std::move(material),
+				RawVertexBufferWithLayout{std::move(layout), pVertices, vertexCount},
+				std::move(*indices),
+				std::move(lods),
+				std::move(meshlets)
+			});
+		}
+
+		if (!r.Ok() || !ReadNode(r, model.root, model.meshes.size()) || !r.AtEnd())
+		{
+			return std::nullopt;
+		}
+		return model;
+	}
+
+	bool ModelCache::Save(const std::string& sourcePath, float scale, uint64_t settings, const ModelData& model)
+	{
+		Writer w;
+		w.Write(magic);
+		w.Write(version);
+		w.Write(scale);
+		w.Write(settings);
+
+		const auto deps = GetDependencies(sourcePath, model);
+		w.Write((uint32_t)deps.size());
+		for (const auto& dep : deps)
+		{
+			const auto stamp = StampFile(dep);
+			if (!stamp)
+			{
+				return false;
+			}
+			w.WriteString(dep);
+			w.Write(stamp->size);
+			w.Write(stamp->time);
+		}
+
+		w.Write((uint32_t)model.meshes.size());
+		for (const auto& mesh : model.meshes)
+		{
+			w.WriteString(mesh.tag);
+
+			const auto& material = mesh.material;
+			w.Write((uint8_t)material.hasDiffuseMap);
+			w.Write((uint8_t)material.hasSpecularMap);
+			w.Write((uint8_t)material.hasNormalMap);
+			w.Write((uint8_t)material.hasAlphaDiffuse);
+			w.Write((uint8_t)material.hasAlphaGloss);
+			w.Write(material.shininess);
+			w.Write(material.specularColor);
+			w.Write(material.diffuseColor);
+			w.WriteString(material.diffusePath);
+			w.WriteString(material.specularPath);
+			w.WriteString(material.normalPath);
+
+			const auto& layout = mesh.vertices.GetLayout();
+			w.Write((uint32_t)layout.GetElementCount());
+			for (size_t e = 0; e < layout.GetElementCount(); e++)
+			{
+				w.Write((uint8_t)layout.ResolveByIndex(e).GetType());
+			}
+			w.Write((uint32_t)mesh.vertices.Size());
+			w.Align();
+			w.Write(mesh.vertices.GetData(), mesh.vertices.SizeBytes());
+
+			// indices are stored as narrow as the index buffer will be
+			WriteIndices(w, mesh.indices);
+			w.Write((uint32_t)mesh.lods.size());
+			for (const auto& lod : mesh.lods)
+			{
+				w.Write(lod.error);
+				WriteIndices(w, lod.indices);
+			}
+			w.Write((uint32_t)mesh.meshlets.size());
+			w.Write(mesh.meshlets.data(), mesh.meshlets.size() * sizeof(Meshlet));
+		}
+
+		WriteNode(w, model.root);
+
+		// write to a temporary first so that a crash mid-write never leaves a half-baked cache behind
+		const auto cachePath = GetCachePath(sourcePath);
+		const auto tempPath  = cachePath + ".tmp";
+		{
+			std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+			if (!out)
+			{
+				return false;
+			}
+			const auto& bytes = w.GetBytes();
+			out.write(bytes.data(), (std::streamsize)bytes.size());
+			if (!out)
+			{
+				return false;
+			}
+		}
+		std::error_code ec;
+		std::filesystem::rename(tempPath, cachePath, ec);
+		return !ec;
+	}
+
+	void ModelCache::Invalidate(const std::string& sourcePath) noexcept
+	{
+		std::error_code ec;
+		std::filesystem::remove(GetCachePath(sourcePath), ec);
+	}
+
+	bool ModelCache::Restamp(const std::string& sourcePath, float scale, uint64_t settings)
+	{
+		std::fstream file(GetCachePath(sourcePath), std::ios::binary | std::ios::in | std::ios::out);
+		char         fileMagic[sizeof(magic)];
+		uint32_t     fileVersion;
+		float        fileScale;
+		uint64_t     fileSettings;
+		uint32_t     count;
+		file.read(fileMagic, sizeof(fileMagic));
+		file.read(reinterpret_cast<char*>(&fileVersion), sizeof(fileVersion));
+		file.read(reinterpret_cast<char*>(&fileScale), sizeof(fileScale));
+		file.read(reinterpret_cast<char*>(&fileSettings), sizeof(fileSettings));
+		file.read(reinterpret_cast<char*>(&count), sizeof(count));
+		if (!file || memcmp(fileMagic, magic, sizeof(magic)) != 0 || fileVersion != version || fileScale != scale || fileSettings != settings ||
+		    count == 0u)
+		{
+			return false;
+		}
+
+		// the stored dependencies are the ones Save found in the imported model, which the caller just vouched for
+		for (uint32_t i = 0; i < count; i++)
+		{
+			uint32_t length = 0u;
+			file.read(reinterpret_cast<char*>(&length), sizeof(length));
+			std::string path(file ? length : 0u, '\0');
+			file.read(path.data(), (std::streamsize)path.size());
+			const auto stamp = file ? StampFile(path) : std::nullopt;
+			if (!file || (i == 0u && !SamePath(path, sourcePath)) || !stamp)
+			{
+				return false;
+			}
+			// stamps are fixed size, so they are overwritten where they are
+			file.seekp(file.tellg());
+			file.write(reinterpret_cast<const char*>(&stamp->size), sizeof(stamp->size));
+			file.write(reinterpret_cast<const char*>(&stamp->time), sizeof(stamp->time));
+			file.seekg(file.tellp());
+		}
+		return (bool)file;
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include "MeshData.h"
+
+namespace D3DEngine
+{
+	/**
+	 * \brief Versioned binary cache of fully imported models, so that warm starts can skip Assimp entirely.
+	 * The cache lives next to the source file and is only used if it was baked from the same version of
+	 * the source (and the files it names, like the .mtl, and the images whose alpha it holds) with the same scale and import settings (Model::GetImportSettingsHash).
+	 */
+	class ModelCache
+	{
+		public:
+			// bump whenever the file layout or the content of ModelData changes
+			static constexpr uint32_t version = 8u;
+
+			static std::string              GetCachePath(const std::string& sourcePath);
+			// settings: hash of the options the model was imported with, a cache made with other options is stale
+			static std::optional<ModelData> Load(const std::string& sourcePath, float scale, uint64_t settings);
+			static bool                     Save(const std::string& sourcePath, float scale, uint64_t settings, const ModelData& model);
+			static void                     Invalidate(const std::string& sourcePath) noexcept;
+			// make a cache baked with this scale and these settings current again after its source files were touched without changing
+			// them (returns false if there is no such cache, or it was made from other files)
+			static bool                     Restamp(const std::string& sourcePath, float scale, uint64_t settings);
+			// files a model file names besides its images: the .mtl libraries of an .obj, the buffers of a glTF (only the ones that exist)
+			static std::vector<std::string> GetSideFiles(const std::string& modelPath);
+			// the images a baked model depends on: only the ones whose alpha ends up in the cache (diffuse and specular maps)
+			static std::vector<std::string> GetAlphaImages(const ModelData& model);
+		private:
+			static std::vector<std::string> GetDependencies(const std::string& sourcePath, const ModelData& model);
+	};
+}
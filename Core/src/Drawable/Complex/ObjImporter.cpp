@@ -0,0 +1,1040 @@
+#include "ObjImporter.h"
+#include "Mesh.h"
+#include "TangentSpace.h"
+#include "Utils/MappedFile.h"
+#include "Utils/Parallel.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+namespace D3DEngine
+{
+	namespace dx = DirectX;
+
+	namespace
+	{
+		// files are cut into pieces of about this size for the parallel parse
+		constexpr size_t chunkSize = 1u << 20;
+		constexpr int    noIndex   = -1;
+
+		// ---------------------------------------------------------------------------
+		// text scanning, straight from the mapping (which is not null terminated)
+
+		bool IsSpace(char c) noexcept
+		{
+			return c == ' ' || c == '\t';
+		}
+
+		bool IsLineEnd(char c) noexcept
+		{
+			return c == '\n' || c == '\r';
+		}
+
+		bool IsDigit(char c) noexcept
+		{
+			return c >= '0' && c <= '9';
+		}
+
+		char ToLower(char c) noexcept
+		{
+			return c >= 'A' && c <= 'Z' ? char(c - 'A' + 'a') : c;
+		}
+
+		const char* SkipSpaces(const char* p, const char* end) noexcept
+		{
+			while (p < end && IsSpace(*p))
+			{
+				p++;
+			}
+			return p;
+		}
+
+		const char* NextLine(const char* p, const char* end) noexcept
+		{
+			p = static_cast<const char*>(std::memchr(p, '\n', end - p));
+			return p ? p + 1 : end;
+		}
+
+		// the rest of the line without surrounding whitespace (names may contain spaces)
+		std::string_view RestOfLine(const char* p, const char* end) noexcept
+		{
+			p          = SkipSpaces(p, end);
+			auto* last = static_cast<const char*>(std::memchr(p, '\n', end - p));
+			last       = last ? last : end;
+			while (last > p && (IsSpace(last[-1]) || last[-1] == '\r'))
+			{
+				last--;
+			}
+			return {p, size_t(last - p)};
+		}
+
+		// keyword at p, followed by whitespace (MTL keywords are not case sensitive, OBJ ones are)
+		bool IsKeyword(const char* p, const char* end, std::string_view keyword, bool matchCase = true) noexcept
+		{
+			if (size_t(end - p) <= keyword.size() || !(IsSpace(p[keyword.size()]) || IsLineEnd(p[keyword.size()])))
+			{
+				return false;
+			}
+			for (size_t i = 0; i < keyword.size(); i++)
+			{
+				if (matchCase ? p[i] != keyword[i] : ToLower(p[i]) != ToLower(keyword[i]))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		constexpr double powersOf10[] = {
+			1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
+
+		// Clinger's fast path: exact whenever the digits fit a double's mantissa and the power of ten is exact as well,
+		// which covers everything exporters write; anything else goes through strtof. A missing number reads as 0.
+		const char* ParseFloat(const char* p, const char* end, float& value) noexcept
+		{
+			p                   = SkipSpaces(p, end);
+			const char* start   = p;
+			const bool negative = p < end && *p == '-';
+			if (p < end && (*p == '-' || *p == '+'))
+			{
+				p++;
+			}
+
+			uint64_t mantissa = 0u;
+			int      digits   = 0; // significant ones in the mantissa
+			int      exponent = 0;
+			bool     any      = false;
+			for (; p < end && IsDigit(*p); p++)
+			{
+				any = true;
+				if (digits < 19)
+				{
+					mantissa = mantissa * 10u + uint64_t(*p - '0');
+					digits += mantissa != 0u;
+				}
+				else
+				{
+					exponent++;
+				}
+			}
+			if (p < end && *p == '.')
+			{
+				for (p++; p < end && IsDigit(*p); p++)
+				{
+					any = true;
+					if (digits < 19)
+					{
+						mantissa = mantissa * 10u + uint64_t(*p - '0');
+						digits += mantissa != 0u;
+						exponent--;
+					}
+				}
+			}
+			if (!any)
+			{
+				value = 0.0f;
+				return start;
+			}
+			if (p < end && (*p == 'e' || *p == 'E'))
+			{
+				const char* q           = p + 1;
+				const bool  negativeExp = q < end && *q == '-';
+				if (q < end && (*q == '-' || *q == '+'))
+				{
+					q++;
+				}
+				if (q < end && IsDigit(*q))
+				{
+					int e = 0;
+					for (; q < end && IsDigit(*q); q++)
+					{
+						e = std::min(e * 10 + (*q - '0'), 100000);
+					}
+					exponent += negativeExp ? -e : e;
+					p = q;
+				}
+			}
+
+			if (mantissa < (uint64_t(1u) << 53) && exponent >= -22 && exponent <= 22)
+			{
+				auto v = double(mantissa);
+				v      = exponent < 0 ? v / powersOf10[-exponent] : v * powersOf10[exponent];
+				value  = float(negative ? -v : v);
+				return p;
+			}
+
+			char         buffer[64];
+			const size_t length = std::min(size_t(p - start), sizeof(buffer) - 1u);
+			std::memcpy(buffer, start, length);
+			buffer[length] = '\0';
+			value          = std::strtof(buffer, nullptr);
+			return p;
+		}
+
+		// 1-based, negative counts back from the last element read so far, 0 when absent
+		const char* ParseIndex(const char* p, const char* end, long long& index) noexcept
+		{
+			const bool negative = p < end && *p == '-';
+			if (negative)
+			{
+				p++;
+			}
+			long long v = 0;
+			for (; p < end && IsDigit(*p); p++)
+			{
+				v = std::min(v * 10 + (*p - '0'), (long long)INT32_MAX);
+			}
+			index = negative ? -v : v;
+			return p;
+		}
+
+		// ---------------------------------------------------------------------------
+		// OBJ
+
+		// statements that shape meshes and nodes, replayed in file order once every chunk is parsed
+		struct Event
+		{
+			enum class Kind
+			{
+				Object,
+				Group,
+				Material,
+				Library,
+			};
+
+			Kind        kind;
+			std::string name;
+			size_t      face; // number of the chunk's faces that come before it
+		};
+
+		struct Chunk
+		{
+			std::vector<dx::XMFLOAT3> positions;
+			std::vector<dx::XMFLOAT2> texcoords;
+			std::vector<dx::XMFLOAT3> normals;
+			// position, texcoord and normal index of every face corner, 0-based (or noIndex)
+			std::vector<int> corners;
+			// corners written relative to the chunk's own first element; they become global when the chunks are stitched
+			std::vector<size_t>   relativeCorners;
+			std::vector<unsigned> faceStarts; // first corner of every face, plus the end of the last one once parsed
+			std::vector<Event>    events;
+
+			size_t FaceCount() const noexcept
+			{
+				return faceStarts.size() - 1u;
+			}
+		};
+
+		const char* ParseFace(const char* p, const char* end, Chunk& chunk)
+		{
+			const long long counts[3] = {
+				(long long)chunk.positions.size(), (long long)chunk.texcoords.size(), (long long)chunk.normals.size()
+			};
+			const auto firstCorner = chunk.corners.size();
+			while (true)
+			{
+				p = SkipSpaces(p, end);
+				if (p == end || !(IsDigit(*p) || *p == '-'))
+				{
+					break;
+				}
+				// v, v/vt, v//vn or v/vt/vn
+				long long index[3] = {};
+				p                  = ParseIndex(p, end, index[0]);
+				if (p < end && *p == '/')
+				{
+					p = ParseIndex(p + 1, end, index[1]);
+					if (p < end && *p == '/')
+					{
+						p = ParseIndex(p + 1, end, index[2]);
+					}
+				}
+				while (p < end && !IsSpace(*p) && !IsLineEnd(*p))
+				{
+					p++;
+				}
+
+				for (size_t k = 0; k < 3; k++)
+				{
+					if (index[k] > 0)
+					{
+						chunk.corners.push_back(int(index[k] - 1));
+					}
+					else if (index[k] < 0)
+					{
+						chunk.relativeCorners.push_back(chunk.corners.size());
+						chunk.corners.push_back(int(counts[k] + index[k]));
+					}
+					else
+					{
+						chunk.corners.push_back(noIndex);
+					}
+				}
+			}
+			if (chunk.corners.size() > firstCorner)
+			{
+				chunk.faceStarts.push_back(unsigned(firstCorner / 3u));
+			}
+			return p;
+		}
+
+		void ParseChunk(const char* p, const char* end, Chunk& chunk)
+		{
+			// a guess that saves most of the reallocations (vertices and faces take about 30 bytes a line)
+			chunk.positions.reserve(size_t(end - p) / 96u);
+			chunk.corners.reserve(size_t(end - p) / 8u);
+			chunk.faceStarts.reserve(size_t(end - p) / 96u);
+
+			for (; p < end; p = NextLine(p, end))
+			{
+				p = SkipSpaces(p, end);
+				if (end - p < 2)
+				{
+					continue;
+				}
+				switch (*p)
+				{
+					case 'v':
+						if (IsSpace(p[1]))
+						{
+							auto& v = chunk.positions.emplace_back();
+							p       = ParseFloat(ParseFloat(ParseFloat(p + 1, end, v.x), end, v.y), end, v.z);
+						}
+						else if (p[1] == 't' && IsKeyword(p, end, "vt"))
+						{
+							auto& v = chunk.texcoords.emplace_back();
+							p       = ParseFloat(ParseFloat(p + 2, end, v.x), end, v.y);
+						}
+						else if (p[1] == 'n' && IsKeyword(p, end, "vn"))
+						{
+							auto& v = chunk.normals.emplace_back();
+							p       = ParseFloat(ParseFloat(ParseFloat(p + 2, end, v.x), end, v.y), end, v.z);
+						}
+						break;
+					case 'f':
+						if (IsSpace(p[1]))
+						{
+							p = ParseFace(p + 1, end, chunk);
+						}
+						break;
+					case 'o':
+					case 'g':
+						if (IsSpace(p[1]) || IsLineEnd(p[1]))
+						{
+							chunk.events.push_back({
+								*p == 'o' ? Event::Kind::Object : Event::Kind::Group,
+								std::string(RestOfLine(p + 1, end)),
+								chunk.faceStarts.size()
+							});
+						}
+						break;
+					case 'u':
+						if (IsKeyword(p, end, "usemtl"))
+						{
+							chunk.events.push_back({Event::Kind::Material, std::string(RestOfLine(p + 6, end)), chunk.faceStarts.size()});
+						}
+						break;
+					case 'm':
+						if (IsKeyword(p, end, "mtllib"))
+						{
+							chunk.events.push_back({Event::Kind::Library, std::string(RestOfLine(p + 6, end)), chunk.faceStarts.size()});
+						}
+						break;
+					default:
+						// comments, smoothing groups, points and lines, ...
+						break;
+				}
+			}
+			chunk.faceStarts.push_back(unsigned(chunk.corners.size() / 3u));
+		}
+
+		// the vertex data of every chunk in one place, with all face corners pointing into it
+		struct Geometry
+		{
+			std::vector<dx::XMFLOAT3> positions;
+			std::vector<dx::XMFLOAT2> texcoords;
+			std::vector<dx::XMFLOAT3> normals;
+			std::vector<Chunk>        chunks;
+		};
+
+		Geometry Stitch(std::vector<Chunk> chunks, size_t nWorkers)
+		{
+			std::vector<std::array<size_t, 3>> offsets(chunks.size());
+			std::array<size_t, 3>              totals = {};
+			for (size_t i = 0; i < chunks.size(); i++)
+			{
+				offsets[i] = totals;
+				totals[0] += chunks[i].positions.size();
+				totals[1] += chunks[i].texcoords.size();
+				totals[2] += chunks[i].normals.size();
+			}
+
+			Geometry geometry;
+			geometry.positions.resize(totals[0]);
+			geometry.texcoords.resize(totals[1]);
+			geometry.normals.resize(totals[2]);
+			ParallelFor(chunks.size(), nWorkers, [&](size_t i)
+			{
+				auto& chunk = chunks[i];
+				std::copy(chunk.positions.begin(), chunk.positions.end(), geometry.positions.begin() + offsets[i][0]);
+				std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), geometry.texcoords.begin() + offsets[i][1]);
+				std::copy(chunk.normals.begin(), chunk.normals.end(), geometry.normals.begin() + offsets[i][2]);
+				for (const auto c : chunk.relativeCorners)
+				{
+					chunk.corners[c] += int(offsets[i][c % 3u]);
+				}
+				chunk.positions       = {};
+				chunk.texcoords       = {};
+				chunk.normals         = {};
+				chunk.relativeCorners = {};
+			});
+			geometry.chunks = std::move(chunks);
+			return geometry;
+		}
+
+		// ---------------------------------------------------------------------------
+		// MTL
+
+		struct ObjMaterial
+		{
+			// what Assimp assumes for anything the library leaves out (or for materials it does not define at all)
+			dx::XMFLOAT3 diffuse   = {0.6f, 0.6f, 0.6f};
+			dx::XMFLOAT3 specular  = {0.0f, 0.0f, 0.0f};
+			float        shininess = 0.0f;
+			std::string  diffuseMap;
+			std::string  specularMap;
+			std::string  normalMap;
+		};
+
+		using MaterialLibrary = std::unordered_map<std::string, ObjMaterial>;
+
+		// texture statements may put options in front of the file name (-bm 0.5, -o 0 0 0, ...)
+		std::string TextureName(const char* p, const char* end)
+		{
+			static constexpr std::pair<std::string_view, int> options[] = {
+				{"-blendu", 1}, {"-blendv", 1}, {"-boost", 1}, {"-mm", 2}, {"-o", 3}, {"-s", 3}, {"-t", 3},
+				{"-texres", 1}, {"-clamp", 1}, {"-bm", 1}, {"-imfchan", 1}, {"-type", 1}, {"-cc", 1}
+			};
+			const auto tokenEnd = [end](const char* q)
+			{
+				while (q < end && !IsSpace(*q) && !IsLineEnd(*q))
+				{
+					q++;
+				}
+				return q;
+			};
+
+			for (p = SkipSpaces(p, end); p < end && *p == '-';)
+			{
+				const std::string_view option(p, size_t(tokenEnd(p) - p));
+				int                    arguments = 0;
+				for (const auto& [name, count] : options)
+				{
+					arguments = option == name ? count : arguments;
+				}
+				for (p = SkipSpaces(tokenEnd(p), end); arguments > 0; arguments--)
+				{
+					p = SkipSpaces(tokenEnd(p), end);
+				}
+			}
+			return std::string(RestOfLine(p, end));
+		}
+
+		void LoadMaterials(const std::filesystem::path& objPath, const std::string& libraryName, MaterialLibrary& library)
+		{
+			// like Assimp, fall back to the .mtl next to the model when the library named in the file is missing
+			auto pFile = std::make_unique<MappedFile>((objPath.parent_path() / libraryName).string());
+			if (!pFile->IsOpen())
+			{
+				pFile = std::make_unique<MappedFile>(std::filesystem::path(objPath).replace_extension(".mtl").string());
+			}
+			if (!pFile->IsOpen())
+			{
+				return;
+			}
+
+			const char*  end       = pFile->GetData() + pFile->GetSize();
+			ObjMaterial* pMaterial = nullptr;
+			for (const char* p = pFile->GetData(); p < end; p = NextLine(p, end))
+			{
+				p = SkipSpaces(p, end);
+				if (IsKeyword(p, end, "newmtl", false))
+				{
+					// redefinitions keep changing the same material
+					pMaterial = &library[std::string(RestOfLine(p + 6, end))];
+				}
+				else if (pMaterial == nullptr)
+				{
+					continue;
+				}
+				else if (IsKeyword(p, end, "Kd", false))
+				{
+					ParseFloat(ParseFloat(ParseFloat(p + 2, end, pMaterial->diffuse.x), end, pMaterial->diffuse.y), end, pMaterial->diffuse.z);
+				}
+				else if (IsKeyword(p, end, "Ks", false))
+				{
+					ParseFloat(ParseFloat(ParseFloat(p + 2, end, pMaterial->specular.x), end, pMaterial->specular.y), end, pMaterial->specular.z);
+				}
+				else if (IsKeyword(p, end, "Ns", false))
+				{
+					ParseFloat(p + 2, end, pMaterial->shininess);
+				}
+				else if (IsKeyword(p, end, "map_Kd", false))
+				{
+					pMaterial->diffuseMap = TextureName(p + 6, end);
+				}
+				else if (IsKeyword(p, end, "map_Ks", false))
+				{
+					pMaterial->specularMap = TextureName(p + 6, end);
+				}
+				else if (IsKeyword(p, end, "map_Kn", false) || IsKeyword(p, end, "norm", false))
+				{
+					pMaterial->normalMap = TextureName(p + (ToLower(p[1]) == 'a' ? 6 : 4), end);
+				}
+			}
+		}
+
+		// same choices as Model::ParseMesh makes for a material coming out of Assimp
+		MaterialDesc Describe(const ObjMaterial& material, const std::string& rootPath)
+		{
+			MaterialDesc desc;
+			if (!material.diffuseMap.empty())
+			{
+				desc.diffusePath   = rootPath + material.diffuseMap;
+				desc.hasDiffuseMap = true;
+			}
+			else
+			{
+				desc.diffuseColor = {material.diffuse.x, material.diffuse.y, material.diffuse.z, desc.diffuseColor.w};
+			}
+			if (!material.specularMap.empty())
+			{
+				desc.specularPath   = rootPath + material.specularMap;
+				desc.hasSpecularMap = true;
+			}
+			else
+			{
+				desc.specularColor = {material.specular.x, material.specular.y, material.specular.z, desc.specularColor.w};
+			}
+			desc.shininess = material.shininess;
+			if (!material.normalMap.empty())
+			{
+				desc.normalPath   = rootPath + material.normalMap;
+				desc.hasNormalMap = true;
+			}
+			return desc;
+		}
+
+		// ---------------------------------------------------------------------------
+		// objects and meshes
+
+		struct FaceRange
+		{
+			size_t chunk;
+			size_t begin;
+			size_t end;
+		};
+
+		struct ObjMesh
+		{
+			std::string                name;
+			std::optional<std::string> material; // none until a usemtl (or the object) gives it one
+			std::vector<FaceRange>     faces;
+			size_t                     faceCount = 0u;
+		};
+
+		struct ObjObject
+		{
+			std::string         name;
+			std::vector<size_t> meshes;
+		};
+
+		/**
+		 * \brief Replays o/g/usemtl and the faces between them the way Assimp's OBJ parser does, so meshes are split, named
+		 * and ordered the same. That includes its quirks: every g with a new name starts an object, an o naming an
+		 * existing object switches back to it (but not to its mesh), and a material change only starts a new mesh if the
+		 * current one already has faces in another material.
+		 */
+		class Assembler
+		{
+			public:
+				void Faces(size_t chunk, size_t begin, size_t end)
+				{
+					if (begin == end)
+					{
+						return;
+					}
+					if (!currentMaterial_)
+					{
+						currentMaterial_ = defaultMaterial;
+					}
+					if (!currentObject_)
+					{
+						CreateObject("defaultobject");
+					}
+					if (!currentMesh_)
+					{
+						CreateMesh("defaultobject");
+					}
+					auto& mesh = meshes_[*currentMesh_];
+					mesh.faces.push_back({chunk, begin, end});
+					mesh.faceCount += end - begin;
+				}
+
+				void Apply(const Event& event)
+				{
+					switch (event.kind)
+					{
+						case Event::Kind::Object:
+						{
+							if (event.name.empty())
+							{
+								break;
+							}
+							const auto it = std::find_if(objects_.begin(), objects_.end(), [&](const ObjObject& o)
+							{
+								return o.name == event.name;
+							});
+							if (it != objects_.end())
+							{
+								currentObject_ = size_t(it - objects_.begin());
+							}
+							else
+							{
+								CreateObject(event.name);
+							}
+							break;
+						}
+						case Event::Kind::Group:
+							if (event.name != activeGroup_)
+							{
+								CreateObject(event.name);
+								activeGroup_ = event.name;
+							}
+							break;
+						case Event::Kind::Material:
+							if (event.name.empty() || currentMaterial_ == event.name)
+							{
+								break;
+							}
+							currentMaterial_ = event.name;
+							if (!currentMesh_ || (meshes_[*currentMesh_].material && meshes_[*currentMesh_].material != event.name &&
+							                      meshes_[*currentMesh_].faceCount > 0u))
+							{
+								CreateMesh(event.name);
+							}
+							meshes_[*currentMesh_].material = event.name;
+							break;
+						case Event::Kind::Library:
+							if (std::find(libraries_.begin(), libraries_.end(), event.name) == libraries_.end())
+							{
+								libraries_.push_back(event.name);
+							}
+							break;
+					}
+				}
+
+				const std::vector<ObjObject>& GetObjects() const noexcept
+				{
+					return objects_;
+				}
+
+				const std::vector<ObjMesh>& GetMeshes() const noexcept
+				{
+					return meshes_;
+				}
+
+				const std::vector<std::string>& GetLibraries() const noexcept
+				{
+					return libraries_;
+				}
+
+			private:
+				void CreateObject(const std::string& name)
+				{
+					currentObject_ = objects_.size();
+					objects_.push_back({name, {}});
+					CreateMesh(name);
+					meshes_[*currentMesh_].material = currentMaterial_;
+				}
+
+				void CreateMesh(const std::string& name)
+				{
+					currentMesh_ = meshes_.size();
+					meshes_.push_back({name, std::nullopt, {}, 0u});
+					if (currentObject_)
+					{
+						objects_[*currentObject_].meshes.push_back(*currentMesh_);
+					}
+				}
+
+			private:
+				static constexpr const char* defaultMaterial = "DefaultMaterial";
+
+				std::vector<ObjObject>     objects_;
+				std::vector<ObjMesh>       meshes_;
+				std::vector<std::string>   libraries_;
+				std::optional<size_t>      currentObject_;
+				std::optional<size_t>      currentMesh_;
+				std::optional<std::string> currentMaterial_;
+				std::string                activeGroup_;
+		};
+
+		// ---------------------------------------------------------------------------
+		// mesh post-processing, in the same order and with the same arithmetic as the Assimp steps Model::Import asks for
+
+		dx::XMFLOAT3 operator-(const dx::XMFLOAT3& a, const dx::XMFLOAT3& b) noexcept
+		{
+			return {a.x - b.x, a.y - b.y, a.z - b.z};
+		}
+
+		dx::XMFLOAT3 operator*(const dx::XMFLOAT3& a, float s) noexcept
+		{
+			return {a.x * s, a.y * s, a.z * s};
+		}
+
+		float Dot(const dx::XMFLOAT3& a, const dx::XMFLOAT3& b) noexcept
+		{
+			return a.x * b.x + a.y * b.y + a.z * b.z;
+		}
+
+		dx::XMFLOAT3 Cross(const dx::XMFLOAT3& a, const dx::XMFLOAT3& b) noexcept
+		{
+			return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+		}
+
+		float Length(const dx::XMFLOAT3& v) noexcept
+		{
+			return std::sqrt(Dot(v, v));
+		}
+
+		// leaves zero vectors alone
+		dx::XMFLOAT3 Normalize(const dx::XMFLOAT3& v) noexcept
+		{
+			const float length = Length(v);
+			return length > 0.0f ? v * (1.0f / length) : v;
+		}
+
+		// a polygon's corners in reverse (the winding flip of the left-handed conversion), cut into triangles: quads fan
+		// out from their concave corner if they have one, larger polygons from their first corner
+		void Triangulate(const std::vector<dx::XMFLOAT3>& positions, unsigned base, unsigned count, std::vector<unsigned>& triangles)
+		{
+			const auto corner = [&](unsigned i)
+			{
+				return base + count - 1u - i % count;
+			};
+			unsigned start = 0u;
+			if (count == 4u)
+			{
+				for (unsigned i = 0; i < 4u; i++)
+				{
+					const auto& v     = positions[corner(i)];
+					const auto  left  = Normalize(positions[corner(i + 3u)] - v);
+					const auto  diag  = Normalize(positions[corner(i + 2u)] - v);
+					const auto  right = Normalize(positions[corner(i + 1u)] - v);
+					if (std::acos(Dot(left, diag)) + std::acos(Dot(right, diag)) > 3.1415926538f)
+					{
+						start = i;
+						break;
+					}
+				}
+			}
+			for (unsigned i = 1; i + 1u < count; i++)
+			{
+				triangles.insert(triangles.end(), {corner(start), corner(start + i), corner(start + i + 1u)});
+			}
+		}
+
+		struct Vertex
+		{
+			dx::XMFLOAT3 position;
+			dx::XMFLOAT3 normal;
+			dx::XMFLOAT3 tangent;
+			dx::XMFLOAT3 bitangent;
+			dx::XMFLOAT2 texcoord;
+
+			bool operator==(const Vertex& rhs) const noexcept
+			{
+				return std::memcmp(this, &rhs, sizeof(Vertex)) == 0;
+			}
+		};
+
+		struct VertexHash
+		{
+			size_t operator()(const Vertex& v) const noexcept
+			{
+				uint32_t words[sizeof(Vertex) / 4u];
+				std::memcpy(words, &v, sizeof(Vertex));
+				uint64_t hash = 14695981039346656037ull;
+				for (const auto w : words)
+				{
+					hash = (hash ^ w) * 1099511628211ull;
+				}
+				return size_t(hash);
+			}
+		};
+
+		MeshData BuildMesh(const Geometry& geometry, const ObjMesh& mesh, MaterialDesc material, std::string tag, float scale)
+		{
+			const auto fetch = [](const auto& elements, int index, const char* what) -> const auto&
+			{
+				if (index < 0 || size_t(index) >= elements.size())
+				{
+					throw ModelException(__LINE__, __FILE__, std::string("OBJ face refers to a ") + what + " that does not exist");
+				}
+				return elements[index];
+			};
+
+			// one vertex per face corner, converted to the left-handed convention with flipped texture v
+			std::vector<dx::XMFLOAT3> positions, normals;
+			std::vector<dx::XMFLOAT2> texcoords;
+			std::vector<unsigned>     triangles;
+			bool                      hasTexcoords = false, hasNormals = false;
+			for (const auto& range : mesh.faces)
+			{
+				const auto& chunk = geometry.chunks[range.chunk];
+				for (size_t f = range.begin; f < range.end; f++)
+				{
+					const auto first = chunk.faceStarts[f];
+					const auto count = chunk.faceStarts[f + 1u] - first;
+					// points and lines do not make it into triangle lists
+					if (count < 3u)
+					{
+						continue;
+					}
+					const auto base = unsigned(positions.size());
+					for (unsigned k = 0; k < count; k++)
+					{
+						const int* pCorner = &chunk.corners[(first + k) * 3u];
+						const auto& p      = fetch(geometry.positions, pCorner[0], "position");
+						positions.push_back({p.x, p.y, -p.z});
+						if (pCorner[1] != noIndex)
+						{
+							const auto& tc = fetch(geometry.texcoords, pCorner[1], "texture coordinate");
+							texcoords.push_back({tc.x, 1.0f - tc.y});
+							hasTexcoords = true;
+						}
+						else
+						{
+							texcoords.push_back({});
+						}
+						if (pCorner[2] != noIndex)
+						{
+							const auto& n = fetch(geometry.normals, pCorner[2], "normal");
+							normals.push_back({n.x, n.y, -n.z});
+							hasNormals = true;
+						}
+						else
+						{
+							normals.push_back({});
+						}
+					}
+					Triangulate(positions, base, count, triangles);
+				}
+			}
+
+			// flat normals for meshes that come without any
+			if (!hasNormals)
+			{
+				for (size_t t = 0; t < triangles.size(); t += 3u)
+				{
+					const auto& p0 = positions[triangles[t]];
+					const auto  n  = Normalize(Cross(positions[triangles[t + 1u]] - p0, positions[triangles[t + 2u]] - p0));
+					for (size_t k = 0; k < 3u; k++)
+					{
+						normals[triangles[t + k]] = n;
+					}
+				}
+			}
+
+			std::vector<dx::XMFLOAT3> tangents(positions.size()), bitangents(positions.size());
+			if (hasTexcoords)
+			{
+				TangentSpace::Compute(positions, normals, texcoords, triangles, tangents, bitangents);
+			}
+
+			// join identical vertices, numbered in the order they first appear in the file
+			std::vector<Vertex>                              vertices;
+			std::vector<unsigned>                            remap(positions.size());
+			std::unordered_map<Vertex, unsigned, VertexHash> unique;
+			vertices.reserve(positions.size());
+			unique.reserve(positions.size());
+			for (size_t i = 0; i < positions.size(); i++)
+			{
+				// -0 and 0 are the same value to Assimp's comparison
+				const auto canonical = [](dx::XMFLOAT3 v)
+				{
+					return dx::XMFLOAT3{v.x + 0.0f, v.y + 0.0f, v.z + 0.0f};
+				};
+				const Vertex v = {
+					canonical(positions[i]), canonical(normals[i]), canonical(tangents[i]), canonical(bitangents[i]),
+					{texcoords[i].x + 0.0f, texcoords[i].y + 0.0f}
+				};
+				const auto [it, inserted] = unique.try_emplace(v, unsigned(vertices.size()));
+				if (inserted)
+				{
+					vertices.push_back(v);
+				}
+				remap[i] = it->second;
+			}
+			std::vector<unsigned int> indices(triangles.size());
+			for (size_t i = 0; i < triangles.size(); i++)
+			{
+				indices[i] = remap[triangles[i]];
+			}
+
+			// same layouts as Model::ParseMesh picks
+			DynamicVertexLayout layout;
+			layout.Append(DynamicVertexLayout::Position3D).Append(DynamicVertexLayout::Normal);
+			if (material.hasDiffuseMap && material.hasNormalMap)
+			{
+				layout.Append(DynamicVertexLayout::Tangent).Append(DynamicVertexLayout::Bitangent).Append(DynamicVertexLayout::Texture2D);
+			}
+			else if (material.hasDiffuseMap)
+			{
+				layout.Append(DynamicVertexLayout::Texture2D);
+			}
+			else if (material.hasNormalMap || material.hasSpecularMap)
+			{
+				throw std::runtime_error("terrible combination of textures in material smh");
+			}
+
+			// each element is a column of the joined vertices
+			RawVertexBufferWithLayout vbuf(std::move(layout));
+			const auto                column = [&vertices](DynamicVertexLayout::ElementType type, size_t offset, float columnScale = 1.0f)
+			{
+				const auto pFirst = reinterpret_cast<const char*>(vertices.data());
+				return RawVertexBufferWithLayout::Column{type, pFirst ? pFirst + offset : nullptr, sizeof(Vertex), columnScale};
+			};
+			if (material.hasDiffuseMap && material.hasNormalMap)
+			{
+				vbuf.Append(vertices.size(), {
+					column(DynamicVertexLayout::Position3D, offsetof(Vertex, position), scale),
+					column(DynamicVertexLayout::Normal, offsetof(Vertex, normal)),
+					column(DynamicVertexLayout::Tangent, offsetof(Vertex, tangent)),
+					column(DynamicVertexLayout::Bitangent, offsetof(Vertex, bitangent)),
+					column(DynamicVertexLayout::Texture2D, offsetof(Vertex, texcoord)),
+				});
+			}
+			else if (material.hasDiffuseMap)
+			{
+				vbuf.Append(vertices.size(), {
+					column(DynamicVertexLayout::Position3D, offsetof(Vertex, position), scale),
+					column(DynamicVertexLayout::Normal, offsetof(Vertex, normal)),
+					column(DynamicVertexLayout::Texture2D, offsetof(Vertex, texcoord)),
+				});
+			}
+			else
+			{
+				vbuf.Append(vertices.size(), {
+					column(DynamicVertexLayout::Position3D, offsetof(Vertex, position), scale),
+					column(DynamicVertexLayout::Normal, offsetof(Vertex, normal)),
+				});
+			}
+			return {std::move(tag), std::move(material), std::move(vbuf), std::move(indices)};
+		}
+	}
+
+	bool ObjImporter::CanImport(const std::string& pathString) noexcept
+	{
+		const auto dot = pathString.find_last_of('.');
+		if (dot == std::string::npos || pathString.size() - dot != 4u)
+		{
+			return false;
+		}
+		return ToLower(pathString[dot + 1u]) == 'o' && ToLower(pathString[dot + 2u]) == 'b' && ToLower(pathString[dot + 3u]) == 'j';
+	}
+
+	ModelData ObjImporter::Import(const std::string& pathString, float scale, size_t nWorkers)
+	{
+		const MappedFile file{pathString};
+		if (!file.IsOpen())
+		{
+			throw ModelException(__LINE__, __FILE__, "Unable to open file \"" + pathString + "\".");
+		}
+		const char* const pBegin = file.GetData();
+		const char* const pEnd   = pBegin + file.GetSize();
+
+		// cut the file at line ends and parse the pieces independently
+		std::vector<const char*> cuts = {pBegin};
+		while (cuts.back() < pEnd)
+		{
+			cuts.push_back(size_t(pEnd - cuts.back()) > chunkSize ? NextLine(cuts.back() + chunkSize, pEnd) : pEnd);
+		}
+		std::vector<Chunk> chunks(cuts.size() - 1u);
+		ParallelFor(chunks.size(), nWorkers, [&](size_t i)
+		{
+			ParseChunk(cuts[i], cuts[i + 1u], chunks[i]);
+		});
+		const auto geometry = Stitch(std::move(chunks), nWorkers);
+
+		// replay the statements between the faces in file order
+		Assembler assembler;
+		for (size_t c = 0; c < geometry.chunks.size(); c++)
+		{
+			const auto& chunk = geometry.chunks[c];
+			size_t      face  = 0u;
+			for (const auto& event : chunk.events)
+			{
+				assembler.Faces(c, face, event.face);
+				assembler.Apply(event);
+				face = event.face;
+			}
+			assembler.Faces(c, face, chunk.FaceCount());
+		}
+
+		const std::filesystem::path path = pathString;
+		MaterialLibrary             library;
+		for (const auto& name : assembler.GetLibraries())
+		{
+			LoadMaterials(path, name, library);
+		}
+
+		// one node per object holding its meshes that got any faces
+		ModelData data;
+		data.root.name = path.filename().string();
+		dx::XMStoreFloat4x4(&data.root.transform, dx::XMMatrixIdentity());
+		std::vector<size_t> meshOrder;
+		for (const auto& object : assembler.GetObjects())
+		{
+			auto& node = data.root.children.emplace_back();
+			node.name  = object.name;
+			dx::XMStoreFloat4x4(&node.transform, dx::XMMatrixIdentity());
+			for (const auto m : object.meshes)
+			{
+				if (assembler.GetMeshes()[m].faceCount > 0u)
+				{
+					node.meshIndices.push_back(unsigned(meshOrder.size()));
+					meshOrder.push_back(m);
+				}
+			}
+		}
+
+		const auto                           rootPath = path.parent_path().string() + "\\";
+		std::vector<std::optional<MeshData>> built(meshOrder.size());
+		ParallelFor(built.size(), nWorkers, [&](size_t i)
+		{
+			const auto& mesh     = assembler.GetMeshes()[meshOrder[i]];
+			const auto  it       = mesh.material ? library.find(*mesh.material) : library.end();
+			const auto  material = Describe(it != library.end() ? it->second : ObjMaterial{}, rootPath);
+			built[i].emplace(BuildMesh(geometry, mesh, material, path.string() + "%" + mesh.name, scale));
+		});
+		data.meshes.reserve(built.size());
+		for (auto& mesh : built)
+		{
+			data.meshes.push_back(std::move(*mesh));
+		}
+		return data;
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+#include "MeshData.h"
+
+namespace D3DEngine
+{
+	/**
+	 * \brief Streaming Wavefront OBJ/MTL reader, used instead of Assimp for .obj files.
+	 * The file is memory mapped and cut into line-aligned chunks that are parsed in parallel, straight from the mapping.
+	 * It yields the meshes and nodes Assimp gives us with the flags Model::Import uses (triangulated, left-handed, with
+	 * normals and tangent frames), so everything after parsing is oblivious to which of the two read the file.
+	 */
+	class ObjImporter
+	{
+		public:
+			// judged by the extension alone
+			static bool CanImport(const std::string& pathString) noexcept;
+			/**
+			 * \brief Parse an OBJ file and the material libraries it references into raw (unoptimized) meshes.
+			 * Meshes come out in the order Assimp would produce them: one node per object (o/g), one mesh per material
+			 * run inside it. Errors are thrown as ModelException.
+			 */
+			static ModelData Import(const std::string& pathString, float scale, size_t nWorkers);
+	};
+}
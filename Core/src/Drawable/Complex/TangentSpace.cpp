@@ -0,0 +1,199 @@
+#include "TangentSpace.h"
+#include <algorithm>
+#include <cmath>
+
+namespace D3DEngine
+{
+	namespace dx = DirectX;
+
+	namespace
+	{
+		dx::XMFLOAT3 operator-(const dx::XMFLOAT3& a, const dx::XMFLOAT3& b) noexcept
+		{
+			return {a.x - b.x, a.y - b.y, a.z - b.z};
+		}
+
+		dx::XMFLOAT3 operator+(const dx::XMFLOAT3& a, const dx::XMFLOAT3& b) noexcept
+		{
+			return {a.x + b.x, a.y + b.y, a.z + b.z};
+		}
+
+		dx::XMFLOAT3 operator*(const dx::XMFLOAT3& a, float s) noexcept
+		{
+			return {a.x * s, a.y * s, a.z * s};
+		}
+
+		float Dot(const dx::XMFLOAT3& a, const dx::XMFLOAT3& b) noexcept
+		{
+			return a.x * b.x + a.y * b.y + a.z * b.z;
+		}
+
+		dx::XMFLOAT3 Cross(const dx::XMFLOAT3& a, const dx::XMFLOAT3& b) noexcept
+		{
+			return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+		}
+
+		float Length(const dx::XMFLOAT3& v) noexcept
+		{
+			return std::sqrt(Dot(v, v));
+		}
+
+		// leaves zero vectors alone
+		dx::XMFLOAT3 Normalize(const dx::XMFLOAT3& v) noexcept
+		{
+			const float length = Length(v);
+			return length > 0.0f ? v * (1.0f / length) : v;
+		}
+
+		bool IsFinite(const dx::XMFLOAT3& v) noexcept
+		{
+			return std::isfinite(v.x) && std::isfinite(v.y) && std::isfinite(v.z);
+		}
+
+		// Assimp's SpatialSort: positions ordered along an arbitrary axis, to find every one within a radius of a point
+		class SpatialSort
+		{
+			public:
+				explicit SpatialSort(const std::vector<dx::XMFLOAT3>& positions)
+					:
+					positions_(positions)
+				{
+					entries_.reserve(positions.size());
+					for (unsigned i = 0; i < positions.size(); i++)
+					{
+						entries_.push_back({Dot(positions[i], axis_), i});
+					}
+					std::sort(entries_.begin(), entries_.end(), [](const Entry& a, const Entry& b)
+					{
+						return a.distance < b.distance;
+					});
+				}
+
+				void Find(const dx::XMFLOAT3& position, float radius, std::vector<unsigned>& found) const
+				{
+					found.clear();
+					const float distance = Dot(position, axis_);
+					auto        it       = std::lower_bound(entries_.begin(), entries_.end(), distance - radius, [](const Entry& e, float d)
+					{
+						return e.distance < d;
+					});
+					for (; it != entries_.end() && it->distance < distance + radius; ++it)
+					{
+						const auto d = positions_[it->index] - position;
+						if (Dot(d, d) < radius * radius)
+						{
+							found.push_back(it->index);
+						}
+					}
+				}
+
+			private:
+				struct Entry
+				{
+					float    distance;
+					unsigned index;
+				};
+
+				inline static const dx::XMFLOAT3 axis_ = Normalize({0.8523f, 0.0812f, 0.5165f});
+
+				const std::vector<dx::XMFLOAT3>& positions_;
+				std::vector<Entry>               entries_;
+		};
+	}
+
+	void TangentSpace::Compute(const std::vector<dx::XMFLOAT3>& positions,
+	                           const std::vector<dx::XMFLOAT3>& normals,
+	                           const std::vector<dx::XMFLOAT2>& texcoords,
+	                           const std::vector<unsigned>&     triangles,
+	                           std::vector<dx::XMFLOAT3>&       tangents,
+	                           std::vector<dx::XMFLOAT3>&       bitangents)
+	{
+		tangents.assign(positions.size(), {});
+		bitangents.assign(positions.size(), {});
+		for (size_t t = 0; t < triangles.size(); t += 3u)
+		{
+			const auto  p0 = triangles[t], p1 = triangles[t + 1u], p2 = triangles[t + 2u];
+			const auto  v  = positions[p1] - positions[p0];
+			const auto  w  = positions[p2] - positions[p0];
+			float       sx = texcoords[p1].x - texcoords[p0].x, sy = texcoords[p1].y - texcoords[p0].y;
+			float       tx = texcoords[p2].x - texcoords[p0].x, ty = texcoords[p2].y - texcoords[p0].y;
+			const float dc = (tx * sy - ty * sx) < 0.0f ? -1.0f : 1.0f;
+			// no extent in texture space, use the default directions
+			if (sx * ty == sy * tx)
+			{
+				sx = 0.0f;
+				sy = 1.0f;
+				tx = 1.0f;
+				ty = 0.0f;
+			}
+			const dx::XMFLOAT3 tangent   = {(w.x * sy - v.x * ty) * dc, (w.y * sy - v.y * ty) * dc, (w.z * sy - v.z * ty) * dc};
+			const dx::XMFLOAT3 bitangent = {(w.x * sx - v.x * tx) * dc, (w.y * sx - v.y * tx) * dc, (w.z * sx - v.z * tx) * dc};
+			for (const auto p : {p0, p1, p2})
+			{
+				const auto& n  = normals[p];
+				auto        lt = Normalize(tangent - n * Dot(tangent, n));
+				auto        lb = Normalize(bitangent - n * Dot(bitangent, n));
+				// rebuild one from the other if only one of them broke down
+				if (IsFinite(lt) != IsFinite(lb))
+				{
+					if (!IsFinite(lt))
+					{
+						lt = Normalize(Cross(n, lb));
+					}
+					else
+					{
+						lb = Normalize(Cross(lt, n));
+					}
+				}
+				tangents[p]   = lt;
+				bitangents[p] = lb;
+			}
+		}
+
+		dx::XMFLOAT3 lo = positions.empty() ? dx::XMFLOAT3{} : positions[0], hi = lo;
+		for (const auto& p : positions)
+		{
+			lo = {std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z)};
+			hi = {std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z)};
+		}
+		const float epsilon = Length(hi - lo) * 1e-4f;
+		const float limit   = std::cos(dx::XMConvertToRadians(45.0f));
+
+		const SpatialSort     sort(positions);
+		std::vector<char>     done(positions.size(), false);
+		std::vector<unsigned> found, group;
+		for (unsigned a = 0; a < positions.size(); a++)
+		{
+			if (done[a])
+			{
+				continue;
+			}
+			sort.Find(positions[a], epsilon, found);
+			// a finds itself as well and so counts twice, as it does in Assimp
+			group.assign(1u, a);
+			for (const auto i : found)
+			{
+				if (done[i] || Dot(normals[i], normals[a]) < 0.9999f ||
+				    Dot(tangents[i], tangents[a]) < limit || Dot(bitangents[i], bitangents[a]) < limit)
+				{
+					continue;
+				}
+				group.push_back(i);
+				done[i] = true;
+			}
+			dx::XMFLOAT3 tangent = {}, bitangent = {};
+			for (const auto i : group)
+			{
+				tangent   = tangent + tangents[i];
+				bitangent = bitangent + bitangents[i];
+			}
+			tangent   = Normalize(tangent);
+			bitangent = Normalize(bitangent);
+			for (const auto i : group)
+			{
+				tangents[i]   = tangent;
+				bitangents[i] = bitangent;
+			}
+		}
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <vector>
+#include <DirectXMath.h>
+
+namespace D3DEngine
+{
+	/**
+	 * \brief Tangent frames for indexed triangles, with the same arithmetic as Assimp's aiProcess_CalcTangentSpace
+	 * (so importers that bypass Assimp still give the frames it would have)
+	 */
+	class TangentSpace
+	{
+		public:
+			/**
+			 * \brief Per-triangle tangent frames projected onto each vertex's normal, then averaged over vertices that sit
+			 * (almost) on the same spot with the same normal and a tangent frame within 45 degrees.
+			 * Meant for left-handed meshes with texture v pointing down, as they come out of Model::Parse.
+			 */
+			static void Compute(const std::vector<DirectX::XMFLOAT3>& positions,
+			                    const std::vector<DirectX::XMFLOAT3>& normals,
+			                    const std::vector<DirectX::XMFLOAT2>& texcoords,
+			                    const std::vector<unsigned>&          triangles,
+			                    std::vector<DirectX::XMFLOAT3>&       tangents,
+			                    std::vector<DirectX::XMFLOAT3>&       bitangents);
+	};
+}
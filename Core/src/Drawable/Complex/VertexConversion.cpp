@@ -0,0 +1,502 @@
+#include "VertexConversion.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include "VertexPacking.h"
+#include "Utils/Parallel.h"
+
+namespace D3DEngine
+{
+	namespace dx = DirectX;
+	namespace pv = DirectX::PackedVector;
+
+	namespace
+	{
+		using Type = DynamicVertexLayout::ElementType;
+
+		// elements that can be converted into each other
+		enum class Family
+		{
+			Position,
+			Texcoord,
+			Normal,
+			Tangent,
+			Bitangent,
+			Color,
+		};
+
+		Family FamilyOf(Type type) noexcept
+		{
+			switch (type)
+			{
+				case Type::Texture2D:
+				case Type::Texture2DHalf:
+					return Family::Texcoord;
+				case Type::Normal:
+				case Type::NormalOct:
+					return Family::Normal;
+				case Type::Tangent:
+				case Type::TangentSigned:
+					return Family::Tangent;
+				case Type::Bitangent:
+					return Family::Bitangent;
+				case Type::Float3Color:
+				case Type::Float4Color:
+				case Type::BGRAColor:
+					return Family::Color;
+				default:
+					return Family::Position;
+			}
+		}
+
+		// what a missing element of each family becomes, as float4
+		dx::XMFLOAT4 DefaultOf(Family family) noexcept
+		{
+			switch (family)
+			{
+				case Family::Texcoord:
+					return {0.0f, 0.0f, 0.0f, 0.0f};
+				case Family::Normal:
+					return {0.0f, 0.0f, 1.0f, 0.0f};
+				case Family::Tangent:
+					return {1.0f, 0.0f, 0.0f, 1.0f};
+				case Family::Bitangent:
+					return {0.0f, 1.0f, 0.0f, 0.0f};
+				case Family::Color:
+					return {1.0f, 1.0f, 1.0f, 1.0f};
+				default:
+					return {0.0f, 0.0f, 0.0f, 1.0f};
+			}
+		}
+
+		const char* CodeOf(Type type) noexcept
+		{
+			return DynamicVertexLayout::Element{type, 0u}.GetCode();
+		}
+
+		template <typename T>
+		T Read(const char* p) noexcept
+		{
+			T value;
+			std::memcpy(&value, p, sizeof(T));
+			return value;
+		}
+
+		template <typename T>
+		void Write(char* p, const T& value) noexcept
+		{
+			std::memcpy(p, &value, sizeof(T));
+		}
+
+		unsigned char ToUnorm8(float v) noexcept
+		{
+			return (unsigned char)std::lround(std::clamp(v, 0.0f, 1.0f) * 255.0f);
+		}
+
+		// count elements to float4: positions get w = 1, tangents their handedness in w (+1 for Tangent, which has none)
+		void Decode(Type type, const char* pSrc, size_t stride, dx::XMFLOAT4* pOut, size_t count) noexcept
+		{
+			for (size_t i = 0; i < count; i++, pSrc += stride)
+			{
+				auto& out = pOut[i];
+				switch (type)
+				{
+					case Type::Position2D:
+					{
+						const auto v = Read<dx::XMFLOAT2>(pSrc);
+						out          = {v.x, v.y, 0.0f, 1.0f};
+						break;
+					}
+					case Type::Position3D:
+					{
+						const auto v = Read<dx::XMFLOAT3>(pSrc);
+						out          = {v.x, v.y, v.z, 1.0f};
+						break;
+					}
+					case Type::Position3DHalf:
+					{
+						const auto v = VertexPacking::DecodePosition(Read<pv::XMHALF4>(pSrc));
+						out          = {v.x, v.y, v.z, 1.0f};
+						break;
+					}
+					case Type::Texture2D:
+					{
+						const auto v = Read<dx::XMFLOAT2>(pSrc);
+						out          = {v.x, v.y, 0.0f, 0.0f};
+						break;
+					}
+					case Type::Texture2DHalf:
+					{
+						const auto v = VertexPacking::DecodeTexcoord(Read<pv::XMHALF2>(pSrc));
+						out          = {v.x, v.y, 0.0f, 0.0f};
+						break;
+					}
+					case Type::Normal:
+					case Type::Bitangent:
+					{
+						const auto v = Read<dx::XMFLOAT3>(pSrc);
+						out          = {v.x, v.y, v.z, 0.0f};
+						break;
+					}
+					case Type::NormalOct:
+					{
+						const auto v = VertexPacking::DecodeNormal(Read<pv::XMSHORTN2>(pSrc));
+						out          = {v.x, v.y, v.z, 0.0f};
+						break;
+					}
+					case Type::Tangent:
+					{
+						const auto v = Read<dx::XMFLOAT3>(pSrc);
+						out          = {v.x, v.y, v.z, 1.0f};
+						break;
+					}
+					case Type::TangentSigned:
+						out = VertexPacking::DecodeTangent(Read<pv::XMSHORTN4>(pSrc));
+						break;
+					case Type::Float3Color:
+					{
+						const auto v = Read<dx::XMFLOAT3>(pSrc);
+						out          = {v.x, v.y, v.z, 1.0f};
+						break;
+					}
+					case Type::Float4Color:
+						out = Read<dx::XMFLOAT4>(pSrc);
+						break;
+					case Type::BGRAColor:
+					{
+						const auto v = Read<::BGRAColor>(pSrc);
+						out          = {v.r / 255.0f, v.g / 255.0f, v.b / 255.0f, v.a / 255.0f};
+						break;
+					}
+					default:
+						assert("Bad element type" && false);
+				}
+			}
+		}
+
+		// float4 to count elements, dropping what the element has no room for
+		void Encode(Type type, const dx::XMFLOAT4* pIn, char* pDst, size_t stride, size_t count) noexcept
+		{
+			for (size_t i = 0; i < count; i++, pDst += stride)
+			{
+				const auto& v = pIn[i];
+				switch (type)
+				{
+					case Type::Position2D:
+					case Type::Texture2D:
+						Write(pDst, dx::XMFLOAT2{v.x, v.y});
+						break;
+					case Type::Position3D:
+					case Type::Normal:
+					case Type::Tangent:
+					case Type::Bitangent:
+					case Type::Float3Color:
+						Write(pDst, dx::XMFLOAT3{v.x, v.y, v.z});
+						break;
+					case Type::Position3DHalf:
+						Write(pDst, VertexPacking::EncodePosition({v.x, v.y, v.z}));
+						break;
+					case Type::Texture2DHalf:
+						Write(pDst, VertexPacking::EncodeTexcoord({v.x, v.y}));
+						break;
+					case Type::NormalOct:
+						Write(pDst, VertexPacking::EncodeNormal({v.x, v.y, v.z}));
+						break;
+					case Type::TangentSigned:
+						Write(pDst, VertexPacking::EncodeTangent(v));
+						break;
+					case Type::Float4Color:
+						Write(pDst, v);
+						break;
+					case Type::BGRAColor:
+						Write(pDst, ::BGRAColor{ToUnorm8(v.w), ToUnorm8(v.x), ToUnorm8(v.y), ToUnorm8(v.z)});
+						break;
+					default:
+						assert("Bad element type" && false);
+				}
+			}
+		}
+
+		// width known at compile time, so the copy of each vertex is a few moves instead of a memcpy call
+		template <size_t Width>
+		void CopyFixed(const char* pSrc, size_t srcStride, char* pDst, size_t dstStride, size_t count) noexcept
+		{
+			for (size_t i = 0; i < count; i++, pSrc += srcStride, pDst += dstStride)
+			{
+				std::memcpy(pDst, pSrc, Width);
+			}
+		}
+	}
+
+	VertexConversion::VertexConversion(const DynamicVertexLayout& from, const DynamicVertexLayout& to)
+		: srcStride(from.Size()),
+		  dstStride(to.Size())
+	{
+		// the first source element of a type, or of a family
+		const auto find = [&from](auto&& match) -> const DynamicVertexLayout::Element*
+		{
+			for (size_t e = 0; e < from.GetElementCount(); e++)
+			{
+				if (match(from.ResolveByIndex(e).GetType()))
+				{
+					return &from.ResolveByIndex(e);
+				}
+			}
+			return nullptr;
+		};
+		const auto ofType   = [&find](Type type) { return find([type](Type t) { return t == type; }); };
+		const auto ofFamily = [&find](Family family) { return find([family](Type t) { return FamilyOf(t) == family; }); };
+
+		for (size_t e = 0; e < to.GetElementCount(); e++)
+		{
+			const auto& element = to.ResolveByIndex(e);
+			const auto  type    = element.GetType();
+			const auto  offset  = element.GetOffset();
+
+			if (const auto pSame = ofType(type))
+			{
+				steps.push_back({Kind::Copy, pSame->GetOffset(), offset, element.Size()});
+			}
+			else if (const auto pKin = ofFamily(FamilyOf(type)))
+			{
+				const auto kin = pKin->GetType();
+				Step       step{Kind::Transcode, pKin->GetOffset(), offset, 0u, kin, type};
+				if (kin == Type::Position3D && type == Type::Position3DHalf)
+				{
+					// xyz through the half stream conversion, then w = 1
+					steps.push_back({Kind::FloatToHalf, pKin->GetOffset(), offset, 3u});
+					step = {Kind::Fill, 0u, offset + 3u * sizeof(pv::HALF), sizeof(pv::HALF)};
+					Write(step.fill.data(), pv::XMConvertFloatToHalf(1.0f));
+				}
+				else if ((kin == Type::Texture2D && type == Type::Texture2DHalf) || (kin == Type::Texture2DHalf && type == Type::Texture2D) ||
+				         (kin == Type::Position3DHalf && type == Type::Position3D))
+				{
+					step.kind  = kin == Type::Texture2D ? Kind::FloatToHalf : Kind::HalfToFloat;
+					step.width = type == Type::Position3D ? 3u : 2u;
+				}
+				else if (const auto pNormal = ofFamily(Family::Normal);
+					kin == Type::Tangent && type == Type::TangentSigned && pNormal && ofType(Type::Bitangent))
+				{
+					// keep the handedness of the source frame, like VertexPacking::Compress
+					step.kind         = Kind::Handedness;
+					step.normalOffset = pNormal->GetOffset();
+					step.normalType   = pNormal->GetType();
+					step.thirdOffset  = ofType(Type::Bitangent)->GetOffset();
+					step.thirdType    = Type::Bitangent;
+				}
+				steps.push_back(step);
+			}
+			else if (const auto pNormal = ofFamily(Family::Normal), pTangent = ofFamily(Family::Tangent);
+				type == Type::Bitangent && pNormal && pTangent)
+			{
+				Step step{Kind::Bitangent, 0u, offset, 0u, Type::Count, type};
+				step.normalOffset = pNormal->GetOffset();
+				step.normalType   = pNormal->GetType();
+				step.thirdOffset  = pTangent->GetOffset();
+				step.thirdType    = pTangent->GetType();
+				steps.push_back(step);
+			}
+			else
+			{
+				Step step{Kind::Fill, 0u, offset, element.Size(), Type::Count, type};
+				step.fill = DefaultValue(type);
+				steps.push_back(step);
+			}
+		}
+
+		// copies of neighbouring elements that stay neighbours become one copy
+		std::vector<Step> merged;
+		for (const auto& step : steps)
+		{
+			auto* pLast = merged.empty() ? nullptr : &merged.back();
+			if (pLast && step.kind == Kind::Copy && pLast->kind == Kind::Copy &&
+			    pLast->srcOffset + pLast->width == step.srcOffset && pLast->dstOffset + pLast->width == step.dstOffset)
+			{
+				pLast->width += step.width;
+				continue;
+			}
+			merged.push_back(step);
+		}
+		steps = std::move(merged);
+
+		needsScratch = std::ranges::any_of(steps, [](const Step& step)
+		{
+			return step.kind == Kind::Transcode || step.kind == Kind::Handedness || step.kind == Kind::Bitangent;
+		});
+	}
+
+	std::shared_ptr<const VertexConversion> VertexConversion::Get(const DynamicVertexLayout& from, const DynamicVertexLayout& to)
+	{
+		static std::mutex                                                               mutex;
+		static std::unordered_map<std::string, std::shared_ptr<const VertexConversion>> plans;
+
+		const auto      key = from.GetCode() + ">" + to.GetCode();
+		std::lock_guard lock{mutex};
+		auto&           pPlan = plans[key];
+		if (!pPlan)
+		{
+			pPlan = std::make_shared<const VertexConversion>(from, to);
+		}
+		return pPlan;
+	}
+
+	void VertexConversion::Run(const char* pSrc, char* pDst, size_t count, size_t nWorkers) const
+	{
+		const auto blocks = (count + blockSize - 1u) / blockSize;
+		ParallelFor(blocks, count < minParallelVertices ? 1u : nWorkers, [&](size_t b)
+		{
+			const auto first = b * blockSize;
+			RunBlock(pSrc + first * srcStride, pDst + first * dstStride, std::min(blockSize, count - first));
+		});
+	}
+
+	void VertexConversion::RunBlock(const char* pSrc, char* pDst, size_t count) const
+	{
+		// two float4 per vertex: the element being made and, for the tangent frame, the normal it is made with
+		std::vector<dx::XMFLOAT4> scratch(needsScratch ? 2u * count : 0u);
+		const auto                pMain   = scratch.data();
+		const auto                pNormal = scratch.data() + count;
+
+		for (const auto& step : steps)
+		{
+			const auto pFrom = pSrc + step.srcOffset;
+			const auto pTo   = pDst + step.dstOffset;
+			switch (step.kind)
+			{
+				case Kind::Copy:
+					if (step.width == srcStride && step.width == dstStride)
+					{
+						std::memcpy(pDst, pSrc, count * srcStride);
+					}
+					else
+					{
+						CopyStrided(pFrom, srcStride, pTo, dstStride, step.width, count);
+					}
+					break;
+				case Kind::FloatToHalf:
+					for (size_t c = 0; c < step.width; c++)
+					{
+						pv::XMConvertFloatToHalfStream(reinterpret_cast<pv::HALF*>(pTo + c * sizeof(pv::HALF)), dstStride,
+						                               reinterpret_cast<const float*>(pFrom + c * sizeof(float)), srcStride, count);
+					}
+					break;
+				case Kind::HalfToFloat:
+					for (size_t c = 0; c < step.width; c++)
+					{
+						pv::XMConvertHalfToFloatStream(reinterpret_cast<float*>(pTo + c * sizeof(float)), dstStride,
+						                               reinterpret_cast<const pv::HALF*>(pFrom + c * sizeof(pv::HALF)), srcStride, count);
+					}
+					break;
+				case Kind::Transcode:
+					Decode(step.from, pFrom, srcStride, pMain, count);
+					Encode(step.to, pMain, pTo, dstStride, count);
+					break;
+				case Kind::Handedness:
+					Decode(step.from, pFrom, srcStride, pMain, count);
+					Decode(step.normalType, pSrc + step.normalOffset, srcStride, pNormal, count);
+					for (size_t i = 0; i < count; i++)
+					{
+						const auto t = dx::XMLoadFloat4(&pMain[i]);
+						const auto n = dx::XMLoadFloat4(&pNormal[i]);
+						const auto b = Read<dx::XMFLOAT3>(pSrc + i * srcStride + step.thirdOffset);
+						pMain[i].w   = dx::XMVectorGetX(dx::XMVector3Dot(dx::XMVector3Cross(n, t), dx::XMLoadFloat3(&b)));
+					}
+					Encode(step.to, pMain, pTo, dstStride, count);
+					break;
+				case Kind::Bitangent:
+					Decode(step.thirdType, pSrc + step.thirdOffset, srcStride, pMain, count);
+					Decode(step.normalType, pSrc + step.normalOffset, srcStride, pNormal, count);
+					for (size_t i = 0; i < count; i++)
+					{
+						const auto t = dx::XMLoadFloat4(&pMain[i]);
+						const auto n = dx::XMLoadFloat4(&pNormal[i]);
+						dx::XMStoreFloat4(&pMain[i], dx::XMVector3Cross(n, t) * pMain[i].w);
+					}
+					Encode(step.to, pMain, pTo, dstStride, count);
+					break;
+				case Kind::Fill:
+					for (size_t i = 0; i < count; i++)
+					{
+						std::memcpy(pTo + i * dstStride, step.fill.data(), step.width);
+					}
+					break;
+			}
+		}
+	}
+
+	std::string VertexConversion::Describe() const
+	{
+		std::ostringstream oss;
+		for (const auto& step : steps)
+		{
+			switch (step.kind)
+			{
+				case Kind::Copy:
+					oss << "copy " << step.width << " bytes";
+					break;
+				case Kind::FloatToHalf:
+					oss << step.width << " floats to halves";
+					break;
+				case Kind::HalfToFloat:
+					oss << step.width << " halves to floats";
+					break;
+				case Kind::Transcode:
+					oss << CodeOf(step.from) << " to " << CodeOf(step.to);
+					break;
+				case Kind::Handedness:
+					oss << CodeOf(step.from) << " to " << CodeOf(step.to) << " with the handedness of " << CodeOf(step.normalType) << " and "
+							<< CodeOf(step.thirdType);
+					break;
+				case Kind::Bitangent:
+					oss << CodeOf(step.to) << " from " << CodeOf(step.normalType) << " x " << CodeOf(step.thirdType);
+					break;
+				case Kind::Fill:
+					oss << "fill " << step.width << " bytes";
+					break;
+			}
+			oss << " (" << step.srcOffset << " -> " << step.dstOffset << ")\n";
+		}
+		return oss.str();
+	}
+
+	void VertexConversion::CopyStrided(const char* pSrc, size_t srcStride, char* pDst, size_t dstStride, size_t width, size_t count) noexcept
+	{
+		switch (width)
+		{
+			case 4:
+				return CopyFixed<4>(pSrc, srcStride, pDst, dstStride, count);
+			case 8:
+				return CopyFixed<8>(pSrc, srcStride, pDst, dstStride, count);
+			case 12:
+				return CopyFixed<12>(pSrc, srcStride, pDst, dstStride, count);
+			case 16:
+				return CopyFixed<16>(pSrc, srcStride, pDst, dstStride, count);
+			case 20:
+				return CopyFixed<20>(pSrc, srcStride, pDst, dstStride, count);
+			case 24:
+				return CopyFixed<24>(pSrc, srcStride, pDst, dstStride, count);
+			case 32:
+				return CopyFixed<32>(pSrc, srcStride, pDst, dstStride, count);
+			case 36:
+				return CopyFixed<36>(pSrc, srcStride, pDst, dstStride, count);
+			case 44:
+				return CopyFixed<44>(pSrc, srcStride, pDst, dstStride, count);
+			default:
+				for (size_t i = 0; i < count; i++, pSrc += srcStride, pDst += dstStride)
+				{
+					std::memcpy(pDst, pSrc, width);
+				}
+		}
+	}
+
+	std::array<char, 16> VertexConversion::DefaultValue(ElementType type) noexcept
+	{
+		std::array<char, 16> value{};
+		const auto           v = DefaultOf(FamilyOf(type));
+		Encode(type, &v, value.data(), 0u, 1u);
+		return value;
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+#include "VertexView.h"
+
+namespace D3DEngine
+{
+	/**
+	 * \brief Plan for turning vertices of one layout into vertices of another, made once per pair of layouts and then run over
+	 * whole buffers (see RawVertexBufferWithLayout::ConvertTo). Every element of the target layout is filled by one step:
+	 * a copy (neighbouring copies merged into one), a strided float <-> half stream conversion, a conversion through float4
+	 * within the element's family (positions, texture coordinates, normals, tangents, bitangents, colors), or a default value
+	 * if the source has nothing to fill it from. Steps run one element at a time over blocks of vertices, blocks in parallel.
+	 */
+	class VertexConversion
+	{
+		public:
+			using ElementType = DynamicVertexLayout::ElementType;
+
+			VertexConversion(const DynamicVertexLayout& from, const DynamicVertexLayout& to);
+			// the plan for a pair of layouts, made on first use and shared from then on
+			static std::shared_ptr<const VertexConversion> Get(const DynamicVertexLayout& from, const DynamicVertexLayout& to);
+			// convert count vertices (0 workers = one per hardware thread, small buffers always run on the calling thread)
+			void Run(const char* pSrc, char* pDst, size_t count, size_t nWorkers = 0u) const;
+			// one line per step, for benchmarks and debugging
+			std::string Describe() const;
+			// what an element without a source is filled with, in its own format
+			static std::array<char, 16> DefaultValue(ElementType type) noexcept;
+			// width bytes from every srcStride to every dstStride, unrolled for the widths vertex elements and vertices come in
+			static void CopyStrided(const char* pSrc, size_t srcStride, char* pDst, size_t dstStride, size_t width, size_t count) noexcept;
+
+			// vertices per block: one block's worth of every stream stays in cache while the steps go over it
+			static constexpr size_t blockSize           = 4096u;
+			static constexpr size_t minParallelVertices = 65536u;
+		private:
+			enum class Kind
+			{
+				Copy,        // width bytes as they are
+				FloatToHalf, // width float components to halves
+				HalfToFloat, // width half components to floats
+				Transcode,   // from -> float4 -> to
+				Handedness,  // Tangent to TangentSigned, w from the source's normal and bitangent
+				Bitangent,   // cross(normal, tangent) * w from the source's normal and tangent
+				Fill,        // width bytes of fill
+			};
+
+			struct Step
+			{
+				Kind                 kind;
+				size_t               srcOffset    = 0u;
+				size_t               dstOffset    = 0u;
+				size_t               width        = 0u;
+				ElementType          from         = ElementType::Count;
+				ElementType          to           = ElementType::Count;
+				size_t               normalOffset = 0u; // Handedness, Bitangent
+				ElementType          normalType   = ElementType::Count;
+				size_t               thirdOffset  = 0u; // Handedness: bitangent, Bitangent: tangent
+				ElementType          thirdType    = ElementType::Count;
+				std::array<char, 16> fill         = {};
+			};
+
+			void RunBlock(const char* pSrc, char* pDst, size_t count) const;
+
+			std::vector<Step> steps;
+			size_t            srcStride;
+			size_t            dstStride;
+			bool              needsScratch = false;
+	};
+}
@@ -0,0 +1,248 @@
+#include "VertexPacking.h"
+#include "VertexView.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace D3DEngine
+{
+	namespace dx = DirectX;
+	namespace pv = DirectX::PackedVector;
+
+	namespace
+	{
+		using Type = DynamicVertexLayout::ElementType;
+
+		constexpr float snorm16 = 32767.0f;
+
+		int16_t ToSnorm16(float v) noexcept
+		{
+			return (int16_t)std::lround(std::clamp(v, -1.0f, 1.0f) * snorm16);
+		}
+
+		// SNORM maps both -32768 and -32767 to -1
+		float FromSnorm16(int16_t v) noexcept
+		{
+			return std::max((float)v / snorm16, -1.0f);
+		}
+
+		float SignNotZero(float v) noexcept
+		{
+			return v >= 0.0f ? 1.0f : -1.0f;
+		}
+
+		template <typename T>
+		const T& Read(const char* pVertex, size_t offset) noexcept
+		{
+			return *reinterpret_cast<const T*>(pVertex + offset);
+		}
+	}
+
+	pv::XMHALF4 VertexPacking::EncodePosition(const dx::XMFLOAT3& position) noexcept
+	{
+		return {
+			pv::XMConvertFloatToHalf(position.x),
+			pv::XMConvertFloatToHalf(position.y),
+			pv::XMConvertFloatToHalf(position.z),
+			pv::XMConvertFloatToHalf(1.0f)
+		};
+	}
+
+	dx::XMFLOAT3 VertexPacking::DecodePosition(const pv::XMHALF4& position) noexcept
+	{
+		return {pv::XMConvertHalfToFloat(position.x), pv::XMConvertHalfToFloat(position.y), pv::XMConvertHalfToFloat(position.z)};
+	}
+
+	pv::XMHALF2 VertexPacking::EncodeTexcoord(const dx::XMFLOAT2& tc) noexcept
+	{
+		return {pv::XMConvertFloatToHalf(tc.x), pv::XMConvertFloatToHalf(tc.y)};
+	}
+
+	dx::XMFLOAT2 VertexPacking::DecodeTexcoord(const pv::XMHALF2& tc) noexcept
+	{
+		return {pv::XMConvertHalfToFloat(tc.x), pv::XMConvertHalfToFloat(tc.y)};
+	}
+
+	// project onto the octahedron |x| + |y| + |z| = 1 and unfold its lower half over the corners of the upper one
+	pv::XMSHORTN2 VertexPacking::EncodeNormal(const dx::XMFLOAT3& normal) noexcept
+	{
+		const float l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+		if (l1 == 0.0f)
+		{
+			return {0, 0};
+		}
+
+		float x = normal.x / l1;
+		float y = normal.y / l1;
+		if (normal.z < 0.0f)
+		{
+			const float fx = (1.0f - std::abs(y)) * SignNotZero(x);
+			const float fy = (1.0f - std::abs(x)) * SignNotZero(y);
+			x              = fx;
+			y              = fy;
+		}
+		return {ToSnorm16(x), ToSnorm16(y)};
+	}
+
+	// mirrored in Shaders/helper/Octahedral.hlsl, keep the two in sync
+	dx::XMFLOAT3 VertexPacking::DecodeNormal(const pv::XMSHORTN2& normal) noexcept
+	{
+		float       x = FromSnorm16(normal.x);
+		float       y = FromSnorm16(normal.y);
+		const float z = 1.0f - std::abs(x) - std::abs(y);
+		// fold the corners back under the upper half
+		const float t = std::max(-z, 0.0f);
+		x += x >= 0.0f ? -t : t;
+		y += y >= 0.0f ? -t : t;
+
+		dx::XMFLOAT3 n;
+		dx::XMStoreFloat3(&n, dx::XMVector3Normalize(dx::XMVectorSet(x, y, z, 0.0f)));
+		return n;
+	}
+
+	pv::XMSHORTN4 VertexPacking::EncodeTangent(const dx::XMFLOAT4& tangent) noexcept
+	{
+		return {ToSnorm16(tangent.x), ToSnorm16(tangent.y), ToSnorm16(tangent.z), ToSnorm16(SignNotZero(tangent.w))};
+	}
+
+	dx::XMFLOAT4 VertexPacking::DecodeTangent(const pv::XMSHORTN4& tangent) noexcept
+	{
+		return {FromSnorm16(tangent.x), FromSnorm16(tangent.y), FromSnorm16(tangent.z), SignNotZero(FromSnorm16(tangent.w))};
+	}
+
+	RawVertexBufferWithLayout VertexPacking::Compress(const RawVertexBufferWithLayout& vertices, const Options& options, Stats* pStats)
+	{
+		const auto& layout = vertices.GetLayout();
+		const auto  count  = vertices.Size();
+		const auto  stride = layout.Size();
+		const char* pSrc   = vertices.GetData();
+
+		Stats stats;
+		stats.bytesBefore = vertices.SizeBytes();
+
+		// find the source offsets of the attributes we might pack
+		size_t positionOffset = 0u, texcoordOffset = 0u, normalOffset = 0u;
+		for (size_t e = 0; e < layout.GetElementCount(); e++)
+		{
+			const auto& element = layout.ResolveByIndex(e);
+			switch (element.GetType())
+			{
+				case Type::Position3D:
+					positionOffset = element.GetOffset();
+					break;
+				case Type::Texture2D:
+					texcoordOffset = element.GetOffset();
+					break;
+				case Type::Normal:
+					normalOffset = element.GetOffset();
+					break;
+				default:
+					break;
+			}
+		}
+
+		// an attribute is only packed if every vertex makes the round trip within bounds
+		bool packPositions = options.positions && layout.Has(Type::Position3D) && count > 0u;
+		if (packPositions)
+		{
+			auto lo = dx::XMLoadFloat3(&Read<dx::XMFLOAT3>(pSrc, positionOffset));
+			auto hi = lo;
+			for (size_t i = 0; i < count; i++)
+			{
+				const auto& p = Read<dx::XMFLOAT3>(pSrc + i * stride, positionOffset);
+				const auto  d = DecodePosition(EncodePosition(p));
+				lo            = dx::XMVectorMin(lo, dx::XMLoadFloat3(&p));
+				hi            = dx::XMVectorMax(hi, dx::XMLoadFloat3(&p));
+				// NaN (overflow to infinity) fails the bound below as well
+				const float error   = dx::XMVectorGetX(dx::XMVector3Length(dx::XMLoadFloat3(&d) - dx::XMLoadFloat3(&p)));
+				stats.positionError = std::isfinite(error) ? std::max(stats.positionError, error) : std::numeric_limits<float>::infinity();
+			}
+			const float radius = dx::XMVectorGetX(dx::XMVector3Length(hi - lo)) * 0.5f;
+			packPositions      = stats.positionError <= options.maxPositionError * radius;
+		}
+		if (!packPositions)
+		{
+			stats.positionError = 0.0f;
+		}
+
+		bool packTexcoords = options.texcoords && layout.Has(Type::Texture2D);
+		if (packTexcoords)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				const auto& tc      = Read<dx::XMFLOAT2>(pSrc + i * stride, texcoordOffset);
+				const auto  d       = DecodeTexcoord(EncodeTexcoord(tc));
+				const float error   = std::max(std::abs(d.x - tc.x), std::abs(d.y - tc.y));
+				stats.texcoordError = std::isfinite(error) ? std::max(stats.texcoordError, error) : std::numeric_limits<float>::infinity();
+			}
+			packTexcoords = stats.texcoordError <= options.maxTexcoordError;
+		}
+		if (!packTexcoords)
+		{
+			stats.texcoordError = 0.0f;
+		}
+
+		const bool packNormals  = options.normals && layout.Has(Type::Normal);
+		const bool packTangents = packNormals && layout.Has(Type::Tangent) && layout.Has(Type::Bitangent);
+		if (packNormals)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				const auto n = dx::XMLoadFloat3(&Read<dx::XMFLOAT3>(pSrc + i * stride, normalOffset));
+				if (dx::XMVectorGetX(dx::XMVector3LengthSq(n)) == 0.0f)
+				{
+					continue;
+				}
+				const auto  d      = DecodeNormal(EncodeNormal(Read<dx::XMFLOAT3>(pSrc + i * stride, normalOffset)));
+				// atan2 rather than acos, which cannot resolve angles this small from a float dot product
+				const auto  un     = dx::XMVector3Normalize(n);
+				const auto  ud     = dx::XMLoadFloat3(&d);
+				const float sine   = dx::XMVectorGetX(dx::XMVector3Length(dx::XMVector3Cross(un, ud)));
+				const float cosine = dx::XMVectorGetX(dx::XMVector3Dot(un, ud));
+				stats.normalError  = std::max(stats.normalError, std::atan2(sine, cosine));
+			}
+		}
+
+		// new layout, in the original element order
+		DynamicVertexLayout packedLayout;
+		for (size_t e = 0; e < layout.GetElementCount(); e++)
+		{
+			auto to = layout.ResolveByIndex(e).GetType();
+			switch (to)
+			{
+				case Type::Position3D:
+					to = packPositions ? Type::Position3DHalf : to;
+					break;
+				case Type::Texture2D:
+					to = packTexcoords ? Type::Texture2DHalf : to;
+					break;
+				case Type::Normal:
+					to = packNormals ? Type::NormalOct : to;
+					break;
+				case Type::Tangent:
+					to = packTangents ? Type::TangentSigned : to;
+					break;
+				case Type::Bitangent:
+					if (packTangents)
+					{
+						continue;
+					}
+					break;
+				default:
+					break;
+			}
+			packedLayout.Append(to);
+		}
+
+		// the tangent keeps the handedness of the original frame, so cross(n, t) * w points along the original bitangent;
+		// one worker, meshes are already compressed in parallel
+		auto packed = vertices.ConvertTo(packedLayout, 1u);
+
+		stats.bytesAfter = packed.SizeBytes();
+		if (pStats)
+		{
+			*pStats = stats;
+		}
+		return packed;
+	}
+}
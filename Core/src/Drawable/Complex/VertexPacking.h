@@ -0,0 +1,54 @@
+#pragma once
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+
+namespace D3DEngine
+{
+	class RawVertexBufferWithLayout;
+
+	/**
+	 * \brief Encoders/decoders behind the compact vertex element types, and the pass that switches a mesh over to them.
+	 * Positions and texture coordinates become half floats, normals become two SNORM16 octahedral coordinates and the
+	 * tangent frame shrinks to a SNORM16 tangent with the bitangent's handedness in w.
+	 */
+	class VertexPacking
+	{
+		public:
+			struct Options
+			{
+				bool  positions        = true;
+				float maxPositionError = 1.0f / 1024.0f; // relative to the mesh's bounding radius, positions stay float beyond it
+				bool  texcoords        = true;
+				float maxTexcoordError = 1.0f / 2048.0f; // absolute, texture coordinates stay float beyond it (e.g. heavy tiling)
+				bool  normals          = true;           // normals and tangent frames (their precision does not depend on the mesh)
+			};
+
+			// what Compress did to one vertex buffer
+			struct Stats
+			{
+				size_t bytesBefore   = 0u;
+				size_t bytesAfter    = 0u;
+				float  positionError = 0.0f; // largest distance between a position and its decoded half, object space
+				float  texcoordError = 0.0f; // largest per-component texture coordinate error
+				float  normalError   = 0.0f; // largest angle (radians) between a normal and its decoded octahedral encoding
+			};
+
+			/**
+			 * \brief Copy of vertices with every attribute packed that stays within the options' error bounds.
+			 * The tangent is only packed if the layout carries a normal and a bitangent to take the handedness from, and the
+			 * bitangent is dropped with it (the vertex shader rebuilds it as cross(normal, tangent) * w).
+			 */
+			static RawVertexBufferWithLayout Compress(const RawVertexBufferWithLayout& vertices, const Options& options, Stats* pStats = nullptr);
+
+			static DirectX::PackedVector::XMHALF4   EncodePosition(const DirectX::XMFLOAT3& position) noexcept;
+			static DirectX::XMFLOAT3                DecodePosition(const DirectX::PackedVector::XMHALF4& position) noexcept;
+			static DirectX::PackedVector::XMHALF2   EncodeTexcoord(const DirectX::XMFLOAT2& tc) noexcept;
+			static DirectX::XMFLOAT2                DecodeTexcoord(const DirectX::PackedVector::XMHALF2& tc) noexcept;
+			// normal does not need to be unit length, a zero normal comes back as +z
+			static DirectX::PackedVector::XMSHORTN2 EncodeNormal(const DirectX::XMFLOAT3& normal) noexcept;
+			static DirectX::XMFLOAT3                DecodeNormal(const DirectX::PackedVector::XMSHORTN2& normal) noexcept;
+			// w is the bitangent's handedness, only its sign is kept
+			static DirectX::PackedVector::XMSHORTN4 EncodeTangent(const DirectX::XMFLOAT4& tangent) noexcept;
+			static DirectX::XMFLOAT4                DecodeTangent(const DirectX::PackedVector::XMSHORTN4& tangent) noexcept;
+	};
+}
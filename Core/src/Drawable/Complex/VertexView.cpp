@@ -1,4 +1,6 @@
 ﻿#include "VertexView.h"
+#include "VertexConversion.h"
+#include <cstring>
 
 namespace D3DEngine
 {
@@ -9,6 +11,18 @@ namespace D3DEngine
 		return elements[i];
 	}
 
+	bool DynamicVertexLayout::Has(ElementType type) const noexcept
+	{
+		for (const auto& e : elements)
+		{
+			if (e.GetType() == type)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
 	// append an element to the layout
 	DynamicVertexLayout& DynamicVertexLayout::Append(ElementType type) noxnd
 	{
@@ -33,6 +47,11 @@ namespace D3DEngine
 		for (const auto& e : elements)
 		{
 			desc.push_back(e.GetDesc());
+			if (storage == Storage::Streams)
+			{
+				desc.back().InputSlot         = (UINT)(desc.size() - 1u);
+				desc.back().AlignedByteOffset = 0u;
+			}
 		}
 		return desc;
 	}
@@ -44,9 +63,25 @@ namespace D3DEngine
 		{
 			code += e.GetCode();
 		}
+		// input layouts for streams differ from interleaved ones with the same elements
+		if (storage == Storage::Streams)
+		{
+			code += "|S";
+		}
 		return code;
 	}
 
+	DynamicVertexLayout& DynamicVertexLayout::SetStorage(Storage storageIn) noexcept
+	{
+		storage = storageIn;
+		return *this;
+	}
+
+	DynamicVertexLayout::Storage DynamicVertexLayout::GetStorage() const noexcept
+	{
+		return storage;
+	}
+
 
 	// VertexLayout::Element
 	DynamicVertexLayout::Element::Element(ElementType type, size_t offset)
@@ -95,6 +130,14 @@ namespace D3DEngine
 				return sizeof(Map<Float4Color>::SysType);
 			case BGRAColor:
 				return sizeof(Map<BGRAColor>::SysType);
+			case Position3DHalf:
+				return sizeof(Map<Position3DHalf>::SysType);
+			case Texture2DHalf:
+				return sizeof(Map<Texture2DHalf>::SysType);
+			case NormalOct:
+				return sizeof(Map<NormalOct>::SysType);
+			case TangentSigned:
+				return sizeof(Map<TangentSigned>::SysType);
 		}
 		assert("Invalid element type" && false);
 		return 0u;
@@ -127,6 +170,14 @@ namespace D3DEngine
 				return Map<Float4Color>::code;
 			case BGRAColor:
 				return Map<BGRAColor>::code;
+			case Position3DHalf:
+				return Map<Position3DHalf>::code;
+			case Texture2DHalf:
+				return Map<Texture2DHalf>::code;
+			case NormalOct:
+				return Map<NormalOct>::code;
+			case TangentSigned:
+				return Map<TangentSigned>::code;
 		}
 		assert("Invalid element type" && false);
 		return "Invalid";
@@ -154,6 +205,14 @@ namespace D3DEngine
 				return GenerateDesc<Float4Color>(GetOffset());
 			case BGRAColor:
 				return GenerateDesc<BGRAColor>(GetOffset());
+			case Position3DHalf:
+				return GenerateDesc<Position3DHalf>(GetOffset());
+			case Texture2DHalf:
+				return GenerateDesc<Texture2DHalf>(GetOffset());
+			case NormalOct:
+				return GenerateDesc<NormalOct>(GetOffset());
+			case TangentSigned:
+				return GenerateDesc<TangentSigned>(GetOffset());
 		}
 		assert("Invalid element type" && false);
 		return {"INVALID", 0, DXGI_FORMAT_UNKNOWN, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0};
@@ -169,20 +228,44 @@ namespace D3DEngine
 		assert(pData != nullptr);
 	}
 
+	DirectX::XMFLOAT3 VertexView::Position() const noxnd
+	{
+		auto& self = const_cast<VertexView&>(*this);
+		if (layout.Has(DynamicVertexLayout::Position3DHalf))
+		{
+			return DynamicVertexLayout::Map<DynamicVertexLayout::Position3DHalf>::Decode(self.Attr<DynamicVertexLayout::Position3DHalf>());
+		}
+		return self.Attr<DynamicVertexLayout::Position3D>();
+	}
+
 	ConstVertexView::ConstVertexView(const VertexView& v) noxnd
 		:
 		vertex(v)
 	{
 	}
 
+	DirectX::XMFLOAT3 ConstVertexView::Position() const noxnd
+	{
+		return vertex.Position();
+	}
+
 
 	// VertexBuffer
 	RawVertexBufferWithLayout::RawVertexBufferWithLayout(DynamicVertexLayout layout, size_t size) noxnd
 		: layout(std::move(layout))
 	{
+		assert(this->layout.GetStorage() == DynamicVertexLayout::Storage::Interleaved && "Streams are stored in VertexStreams");
 		Resize(size);
 	}
 
+	RawVertexBufferWithLayout::RawVertexBufferWithLayout(DynamicVertexLayout layout, const char* pData, size_t size) noxnd
+		: layout(std::move(layout))
+	{
+		assert(this->layout.GetStorage() == DynamicVertexLayout::Storage::Interleaved && "Streams are stored in VertexStreams");
+		assert(pData != nullptr || size == 0u);
+		buffer.assign(pData, pData + this->layout.Size() * size);
+	}
+
 	void RawVertexBufferWithLayout::Resize(size_t newSize) noxnd
 	{
 		const auto size = Size();
@@ -192,11 +275,70 @@ namespace D3DEngine
 		}
 	}
 
+	void RawVertexBufferWithLayout::Reserve(size_t capacity) noxnd
+	{
+		buffer.reserve(layout.Size() * capacity);
+	}
+
+	void RawVertexBufferWithLayout::Append(size_t count, std::initializer_list<Column> columns) noxnd
+	{
+		namespace dx = DirectX;
+		const auto stride = layout.Size();
+		const auto first  = buffer.size();
+		buffer.resize(first + stride * count);
+
+		for (const auto& column : columns)
+		{
+			size_t e = 0;
+			while (e < layout.GetElementCount() && layout.ResolveByIndex(e).GetType() != column.type)
+			{
+				e++;
+			}
+			assert("Column for an element the layout doesn't have" && e < layout.GetElementCount());
+			const auto& element   = layout.ResolveByIndex(e);
+			const auto  size      = element.Size();
+			const auto  srcStride = column.stride ? column.stride : size;
+			const auto  pSrc      = static_cast<const char*>(column.pData);
+			const auto  pDst      = buffer.data() + first + element.GetOffset();
+			if (column.scale == 1.0f)
+			{
+				VertexConversion::CopyStrided(pSrc, srcStride, pDst, stride, size, count);
+				continue;
+			}
+
+			// a scaling matrix through the transform streams: a vectorized strided multiply, exact for a diagonal matrix
+			const auto scaling = dx::XMMatrixScaling(column.scale, column.scale, column.scale);
+			switch (column.type)
+			{
+				case DynamicVertexLayout::Position2D:
+				case DynamicVertexLayout::Texture2D:
+					dx::XMVector2TransformNormalStream(reinterpret_cast<dx::XMFLOAT2*>(pDst), stride,
+					                                   reinterpret_cast<const dx::XMFLOAT2*>(pSrc), srcStride, count, scaling);
+					break;
+				case DynamicVertexLayout::Position3D:
+				case DynamicVertexLayout::Normal:
+				case DynamicVertexLayout::Tangent:
+				case DynamicVertexLayout::Bitangent:
+				case DynamicVertexLayout::Float3Color:
+					dx::XMVector3TransformNormalStream(reinterpret_cast<dx::XMFLOAT3*>(pDst), stride,
+					                                   reinterpret_cast<const dx::XMFLOAT3*>(pSrc), srcStride, count, scaling);
+					break;
+				default:
+					assert("Only float2/float3 elements can be scaled" && false);
+			}
+		}
+	}
+
 	const char* RawVertexBufferWithLayout::GetData() const noxnd
 	{
 		return buffer.data();
 	}
 
+	char* RawVertexBufferWithLayout::GetData() noxnd
+	{
+		return buffer.data();
+	}
+
 	const DynamicVertexLayout& RawVertexBufferWithLayout::GetLayout() const noexcept
 	{
 		return layout;
@@ -213,6 +355,13 @@ namespace D3DEngine
 		return buffer.size();
 	}
 
+	RawVertexBufferWithLayout RawVertexBufferWithLayout::ConvertTo(const DynamicVertexLayout& target, size_t nWorkers) const
+	{
+		RawVertexBufferWithLayout converted{target, Size()};
+		VertexConversion::Get(layout, target)->Run(GetData(), converted.GetData(), Size(), nWorkers);
+		return converted;
+	}
+
 	VertexView RawVertexBufferWithLayout::Back() noxnd
 	{
 		assert(buffer.size() != 0u);
@@ -245,4 +394,112 @@ namespace D3DEngine
 	{
 		return const_cast<RawVertexBufferWithLayout&>(*this)[i];
 	}
+
+
+	// VertexStreams
+	VertexStreams::VertexStreams(DynamicVertexLayout layoutIn, size_t size) noxnd
+		: streams(layoutIn.GetElementCount()),
+		  layout(std::move(layoutIn.SetStorage(DynamicVertexLayout::Storage::Streams)))
+	{
+		Resize(size);
+	}
+
+	VertexStreams::VertexStreams(const RawVertexBufferWithLayout& vertices) noxnd
+		: VertexStreams(vertices.GetLayout(), vertices.Size())
+	{
+		// one pass per element, each reading the interleaved vertices with a constant stride and writing its stream in order
+		const auto stride = layout.Size();
+		for (size_t e = 0; e < streams.size(); e++)
+		{
+			const auto& element = layout.ResolveByIndex(e);
+			const auto  width   = element.Size();
+			auto        pSrc    = vertices.GetData() + element.GetOffset();
+			auto        pDst    = streams[e].data();
+			for (size_t i = 0; i < size; i++, pSrc += stride, pDst += width)
+			{
+				memcpy(pDst, pSrc, width);
+			}
+		}
+	}
+
+	RawVertexBufferWithLayout VertexStreams::Interleave() const noxnd
+	{
+		RawVertexBufferWithLayout vertices{DynamicVertexLayout{layout}.SetStorage(DynamicVertexLayout::Storage::Interleaved), size};
+		const auto                stride = layout.Size();
+		for (size_t e = 0; e < streams.size(); e++)
+		{
+			const auto& element = layout.ResolveByIndex(e);
+			const auto  width   = element.Size();
+			auto        pSrc    = streams[e].data();
+			auto        pDst    = vertices.GetData() + element.GetOffset();
+			for (size_t i = 0; i < size; i++, pSrc += width, pDst += stride)
+			{
+				memcpy(pDst, pSrc, width);
+			}
+		}
+		return vertices;
+	}
+
+	void VertexStreams::Resize(size_t newSize) noxnd
+	{
+		if (size < newSize)
+		{
+			for (size_t e = 0; e < streams.size(); e++)
+			{
+				streams[e].resize(layout.ResolveByIndex(e).Size() * newSize);
+			}
+			size = newSize;
+		}
+	}
+
+	const DynamicVertexLayout& VertexStreams::GetLayout() const noexcept
+	{
+		return layout;
+	}
+
+	// size: in number of vertices
+	size_t VertexStreams::Size() const noexcept
+	{
+		return size;
+	}
+
+	size_t VertexStreams::SizeBytes() const noexcept
+	{
+		return layout.Size() * size;
+	}
+
+	size_t VertexStreams::GetStreamCount() const noexcept
+	{
+		return streams.size();
+	}
+
+	size_t VertexStreams::GetStreamStride(size_t stream) const noxnd
+	{
+		return layout.ResolveByIndex(stream).Size();
+	}
+
+	const char* VertexStreams::GetStreamData(size_t stream) const noxnd
+	{
+		assert(stream < streams.size());
+		return streams[stream].data();
+	}
+
+	char* VertexStreams::GetStreamData(size_t stream) noxnd
+	{
+		assert(stream < streams.size());
+		return streams[stream].data();
+	}
+
+	size_t VertexStreams::StreamOf(DynamicVertexLayout::ElementType type) const noxnd
+	{
+		for (size_t e = 0; e < layout.GetElementCount(); e++)
+		{
+			if (layout.ResolveByIndex(e).GetType() == type)
+			{
+				return e;
+			}
+		}
+		assert("Could not resolve element type" && false);
+		return 0u;
+	}
 }
@@ -1,8 +1,11 @@
 ﻿#pragma once
+#include <array>
+#include <string_view>
 #include <vector>
 #include <type_traits>
 #include "Graphics.h"
 #include "Color.h"
+#include "VertexPacking.h"
 
 namespace D3DEngine
 {
@@ -24,9 +27,24 @@ namespace D3DEngine
 				Float3Color,
 				Float4Color,
 				BGRAColor,
+				// compact stand-ins for the float elements above (see VertexPacking), appended so cached type values stay valid
+				Position3DHalf,
+				Texture2DHalf,
+				NormalOct,
+				TangentSigned, // tangent with the bitangent's handedness in w, replaces Tangent + Bitangent
 				Count,
 			};
 
+			/**
+			 * \brief How vertices with this layout are stored: interleaved in one stream (RawVertexBufferWithLayout), or with
+			 * every element in a stream of its own (VertexStreams), which the input layout then reads from one slot per element
+			 */
+			enum class Storage
+			{
+				Interleaved,
+				Streams,
+			};
+
 			// template specialization
 			// compile-time lookup table
 			template <ElementType>
@@ -113,6 +131,56 @@ namespace D3DEngine
 				static constexpr const char* code       = "C8";
 			};
 
+			// the compact types below also know how to convert from (and back to) the float type they stand in for
+
+			template <>
+			struct Map<Position3DHalf>
+			{
+				using SysType = DirectX::PackedVector::XMHALF4;
+				static constexpr DXGI_FORMAT dxgiFormat = DXGI_FORMAT_R16G16B16A16_FLOAT; // there is no 3 component 16-bit format, w is padding
+				static constexpr const char* semantic   = "Position";
+				static constexpr const char* code       = "P3h";
+
+				static SysType Encode(const DirectX::XMFLOAT3& v) noexcept { return VertexPacking::EncodePosition(v); }
+				static DirectX::XMFLOAT3 Decode(const SysType& v) noexcept { return VertexPacking::DecodePosition(v); }
+			};
+
+			template <>
+			struct Map<Texture2DHalf>
+			{
+				using SysType = DirectX::PackedVector::XMHALF2;
+				static constexpr DXGI_FORMAT dxgiFormat = DXGI_FORMAT_R16G16_FLOAT;
+				static constexpr const char* semantic   = "TexCoord";
+				static constexpr const char* code       = "T2h";
+
+				static SysType Encode(const DirectX::XMFLOAT2& v) noexcept { return VertexPacking::EncodeTexcoord(v); }
+				static DirectX::XMFLOAT2 Decode(const SysType& v) noexcept { return VertexPacking::DecodeTexcoord(v); }
+			};
+
+			template <>
+			struct Map<NormalOct>
+			{
+				using SysType = DirectX::PackedVector::XMSHORTN2;
+				static constexpr DXGI_FORMAT dxgiFormat = DXGI_FORMAT_R16G16_SNORM;
+				static constexpr const char* semantic   = "Normal";
+				static constexpr const char* code       = "No";
+
+				static SysType Encode(const DirectX::XMFLOAT3& v) noexcept { return VertexPacking::EncodeNormal(v); }
+				static DirectX::XMFLOAT3 Decode(const SysType& v) noexcept { return VertexPacking::DecodeNormal(v); }
+			};
+
+			template <>
+			struct Map<TangentSigned>
+			{
+				using SysType = DirectX::PackedVector::XMSHORTN4;
+				static constexpr DXGI_FORMAT dxgiFormat = DXGI_FORMAT_R16G16B16A16_SNORM;
+				static constexpr const char* semantic   = "Tangent";
+				static constexpr const char* code       = "Nts";
+
+				static SysType Encode(const DirectX::XMFLOAT4& v) noexcept { return VertexPacking::EncodeTangent(v); }
+				static DirectX::XMFLOAT4 Decode(const SysType& v) noexcept { return VertexPacking::DecodeTangent(v); }
+			};
+
 			class Element
 			{
 				public:
@@ -156,13 +224,18 @@ namespace D3DEngine
 			}
 
 			const Element&                        ResolveByIndex(size_t i) const noxnd;
+			bool                                  Has(ElementType type) const noexcept;
 			DynamicVertexLayout&                  Append(ElementType type) noxnd;
 			size_t                                Size() const noxnd;
 			size_t                                GetElementCount() const noexcept;
+			// one input slot per element for Storage::Streams, each element at offset 0 of its slot
 			std::vector<D3D11_INPUT_ELEMENT_DESC> GetD3DLayout() const noxnd;
 			std::string                           GetCode() const noxnd;
+			DynamicVertexLayout&                  SetStorage(Storage storage) noexcept;
+			Storage                               GetStorage() const noexcept;
 		private:
 			std::vector<Element> elements;
+			Storage              storage = Storage::Interleaved;
 	};
 
 	/**
@@ -180,6 +253,9 @@ namespace D3DEngine
 				return *reinterpret_cast<typename DynamicVertexLayout::Map<Type>::SysType*>(pAttribute);
 			}
 
+			// 3D position, whether the layout stores it as floats or halves
+			DirectX::XMFLOAT3 Position() const noxnd;
+
 			template <typename T>
 			void SetAttributeByIndex(size_t i, T&& val) noxnd
 			{
@@ -215,6 +291,18 @@ namespace D3DEngine
 					case DynamicVertexLayout::BGRAColor:
 						SetAttribute<DynamicVertexLayout::BGRAColor>(pAttribute, std::forward<T>(val));
 						break;
+					case DynamicVertexLayout::Position3DHalf:
+						SetAttribute<DynamicVertexLayout::Position3DHalf>(pAttribute, std::forward<T>(val));
+						break;
+					case DynamicVertexLayout::Texture2DHalf:
+						SetAttribute<DynamicVertexLayout::Texture2DHalf>(pAttribute, std::forward<T>(val));
+						break;
+					case DynamicVertexLayout::NormalOct:
+						SetAttribute<DynamicVertexLayout::NormalOct>(pAttribute, std::forward<T>(val));
+						break;
+					case DynamicVertexLayout::TangentSigned:
+						SetAttribute<DynamicVertexLayout::TangentSigned>(pAttribute, std::forward<T>(val));
+						break;
 					default:
 						assert("Bad element type" && false);
 				}
@@ -240,6 +328,11 @@ namespace D3DEngine
 				{
 					*reinterpret_cast<Dest*>(pAttribute) = val;
 				}
+				else if constexpr (requires { DynamicVertexLayout::Map<DestLayoutType>::Encode(val); })
+				{
+					// compact element filled from the float type it stands in for
+					*reinterpret_cast<Dest*>(pAttribute) = DynamicVertexLayout::Map<DestLayoutType>::Encode(val);
+				}
 				else
 				{
 					assert("Parameter attribute type mismatch" && false);
@@ -265,19 +358,42 @@ namespace D3DEngine
 				return const_cast<VertexView&>(vertex).Attr<Type>();
 			}
 
+			DirectX::XMFLOAT3 Position() const noxnd;
+
 		private:
 			VertexView vertex;
 	};
 
 	class RawVertexBufferWithLayout
 	{
+		public:
+			// where one element of a batch of vertices comes from: an array of its SysType, or of anything laid out like it
+			// (aiVector3D, a member of an importer's own vertex struct), stride bytes from one vertex to the next
+			struct Column
+			{
+				DynamicVertexLayout::ElementType type;
+				const void*                      pData;
+				size_t                           stride = 0u;   // 0: tightly packed
+				float                            scale  = 1.0f; // float elements only
+			};
+
 		public:
 			RawVertexBufferWithLayout(DynamicVertexLayout layout, size_t size = 0u) noxnd;
+			// adopt `size` vertices that are already packed according to `layout` (e.g. read back from a model cache)
+			RawVertexBufferWithLayout(DynamicVertexLayout layout, const char* pData, size_t size) noxnd;
 			void                       Resize(size_t newSize) noxnd;
+			void                       Reserve(size_t capacity) noxnd;
+			// append count vertices in one go, one column per element (elements without one are zeroed): the buffer grows once
+			// and every column is written with one strided pass instead of a SetAttributeByIndex switch per vertex and element
+			void                       Append(size_t count, std::initializer_list<Column> columns) noxnd;
 			const char*                GetData() const noxnd;
+			char*                      GetData() noxnd;
 			const DynamicVertexLayout& GetLayout() const noexcept;
 			size_t                     Size() const noxnd;
 			size_t                     SizeBytes() const noxnd;
+			// the same vertices in another layout: elements are matched by type, converted within their kind (e.g. Normal to
+			// NormalOct) or filled with a default (see VertexConversion); 0 workers = one per hardware thread
+			RawVertexBufferWithLayout  ConvertTo(const DynamicVertexLayout& target, size_t nWorkers = 0u) const;
 
 			// construct a new Vertex in-place at the end of the buffer
 			template <typename ...Params>
@@ -302,4 +418,231 @@ namespace D3DEngine
 			// the layout that describes the structure of the vertices
 			DynamicVertexLayout layout;
 	};
+
+	/**
+	 * \brief Structure-of-arrays counterpart of RawVertexBufferWithLayout: every element of the layout lives in a contiguous
+	 * stream of its own, so a pass that only needs positions reads tightly packed positions and nothing else
+	 */
+	class VertexStreams
+	{
+		public:
+			// layout is switched to Storage::Streams
+			VertexStreams(DynamicVertexLayout layout, size_t size = 0u) noxnd;
+			// split interleaved vertices into streams
+			explicit VertexStreams(const RawVertexBufferWithLayout& vertices) noxnd;
+			// the same vertices interleaved again
+			RawVertexBufferWithLayout  Interleave() const noxnd;
+			void                       Resize(size_t newSize) noxnd;
+			const DynamicVertexLayout& GetLayout() const noexcept;
+			size_t                     Size() const noexcept;
+			size_t                     SizeBytes() const noexcept;
+			// streams come in the order of the layout's elements
+			size_t                     GetStreamCount() const noexcept;
+			size_t                     GetStreamStride(size_t stream) const noxnd;
+			const char*                GetStreamData(size_t stream) const noxnd;
+			char*                      GetStreamData(size_t stream) noxnd;
+			// index of the stream holding an element type (the layout must have it)
+			size_t                     StreamOf(DynamicVertexLayout::ElementType type) const noxnd;
+
+			// the stream of one element type as an array of Size() attributes
+			template <DynamicVertexLayout::ElementType Type>
+			auto* Stream() noxnd
+			{
+				return reinterpret_cast<typename DynamicVertexLayout::Map<Type>::SysType*>(GetStreamData(StreamOf(Type)));
+			}
+
+			template <DynamicVertexLayout::ElementType Type>
+			const auto* Stream() const noxnd
+			{
+				return reinterpret_cast<const typename DynamicVertexLayout::Map<Type>::SysType*>(GetStreamData(StreamOf(Type)));
+			}
+
+		private:
+			std::vector<std::vector<char>> streams;
+			DynamicVertexLayout            layout;
+			size_t                         size = 0u;
+	};
+
+	/**
+	 * \brief Vertex layout fixed at compile time: offsets, stride, D3D input descriptors and layout code are all constants,
+	 * so attribute access is a load at a fixed offset instead of a search through the layout's elements.
+	 * Interoperates with the dynamic side: Dynamic() makes the DynamicVertexLayout with the same elements (for
+	 * RawVertexBufferWithLayout, InputLayout and the Codex), and View() reads a buffer built with it in place.
+	 */
+	template <DynamicVertexLayout::ElementType... Types>
+	class StaticVertexLayout
+	{
+		public:
+			using ElementType = DynamicVertexLayout::ElementType;
+			template <ElementType Type>
+			using SysType = typename DynamicVertexLayout::Map<Type>::SysType;
+
+			static_assert(sizeof...(Types) > 0u, "A vertex layout needs at least one element");
+
+		private:
+			static constexpr std::array<ElementType, sizeof...(Types)> types = {Types...};
+
+			// offset of every element, packed in order like DynamicVertexLayout::Append does it
+			static constexpr std::array<size_t, sizeof...(Types)> offsets = []
+			{
+				constexpr std::array<size_t, sizeof...(Types)> sizes = {sizeof(SysType<Types>)...};
+				std::array<size_t, sizeof...(Types)>           result{};
+				size_t                                         offset = 0u;
+				for (size_t i = 0; i < sizes.size(); i++)
+				{
+					result[i] = offset;
+					offset += sizes[i];
+				}
+				return result;
+			}();
+
+			// every element code in order, zero terminated
+			static constexpr auto codeChars = []
+			{
+				constexpr size_t length = (std::char_traits<char>::length(DynamicVertexLayout::Map<Types>::code) + ...);
+				std::array<char, length + 1u> result{};
+				size_t                        n = 0u;
+				for (const char* pCode : {DynamicVertexLayout::Map<Types>::code...})
+				{
+					while (*pCode != '\0')
+					{
+						result[n++] = *pCode++;
+					}
+				}
+				return result;
+			}();
+
+		public:
+			static constexpr size_t count  = sizeof...(Types);
+			static constexpr size_t stride = (sizeof(SysType<Types>) + ...);
+			// same string as DynamicVertexLayout::GetCode() gives for the same elements
+			static constexpr std::string_view code{codeChars.data(), codeChars.size() - 1u};
+
+			static constexpr std::array<D3D11_INPUT_ELEMENT_DESC, sizeof...(Types)> d3dLayout = []
+			{
+				std::array<D3D11_INPUT_ELEMENT_DESC, sizeof...(Types)> result = {
+					D3D11_INPUT_ELEMENT_DESC{
+						DynamicVertexLayout::Map<Types>::semantic, 0, DynamicVertexLayout::Map<Types>::dxgiFormat, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0
+					}...
+				};
+				for (size_t i = 0; i < result.size(); i++)
+				{
+					result[i].AlignedByteOffset = (UINT)offsets[i];
+				}
+				return result;
+			}();
+
+			template <ElementType Type>
+			static constexpr bool Has() noexcept
+			{
+				return ((Type == Types) || ...);
+			}
+
+			template <ElementType Type>
+			static constexpr size_t Offset() noexcept
+			{
+				static_assert(Has<Type>(), "Element type is not part of the layout");
+				size_t i = 0u;
+				while (types[i] != Type)
+				{
+					i++;
+				}
+				return offsets[i];
+			}
+
+			// the same layout, for everything that takes a DynamicVertexLayout
+			static DynamicVertexLayout Dynamic() noxnd
+			{
+				DynamicVertexLayout layout;
+				(layout.Append(Types), ...);
+				return layout;
+			}
+
+			// true if layout has exactly these elements in this order (and so the same offsets)
+			static bool Matches(const DynamicVertexLayout& layout) noexcept
+			{
+				if (layout.GetElementCount() != count)
+				{
+					return false;
+				}
+				for (size_t i = 0; i < count; i++)
+				{
+					if (layout.ResolveByIndex(i).GetType() != types[i])
+					{
+						return false;
+					}
+				}
+				return true;
+			}
+
+			/**
+			 * \brief Proxy into one vertex; Byte is char, or const char for read-only access
+			 */
+			template <typename Byte>
+			class BasicVertex
+			{
+				public:
+					explicit BasicVertex(Byte* pData) noexcept
+						: pData(pData)
+					{
+					}
+
+					template <ElementType Type>
+					auto& Attr() const noexcept
+					{
+						constexpr size_t offset = Offset<Type>();
+						using Attribute         = std::conditional_t<std::is_const_v<Byte>, const SysType<Type>, SysType<Type>>;
+						return *reinterpret_cast<Attribute*>(pData + offset);
+					}
+
+				private:
+					Byte* pData;
+			};
+
+			/**
+			 * \brief The vertices of a RawVertexBufferWithLayout whose layout matches, indexed with the constant stride
+			 */
+			template <typename Byte>
+			class BasicVertices
+			{
+				public:
+					BasicVertices(Byte* pData, size_t size) noexcept
+						: pData(pData),
+						  size(size)
+					{
+					}
+
+					BasicVertex<Byte> operator[](size_t i) const noxnd
+					{
+						assert(i < size);
+						return BasicVertex<Byte>{pData + stride * i};
+					}
+
+					size_t Size() const noexcept
+					{
+						return size;
+					}
+
+				private:
+					Byte*  pData;
+					size_t size;
+			};
+
+			using Vertex        = BasicVertex<char>;
+			using ConstVertex   = BasicVertex<const char>;
+			using Vertices      = BasicVertices<char>;
+			using ConstVertices = BasicVertices<const char>;
+
+			static Vertices View(RawVertexBufferWithLayout& buffer) noxnd
+			{
+				assert(Matches(buffer.GetLayout()) && "Buffer layout does not match the static layout");
+				return {buffer.GetData(), buffer.Size()};
+			}
+
+			static ConstVertices View(const RawVertexBufferWithLayout& buffer) noxnd
+			{
+				assert(Matches(buffer.GetLayout()) && "Buffer layout does not match the static layout");
+				return {buffer.GetData(), buffer.Size()};
+			}
+	};
 }
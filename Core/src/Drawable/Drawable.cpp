@@ -7,21 +7,68 @@ namespace D3DEngine
 	void Drawable::Draw(Graphics& gfx) const noxnd
 	{
 		// bind the bindables (bindables that are unique per instance)
-		for (auto& b : binds_)
+		for (const auto pb : bindOrder_)
 		{
-			b->Bind(gfx);
+			pb->Bind(gfx);
 		}
 		gfx.DrawIndexed(pIndexBuffer_->GetCount());
 	}
 
-	void Drawable::AddBind(std::shared_ptr<Bindable> bind) noxnd
+	void Drawable::DrawRange(Graphics& gfx, IndexRange range, INT baseVertex) const noxnd
 	{
+		for (const auto pb : bindOrder_)
+		{
+			pb->Bind(gfx);
+		}
+		gfx.DrawIndexed(range.count, range.start, baseVertex);
+	}
+
+	void Drawable::DrawRanges(Graphics& gfx, const std::vector<IndexRange>& ranges, UINT firstIndex, INT baseVertex) const noxnd
+	{
+		for (const auto pb : bindOrder_)
+		{
+			pb->Bind(gfx);
+		}
+		for (const auto& range : ranges)
+		{
+			gfx.DrawIndexed(range.count, firstIndex + range.start, baseVertex);
+		}
+	}
+
+	void Drawable::AddBindable(std::shared_ptr<Bindable> bind) noxnd
+	{
+		const auto id = bind->GetTypeId();
+		assert("Bindable added without its type" && id != Bindable::noTypeId);
 		// special case for index buffer
-		if (typeid(*bind) == typeid(IndexBuffer))
+		if (id == Bindable::TypeIdOf<IndexBuffer>())
 		{
 			assert("Binding multiple index buffers not allowed" && pIndexBuffer_ == nullptr);
-			pIndexBuffer_ = &static_cast<IndexBuffer&>(*bind);
+			pIndexBuffer_ = static_cast<const IndexBuffer*>(bind.get());
 		}
+		if (id >= bindsByType_.size())
+		{
+			bindsByType_.resize(id + 1u, nullptr);
+		}
+		if (bindsByType_[id] == nullptr)
+		{
+			bindsByType_[id] = bind.get();
+		}
+		// after the ones of the same type added before, so that same type bindables still bind in the order they were added
+		const auto at = std::ranges::upper_bound(bindOrder_, id, {}, [](const Bindable* pb) { return pb->GetTypeId(); });
+		bindOrder_.insert(at, bind.get());
 		binds_.push_back(std::move(bind));
 	}
+
+	void Drawable::ReplaceBindable(std::shared_ptr<Bindable> bind) noxnd
+	{
+		const auto id = bind->GetTypeId();
+		assert("Bindable replaced without its type" && id != Bindable::noTypeId);
+		assert("Index buffers cannot be replaced" && id != Bindable::TypeIdOf<IndexBuffer>());
+		assert("No bindable of this type to replace" && id < bindsByType_.size() && bindsByType_[id] != nullptr);
+		const auto pOld = bindsByType_[id];
+		// same type ID, so it takes the old one's place in the bind order as well
+		*std::ranges::find(bindOrder_, pOld) = bind.get();
+		bindsByType_[id]                     = bind.get();
+		*std::ranges::find_if(binds_, [pOld](const auto& pb) { return pb.get() == pOld; }) = std::move(bind);
+	}
 }
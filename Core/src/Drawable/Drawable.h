@@ -1,37 +1,55 @@
 #pragma once
 #include "Graphics.h"
+#include "Bindable/Bindable.h"
 
 namespace D3DEngine
 {
-	class Bindable;
 	class IndexBuffer;
 
 	class Drawable
 	{
 		public:
+			// part of the bound index buffer, in indices
+			struct IndexRange
+			{
+				UINT start;
+				UINT count;
+			};
+
 			Drawable()                = default;
 			virtual ~Drawable()       = default;
 			Drawable(const Drawable&) = delete;
 			virtual DirectX::XMMATRIX GetTransformXM() const noexcept = 0;
 			void                      Draw(Graphics& gfx) const noxnd;
-			// query instance of bindable to be changed
+			// query instance of bindable to be changed: the first one added of exactly type T (not of a type derived from it)
 			template <class T>
 			T* QueryBindable() noexcept
 			{
-				for (auto& pb : binds_)
-				{
-					if (auto pt = dynamic_cast<T*>(pb.get()))
-					{
-						return pt;
-					}
-				}
-				return nullptr;
+				const auto id = Bindable::TypeIdOf<T>();
+				return id < bindsByType_.size() ? static_cast<T*>(bindsByType_[id]) : nullptr;
 			}
 
 		protected:
-			void AddBind(std::shared_ptr<Bindable> bind) noxnd;
+			// a bindable passed as a plain Bindable has to be identified already (see Bindable::Identify)
+			template <class T>
+			void AddBind(std::shared_ptr<T> bind) noxnd
+			{
+				Bindable::Identify(*bind);
+				AddBindable(std::move(bind));
+			}
+			// swap the first bindable of the replacement's type (added before) for the replacement
+			void ReplaceBindable(std::shared_ptr<Bindable> bind) noxnd;
+			// draw only part of the bound index buffer (e.g. one mesh of a shared buffer), baseVertex is added to its indices
+			void DrawRange(Graphics& gfx, IndexRange range, INT baseVertex = 0) const noxnd;
+			// bind everything once, then draw only the given parts of the bound index buffer (starts relative to firstIndex)
+			void DrawRanges(Graphics& gfx, const std::vector<IndexRange>& ranges, UINT firstIndex = 0u, INT baseVertex = 0) const noxnd;
+		private:
+			void AddBindable(std::shared_ptr<Bindable> bind) noxnd;
 		private:
 			const IndexBuffer*                     pIndexBuffer_ = nullptr;
-			std::vector<std::shared_ptr<Bindable>> binds_; // Single pool of Bindables per Drawable instance
+			std::vector<std::shared_ptr<Bindable>> binds_;       // Single pool of Bindables per Drawable instance, keeps them alive
+			// what Draw walks, sorted by type ID: drawables made of the same types of bindable call their Binds in the same order
+			std::vector<Bindable*>                 bindOrder_;
+			std::vector<Bindable*>                 bindsByType_; // first bindable of each type, indexed by its type ID
 	};
 }
@@ -9,7 +9,7 @@ namespace D3DEngine
 		public:
 			IndexedTriangleList() = default;
 
-			IndexedTriangleList(RawVertexBufferWithLayout verts_in, std::vector<unsigned short> indices_in)
+			IndexedTriangleList(RawVertexBufferWithLayout verts_in, std::vector<unsigned int> indices_in)
 				:
 				vertices(std::move(verts_in)),
 				indices(std::move(indices_in))
@@ -21,9 +21,27 @@ namespace D3DEngine
 			void Transform(DirectX::FXMMATRIX matrix)
 			{
 				using Elements = DynamicVertexLayout::ElementType;
-				for (int i = 0; i < vertices.Size(); i++)
+				// the offset is looked up once, not per vertex (VertexView::Attr searches the layout on every access)
+				const auto stride = vertices.GetLayout().Size();
+				auto       pPos   = vertices.GetData() + vertices.GetLayout().Resolve<Elements::Position3D>().GetOffset();
+				for (size_t i = 0; i < vertices.Size(); i++, pPos += stride)
 				{
-					auto& pos = vertices[i].Attr<Elements::Position3D>();
+					auto& pos = *reinterpret_cast<DirectX::XMFLOAT3*>(pPos);
+					DirectX::XMStoreFloat3(
+					                       &pos,
+					                       DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&pos), matrix)
+					                      );
+				}
+			}
+
+			// Transform for lists known to be built with Layout, where every access is at a constant offset
+			template <typename Layout>
+			void Transform(DirectX::FXMMATRIX matrix) noxnd
+			{
+				const auto view = Layout::View(vertices);
+				for (size_t i = 0; i < view.Size(); i++)
+				{
+					auto& pos = view[i].template Attr<DynamicVertexLayout::Position3D>();
 					DirectX::XMStoreFloat3(
 					                       &pos,
 					                       DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&pos), matrix)
@@ -35,25 +53,98 @@ namespace D3DEngine
 			{
 				using namespace DirectX;
 				using Type = DynamicVertexLayout::ElementType;
+				const auto stride    = vertices.GetLayout().Size();
+				const auto posOffset = vertices.GetLayout().Resolve<Type::Position3D>().GetOffset();
+				const auto nOffset   = vertices.GetLayout().Resolve<Type::Normal>().GetOffset();
+				const auto pData     = vertices.GetData();
+				const auto position  = [&](unsigned int v) { return reinterpret_cast<XMFLOAT3*>(pData + v * stride + posOffset); };
+				const auto normal    = [&](unsigned int v) { return reinterpret_cast<XMFLOAT3*>(pData + v * stride + nOffset); };
 				for (size_t i = 0; i < indices.size(); i += 3)
 				{
-					auto       v0 = vertices[indices[i]];
-					auto       v1 = vertices[indices[i + 1]];
-					auto       v2 = vertices[indices[i + 2]];
-					const auto p0 = XMLoadFloat3(&v0.Attr<Type::Position3D>());
-					const auto p1 = XMLoadFloat3(&v1.Attr<Type::Position3D>());
-					const auto p2 = XMLoadFloat3(&v2.Attr<Type::Position3D>());
+					const auto p0 = XMLoadFloat3(position(indices[i]));
+					const auto p1 = XMLoadFloat3(position(indices[i + 1]));
+					const auto p2 = XMLoadFloat3(position(indices[i + 2]));
 
 					const auto n = XMVector3Normalize(XMVector3Cross((p1 - p0), (p2 - p0)));
 
-					XMStoreFloat3(&v0.Attr<Type::Normal>(), n);
-					XMStoreFloat3(&v1.Attr<Type::Normal>(), n);
-					XMStoreFloat3(&v2.Attr<Type::Normal>(), n);
+					XMStoreFloat3(normal(indices[i]), n);
+					XMStoreFloat3(normal(indices[i + 1]), n);
+					XMStoreFloat3(normal(indices[i + 2]), n);
 				}
 			}
 
+			// true if the list can be drawn with a 16-bit index buffer as it is
+			bool FitsShortIndices() const noexcept
+			{
+				return vertices.Size() <= maxShortIndexedVertices;
+			}
+
+			/**
+			 * \brief Cut the list into pieces that each address at most 65536 vertices, so every piece can use 16-bit indices.
+			 * Triangles keep their order, and vertices used on both sides of a cut are duplicated into each piece.
+			 */
+			std::vector<IndexedTriangleList> SplitForShortIndices() const
+			{
+				const auto stride = vertices.GetLayout().Size();
+
+				std::vector<IndexedTriangleList> pieces;
+				std::vector<char>                pieceVertices;
+				std::vector<unsigned int>        pieceIndices;
+				unsigned int                     pieceVertexCount = 0u;
+				// remap[v] is v's index in the current piece, valid when owner[v] is the current piece number
+				std::vector<unsigned int> remap(vertices.Size());
+				std::vector<size_t>       owner(vertices.Size(), std::numeric_limits<size_t>::max());
+
+				const auto flush = [&]
+				{
+					pieces.emplace_back(
+					                    RawVertexBufferWithLayout{vertices.GetLayout(), pieceVertices.data(), pieceVertexCount},
+					                    std::move(pieceIndices)
+					                   );
+					pieceVertices.clear();
+					pieceIndices.clear();
+					pieceVertexCount = 0u;
+				};
+
+				for (size_t i = 0; i < indices.size(); i += 3)
+				{
+					// start a new piece if this triangle might not fit (a vertex repeated within the triangle is counted twice, which is harmless)
+					size_t newVertices = 0u;
+					for (size_t k = 0; k < 3; k++)
+					{
+						newVertices += owner[indices[i + k]] != pieces.size() ? 1u : 0u;
+					}
+					if (pieceVertexCount + newVertices > maxShortIndexedVertices)
+					{
+						flush();
+					}
+
+					for (size_t k = 0; k < 3; k++)
+					{
+						const auto v = indices[i + k];
+						if (owner[v] != pieces.size())
+						{
+							owner[v] = pieces.size();
+							remap[v] = pieceVertexCount++;
+							const auto pVertex = vertices.GetData() + v * stride;
+							pieceVertices.insert(pieceVertices.end(), pVertex, pVertex + stride);
+						}
+						pieceIndices.push_back(remap[v]);
+					}
+				}
+				if (!pieceIndices.empty())
+				{
+					flush();
+				}
+
+				return pieces;
+			}
+
 		public:
-			RawVertexBufferWithLayout   vertices;
-			std::vector<unsigned short> indices;
+			// largest number of vertices 16-bit indices can address
+			static constexpr size_t maxShortIndexedVertices = 0x10000u;
+
+			RawVertexBufferWithLayout vertices;
+			std::vector<unsigned int> indices;
 	};
 }
@@ -21,6 +21,7 @@ namespace D3DEngine
 				const float     longitudeAngle = 2.0f * PI / longDiv;
 
 				RawVertexBufferWithLayout vb{std::move(layout)};
+				vb.Reserve(size_t(latDiv - 1) * longDiv + 2u);
 				for (int iLat = 1; iLat < latDiv; iLat++)
 				{
 					const auto latBase = XMVector3Transform(
@@ -40,13 +41,13 @@ namespace D3DEngine
 				}
 
 				// add the cap vertices
-				const auto iNorthPole = (unsigned short)vb.Size();
+				const auto iNorthPole = (unsigned int)vb.Size();
 				{
 					dx::XMFLOAT3 northPos;
 					XMStoreFloat3(&northPos, base);
 					vb.EmplaceBack(northPos);
 				}
-				const auto iSouthPole = (unsigned short)vb.Size();
+				const auto iSouthPole = (unsigned int)vb.Size();
 				{
 					dx::XMFLOAT3 southPos;
 					XMStoreFloat3(&southPos, dx::XMVectorNegate(base));
@@ -57,7 +58,7 @@ namespace D3DEngine
 				{
 					return iLat * longDiv + iLong;
 				};
-				std::vector<unsigned short> indices;
+				std::vector<unsigned int> indices;
 				for (unsigned short iLat = 0; iLat < latDiv - 2; iLat++)
 				{
 					for (unsigned short iLong = 0; iLong < longDiv - 1; iLong++)
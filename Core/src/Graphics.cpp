@@ -12,6 +12,9 @@ namespace D3DEngine
 	namespace dx = DirectX;
 
 	Graphics::Graphics(HWND hWnd, int width, int height)
+		:
+		width_((UINT)width),
+		height_((UINT)height)
 	{
 		// ---------------Swap Chain and Device Creation Stage--------------------------
 		// Describes a swap chain
@@ -79,6 +82,7 @@ namespace D3DEngine
 			               nullptr,
 			               &pDeviceContext_
 		               ));
+		state_.SetContext(pDeviceContext_.Get());
 		// ------------End Swap Chain and Device Creation Stage--------------------------
 
 
@@ -157,7 +161,7 @@ namespace D3DEngine
 
 
 		// ---------Bind Render target and Depth Stencil Stage--------------------------
-		pDeviceContext_->OMSetRenderTargets(1u, pRenderTargetView_.GetAddressOf(), pDepthStencilView_.Get());
+		state_.SetRenderTargets(pRenderTargetView_.Get(), pDepthStencilView_.Get());
 		// -------End Bind Render target and Depth Stencil Stage--------------------------
 
 
@@ -194,11 +198,18 @@ namespace D3DEngine
 		ImGui_ImplDX11_Shutdown();
 	}
 
-	void Graphics::DrawIndexed(UINT count) noxnd
+	void Graphics::DrawIndexed(UINT count, UINT startIndex, INT baseVertex) noxnd
+	{
+		// Using flip mode means that we have to rebind render targets every frame: Present unbinds them, and EndFrame invalidates the
+		// tracked state after it, so this reaches the context on the first draw of a frame only
+		state_.SetRenderTargets(pRenderTargetView_.Get(), pDepthStencilView_.Get());
+		GFX_THROW_INFO_ONLY(pDeviceContext_->DrawIndexed(count, startIndex, baseVertex));
+		frameStats_.drawCalls++;
+	}
+
+	const Graphics::FrameStats& Graphics::GetFrameStats() const noexcept
 	{
-		// Using flip mode means that we have to rebind render targets every frame
-		pDeviceContext_->OMSetRenderTargets(1u, pRenderTargetView_.GetAddressOf(), pDepthStencilView_.Get());
-		GFX_THROW_INFO_ONLY(pDeviceContext_->DrawIndexed(count, 0u, 0u));
+		return lastFrameStats_;
 	}
 
 	void Graphics::SetProjection(DirectX::FXMMATRIX proj) noexcept
@@ -221,6 +232,16 @@ namespace D3DEngine
 		return cameraMat_;
 	}
 
+	UINT Graphics::GetWidth() const noexcept
+	{
+		return width_;
+	}
+
+	UINT Graphics::GetHeight() const noexcept
+	{
+		return height_;
+	}
+
 	void Graphics::BeginFrame(float red, float green, float blue) noexcept
 	{
 		// imgui begin frame
@@ -231,6 +252,11 @@ namespace D3DEngine
 			ImGui::NewFrame();
 		}
 
+		frameStats_.states = state_.GetCounters();
+		lastFrameStats_    = frameStats_;
+		frameStats_        = {};
+		state_.ResetCounters();
+
 		const float color[] = {red, green, blue, 1.0f};
 		pDeviceContext_->ClearRenderTargetView(pRenderTargetView_.Get(), color);
 		pDeviceContext_->ClearDepthStencilView(pDepthStencilView_.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0u);
@@ -244,6 +270,8 @@ namespace D3DEngine
 			ImGui::Render();
 			ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
 		}
+		// imgui sets state of its own behind the tracker's back
+		state_.Invalidate();
 
 		HRESULT hr;
 
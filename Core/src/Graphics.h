@@ -3,11 +3,13 @@
 #include "Debug/DXException.h"
 #include "Debug/DxgiInfoManager.h"
 #include "Debug/ConditionalNoexcept.h"
+#include "StateTracker.h"
 
 #include <d3d11.h>
 #include <wrl.h>
 #include <d3dcompiler.h>
 #include <DirectXMath.h>
+#include <mutex>
 
 namespace D3DEngine
 {
@@ -21,6 +23,13 @@ namespace D3DEngine
 		// Bindable now have access to private member of Graphics class
 		friend class Bindable;
 		public:
+			// what the draws of one frame cost in submissions to the context
+			struct FrameStats
+			{
+				UINT          drawCalls = 0u;
+				StateCounters states;    // state setting calls that reached the context, and that were dropped, per kind of state
+			};
+
 			Graphics(HWND hWnd, int width, int height);
 
 			// we don't want to copy/move Graphics object
@@ -29,7 +38,10 @@ namespace D3DEngine
 
 			~Graphics();
 
-			void DrawIndexed(UINT count) noxnd;
+			// baseVertex is added to every index before it is looked up, so meshes can share one vertex buffer
+			void DrawIndexed(UINT count, UINT startIndex = 0u, INT baseVertex = 0) noxnd;
+			// counters of the last completed frame
+			const FrameStats& GetFrameStats() const noexcept;
 
 			void              SetProjection(DirectX::FXMMATRIX proj) noexcept;
 			DirectX::XMMATRIX GetProjection() const noexcept;
@@ -37,6 +49,10 @@ namespace D3DEngine
 			void              SetCamera(DirectX::FXMMATRIX cam) noexcept;
 			DirectX::XMMATRIX GetCamera() const noexcept;
 
+			// size of the back buffer in pixels
+			UINT GetWidth() const noexcept;
+			UINT GetHeight() const noexcept;
+
 			void BeginFrame(float red, float green, float blue) noexcept;
 			void EndFrame();
 			void ClearBuffer(float red, float green, float blue) noexcept;
@@ -48,6 +64,16 @@ namespace D3DEngine
 		private:
 			bool imguiEnabled_ = true;
 
+			// all state setting goes through it (bindables reach it via Bindable::GetState); it forgets what is bound once imgui has drawn
+			StateTracker<ID3D11DeviceContext> state_;
+			// the immediate context is not thread-safe: bindables constructed off the render thread use it under this lock
+			std::mutex                        contextMutex_;
+			FrameStats                        frameStats_;
+			FrameStats                        lastFrameStats_;
+
+			UINT width_;
+			UINT height_;
+
 			DirectX::XMMATRIX projMat_;
 			DirectX::XMMATRIX cameraMat_;
 
@@ -0,0 +1,28 @@
+#include "../../helper/Transform.hlsl"
+#include "../../helper/Octahedral.hlsl"
+
+struct VSOut
+{
+	float3 viewPos : Position;
+	float3 viewNormal : Normal;
+	float3 viewTangent : Tangent;
+	float3 viewBitangent : Bitangent;
+	float2 tc : TexCoord;
+	float4 pos : SV_Position;
+};
+
+// same as PhongVSNormalMap, for vertices packed by VertexPacking (octahedral normal, tangent with handedness in w)
+VSOut main(float3 inPos : Position, float2 inNormal : Normal, float4 inTangent : Tangent, float2 inTexCoord : TexCoord)
+{
+	const float3 normal    = DecodeOctahedral(inNormal);
+	const float3 bitangent = cross(normal, inTangent.xyz) * inTangent.w;
+
+	VSOut vso;
+	vso.viewPos       = (float3)mul(float4(inPos, 1.0f), modelView);
+	vso.viewNormal    = mul(normal, (float3x3)modelView);
+	vso.viewTangent   = mul(inTangent.xyz, (float3x3)modelView);
+	vso.viewBitangent = mul(bitangent, (float3x3)modelView);
+	vso.pos           = mul(float4(inPos, 1.0f), modelViewProj);
+	vso.tc            = inTexCoord;
+	return vso;
+}
@@ -0,0 +1,19 @@
+#include "../../helper/Transform.hlsl"
+#include "../../helper/Octahedral.hlsl"
+
+struct VSOut
+{
+	float3 viewPos : Position;
+	float3 viewNormal : Normal;
+	float4 pos : SV_Position;
+};
+
+// same as PhongVSNotex, for vertices whose normal VertexPacking stored octahedral
+VSOut main(float3 inPos : Position, float2 inNormal : Normal)
+{
+	VSOut vso;
+	vso.viewPos    = (float3)mul(float4(inPos, 1.0f), modelView);
+	vso.viewNormal = mul(DecodeOctahedral(inNormal), (float3x3)modelView);
+	vso.pos        = mul(float4(inPos, 1.0f), modelViewProj);
+	return vso;
+}
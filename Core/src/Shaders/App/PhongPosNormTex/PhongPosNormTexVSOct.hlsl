@@ -0,0 +1,21 @@
+#include "../../helper/Transform.hlsl"
+#include "../../helper/Octahedral.hlsl"
+
+struct VSOut
+{
+	float3 viewPos : Position;
+	float3 viewNormal : Normal;
+	float2 tc : TexCoord;
+	float4 pos : SV_Position;
+};
+
+// same as PhongPosNormTexVS, for vertices whose normal VertexPacking stored octahedral
+VSOut main(float3 inPos : Position, float2 inNormal : Normal, float2 inTexCoord : TexCoord)
+{
+	VSOut vso;
+	vso.viewPos    = (float3)mul(float4(inPos, 1.0f), modelView);
+	vso.viewNormal = mul(DecodeOctahedral(inNormal), (float3x3)modelView);
+	vso.pos        = mul(float4(inPos, 1.0f), modelViewProj);
+	vso.tc         = inTexCoord;
+	return vso;
+}
@@ -0,0 +1,8 @@
+// inverse of VertexPacking::EncodeNormal (the SNORM format already brought the coordinates into [-1, 1])
+float3 DecodeOctahedral(const in float2 oct)
+{
+	float3      n = float3(oct, 1.0f - abs(oct.x) - abs(oct.y));
+	const float t = max(-n.z, 0.0f);
+	n.xy += n.xy >= 0.0f ? -t : t;
+	return normalize(n);
+}
@@ -0,0 +1,292 @@
+#pragma once
+#include <d3d11.h>
+#include <array>
+#include <optional>
+
+namespace D3DEngine
+{
+	// the kinds of state a StateTracker sets, and counts the calls of
+	enum class PipelineState
+	{
+		Topology,
+		InputLayout,
+		VertexBuffers,
+		IndexBuffer,
+		VertexShader,
+		VSConstantBuffers,
+		PixelShader,
+		PSConstantBuffers,
+		PSShaderResources,
+		PSSamplers,
+		Rasterizer,
+		Blend,
+		RenderTargets,
+		Count
+	};
+
+	inline const char* ToString(PipelineState state) noexcept
+	{
+		constexpr const char* names[] = {
+			"Topology", "Input layout", "Vertex buffers", "Index buffer", "Vertex shader", "VS constant buffers", "Pixel shader",
+			"PS constant buffers", "PS shader resources", "PS samplers", "Rasterizer", "Blend", "Render targets"
+		};
+		static_assert(std::size(names) == size_t(PipelineState::Count));
+		return names[size_t(state)];
+	}
+
+	struct StateCounter
+	{
+		UINT issued  = 0u; // calls that reached the context
+		UINT skipped = 0u; // calls dropped because the context had that state already
+	};
+
+	using StateCounters = std::array<StateCounter, size_t(PipelineState::Count)>;
+
+	/**
+	 * \brief Shadow copy of what is bound to a device context, per pipeline stage and slot: setting what is bound already does not
+	 * reach the context. Every call is counted as issued or skipped.
+	 * State is unknown until first set, and again after Invalidate, which is needed whenever something else (imgui, Present with a
+	 * flip model swap chain) changes the context behind the tracker's back. Comparing raw pointers is safe because the context holds
+	 * a reference to everything bound to it, so a bound object cannot be freed and its address reused.
+	 * \tparam Context ID3D11DeviceContext, or a stand-in with the same Set methods (to check what reaches it without a GPU)
+	 */
+	template <class Context>
+	class StateTracker
+	{
+		public:
+			static constexpr UINT vertexBufferSlots   = D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT;
+			static constexpr UINT constantBufferSlots = D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT;
+			static constexpr UINT samplerSlots        = D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT;
+			// of the 128 shader resource slots, only the first are tracked; the rest are set every time
+			static constexpr UINT resourceSlots = 16u;
+
+			explicit StateTracker(Context* pContext = nullptr) noexcept
+				: pContext(pContext)
+			{
+			}
+
+			void SetContext(Context* pNewContext) noexcept
+			{
+				pContext = pNewContext;
+				Invalidate();
+			}
+
+			// forget what is bound: the next call of every kind reaches the context
+			void Invalidate() noexcept
+			{
+				bound = {};
+			}
+
+			const StateCounters& GetCounters() const noexcept
+			{
+				return counters;
+			}
+
+			void ResetCounters() noexcept
+			{
+				counters = {};
+			}
+
+			void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology) noexcept
+			{
+				if (!Skip(PipelineState::Topology, bound.topology == topology))
+				{
+					pContext->IASetPrimitiveTopology(topology);
+					bound.topology = topology;
+				}
+			}
+
+			void SetInputLayout(ID3D11InputLayout* pLayout) noexcept
+			{
+				if (!Skip(PipelineState::InputLayout, bound.pInputLayout == pLayout))
+				{
+					pContext->IASetInputLayout(pLayout);
+					bound.pInputLayout = pLayout;
+				}
+			}
+
+			// buffers into slots 0..count-1, at offset 0
+			void SetVertexBuffers(UINT count, ID3D11Buffer* const* pBuffers, const UINT* pStrides) noexcept
+			{
+				VertexBuffers buffers{.count = count};
+				std::copy_n(pBuffers, count, buffers.pBuffers.begin());
+				std::copy_n(pStrides, count, buffers.strides.begin());
+				if (!Skip(PipelineState::VertexBuffers, bound.vertexBuffers == buffers))
+				{
+					constexpr std::array<UINT, vertexBufferSlots> offsets{};
+					pContext->IASetVertexBuffers(0u, count, pBuffers, pStrides, offsets.data());
+					bound.vertexBuffers = buffers;
+				}
+			}
+
+			void SetIndexBuffer(ID3D11Buffer* pBuffer, DXGI_FORMAT format) noexcept
+			{
+				const IndexBuffer buffer{pBuffer, format};
+				if (!Skip(PipelineState::IndexBuffer, bound.indexBuffer == buffer))
+				{
+					pContext->IASetIndexBuffer(pBuffer, format, 0u);
+					bound.indexBuffer = buffer;
+				}
+			}
+
+			void SetVertexShader(ID3D11VertexShader* pShader) noexcept
+			{
+				if (!Skip(PipelineState::VertexShader, bound.pVertexShader == pShader))
+				{
+					pContext->VSSetShader(pShader, nullptr, 0u);
+					bound.pVertexShader = pShader;
+				}
+			}
+
+			void SetPixelShader(ID3D11PixelShader* pShader) noexcept
+			{
+				if (!Skip(PipelineState::PixelShader, bound.pPixelShader == pShader))
+				{
+					pContext->PSSetShader(pShader, nullptr, 0u);
+					bound.pPixelShader = pShader;
+				}
+			}
+
+			void SetVSConstantBuffer(UINT slot, ID3D11Buffer* pBuffer) noexcept
+			{
+				if (!Skip(PipelineState::VSConstantBuffers, bound.vsConstantBuffers[slot] == pBuffer))
+				{
+					pContext->VSSetConstantBuffers(slot, 1u, &pBuffer);
+					bound.vsConstantBuffers[slot] = pBuffer;
+				}
+			}
+
+			void SetPSConstantBuffer(UINT slot, ID3D11Buffer* pBuffer) noexcept
+			{
+				if (!Skip(PipelineState::PSConstantBuffers, bound.psConstantBuffers[slot] == pBuffer))
+				{
+					pContext->PSSetConstantBuffers(slot, 1u, &pBuffer);
+					bound.psConstantBuffers[slot] = pBuffer;
+				}
+			}
+
+			void SetPSShaderResource(UINT slot, ID3D11ShaderResourceView* pView) noexcept
+			{
+				if (!Skip(PipelineState::PSShaderResources, slot < resourceSlots && bound.psResources[slot] == pView))
+				{
+					pContext->PSSetShaderResources(slot, 1u, &pView);
+					if (slot < resourceSlots)
+					{
+						bound.psResources[slot] = pView;
+					}
+				}
+			}
+
+			void SetPSSampler(UINT slot, ID3D11SamplerState* pSampler) noexcept
+			{
+				if (!Skip(PipelineState::PSSamplers, bound.psSamplers[slot] == pSampler))
+				{
+					pContext->PSSetSamplers(slot, 1u, &pSampler);
+					bound.psSamplers[slot] = pSampler;
+				}
+			}
+
+			void SetRasterizerState(ID3D11RasterizerState* pState) noexcept
+			{
+				if (!Skip(PipelineState::Rasterizer, bound.pRasterizer == pState))
+				{
+					pContext->RSSetState(pState);
+					bound.pRasterizer = pState;
+				}
+			}
+
+			// pFactor: 4 floats, or nullptr for the default of all ones
+			void SetBlendState(ID3D11BlendState* pState, const float* pFactor, UINT sampleMask) noexcept
+			{
+				Blend blend{.pState = pState, .hasFactor = pFactor != nullptr, .sampleMask = sampleMask};
+				if (pFactor != nullptr)
+				{
+					std::copy_n(pFactor, 4u, blend.factor.begin());
+				}
+				if (!Skip(PipelineState::Blend, bound.blend == blend))
+				{
+					pContext->OMSetBlendState(pState, pFactor, sampleMask);
+					bound.blend = blend;
+				}
+			}
+
+			// one render target and the depth stencil view
+			void SetRenderTargets(ID3D11RenderTargetView* pTarget, ID3D11DepthStencilView* pDepthStencil) noexcept
+			{
+				const RenderTargets targets{pTarget, pDepthStencil};
+				if (!Skip(PipelineState::RenderTargets, bound.renderTargets == targets))
+				{
+					pContext->OMSetRenderTargets(1u, &pTarget, pDepthStencil);
+					bound.renderTargets = targets;
+				}
+			}
+
+		private:
+			struct VertexBuffers
+			{
+				UINT                                           count = 0u;
+				std::array<ID3D11Buffer*, vertexBufferSlots> pBuffers{};
+				std::array<UINT, vertexBufferSlots>          strides{};
+
+				bool operator==(const VertexBuffers& other) const noexcept
+				{
+					return count == other.count && std::equal(pBuffers.begin(), pBuffers.begin() + count, other.pBuffers.begin()) &&
+					       std::equal(strides.begin(), strides.begin() + count, other.strides.begin());
+				}
+			};
+
+			struct IndexBuffer
+			{
+				ID3D11Buffer* pBuffer;
+				DXGI_FORMAT   format;
+				bool          operator==(const IndexBuffer&) const noexcept = default;
+			};
+
+			struct Blend
+			{
+				ID3D11BlendState*    pState = nullptr;
+				std::array<float, 4> factor{};
+				bool                 hasFactor  = false;
+				UINT                 sampleMask = 0u;
+				bool                 operator==(const Blend&) const noexcept = default;
+			};
+
+			struct RenderTargets
+			{
+				ID3D11RenderTargetView* pTarget;
+				ID3D11DepthStencilView* pDepthStencil;
+				bool                    operator==(const RenderTargets&) const noexcept = default;
+			};
+
+			// empty: not known what the context has
+			struct Bound
+			{
+				std::optional<D3D11_PRIMITIVE_TOPOLOGY>                                  topology;
+				std::optional<ID3D11InputLayout*>                                        pInputLayout;
+				std::optional<VertexBuffers>                                             vertexBuffers;
+				std::optional<IndexBuffer>                                               indexBuffer;
+				std::optional<ID3D11VertexShader*>                                       pVertexShader;
+				std::optional<ID3D11PixelShader*>                                        pPixelShader;
+				std::array<std::optional<ID3D11Buffer*>, constantBufferSlots>            vsConstantBuffers;
+				std::array<std::optional<ID3D11Buffer*>, constantBufferSlots>            psConstantBuffers;
+				std::array<std::optional<ID3D11ShaderResourceView*>, resourceSlots>      psResources;
+				std::array<std::optional<ID3D11SamplerState*>, samplerSlots>             psSamplers;
+				std::optional<ID3D11RasterizerState*>                                    pRasterizer;
+				std::optional<Blend>                                                     blend;
+				std::optional<RenderTargets>                                             renderTargets;
+			};
+
+			// counts the call, and whether it can be dropped
+			bool Skip(PipelineState state, bool redundant) noexcept
+			{
+				auto& counter = counters[size_t(state)];
+				(redundant ? counter.skipped : counter.issued)++;
+				return redundant;
+			}
+
+		private:
+			Context*      pContext;
+			Bound         bound;
+			StateCounters counters{};
+	};
+}
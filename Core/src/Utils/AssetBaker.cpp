@@ -0,0 +1,511 @@
+#include "AssetBaker.h"
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <optional>
+#include "DXTimer.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+#include "Surface.h"
+#include "Drawable/Complex/Mesh.h"
+#include "Drawable/Complex/ModelCache.h"
+
+// Manifest layout (text, one entry per line, fields separated by tabs, paths always last):
+//
+//   D3DEngineBake <version>
+//   file   <content hash> <size> <last write time> <alpha: 1, 0 or -1 if not decoded> <path>
+//   model  <key> <cache size> <cache last write time> <input count> <path>
+//   input  <path>                                     (input count of them follow every model line, the model file first)
+//
+// hashes are hexadecimal; a model's key hashes the bake settings and the path and content hash of every input
+
+namespace D3DEngine
+{
+	namespace
+	{
+		struct FileRecord
+		{
+			uint64_t hash    = 0u;
+			uint64_t size    = 0u;
+			int64_t  time    = 0;
+			int      alpha   = -1;    // images only: whether they decode with alpha (-1 = not decoded since they last changed)
+			bool     checked = false; // this run: stamp looked at
+			bool     exists  = false; // this run: found on disk
+			bool     hashed  = false; // this run: stamp had changed, so the content was read
+		};
+
+		struct ModelRecord
+		{
+			uint64_t                 key        = 0u;
+			uint64_t                 cacheSize  = 0u;
+			int64_t                  cacheTime  = 0;
+			std::vector<std::string> inputs;
+		};
+
+		struct Manifest
+		{
+			std::map<std::string, FileRecord>  files;
+			std::map<std::string, ModelRecord> models;
+		};
+
+		struct FileStamp
+		{
+			uint64_t size;
+			int64_t  time;
+		};
+
+		std::optional<FileStamp> StampFile(const std::string& path)
+		{
+			std::error_code ec;
+			const auto      size = std::filesystem::file_size(path, ec);
+			if (ec)
+			{
+				return std::nullopt;
+			}
+			const auto time = std::filesystem::last_write_time(path, ec);
+			if (ec)
+			{
+				return std::nullopt;
+			}
+			return FileStamp{(uint64_t)size, (int64_t)time.time_since_epoch().count()};
+		}
+
+		// FNV-1a
+		void HashBytes(uint64_t& hash, const void* pData, size_t size) noexcept
+		{
+			const auto pBytes = static_cast<const unsigned char*>(pData);
+			for (size_t i = 0; i < size; i++)
+			{
+				hash = (hash ^ pBytes[i]) * 1099511628211ull;
+			}
+		}
+
+		// FNV-1a a word at a time (with the high bits folded back down, which the multiply alone never does), then the tail
+		uint64_t HashContent(const char* pData, size_t size) noexcept
+		{
+			uint64_t hash = 14695981039346656037ull;
+			size_t   i    = 0u;
+			for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+			{
+				uint64_t word;
+				memcpy(&word, pData + i, sizeof(word));
+				hash = (hash ^ word) * 1099511628211ull;
+				hash ^= hash >> 32;
+			}
+			HashBytes(hash, pData + i, size - i);
+			HashBytes(hash, &size, sizeof(size));
+			return hash;
+		}
+
+		// the settings' part of every model key
+		uint64_t HashSettings(const AssetBaker::Settings& settings) noexcept
+		{
+			uint64_t hash = 14695981039346656037ull;
+			HashBytes(hash, &AssetBaker::version, sizeof(AssetBaker::version));
+			HashBytes(hash, &ModelCache::version, sizeof(ModelCache::version));
+			HashBytes(hash, &settings.scale, sizeof(settings.scale));
+			const auto importSettings = Model::GetImportSettingsHash();
+			HashBytes(hash, &importSettings, sizeof(importSettings));
+			return hash;
+		}
+
+		uint64_t HashInputs(uint64_t hash, const std::vector<std::string>& inputs, const Manifest& manifest)
+		{
+			for (const auto& input : inputs)
+			{
+				// the length keeps ("ab", "c") apart from ("a", "bc")
+				const auto length = input.size();
+				HashBytes(hash, &length, sizeof(length));
+				HashBytes(hash, input.data(), length);
+				HashBytes(hash, &manifest.files.at(input).hash, sizeof(uint64_t));
+			}
+			return hash;
+		}
+
+		Manifest ReadManifest(const std::string& path)
+		{
+			Manifest      manifest;
+			std::ifstream file(path);
+			std::string   line;
+			if (!std::getline(file, line) || line != "D3DEngineBake " + std::to_string(AssetBaker::version))
+			{
+				// missing, or written by another version: bake everything
+				return manifest;
+			}
+
+			const auto split = [](const std::string& s)
+			{
+				std::vector<std::string> fields;
+				for (size_t start = 0u;;)
+				{
+					const auto end = s.find('\t', start);
+					fields.push_back(s.substr(start, end - start));
+					if (end == std::string::npos)
+					{
+						return fields;
+					}
+					start = end + 1u;
+				}
+			};
+			try
+			{
+				ModelRecord* pModel = nullptr;
+				while (std::getline(file, line))
+				{
+					const auto fields = split(line);
+					if (fields[0] == "file" && fields.size() == 6u)
+					{
+						auto& record = manifest.files[fields[5]];
+						record.hash  = std::stoull(fields[1], nullptr, 16);
+						record.size  = std::stoull(fields[2]);
+						record.time  = std::stoll(fields[3]);
+						record.alpha = std::stoi(fields[4]);
+					}
+					else if (fields[0] == "model" && fields.size() == 6u)
+					{
+						pModel            = &manifest.models[fields[5]];
+						pModel->key       = std::stoull(fields[1], nullptr, 16);
+						pModel->cacheSize = std::stoull(fields[2]);
+						pModel->cacheTime = std::stoll(fields[3]);
+						pModel->inputs.reserve(std::stoull(fields[4]));
+					}
+					else if (fields[0] == "input" && fields.size() == 2u && pModel != nullptr)
+					{
+						pModel->inputs.push_back(fields[1]);
+					}
+				}
+			}
+			catch (const std::exception&)
+			{
+				// a damaged manifest only costs this run its shortcuts
+				return {};
+			}
+
+			// models whose inputs are not all listed are not trusted
+			std::erase_if(manifest.models, [&manifest](const auto& model)
+			{
+				return model.second.inputs.empty() || std::ranges::any_of(model.second.inputs, [&manifest](const std::string& input)
+				{
+					return !manifest.files.contains(input);
+				});
+			});
+			return manifest;
+		}
+
+		bool WriteManifest(const std::string& path, const Manifest& manifest)
+		{
+			// only the files some model is made from are worth remembering
+			std::map<std::string, const FileRecord*> files;
+			for (const auto& [modelPath, model] : manifest.models)
+			{
+				for (const auto& input : model.inputs)
+				{
+					files.emplace(input, &manifest.files.at(input));
+				}
+			}
+
+			// write to a temporary first so that a crash mid-write never leaves a half-written manifest behind
+			const auto tempPath = path + ".tmp";
+			{
+				std::ofstream out(tempPath, std::ios::trunc);
+				if (!out)
+				{
+					return false;
+				}
+				out << "D3DEngineBake " << AssetBaker::version << "\n";
+				for (const auto& [filePath, pFile] : files)
+				{
+					out << "file\t" << std::hex << pFile->hash << std::dec << "\t" << pFile->size << "\t" << pFile->time << "\t"
+							<< pFile->alpha << "\t" << filePath << "\n";
+				}
+				for (const auto& [modelPath, model] : manifest.models)
+				{
+					out << "model\t" << std::hex << model.key << std::dec << "\t" << model.cacheSize << "\t" << model.cacheTime << "\t"
+							<< model.inputs.size() << "\t" << modelPath << "\n";
+					for (const auto& input : model.inputs)
+					{
+						out << "input\t" << input << "\n";
+					}
+				}
+				if (!out)
+				{
+					return false;
+				}
+			}
+			std::error_code ec;
+			std::filesystem::rename(tempPath, path, ec);
+			return !ec;
+		}
+
+		// look at every file not looked at yet this run, and read the ones that changed since the manifest was written
+		void CheckFiles(Manifest& manifest, const std::vector<std::string>& paths, size_t nWorkers, AssetBaker::Report& report)
+		{
+			// the map's nodes stay put, so the workers can fill in records by pointer
+			std::vector<std::pair<const std::string*, FileRecord*>> pending;
+			for (const auto& path : paths)
+			{
+				auto& [key, record] = *manifest.files.try_emplace(path).first;
+				if (!record.checked)
+				{
+					record.checked = true;
+					pending.emplace_back(&key, &record);
+				}
+			}
+
+			std::atomic<size_t>   hashed = 0u;
+			std::atomic<uint64_t> bytes  = 0u;
+			ParallelFor(pending.size(), nWorkers, [&](size_t i)
+			{
+				const auto& path   = *pending[i].first;
+				auto&       record = *pending[i].second;
+				const auto  stamp  = StampFile(path);
+				record.exists      = stamp.has_value();
+				if (!stamp || (stamp->size == record.size && stamp->time == record.time))
+				{
+					return;
+				}
+
+				// an empty file cannot be mapped, but it has a hash all the same
+				const MappedFile file{path};
+				const auto       hash = file.IsOpen() ? HashContent(file.GetData(), file.GetSize()) : HashContent(nullptr, 0u);
+				if (hash != record.hash)
+				{
+					record.alpha = -1;
+				}
+				record.hash   = hash;
+				record.size   = stamp->size;
+				record.time   = stamp->time;
+				record.hashed = true;
+				hashed++;
+				bytes += file.GetSize();
+			});
+			report.filesChecked += pending.size();
+			report.filesHashed += hashed;
+			report.bytesHashed += bytes;
+		}
+	}
+
+	bool AssetBaker::CanBake(const std::string& path) noexcept
+	{
+		auto extension = std::filesystem::path{path}.extension().string();
+		std::ranges::transform(extension, extension.begin(), [](char c) { return (char)std::tolower((unsigned char)c); });
+		return extension == ".obj" || extension == ".gltf" || extension == ".glb";
+	}
+
+	std::vector<std::string> AssetBaker::FindModels(const std::string& directory)
+	{
+		std::vector<std::string> models;
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(directory))
+		{
+			if (entry.is_regular_file() && CanBake(entry.path().string()))
+			{
+				models.push_back(entry.path().string());
+			}
+		}
+		std::ranges::sort(models);
+		return models;
+	}
+
+	AssetBaker::Report AssetBaker::Bake(const std::vector<std::string>& models, const std::string& manifestPath, const Settings& settings)
+	{
+		const DXTimer timer;
+		Report        report;
+		report.models             = models.size();
+		auto       manifest       = ReadManifest(manifestPath);
+		const auto importSettings = Model::GetImportSettingsHash();
+		const auto settingsHash   = HashSettings(settings);
+
+		// everything the models were made from last time (a model the manifest does not know yet: just its own file)
+		std::vector<std::string> known;
+		for (const auto& path : models)
+		{
+			const auto record = manifest.models.find(path);
+			if (record != manifest.models.end())
+			{
+				known.insert(known.end(), record->second.inputs.begin(), record->second.inputs.end());
+			}
+			else
+			{
+				known.push_back(path);
+			}
+		}
+		CheckFiles(manifest, known, settings.nWorkers, report);
+
+		// a model is current if its cache is the one the manifest saw written, from inputs that still hash the same
+		struct Job
+		{
+			std::string              path;
+			ModelData                data;
+			std::vector<std::string> inputs;     // the model file, its side files, then its images
+			size_t                   firstImage = 0u;
+			std::string              error;
+		};
+		std::vector<Job> jobs;
+		for (const auto& path : models)
+		{
+			const auto r = manifest.models.find(path);
+			if (r != manifest.models.end())
+			{
+				auto&      record = r->second;
+				const auto cache  = StampFile(ModelCache::GetCachePath(path));
+				const bool current = cache && cache->size == record.cacheSize && cache->time == record.cacheTime &&
+				                     std::ranges::all_of(record.inputs, [&manifest](const std::string& input)
+				                     {
+					                     return manifest.files.at(input).exists;
+				                     }) &&
+				                     HashInputs(settingsHash, record.inputs, manifest) == record.key;
+				const bool touched = std::ranges::any_of(record.inputs, [&manifest](const std::string& input)
+				{
+					return manifest.files.at(input).hashed;
+				});
+				if (current && !touched)
+				{
+					report.upToDate++;
+					continue;
+				}
+				// same content under new stamps: the cache stays, but it has to learn the stamps or loading it would not trust it
+				if (current && ModelCache::Restamp(path, settings.scale, importSettings))
+				{
+					const auto restamped = StampFile(ModelCache::GetCachePath(path));
+					record.cacheSize     = restamped ? restamped->size : 0u;
+					record.cacheTime     = restamped ? restamped->time : 0;
+					report.restamped++;
+					continue;
+				}
+			}
+			jobs.push_back({path});
+		}
+
+		// import every stale model, each on its own worker
+		ParallelFor(jobs.size(), settings.nWorkers, [&](size_t i)
+		{
+			auto& job = jobs[i];
+			try
+			{
+				job.data   = Model::Process(job.path, settings.scale);
+				job.inputs = {job.path};
+				for (auto& path : ModelCache::GetSideFiles(job.path))
+				{
+					job.inputs.push_back(std::move(path));
+				}
+				job.firstImage = job.inputs.size();
+				for (auto& path : ModelCache::GetAlphaImages(job.data))
+				{
+					job.inputs.push_back(std::move(path));
+				}
+			}
+			catch (const std::exception& e)
+			{
+				job.error = e.what();
+			}
+		});
+
+		// the inputs the imports turned up, and then the images among them whose alpha is not known for their current content
+		std::vector<std::string> found;
+		for (const auto& job : jobs)
+		{
+			found.insert(found.end(), job.inputs.begin(), job.inputs.end());
+		}
+		CheckFiles(manifest, found, settings.nWorkers, report);
+
+		std::vector<std::string> undecoded;
+		for (const auto& job : jobs)
+		{
+			for (size_t k = job.firstImage; k < job.inputs.size(); k++)
+			{
+				const auto& record = manifest.files.at(job.inputs[k]);
+				if (record.exists && record.alpha < 0 && std::ranges::find(undecoded, job.inputs[k]) == undecoded.end())
+				{
+					undecoded.push_back(job.inputs[k]);
+				}
+			}
+		}
+		std::vector<int> alphas(undecoded.size(), -1);
+		ParallelFor(undecoded.size(), settings.nWorkers, [&](size_t i)
+		{
+			try
+			{
+				alphas[i] = Surface::FromFile(undecoded[i]).AlphaLoaded() ? 1 : 0;
+			}
+			catch (const std::exception&)
+			{
+				// left at -1, which fails every model using the image below
+			}
+		});
+		for (size_t i = 0; i < undecoded.size(); i++)
+		{
+			manifest.files.at(undecoded[i]).alpha = alphas[i];
+		}
+		report.imagesDecoded = undecoded.size();
+
+		// set the alpha flags like making the meshes does, then write the caches
+		ParallelFor(jobs.size(), settings.nWorkers, [&](size_t i)
+		{
+			auto& job = jobs[i];
+			if (!job.error.empty())
+			{
+				return;
+			}
+			const auto alphaOf = [&](const std::string& path)
+			{
+				const auto& record = manifest.files.at(path);
+				if (!record.exists || record.alpha < 0)
+				{
+					throw std::runtime_error("cannot decode " + path);
+				}
+				return record.alpha == 1;
+			};
+			try
+			{
+				for (auto& mesh : job.data.meshes)
+				{
+					auto& material = mesh.material;
+					if (material.hasDiffuseMap)
+					{
+						material.hasAlphaDiffuse = alphaOf(material.diffusePath);
+					}
+					if (material.hasSpecularMap)
+					{
+						material.hasAlphaGloss = alphaOf(material.specularPath);
+					}
+				}
+				if (!ModelCache::Save(job.path, settings.scale, importSettings, job.data))
+				{
+					throw std::runtime_error("cannot write " + ModelCache::GetCachePath(job.path));
+				}
+			}
+			catch (const std::exception& e)
+			{
+				job.error = e.what();
+			}
+			job.data = {};
+		});
+
+		for (auto& job : jobs)
+		{
+			if (!job.error.empty())
+			{
+				// forgotten, so the next run tries again
+				manifest.models.erase(job.path);
+				report.failures.push_back(job.path + ": " + job.error);
+				continue;
+			}
+			const auto cache = StampFile(ModelCache::GetCachePath(job.path));
+			auto&      record = manifest.models[job.path];
+			record.key        = HashInputs(settingsHash, job.inputs, manifest);
+			record.cacheSize  = cache ? cache->size : 0u;
+			record.cacheTime  = cache ? cache->time : 0;
+			record.inputs     = std::move(job.inputs);
+			report.baked++;
+		}
+
+		if (!WriteManifest(manifestPath, manifest))
+		{
+			report.failures.push_back(manifestPath + ": cannot write the manifest");
+		}
+		report.seconds = timer.Peek();
+		return report;
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace D3DEngine
+{
+	/**
+	 * \brief Incremental, offline filling of the model cache: models are imported and stored where ModelCache::Load finds them,
+	 * but only if one of the files they are made from (the model, its material libraries or buffers, its images) or the bake
+	 * settings changed since the last run. Files are told apart by content hash; a file whose size and time did not change is
+	 * not even read. What a run learned goes into a manifest, so a run over unchanged files only has to look at file stamps.
+	 */
+	class AssetBaker
+	{
+		public:
+			// bump whenever the manifest layout or the meaning of its entries changes
+			static constexpr uint32_t version = 1u;
+
+			struct Settings
+			{
+				float  scale    = 1.0f; // handed to the import, so a change of scale rebakes everything
+				size_t nWorkers = 0u;   // threads for hashing, importing and decoding (0 = one per hardware thread)
+			};
+
+			struct Report
+			{
+				size_t                   models        = 0u;
+				size_t                   baked         = 0u; // imported again and written to the cache
+				size_t                   restamped     = 0u; // touched but unchanged, only the cache's file stamps were refreshed
+				size_t                   upToDate      = 0u;
+				size_t                   filesChecked  = 0u; // input files looked at
+				size_t                   filesHashed   = 0u; // of those, the ones that had to be read
+				uint64_t                 bytesHashed   = 0u;
+				size_t                   imagesDecoded = 0u; // images decoded to learn whether they have alpha
+				std::vector<std::string> failures;           // one line per model that could not be baked
+				float                    seconds       = 0.0f;
+			};
+
+			// judged by the extension alone (.obj, .gltf or .glb)
+			static bool CanBake(const std::string& path) noexcept;
+			// every model file below directory, in a stable order
+			static std::vector<std::string> FindModels(const std::string& directory);
+			/**
+			 * \brief Bring the model cache of every model up to date, in parallel, and write the manifest for the next run.
+			 * A model that fails to bake is reported and does not keep the others from baking.
+			 * \param manifestPath where the last run's manifest is read from and this run's written to (created if missing)
+			 */
+			static Report Bake(const std::vector<std::string>& models, const std::string& manifestPath, const Settings& settings);
+	};
+}
@@ -0,0 +1,35 @@
+#include "Benchmarks.h"
+
+namespace D3DEngine
+{
+	Benchmarks::Checker::Checker(std::ostream& out) noexcept
+		: out_(out)
+	{
+	}
+
+	void Benchmarks::Checker::operator()(bool passed, const std::string& what)
+	{
+		allPassed_ = allPassed_ && passed;
+		out_ << "  " << (passed ? "[ok]     " : "[FAILED] ") << what << "\n";
+	}
+
+	bool Benchmarks::Checker::AllPassed() const noexcept
+	{
+		return allPassed_;
+	}
+
+	Benchmarks::Result Benchmarks::Report(const std::string& title, const std::ostringstream& body)
+	{
+		auto report = "[Benchmark] " + title + "\n" + body.str();
+		OutputDebugStringA(report.c_str());
+		return {std::move(report), true};
+	}
+
+	Benchmarks::Result Benchmarks::Report(const std::string& title, std::ostringstream& body, const Checker& checks)
+	{
+		body << (checks.AllPassed() ? "all checks passed\n" : "SOME CHECKS FAILED\n");
+		auto result   = Report(title, body);
+		result.passed = checks.AllPassed();
+		return result;
+	}
+}
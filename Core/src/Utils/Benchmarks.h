@@ -0,0 +1,119 @@
+#pragma once
+#include <algorithm>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "DXTimer.h"
+
+namespace D3DEngine
+{
+	class Graphics;
+
+	/**
+	 * \brief Developer benchmarks reachable through the makeshift command line in App::App.
+	 * Each benchmark returns a human readable report (which also goes to the debugger output) and whether all of its checks passed.
+	 * They live in one file per subsystem: BenchmarksLoading, BenchmarksMeshes, BenchmarksVertices, BenchmarksBindables and BenchmarksGraphics.
+	 */
+	class Benchmarks
+	{
+		public:
+			struct ModelSpec
+			{
+				std::string path;
+				float       scale;
+			};
+
+			struct Result
+			{
+				std::string report;
+				bool        passed; // every check in the report passed (benchmarks without checks always pass)
+			};
+
+			// cold Assimp import vs. warm model cache load, without touching the device
+			static Result ModelCacheLoad(const std::vector<ModelSpec>& models, int repetitions = 3);
+			// Assimp import + texture decoding on a single worker vs. on every hardware thread, checking both give the same data
+			static Result ModelParallelLoad(const std::vector<ModelSpec>& models, int repetitions = 3);
+			// index width selection and 16-bit splitting on synthetic meshes around the 65536 vertex boundary
+			static Result IndexWidth();
+			// offline post-transform cache metrics (ACMR/ATVR) of every mesh in authoring order vs. after MeshOptimizer
+			static Result MeshOptimization(const std::vector<ModelSpec>& models);
+			// simplifier triangle counts and error bounds on synthetic meshes, LOD selection rules, and the LOD chains of real models
+			static Result MeshLods(const std::vector<ModelSpec>& models);
+			// meshlet partitioning invariants and cull conservativeness on a sphere, and how much of real models culls per view
+			static Result Meshlets(const std::vector<ModelSpec>& models);
+			// round-trip error of every compact vertex encoding, and how much smaller VertexPacking makes synthetic and real meshes
+			static Result VertexCompression(const std::vector<ModelSpec>& models);
+			// ObjImporter throughput (MB/s) on one worker and on every hardware thread vs. Assimp, checking both give the same meshes
+			static Result ObjImport(const std::vector<ModelSpec>& models, int repetitions = 3);
+			// GltfImporter load time on one worker and on every hardware thread vs. Assimp, on synthetic .glb/.gltf files and real ones
+			static Result GltfImport(const std::vector<ModelSpec>& models, int repetitions = 3);
+			// vertex/index buffer binds one frame of every mesh costs with a buffer pair per mesh vs. per-layout GeometryArenas
+			static Result GeometryArenas(const std::vector<ModelSpec>& models);
+			// material interning from parsed MTL files (identical materials share an ID, any differing parameter splits them), and how many
+			// unique materials and constant buffers real models come down to
+			static Result Materials(const std::vector<ModelSpec>& models);
+			// FileWatcher debouncing on synthetic and real file writes, and in-place Codex reloads with stand-in bindables (no device)
+			static Result HotReload();
+			// AssetBaker on a synthetic set of models (which edits rebake what), and a cold vs. an unchanged second bake of a real directory
+			static Result AssetBake(const std::string& directory, float scale);
+			// StaticVertexLayout against the DynamicVertexLayout with the same elements, and per-vertex transform throughput through each
+			static Result VertexLayouts(size_t vertexCount = 1u << 20, int repetitions = 5);
+			// position-only CPU passes (bounding box, transform) over interleaved vertices vs. VertexStreams, on synthetic and real models
+			static Result VertexStorage(const std::vector<ModelSpec>& models, size_t vertexCount = 1u << 20, int repetitions = 5);
+			// ConvertTo between every pair of element types against reference decodes, and its throughput against per-vertex rebuilds
+			static Result VertexConversions(size_t vertexCount = 1u << 20, int repetitions = 5);
+			// filling vertex buffers from per-attribute arrays (as Assimp gives them) with EmplaceBack per vertex vs. Append per mesh
+			static Result VertexIngestion(const std::vector<ModelSpec>& models, int repetitions = 5);
+			// Codex keys (equality, collisions) and the cost of a Resolve hit and miss with string UIDs vs. CodexKeys, on stand-in bindables
+			static Result CodexLookups(Graphics& gfx, size_t keyCount = 4096u, int repetitions = 5);
+			// many threads resolving overlapping keys at once (one construction per key, constructions of different keys overlapping, a throwing
+			// constructor reaching every waiter), and hit throughput across threads, on stand-in bindables with slow constructors
+			static Result CodexConcurrency(Graphics& gfx, size_t threadCount = 16u, size_t keyCount = 64u);
+			// Codex eviction on stand-in bindables of known cost: the budget kept under churn, bindables in use never evicted, second chances
+			// for re-resolved ones, and Collect
+			static Result CodexEviction(Graphics& gfx);
+			// the Codex statistics (per type counters, creation log, JSON) against a known sequence of resolves on stand-in bindables
+			static Result CodexStats(Graphics& gfx);
+			// a prewarm manifest recorded from one "run" and replayed before the next: Codex misses during the frames with and without it
+			static Result CodexPrewarm(Graphics& gfx, size_t keyCount = 48u);
+			// the state tracker against a recording stand-in context (no device): sorted scene draws with every call sent vs. redundant ones
+			// dropped, the context ending up in the same state either way, and the edges (unknown vs. nullptr, slots, invalidation)
+			static Result StateTracking();
+			// Drawable's bindable storage on stand-in bindables: QueryBindable by type ID against a dynamic_cast scan, and the bind loop
+			// over the sorted pointers against one over shared pointers, per drawable
+			static Result DrawableBindables(Graphics& gfx, size_t drawableCount = 1000u, int repetitions = 5);
+		private:
+			// best-of-n wall time of a callable in milliseconds
+			template <typename F>
+			static float TimeBestOf(int repetitions, F&& func)
+			{
+				float best = std::numeric_limits<float>::max();
+				for (int i = 0; i < repetitions; i++)
+				{
+					DXTimer timer;
+					func();
+					best = std::min(best, timer.Peek() * 1000.0f);
+				}
+				return best;
+			}
+
+			// writes an [ok] or [FAILED] line for each check into the report, and remembers whether any failed
+			class Checker
+			{
+				public:
+					explicit Checker(std::ostream& out) noexcept;
+					void operator()(bool passed, const std::string& what);
+					bool AllPassed() const noexcept;
+				private:
+					std::ostream& out_;
+					bool          allPassed_ = true;
+			};
+
+			// for benchmarks that only measure
+			static Result Report(const std::string& title, const std::ostringstream& body);
+			// closes the body with the verdict of the checks
+			static Result Report(const std::string& title, std::ostringstream& body, const Checker& checks);
+	};
+}
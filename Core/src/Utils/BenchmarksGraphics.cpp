@@ -0,0 +1,283 @@
+#include "Benchmarks.h"
+#include "Bindable/IndexBuffer.h"
+#include "StateTracker.h"
+#include <map>
+
+namespace D3DEngine
+{
+	namespace
+	{
+		// stands in for a device context: keeps what each call set, per kind of state and slot, and counts the calls that reach it
+		class RecordingContext
+		{
+			public:
+				using Value = std::vector<uintptr_t>;
+
+				std::map<std::pair<PipelineState, UINT>, Value> state;
+				size_t                                          calls = 0u;
+
+				void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+				{
+					Record(PipelineState::Topology, 0u, {uintptr_t(topology)});
+				}
+
+				void IASetInputLayout(ID3D11InputLayout* pLayout)
+				{
+					Record(PipelineState::InputLayout, 0u, {Bits(pLayout)});
+				}
+
+				// every slot keeps its buffer until it is set again, like the input assembler's
+				void IASetVertexBuffers(UINT start, UINT count, ID3D11Buffer* const* pBuffers, const UINT* pStrides, const UINT* pOffsets)
+				{
+					calls++;
+					for (UINT i = 0; i < count; i++)
+					{
+						state[{PipelineState::VertexBuffers, start + i}] = {Bits(pBuffers[i]), pStrides[i], pOffsets[i]};
+					}
+				}
+
+				void IASetIndexBuffer(ID3D11Buffer* pBuffer, DXGI_FORMAT format, UINT offset)
+				{
+					Record(PipelineState::IndexBuffer, 0u, {Bits(pBuffer), uintptr_t(format), offset});
+				}
+
+				void VSSetShader(ID3D11VertexShader* pShader, ID3D11ClassInstance* const*, UINT)
+				{
+					Record(PipelineState::VertexShader, 0u, {Bits(pShader)});
+				}
+
+				void PSSetShader(ID3D11PixelShader* pShader, ID3D11ClassInstance* const*, UINT)
+				{
+					Record(PipelineState::PixelShader, 0u, {Bits(pShader)});
+				}
+
+				void VSSetConstantBuffers(UINT slot, UINT, ID3D11Buffer* const* ppBuffer)
+				{
+					Record(PipelineState::VSConstantBuffers, slot, {Bits(*ppBuffer)});
+				}
+
+				void PSSetConstantBuffers(UINT slot, UINT, ID3D11Buffer* const* ppBuffer)
+				{
+					Record(PipelineState::PSConstantBuffers, slot, {Bits(*ppBuffer)});
+				}
+
+				void PSSetShaderResources(UINT slot, UINT, ID3D11ShaderResourceView* const* ppView)
+				{
+					Record(PipelineState::PSShaderResources, slot, {Bits(*ppView)});
+				}
+
+				void PSSetSamplers(UINT slot, UINT, ID3D11SamplerState* const* ppSampler)
+				{
+					Record(PipelineState::PSSamplers, slot, {Bits(*ppSampler)});
+				}
+
+				void RSSetState(ID3D11RasterizerState* pState)
+				{
+					Record(PipelineState::Rasterizer, 0u, {Bits(pState)});
+				}
+
+				// no factor means all ones
+				void OMSetBlendState(ID3D11BlendState* pState, const FLOAT* pFactor, UINT sampleMask)
+				{
+					Value value = {Bits(pState), sampleMask};
+					for (int i = 0; i < 4; i++)
+					{
+						value.push_back(std::bit_cast<uint32_t>(pFactor ? pFactor[i] : 1.0f));
+					}
+					Record(PipelineState::Blend, 0u, std::move(value));
+				}
+
+				void OMSetRenderTargets(UINT, ID3D11RenderTargetView* const* ppTarget, ID3D11DepthStencilView* pDepthStencil)
+				{
+					Record(PipelineState::RenderTargets, 0u, {Bits(*ppTarget), Bits(pDepthStencil)});
+				}
+
+			private:
+				static uintptr_t Bits(const void* p) noexcept
+				{
+					return reinterpret_cast<uintptr_t>(p);
+				}
+
+				void Record(PipelineState kind, UINT slot, Value value)
+				{
+					calls++;
+					state[{kind, slot}] = std::move(value);
+				}
+		};
+
+		// a distinct, never dereferenced address standing in for the id-th object of a kind
+		template <typename T>
+		T* FakeObject(size_t id) noexcept
+		{
+			return reinterpret_cast<T*>(uintptr_t(id + 1u) * 64u);
+		}
+	}
+
+	Benchmarks::Result Benchmarks::StateTracking()
+	{
+		std::ostringstream oss;
+		oss << std::fixed << std::setprecision(2);
+		Checker check{oss};
+
+		// a scene the way drawables bind it: pipelines (shaders, layout, topology) and materials (shader, constants, textures, states)
+		// shared by many meshes, drawn sorted by pipeline and material. Ids of different kinds of object may coincide, their addresses do not
+		// matter across kinds
+		struct Draw
+		{
+			size_t pipeline;
+			size_t material;
+			size_t mesh;
+		};
+		constexpr size_t  pipelineCount = 3u;
+		constexpr size_t  materialCount = 12u;
+		constexpr size_t  meshCount     = 400u;
+		constexpr UINT    frameCount    = 3u;
+		std::vector<Draw> draws;
+		std::mt19937      rng(24u);
+		// meshes come from models of four, sharing one material and the model's vertex and index buffers
+		for (size_t mesh = 0; mesh < meshCount; mesh += 4u)
+		{
+			const size_t material = rng() % materialCount;
+			for (size_t i = 0; i < 4u; i++)
+			{
+				draws.push_back({material % pipelineCount, material, mesh + i});
+			}
+		}
+		std::ranges::stable_sort(draws, {}, [](const Draw& d) { return std::pair(d.pipeline, d.material); });
+
+		// the calls of one draw, Graphics::DrawIndexed's render targets first; returns how many were made
+		const auto bind = [](StateTracker<RecordingContext>& t, const Draw& d)
+		{
+			const float factor[] = {0.5f, 0.5f, 0.5f, 1.0f};
+			// pipeline 2 draws lines, with a second vertex stream of colors
+			const bool  lines     = d.pipeline == 2u;
+			const bool  normalMap = d.material % 2u == 0u;
+			t.SetRenderTargets(FakeObject<ID3D11RenderTargetView>(0u), FakeObject<ID3D11DepthStencilView>(0u));
+			t.SetPrimitiveTopology(lines ? D3D11_PRIMITIVE_TOPOLOGY_LINELIST : D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+			t.SetInputLayout(FakeObject<ID3D11InputLayout>(d.pipeline));
+			t.SetVertexShader(FakeObject<ID3D11VertexShader>(d.pipeline));
+			// one transform buffer, updated (mapped) per draw but always the same object
+			t.SetVSConstantBuffer(0u, FakeObject<ID3D11Buffer>(0u));
+			t.SetPixelShader(FakeObject<ID3D11PixelShader>(d.pipeline * 2u + normalMap));
+			t.SetPSConstantBuffer(0u, FakeObject<ID3D11Buffer>(1u + d.material));
+			t.SetPSShaderResource(0u, FakeObject<ID3D11ShaderResourceView>(d.material));
+			if (normalMap)
+			{
+				t.SetPSShaderResource(2u, FakeObject<ID3D11ShaderResourceView>(100u + d.material));
+			}
+			t.SetPSSampler(0u, FakeObject<ID3D11SamplerState>(0u));
+			t.SetRasterizerState(FakeObject<ID3D11RasterizerState>(d.material % 3u == 0u));
+			t.SetBlendState(FakeObject<ID3D11BlendState>(d.material % 4u == 0u), d.material % 4u == 0u ? factor : nullptr, 0xFFFFFFFFu);
+			ID3D11Buffer* const pBuffers[] = {FakeObject<ID3D11Buffer>(100u + d.mesh / 4u), FakeObject<ID3D11Buffer>(1000u + d.mesh / 4u)};
+			const UINT          strides[]  = {32u, 4u};
+			t.SetVertexBuffers(lines ? 2u : 1u, pBuffers, strides);
+			t.SetIndexBuffer(FakeObject<ID3D11Buffer>(2000u + d.mesh / 4u), d.mesh / 4u % 2u ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT);
+			return size_t(13u + normalMap);
+		};
+
+		// the same frames with the tracker, and with it forgetting everything before each draw (which sends every call: the naive replay)
+		RecordingContext               tracked;
+		RecordingContext               naive;
+		StateTracker<RecordingContext> tracker(&tracked);
+		StateTracker<RecordingContext> replay(&naive);
+		size_t                         made     = 0u;
+		bool                           sameState = true;
+		for (UINT frame = 0; frame < frameCount; frame++)
+		{
+			for (const auto& d : draws)
+			{
+				made += bind(tracker, d);
+				replay.Invalidate();
+				bind(replay, d);
+				sameState = sameState && tracked.state == naive.state;
+			}
+			// what EndFrame does once imgui has drawn and Present has unbound the targets
+			tracker.Invalidate();
+		}
+
+		StateCounter total;
+		oss << "scene (" << draws.size() << " draws of " << materialCount << " materials over " << pipelineCount << " pipelines, " << frameCount
+				<< " frames)\n";
+		for (size_t i = 0; i < size_t(PipelineState::Count); i++)
+		{
+			const auto& c = tracker.GetCounters()[i];
+			total.issued += c.issued;
+			total.skipped += c.skipped;
+			oss << "  " << std::left << std::setw(22) << ToString(PipelineState(i)) << std::right << std::setw(6) << c.issued << " issued"
+					<< std::setw(7) << c.skipped << " skipped\n";
+		}
+		oss << "  context calls: " << naive.calls << " naive, " << tracked.calls << " tracked ("
+				<< 100.0 * (1.0 - double(tracked.calls) / double(naive.calls)) << "% fewer)\n";
+		check(sameState, "after every draw, the context holds the same state as with every call sent");
+		check(total.issued + total.skipped == made && total.issued == tracked.calls, "every call counted once, as issued or skipped");
+		check(tracked.calls * 2u < naive.calls, "over half of the calls dropped");
+		check(tracker.GetCounters()[size_t(PipelineState::RenderTargets)].issued == frameCount, "render targets set once per frame");
+		check(tracker.GetCounters()[size_t(PipelineState::VSConstantBuffers)].issued == frameCount,
+		      "the transform buffer, updated but never rebound, set once per frame");
+
+		// the edges
+		oss << "edges\n";
+		RecordingContext               context;
+		StateTracker<RecordingContext> t(&context);
+		t.SetPixelShader(nullptr);
+		t.SetPixelShader(nullptr);
+		check(context.calls == 1u, "unbinding is sent when nothing is known, and dropped after");
+		t.Invalidate();
+		t.SetPixelShader(nullptr);
+		t.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		t.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		check(context.calls == 3u, "after Invalidate, the same state is sent again");
+		const auto pA = FakeObject<ID3D11Buffer>(0u);
+		const auto pB = FakeObject<ID3D11Buffer>(1u);
+		const auto before = context.calls;
+		t.SetPSConstantBuffer(0u, pA);
+		t.SetPSConstantBuffer(1u, pA);
+		t.SetVSConstantBuffer(0u, pA);
+		t.SetPSConstantBuffer(0u, pB);
+		t.SetPSConstantBuffer(1u, pA);
+		check(context.calls - before == 4u, "slots and stages are tracked apart");
+		const auto pView = FakeObject<ID3D11ShaderResourceView>(0u);
+		t.SetPSShaderResource(20u, pView);
+		t.SetPSShaderResource(20u, pView);
+		check(context.calls - before == 6u, "untracked high resource slots are always sent");
+		ID3D11Buffer* const two[]   = {pA, pB};
+		ID3D11Buffer* const other[] = {pA, pA};
+		const UINT          strides[] = {16u, 16u};
+		t.SetVertexBuffers(2u, two, strides);
+		t.SetVertexBuffers(2u, other, strides);
+		t.SetVertexBuffers(1u, other, strides);
+		t.SetVertexBuffers(1u, two, strides);
+		check(context.calls - before == 9u, "vertex buffers compare on every stream and the stream count");
+		const float half[] = {0.5f, 0.5f, 0.5f, 0.5f};
+		t.SetBlendState(nullptr, half, 0xFFFFFFFFu);
+		t.SetBlendState(nullptr, nullptr, 0xFFFFFFFFu);
+		t.SetBlendState(nullptr, nullptr, 0xFFFFFFFFu);
+		check(context.calls - before == 11u, "blend factors are part of the blend state");
+
+		// what a call costs through the tracker, when dropped and when sent to an empty stand-in
+		struct NullContext
+		{
+			void PSSetShaderResources(UINT, UINT, ID3D11ShaderResourceView* const*) {}
+		};
+		NullContext                 null;
+		StateTracker<NullContext>   cheap(&null);
+		constexpr int               callCount = 1 << 20;
+		const auto tSkip = TimeBestOf(5, [&]
+		{
+			for (int i = 0; i < callCount; i++)
+			{
+				cheap.SetPSShaderResource(0u, pView);
+			}
+		});
+		const auto tSend = TimeBestOf(5, [&]
+		{
+			for (int i = 0; i < callCount; i++)
+			{
+				cheap.SetPSShaderResource(UINT(i & 1), FakeObject<ID3D11ShaderResourceView>(i & 2));
+			}
+		});
+		oss << "tracker overhead: " << tSkip * 1e6f / callCount << " ns per dropped call, " << tSend * 1e6f / callCount << " ns per sent call\n";
+
+		return Report("State Tracking", oss, check);
+	}
+}
@@ -0,0 +1,653 @@
+#include "Benchmarks.h"
+#include "Drawable/Complex/Mesh.h"
+#include "Drawable/Complex/ModelCache.h"
+#include "AssetBaker.h"
+#include "Surface.h"
+#include <filesystem>
+#include <fstream>
+
+namespace D3DEngine
+{
+	namespace
+	{
+		bool SameNodes(const NodeData& a, const NodeData& b)
+		{
+			if (a.name != b.name || a.meshIndices != b.meshIndices || a.children.size() != b.children.size() ||
+			    memcmp(&a.transform, &b.transform, sizeof(a.transform)) != 0)
+			{
+				return false;
+			}
+			for (size_t i = 0; i < a.children.size(); i++)
+			{
+				if (!SameNodes(a.children[i], b.children[i]))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		bool SameMaterials(const MaterialDesc& a, const MaterialDesc& b)
+		{
+			return a.hasDiffuseMap == b.hasDiffuseMap && a.hasSpecularMap == b.hasSpecularMap && a.hasNormalMap == b.hasNormalMap &&
+			       a.hasAlphaDiffuse == b.hasAlphaDiffuse && a.hasAlphaGloss == b.hasAlphaGloss && a.shininess == b.shininess &&
+			       memcmp(&a.specularColor, &b.specularColor, sizeof(a.specularColor)) == 0 &&
+			       memcmp(&a.diffuseColor, &b.diffuseColor, sizeof(a.diffuseColor)) == 0 &&
+			       a.diffusePath == b.diffusePath && a.specularPath == b.specularPath && a.normalPath == b.normalPath;
+		}
+
+		// the parallel loader and the model cache have to produce exactly what a serial import does, down to the byte
+		bool SameModelData(const ModelData& a, const ModelData& b)
+		{
+			if (a.meshes.size() != b.meshes.size() || !SameNodes(a.root, b.root))
+			{
+				return false;
+			}
+			for (size_t i = 0; i < a.meshes.size(); i++)
+			{
+				const auto& ma = a.meshes[i];
+				const auto& mb = b.meshes[i];
+				if (ma.tag != mb.tag || ma.indices != mb.indices || !SameMaterials(ma.material, mb.material) ||
+				    ma.vertices.GetLayout().GetCode() != mb.vertices.GetLayout().GetCode() ||
+				    ma.vertices.SizeBytes() != mb.vertices.SizeBytes() ||
+				    memcmp(ma.vertices.GetData(), mb.vertices.GetData(), ma.vertices.SizeBytes()) != 0 ||
+				    ma.lods.size() != mb.lods.size() || ma.meshlets.size() != mb.meshlets.size() ||
+				    (!ma.meshlets.empty() && memcmp(ma.meshlets.data(), mb.meshlets.data(), ma.meshlets.size() * sizeof(Meshlet)) != 0))
+				{
+					return false;
+				}
+				for (size_t l = 0; l < ma.lods.size(); l++)
+				{
+					if (ma.lods[l].indices != mb.lods[l].indices || ma.lods[l].error != mb.lods[l].error)
+					{
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		// how far a parse of a file is from Assimp's: structure has to match exactly, vertex attributes up to float noise
+		struct ParseDifference
+		{
+			std::string mismatch;        // first structural difference, empty if there is none
+			float       position = 0.0f; // largest distance, relative to the largest coordinate of the model
+			float       texcoord = 0.0f;
+			float       normal   = 0.0f; // largest angles, radians
+			float       tangent  = 0.0f;
+		};
+
+		// node transforms have to match bit for bit unless a tolerance is given (for formats whose transforms we compose ourselves)
+		ParseDifference CompareParses(const ModelData& ours, const ModelData& assimp, float transformTolerance = 0.0f)
+		{
+			using Type   = DynamicVertexLayout::ElementType;
+			namespace dx = DirectX;
+
+			ParseDifference difference;
+			const auto      angle = [](const dx::XMFLOAT3& a, const dx::XMFLOAT3& b)
+			{
+				const auto va = dx::XMLoadFloat3(&a);
+				const auto vb = dx::XMLoadFloat3(&b);
+				const bool za = dx::XMVectorGetX(dx::XMVector3LengthSq(va)) == 0.0f;
+				const bool zb = dx::XMVectorGetX(dx::XMVector3LengthSq(vb)) == 0.0f;
+				if (za || zb)
+				{
+					return za == zb ? 0.0f : dx::XM_PI;
+				}
+				return std::atan2(dx::XMVectorGetX(dx::XMVector3Length(dx::XMVector3Cross(va, vb))), dx::XMVectorGetX(dx::XMVector3Dot(va, vb)));
+			};
+
+			const auto compareNodes = [&](auto& self, const NodeData& a, const NodeData& b, const std::string& where) -> void
+			{
+				if (!difference.mismatch.empty())
+				{
+					return;
+				}
+				bool sameTransform = memcmp(&a.transform, &b.transform, sizeof(a.transform)) == 0;
+				if (!sameTransform && transformTolerance > 0.0f)
+				{
+					sameTransform = true;
+					for (size_t i = 0; i < 16u; i++)
+					{
+						sameTransform = sameTransform && std::abs((&a.transform._11)[i] - (&b.transform._11)[i]) <= transformTolerance;
+					}
+				}
+				if (a.name != b.name || a.meshIndices != b.meshIndices || a.children.size() != b.children.size() || !sameTransform)
+				{
+					difference.mismatch = "node " + where + "/" + b.name + " differs";
+					return;
+				}
+				for (size_t i = 0; i < a.children.size(); i++)
+				{
+					self(self, a.children[i], b.children[i], where + "/" + b.name);
+				}
+			};
+			compareNodes(compareNodes, ours.root, assimp.root, "");
+			if (!difference.mismatch.empty())
+			{
+				return difference;
+			}
+			if (ours.meshes.size() != assimp.meshes.size())
+			{
+				difference.mismatch = std::to_string(ours.meshes.size()) + " meshes vs. " + std::to_string(assimp.meshes.size());
+				return difference;
+			}
+
+			float extent = 0.0f;
+			for (const auto& mesh : assimp.meshes)
+			{
+				for (size_t i = 0; i < mesh.vertices.Size(); i++)
+				{
+					const auto p = mesh.vertices[i].Position();
+					extent       = std::max({extent, std::abs(p.x), std::abs(p.y), std::abs(p.z)});
+				}
+			}
+			for (size_t m = 0; m < ours.meshes.size(); m++)
+			{
+				const auto& a  = ours.meshes[m];
+				const auto& b  = assimp.meshes[m];
+				const auto& ma = a.material;
+				const auto& mb = b.material;
+				if (a.tag != b.tag || a.vertices.GetLayout().GetCode() != b.vertices.GetLayout().GetCode() ||
+				    ma.hasDiffuseMap != mb.hasDiffuseMap || ma.hasSpecularMap != mb.hasSpecularMap || ma.hasNormalMap != mb.hasNormalMap ||
+				    ma.diffusePath != mb.diffusePath || ma.specularPath != mb.specularPath || ma.normalPath != mb.normalPath ||
+				    ma.shininess != mb.shininess || memcmp(&ma.diffuseColor, &mb.diffuseColor, sizeof(ma.diffuseColor)) != 0 ||
+				    memcmp(&ma.specularColor, &mb.specularColor, sizeof(ma.specularColor)) != 0)
+				{
+					difference.mismatch = "mesh " + b.tag + ": tag, layout or material differs";
+					return difference;
+				}
+				if (a.vertices.Size() != b.vertices.Size() || a.indices != b.indices)
+				{
+					difference.mismatch = "mesh " + b.tag + ": " + std::to_string(a.vertices.Size()) + " vertices vs. " +
+					                      std::to_string(b.vertices.Size()) + ", or different indices";
+					return difference;
+				}
+
+				const auto& layout = b.vertices.GetLayout();
+				for (size_t i = 0; i < b.vertices.Size(); i++)
+				{
+					const auto va = a.vertices[i];
+					const auto vb = b.vertices[i];
+					const auto pa = va.Position();
+					const auto pb = vb.Position();
+					difference.position = std::max(difference.position,
+					                                dx::XMVectorGetX(dx::XMVector3Length(dx::XMLoadFloat3(&pa) - dx::XMLoadFloat3(&pb))) /
+					                                std::max(extent, 1.0e-6f));
+					if (layout.Has(Type::Normal))
+					{
+						difference.normal = std::max(difference.normal, angle(va.Attr<Type::Normal>(), vb.Attr<Type::Normal>()));
+					}
+					if (layout.Has(Type::Tangent))
+					{
+						difference.tangent = std::max({
+							difference.tangent, angle(va.Attr<Type::Tangent>(), vb.Attr<Type::Tangent>()),
+							angle(va.Attr<Type::Bitangent>(), vb.Attr<Type::Bitangent>())
+						});
+					}
+					if (layout.Has(Type::Texture2D))
+					{
+						const auto& ta      = va.Attr<Type::Texture2D>();
+						const auto& tb      = vb.Attr<Type::Texture2D>();
+						difference.texcoord = std::max({difference.texcoord, std::abs(ta.x - tb.x), std::abs(ta.y - tb.y)});
+					}
+				}
+			}
+			return difference;
+		}
+
+		std::string EncodeBase64(const std::string& bytes)
+		{
+			static constexpr char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+			std::string           text;
+			for (size_t i = 0; i < bytes.size(); i += 3u)
+			{
+				uint32_t bits = uint32_t((unsigned char)bytes[i]) << 16;
+				bits |= i + 1u < bytes.size() ? uint32_t((unsigned char)bytes[i + 1u]) << 8 : 0u;
+				bits |= i + 2u < bytes.size() ? uint32_t((unsigned char)bytes[i + 2u]) : 0u;
+				text += alphabet[(bits >> 18) & 63u];
+				text += alphabet[(bits >> 12) & 63u];
+				text += i + 1u < bytes.size() ? alphabet[(bits >> 6) & 63u] : '=';
+				text += i + 2u < bytes.size() ? alphabet[bits & 63u] : '=';
+			}
+			return text;
+		}
+	}
+
+	Benchmarks::Result Benchmarks::ModelCacheLoad(const std::vector<ModelSpec>& models, int repetitions)
+	{
+		std::ostringstream oss;
+		oss << std::fixed << std::setprecision(2);
+		Checker check{oss};
+		for (const auto& model : models)
+		{
+			ModelCache::Invalidate(model.path);
+
+			ModelData  data;
+			const auto coldMs = TimeBestOf(repetitions, [&] { data = Model::Import(model.path, model.scale); });
+			const auto bakeMs = TimeBestOf(1, [&] { ModelCache::Save(model.path, model.scale, Model::GetImportSettingsHash(), data); });
+
+			std::optional<ModelData> cached;
+			const auto               warmMs = TimeBestOf(repetitions, [&] { cached = ModelCache::Load(model.path, model.scale, Model::GetImportSettingsHash()); });
+
+			oss << model.path << " (" << data.meshes.size() << " meshes)\n"
+					<< "  cold (import):      " << coldMs << " ms\n"
+					<< "  bake:               " << bakeMs << " ms\n"
+					<< "  warm (model cache): " << warmMs << " ms"
+					<< "  [" << coldMs / std::max(warmMs, 0.001f) << "x]\n";
+			check(cached && SameModelData(data, *cached), "cache round trip matches the import");
+		}
+		return Report("Model cache", oss, check);
+	}
+
+	Benchmarks::Result Benchmarks::ModelParallelLoad(const std::vector<ModelSpec>& models, int repetitions)
+	{
+		const auto previousWorkers = Model::GetWorkerCount();
+		Model::SetWorkerCount(0u);
+		const auto parallelWorkers = Model::GetWorkerCount();
+
+		std::ostringstream oss;
+		oss << std::fixed << std::setprecision(2);
+		Checker check{oss};
+		for (const auto& model : models)
+		{
+			ModelData serial;
+			ModelData parallel;
+			size_t    imageCount = 0u;
+
+			Model::SetWorkerCount(1u);
+			const auto serialImportMs = TimeBestOf(repetitions, [&] { serial = Model::Import(model.path, model.scale); });
+			const auto serialDecodeMs = TimeBestOf(repetitions, [&] { imageCount = Model::DecodeTextures(serial, false).size(); });
+
+			Model::SetWorkerCount(parallelWorkers);
+			const auto parallelImportMs = TimeBestOf(repetitions, [&] { parallel = Model::Import(model.path, model.scale); });
+			const auto parallelDecodeMs = TimeBestOf(repetitions, [&] { Model::DecodeTextures(parallel, false); });
+
+			const auto serialMs   = serialImportMs + serialDecodeMs;
+			const auto parallelMs = parallelImportMs + parallelDecodeMs;
+			oss << model.path << " (" << serial.meshes.size() << " meshes, " << imageCount << " images)\n"
+					<< "  1 worker:   import " << serialImportMs << " ms, decode " << serialDecodeMs << " ms\n"
+					<< "  " << parallelWorkers << " workers:  import " << parallelImportMs << " ms, decode " << parallelDecodeMs << " ms"
+					<< "  [" << serialMs / std::max(parallelMs, 0.001f) << "x]\n";
+			check(SameModelData(serial, parallel), "identical output");
+		}
+
+		Model::SetWorkerCount(previousWorkers);
+		return Report("Parallel model load", oss, check);
+	}
+
+	Benchmarks::Result Benchmarks::ObjImport(const std::vector<ModelSpec>& models, int repetitions)
+	{
+		const auto previousWorkers = Model::GetWorkerCount();
+		Model::SetWorkerCount(0u);
+		const auto parallelWorkers = Model::GetWorkerCount();
+
+		std::ostringstream oss;
+		oss << std::fixed << std::setprecision(1);
+		Checker check{oss};
+		const auto compare = [&](const ModelData& ours, const ModelData& assimp)
+		{
+			const auto         difference = CompareParses(ours, assimp);
+			std::ostringstream what;
+			what << std::scientific << std::setprecision(2);
+			if (!difference.mismatch.empty())
+			{
+				check(false, "same meshes as Assimp: " + difference.mismatch);
+				return;
+			}
+			what << "same nodes, meshes, materials and indices as Assimp; vertices within " << difference.position << " (relative) / "
+					<< difference.texcoord << " (texcoords) / " << difference.normal << " rad (normals) / " << difference.tangent
+					<< " rad (tangent frames)";
+			check(difference.position <= 1.0e-6f && difference.texcoord <= 1.0e-6f && difference.normal <= 1.0e-4f &&
+			      difference.tangent <= 1.0e-2f, what.str());
+		};
+
+		// a small file going through the less common paths: statements before the first object, relative indices, a concave
+		// quad, groups, material changes inside a group, a material the library does not define, a mesh without normals
+		oss << "synthetic file\n";
+		{
+			const auto directory = std::filesystem::temp_directory_path() / "D3DEngineObjImport";
+			std::filesystem::create_directories(directory);
+			std::ofstream(directory / "synthetic.mtl") << "newmtl red\nKd 1 0 0\nKs 0.5 0.5 0.5\nNs 20\n"
+					"newmtl blue\n\tKd 0 0 1\n\tNs 4.0e1\n";
+			std::ofstream(directory / "synthetic.obj") << "# D3DEngine ObjImport benchmark\nmtllib synthetic.mtl\nusemtl red\n"
+					"v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nv 0.5 0.5 -1.0e-1\nv +0.4 0.4 0\n"
+					"vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\nvn 0 0 1\n"
+					"o quads\nf 1/1/1 2/2/1 3/3/1 4/4/1\nf -6/-4/-1 -5/-3/-1 -1/-2/-1 -3/-1/-1\n"
+					"g plain\nusemtl blue\nf 1//1 3//1 5//1\nusemtl red\nf 2//1 3//1 5//1\n"
+					"o flat\r\nusemtl missing\r\nf 1/1 2/2 4/4\r\nf 2/2 3/3 4/4";
+			const auto path = (directory / "synthetic.obj").string();
+			compare(Model::Parse(path), Model::Parse(path, 1.0f, true));
+		}
+
+		for (const auto& model : models)
+		{
+			const auto megabytes = (float)std::filesystem::file_size(model.path) / (1024.0f * 1024.0f);
+			ModelData  serial, parallel, assimp;
+
+			Model::SetWorkerCount(1u);
+			const auto serialMs = TimeBestOf(repetitions, [&] { serial = Model::Parse(model.path, model.scale); });
+			Model::SetWorkerCount(parallelWorkers);
+			const auto parallelMs = TimeBestOf(repetitions, [&] { parallel = Model::Parse(model.path, model.scale); });
+			const auto assimpMs   = TimeBestOf(repetitions, [&] { assimp = Model::Parse(model.path, model.scale, true); });
+
+			const auto throughput = [megabytes](float ms)
+			{
+				return megabytes / std::max(ms, 0.001f) * 1000.0f;
+			};
+			oss << model.path << " (" << megabytes << " MB, " << assimp.meshes.size() << " meshes)\n"
+					<< "  ObjImporter, 1 worker:    " << serialMs << " ms, " << throughput(serialMs) << " MB/s\n"
+					<< "  ObjImporter, " << parallelWorkers << " workers:   " << parallelMs << " ms, " << throughput(parallelMs) << " MB/s  ["
+					<< assimpMs / std::max(parallelMs, 0.001f) << "x Assimp]\n"
+					<< "  Assimp:                   " << assimpMs << " ms, " << throughput(assimpMs) << " MB/s\n";
+			check(SameModelData(serial, parallel), "1 worker and " + std::to_string(parallelWorkers) + " workers give identical data");
+			compare(parallel, assimp);
+		}
+
+		Model::SetWorkerCount(previousWorkers);
+		return Report("OBJ import", oss, check);
+	}
+
+	Benchmarks::Result Benchmarks::GltfImport(const std::vector<ModelSpec>& models, int repetitions)
+	{
+		namespace dx               = DirectX;
+		const auto previousWorkers = Model::GetWorkerCount();
+		Model::SetWorkerCount(0u);
+		const auto parallelWorkers = Model::GetWorkerCount();
+
+		std::ostringstream oss;
+		oss << std::fixed << std::setprecision(2);
+		Checker check{oss};
+		const auto compare = [&](const ModelData& ours, const ModelData& assimp)
+		{
+			const auto         difference = CompareParses(ours, assimp, 1.0e-5f);
+			std::ostringstream what;
+			what << std::scientific << std::setprecision(2);
+			if (!difference.mismatch.empty())
+			{
+				check(false, "same meshes as Assimp: " + difference.mismatch);
+				return;
+			}
+			what << "same nodes, meshes, materials and indices as Assimp; vertices within " << difference.position << " (relative) / "
+					<< difference.texcoord << " (texcoords) / " << difference.normal << " rad (normals) / " << difference.tangent
+					<< " rad (tangent frames)";
+			check(difference.position <= 1.0e-6f && difference.texcoord <= 1.0e-6f && difference.normal <= 1.0e-4f &&
+			      difference.tangent <= 1.0e-2f, what.str());
+		};
+		// the same geometry, whichever way the buffer was stored
+		const auto sameGeometry = [](const ModelData& a, const ModelData& b)
+		{
+			bool same = a.meshes.size() == b.meshes.size();
+			for (size_t i = 0; same && i < a.meshes.size(); i++)
+			{
+				same = a.meshes[i].indices == b.meshes[i].indices && a.meshes[i].vertices.SizeBytes() == b.meshes[i].vertices.SizeBytes() &&
+				       memcmp(a.meshes[i].vertices.GetData(), b.meshes[i].vertices.GetData(), a.meshes[i].vertices.SizeBytes()) == 0;
+			}
+			return same;
+		};
+
+		// a quad whose positions and normals are interleaved like the vertex layout (so its block is taken over as is), a
+		// triangle strip without normals or indices, TRS and matrix nodes; stored as .glb, as .gltf + .bin and with a data URI
+		oss << "synthetic files\n";
+		{
+			std::string bin;
+			const auto  put = [&bin](const auto& value)
+			{
+				bin.append(reinterpret_cast<const char*>(&value), sizeof(value));
+			};
+			const float    quad[4][6]     = {{0, 0, 0.5f, 0, 0, 1}, {1, 0, 0.5f, 0, 0, 1}, {1, 1, 0.5f, 0, 0, 1}, {0, 1, 0.5f, 0, 0, 1}};
+			const uint16_t quadIndices[6] = {0, 1, 2, 0, 2, 3};
+			const float    strip[4][3]    = {{0, 0, 1}, {1, 0, 1}, {0, 1, 2}, {1, 1, 2}};
+			put(quad);
+			put(quadIndices);
+			put(strip);
+			const std::string json = R"({"asset":{"version":"2.0"},"scene":0,"scenes":[{"nodes":[0]}],)"
+					R"("nodes":[{"name":"root","children":[1,2],"scale":[2,2,2]},{"name":"quad","mesh":0,"translation":[1,2,3]},)"
+					R"({"name":"strip","mesh":1,"matrix":[1,0,0,0,0,1,0,0,0,0,1,0,4,5,6,1]}],)"
+					R"("materials":[{"name":"red","pbrMetallicRoughness":{"baseColorFactor":[1,0,0,1],"roughnessFactor":0.5}}],)"
+					R"("meshes":[{"name":"quad","primitives":[{"attributes":{"POSITION":0,"NORMAL":1},"indices":2,"material":0}]},)"
+					R"({"name":"strip","primitives":[{"attributes":{"POSITION":3},"mode":5}]}],)"
+					R"("accessors":[{"bufferView":0,"componentType":5126,"count":4,"type":"VEC3"},)"
+					R"({"bufferView":0,"byteOffset":12,"componentType":5126,"count":4,"type":"VEC3"},)"
+					R"({"bufferView":1,"componentType":5123,"count":6,"type":"SCALAR"},{"bufferView":2,"componentType":5126,"count":4,"type":"VEC3"}],)"
+					R"("bufferViews":[{"buffer":0,"byteLength":96,"byteStride":24},{"buffer":0,"byteOffset":96,"byteLength":12},)"
+					R"({"buffer":0,"byteOffset":108,"byteLength":48}],"buffers":[{"byteLength":156)";
+
+			const auto directory = std::filesystem::temp_directory_path() / "D3DEngineGltfImport";
+			std::filesystem::create_directories(directory);
+			{
+				// header, then the JSON chunk (padded with spaces) and the BIN chunk (already a multiple of 4 bytes)
+				auto glbJson = json + "}]}";
+				glbJson.resize((glbJson.size() + 3u) / 4u * 4u, ' ');
+				std::ofstream glb(directory / "synthetic.glb", std::ios::binary);
+				const auto    word = [&glb](uint32_t value)
+				{
+					glb.write(reinterpret_cast<const char*>(&value), sizeof(value));
+				};
+				glb.write("glTF", 4);
+				word(2u);
+				word(uint32_t(12u + 8u + glbJson.size() + 8u + bin.size()));
+				word(uint32_t(glbJson.size()));
+				word(0x4E4F534Au);
+				glb.write(glbJson.data(), (std::streamsize)glbJson.size());
+				word(uint32_t(bin.size()));
+				word(0x004E4942u);
+				glb.write(bin.data(), (std::streamsize)bin.size());
+			}
+			std::ofstream(directory / "synthetic.bin", std::ios::binary).write(bin.data(), (std::streamsize)bin.size());
+			std::ofstream(directory / "external.gltf") << json << R"(,"uri":"synthetic.bin"}]})";
+			std::ofstream(directory / "embedded.gltf") << json << R"(,"uri":"data:application/octet-stream;base64,)" << EncodeBase64(bin) << R"("}]})";
+
+			const auto path = (directory / "synthetic.glb").string();
+			const auto glb  = Model::Parse(path, 2.0f);
+			if (glb.meshes.size() != 2u || glb.root.children.size() != 2u)
+			{
+				check(false, std::to_string(glb.meshes.size()) + " meshes and " + std::to_string(glb.root.children.size()) +
+				             " child nodes parsed, 2 and 2 expected");
+			}
+			else
+			{
+				const auto& quadMesh = glb.meshes[0];
+				bool        mirrored = quadMesh.indices == std::vector<unsigned int>{2, 1, 0, 3, 2, 0} && quadMesh.vertices.Size() == 4u;
+				for (size_t i = 0; mirrored && i < 4u; i++)
+				{
+					const auto p = quadMesh.vertices[i].Position();
+					const auto n = quadMesh.vertices[i].Attr<DynamicVertexLayout::Normal>();
+					mirrored     = p.x == quad[i][0] * 2.0f && p.y == quad[i][1] * 2.0f && p.z == -1.0f && n.z == -1.0f;
+				}
+				check(mirrored, "interleaved quad scaled, mirrored into the left-handed convention and its winding flipped");
+
+				const auto& stripMesh = glb.meshes[1];
+				bool        flat      = stripMesh.indices.size() == 6u && stripMesh.vertices.Size() == 4u;
+				for (size_t i = 0; flat && i < 4u; i++)
+				{
+					const auto n = stripMesh.vertices[i].Attr<DynamicVertexLayout::Normal>();
+					flat         = std::abs(n.x * n.x + n.y * n.y + n.z * n.z - 1.0f) < 1.0e-5f;
+				}
+				check(flat, "triangle strip without indices cut into 2 triangles, with generated unit normals");
+
+				const auto& q = glb.root.children[0].transform;
+				const auto& m = glb.root.children[1].transform;
+				check(glb.root.name == "root" && glb.root.transform._11 == 2.0f && glb.root.transform._33 == 2.0f &&
+				      q._41 == 1.0f && q._42 == 2.0f && q._43 == -3.0f && m._41 == 4.0f && m._42 == 5.0f && m._43 == -6.0f,
+				      "node hierarchy with TRS and matrix transforms, translations mirrored");
+
+				const auto& material = quadMesh.material;
+				check(material.diffuseColor.x == 1.0f && material.diffuseColor.y == 0.0f && material.shininess == 250.0f,
+				      "base color as diffuse color, roughness as Phong exponent");
+			}
+			check(sameGeometry(glb, Model::Parse((directory / "external.gltf").string(), 2.0f)) &&
+			      sameGeometry(glb, Model::Parse((directory / "embedded.gltf").string(), 2.0f)),
+			      "same meshes from the .glb chunk, a mapped .bin and a base64 data URI");
+			compare(glb, Model::Parse(path, 2.0f, true));
+		}
+
+		for (const auto& model : models)
+		{
+			const auto megabytes = (float)std::filesystem::file_size(model.path) / (1024.0f * 1024.0f);
+			ModelData  serial, parallel, assimp;
+
+			Model::SetWorkerCount(1u);
+			const auto serialMs = TimeBestOf(repetitions, [&] { serial = Model::Parse(model.path, model.scale); });
+			Model::SetWorkerCount(parallelWorkers);
+			const auto parallelMs = TimeBestOf(repetitions, [&] { parallel = Model::Parse(model.path, model.scale); });
+			const auto assimpMs   = TimeBestOf(repetitions, [&] { assimp = Model::Parse(model.path, model.scale, true); });
+
+			const auto throughput = [megabytes](float ms)
+			{
+				return megabytes / std::max(ms, 0.001f) * 1000.0f;
+			};
+			oss << model.path << " (" << megabytes << " MB, " << assimp.meshes.size() << " meshes)\n"
+					<< "  GltfImporter, 1 worker:   " << serialMs << " ms, " << throughput(serialMs) << " MB/s\n"
+					<< "  GltfImporter, " << parallelWorkers << " workers:  " << parallelMs << " ms, " << throughput(parallelMs) << " MB/s  ["
+					<< assimpMs / std::max(parallelMs, 0.001f) << "x Assimp]\n"
+					<< "  Assimp:                   " << assimpMs << " ms, " << throughput(assimpMs) << " MB/s\n";
+			check(SameModelData(serial, parallel), "1 worker and " + std::to_string(parallelWorkers) + " workers give identical data");
+			compare(parallel, assimp);
+		}
+
+		Model::SetWorkerCount(previousWorkers);
+		return Report("glTF import", oss, check);
+	}
+
+	Benchmarks::Result Benchmarks::AssetBake(const std::string& directory, float scale)
+	{
+		std::ostringstream oss;
+		oss << std::fixed << std::setprecision(2);
+		Checker check{oss};
+		const auto print = [&oss](const char* name, const AssetBaker::Report& report)
+		{
+			oss << "  " << name << ": " << report.baked << " baked, " << report.restamped << " restamped, " << report.upToDate
+					<< " up to date; " << report.filesHashed << " / " << report.filesChecked << " files read ("
+					<< report.bytesHashed / (1024.0 * 1024.0) << " MB), " << report.imagesDecoded << " images decoded, "
+					<< report.seconds * 1000.0f << " ms\n";
+			for (const auto& failure : report.failures)
+			{
+				oss << "    " << failure << "\n";
+			}
+		};
+		using namespace std::chrono_literals;
+
+		const auto temp = std::filesystem::temp_directory_path() / "D3DEngineBake";
+		std::filesystem::remove_all(temp);
+		std::filesystem::create_directories(temp);
+
+		// every write moves the file's time on by a few seconds, so no edit can hide in the file system's time resolution
+		auto       fileTime = std::filesystem::file_time_type::clock::now();
+		const auto bump     = [&fileTime](const std::filesystem::path& path)
+		{
+			fileTime += 2s;
+			std::filesystem::last_write_time(path, fileTime);
+		};
+		const auto write = [&bump](const std::filesystem::path& path, const std::string& text)
+		{
+			std::ofstream(path, std::ios::binary | std::ios::trunc) << text;
+			bump(path);
+		};
+		// a 2x2 image, opaque or with one transparent pixel
+		const auto writeImage = [&bump](const std::filesystem::path& path, bool alpha)
+		{
+			Surface image{2u, 2u};
+			image.Clear({255u, 200u, 100u, 50u});
+			if (alpha)
+			{
+				image.PutPixel(1u, 1u, {0u, 200u, 100u, 50u});
+			}
+			image.Save(path.string());
+			bump(path);
+		};
+		const auto quad = [](const std::string& name)
+		{
+			return "mtllib " + name + ".mtl\n"
+					"v -1 -1 0\nv 1 -1 0\nv 1 1 0\nv -1 1 0\n"
+					"vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+					"vn 0 0 1\n"
+					"usemtl " + name + "\n"
+					"f 1/1/1 2/2/1 3/3/1\nf 1/1/1 3/3/1 4/4/1\n";
+		};
+
+		// two quads, a textured one and a plain one
+		oss << "incremental bakes (synthetic)\n";
+		{
+			const auto a        = (temp / "a.obj").string();
+			const auto b        = (temp / "b.obj").string();
+			const auto manifest = (temp / "bake.manifest").string();
+			write(a, quad("a"));
+			write(temp / "a.mtl", "newmtl a\nKd 0.8 0.8 0.8\nNs 20\nmap_Kd a.png\n");
+			writeImage(temp / "a.png", false);
+			write(b, quad("b"));
+			write(temp / "b.mtl", "newmtl b\nKd 0.2 0.4 0.6\nNs 20\n");
+
+			const auto models = AssetBaker::FindModels(temp.string());
+			check(models == std::vector<std::string>{a, b}, "both models are found");
+			const auto alphaOf = [&a](float s)
+			{
+				const auto data = ModelCache::Load(a, s, Model::GetImportSettingsHash());
+				return data && !data->meshes.empty() && data->meshes.front().material.hasAlphaDiffuse;
+			};
+
+			auto report = AssetBaker::Bake(models, manifest, {1.0f});
+			print("first", report);
+			check(report.baked == 2u && report.failures.empty() && report.imagesDecoded == 1u, "the first run bakes both and decodes the image");
+			const auto importSettings = Model::GetImportSettingsHash();
+			check(ModelCache::Load(a, 1.0f, importSettings) && ModelCache::Load(b, 1.0f, importSettings), "the caches load like ones the app wrote");
+			check(!ModelCache::Load(a, 1.0f, importSettings + 1u), "but not for other import settings");
+
+			report = AssetBaker::Bake(models, manifest, {1.0f});
+			print("again", report);
+			check(report.upToDate == 2u && report.filesHashed == 0u && report.imagesDecoded == 0u, "a second run reads no file and bakes nothing");
+
+			write(a, quad("a"));
+			report = AssetBaker::Bake(models, manifest, {1.0f});
+			print("a.obj saved unchanged", report);
+			check(report.baked == 0u && report.restamped == 1u && report.filesHashed == 1u, "a touched file is read, but nothing is rebaked");
+			check(ModelCache::Load(a, 1.0f, importSettings).has_value(), "and the restamped cache still loads");
+
+			writeImage(temp / "a.png", true);
+			report = AssetBaker::Bake(models, manifest, {1.0f});
+			print("a.png changed", report);
+			check(report.baked == 1u && report.upToDate == 1u && report.imagesDecoded == 1u, "a changed image rebakes the model using it, and only that one");
+			check(alphaOf(1.0f), "which learns the image's new alpha");
+
+			write(temp / "b.mtl", "newmtl b\nKd 0.6 0.4 0.2\nNs 20\n");
+			report = AssetBaker::Bake(models, manifest, {1.0f});
+			print("b.mtl changed", report);
+			check(report.baked == 1u && report.upToDate == 1u && report.imagesDecoded == 0u, "a changed material library rebakes its model only");
+
+			std::filesystem::remove(ModelCache::GetCachePath(b));
+			report = AssetBaker::Bake(models, manifest, {1.0f});
+			print("b's cache deleted", report);
+			check(report.baked == 1u && report.upToDate == 1u, "a missing cache is baked again");
+
+			report = AssetBaker::Bake(models, manifest, {2.0f});
+			print("scale 2", report);
+			check(report.baked == 2u && report.imagesDecoded == 0u, "changed settings rebake everything, images are not decoded again");
+			check(alphaOf(2.0f), "with what was learned about the images");
+		}
+
+		// the same directory twice, from no manifest at all
+		oss << "cold vs. unchanged bake of " << directory << "\n";
+		{
+			std::vector<std::string> models;
+			try
+			{
+				models = AssetBaker::FindModels(directory);
+			}
+			catch (const std::exception&)
+			{
+			}
+			check(!models.empty(), "models are found");
+			const auto manifest = (temp / "models.manifest").string();
+			const auto cold     = AssetBaker::Bake(models, manifest, {scale});
+			print("cold", cold);
+			const auto warm = AssetBaker::Bake(models, manifest, {scale});
+			print("unchanged", warm);
+			check(cold.failures.empty() && cold.baked == models.size(), "the cold run bakes every model");
+			check(warm.upToDate == models.size() && warm.filesHashed == 0u, "the second run reads no file and bakes nothing");
+			check(warm.seconds < 0.1f, "and takes milliseconds");
+		}
+
+		std::filesystem::remove_all(temp);
+		return Report("Asset Bake", oss, check);
+	}
+}
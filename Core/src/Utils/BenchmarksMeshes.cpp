@@ -0,0 +1,754 @@
+#include "Benchmarks.h"
+#include <limits>
+#include "Drawable/Complex/Mesh.h"
+#include "Drawable/Geometry/IndexedTriangleList.h"
+#include "Bindable/IndexBuffer.h"
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <set>
+
+namespace D3DEngine
+{
+	namespace
+	{
+		// unit UV sphere with a texture seam down longitude 0, where each vertex exists twice with different texcoords
+		IndexedTriangleList MakeSeamedSphere(int latDiv, int longDiv)
+		{
+			using Type = DynamicVertexLayout::ElementType;
+			RawVertexBufferWithLayout vertices(std::move(DynamicVertexLayout{}.Append(Type::Position3D).Append(Type::Texture2D)));
+			for (int lat = 0; lat <= latDiv; lat++)
+			{
+				for (int lon = 0; lon <= longDiv; lon++)
+				{
+					const float theta = DirectX::XM_PI * (float)lat / (float)latDiv;
+					const float phi   = DirectX::XM_2PI * (float)(lon % longDiv) / (float)longDiv;
+					vertices.EmplaceBack(
+					                     DirectX::XMFLOAT3{std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)},
+					                     DirectX::XMFLOAT2{(float)lon / (float)longDiv, (float)lat / (float)latDiv}
+					                    );
+				}
+			}
+			const auto index = [longDiv](int lat, int lon)
+			{
+				return (unsigned int)(lat * (longDiv + 1) + lon);
+			};
+			std::vector<unsigned int> indices;
+			for (int lat = 0; lat < latDiv; lat++)
+			{
+				for (int lon = 0; lon < longDiv; lon++)
+				{
+					if (lat > 0)
+					{
+						indices.insert(indices.end(), {index(lat, lon), index(lat, lon + 1), index(lat + 1, lon)});
+					}
+					if (lat < latDiv - 1)
+					{
+						indices.insert(indices.end(), {index(lat, lon + 1), index(lat + 1, lon + 1), index(lat + 1, lon)});
+					}
+				}
+			}
+			return {std::move(vertices), std::move(indices)};
+		}
+	}
+
+	Benchmarks::Result Benchmarks::IndexWidth()
+	{
+		using Type = DynamicVertexLayout::ElementType;
+
+		// a fan of thin triangles over n vertices, plus one triangle spanning the whole list so that splitting has to duplicate
+		const auto makeMesh = [](size_t n)
+		{
+			RawVertexBufferWithLayout vertices(std::move(DynamicVertexLayout{}.Append(Type::Position3D)), n);
+			for (size_t i = 0; i < n; i++)
+			{
+				vertices[i].Attr<Type::Position3D>() = {(float)i, (float)(i % 7), 0.0f};
+			}
+			std::vector<unsigned int> indices;
+			for (unsigned int i = 0; i + 2 < n; i++)
+			{
+				indices.insert(indices.end(), {i, i + 1, i + 2});
+			}
+			indices.insert(indices.end(), {0u, (unsigned int)n / 2u, (unsigned int)n - 1u});
+			return IndexedTriangleList{std::move(vertices), std::move(indices)};
+		};
+
+		// every triangle of every piece has to match the original triangle, in the original order
+		const auto samePositions = [](const IndexedTriangleList& original, const std::vector<IndexedTriangleList>& pieces)
+		{
+			size_t i = 0;
+			for (const auto& piece : pieces)
+			{
+				if (!piece.FitsShortIndices())
+				{
+					return false;
+				}
+				for (const auto index : piece.indices)
+				{
+					const auto& a = original.vertices[original.indices[i++]].Attr<Type::Position3D>();
+					const auto& b = piece.vertices[index].Attr<Type::Position3D>();
+					if (a.x != b.x || a.y != b.y || a.z != b.z)
+					{
+						return false;
+					}
+				}
+			}
+			return i == original.indices.size();
+		};
+
+		std::ostringstream oss;
+		Checker            check{oss};
+		for (const size_t n : {65535u, 65536u, 65537u, 200000u})
+		{
+			const auto mesh      = makeMesh(n);
+			const auto format    = IndexBuffer::ChooseFormat(mesh.indices);
+			const auto pieces    = mesh.SplitForShortIndices();
+			const bool expect16  = n <= IndexedTriangleList::maxShortIndexedVertices;
+			const bool formatOk  = (format == DXGI_FORMAT_R16_UINT) == expect16;
+			const bool piecesOk  = samePositions(mesh, pieces) && (pieces.size() == 1u) == expect16;
+			const auto indexSize = format == DXGI_FORMAT_R16_UINT ? sizeof(unsigned short) : sizeof(unsigned int);
+
+			oss << n << " vertices: " << (format == DXGI_FORMAT_R16_UINT ? "16" : "32") << "-bit, "
+					<< mesh.indices.size() * indexSize / 1024u << " KiB of indices, "
+					<< pieces.size() << " piece(s) when split\n";
+			check(formatOk && piecesOk, "index width and pieces as expected");
+		}
+		return Report("Index width", oss, check);
+	}
+
+	Benchmarks::Result Benchmarks::MeshOptimization(const std::vector<ModelSpec>& models)
+	{
+		const auto previousOptions = Model::GetMeshOptimization();
+		Model::SetMeshOptimization({false, false, false});
+
+		MeshOptimizer::Options cacheOnly;
+		cacheOnly.overdraw    = false;
+		cacheOnly.vertexFetch = false;
+		const MeshOptimizer::Options full;
+
+		std::ostringstream oss;
+		oss << std::fixed << std::setprecision(3);
+		for (const auto& model : models)
+		{
+			const auto data = Model::Import(model.path, model.scale);
+
+			// triangle weighted totals over the whole model
+			double before[2] = {}, cached[2] = {}, after[2] = {};
+			size_t triangles = 0u;
+			float  ms        = 0.0f;
+
+			oss << model.path << " (" << data.meshes.size() << " meshes, FIFO cache of " << MeshOptimizer::analyzeCacheSize << ")\n"
+					<< "  ACMR/ATVR: authoring order -> vertex cache -> vertex cache + overdraw + fetch\n";
+			for (const auto& mesh : data.meshes)
+			{
+				auto cacheVertices = mesh.vertices;
+				auto cacheIndices  = mesh.indices;
+				MeshOptimizer::Optimize(cacheVertices, cacheIndices, cacheOnly);
+
+				auto fullVertices = mesh.vertices;
+				auto fullIndices  = mesh.indices;
+				ms += TimeBestOf(1, [&] { MeshOptimizer::Optimize(fullVertices, fullIndices, full); });
+
+				const auto s0 = MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.vertices.Size());
+				const auto s1 = MeshOptimizer::AnalyzeVertexCache(cacheIndices, cacheVertices.Size());
+				const auto s2 = MeshOptimizer::AnalyzeVertexCache(fullIndices, fullVertices.Size());
+
+				const auto n = mesh.indices.size() / 3u;
+				triangles += n;
+				before[0] += s0.acmr * n;
+				before[1] += s0.atvr * n;
+				cached[0] += s1.acmr * n;
+				cached[1] += s1.atvr * n;
+				after[0] += s2.acmr * n;
+				after[1] += s2.atvr * n;
+
+				oss << "  " << mesh.tag.substr(mesh.tag.find('%') + 1u) << " (" << n << " tris): "
+						<< s0.acmr << "/" << s0.atvr << " -> "
+						<< s1.acmr << "/" << s1.atvr << " -> "
+						<< s2.acmr << "/" << s2.atvr << "\n";
+			}
+			const auto t = (double)std::max<size_t>(triangles, 1u);
+			oss << "  total (" << triangles << " tris): "
+					<< before[0] / t << "/" << before[1] / t << " -> "
+					<< cached[0] / t << "/" << cached[1] / t << " -> "
+					<< after[0] / t << "/" << after[1] / t
+					<< "  (optimizing took " << std::setprecision(2) << ms << " ms)\n" << std::setprecision(3);
+		}
+
+		Model::SetMeshOptimization(previousOptions);
+		return Report("Mesh optimization", oss);
+	}
+
+	Benchmarks::Result Benchmarks::MeshLods(const std::vector<ModelSpec>& models)
+	{
+		using Type = DynamicVertexLayout::ElementType;
+
+		std::ostringstream oss;
+		oss << std::fixed << std::setprecision(4);
+		Checker check{oss};
+
+		// sphere: the vertices all sit on the unit sphere, so how far triangle centers sink below it measures the real deviation
+		{
+			const int  latDiv = 60, longDiv = 120;
+			const auto sphere = MakeSeamedSphere(latDiv, longDiv);
+			oss << "seamed sphere (" << sphere.indices.size() / 3u << " tris)\n";
+			for (const auto divisor : {2u, 8u, 40u})
+			{
+				const auto target   = sphere.indices.size() / 3u / divisor;
+				const auto maxError = 0.25f;
+				const auto result   = MeshSimplifier::Simplify(sphere.vertices, sphere.indices, target * 3u, maxError);
+
+				float deviation = 0.0f;
+				for (size_t i = 0; i < result.indices.size(); i += 3)
+				{
+					DirectX::XMVECTOR center = DirectX::XMVectorZero();
+					for (size_t k = 0; k < 3; k++)
+					{
+						center = DirectX::XMVectorAdd(center, DirectX::XMLoadFloat3(&sphere.vertices[result.indices[i + k]].Attr<Type::Position3D>()));
+					}
+					deviation = std::max(deviation, 1.0f - DirectX::XMVectorGetX(DirectX::XMVector3Length(center)) / 3.0f);
+				}
+				// both copies of a seam vertex have to survive or go together
+				std::vector<bool> used(sphere.vertices.Size(), false);
+				for (const auto i : result.indices)
+				{
+					used[i] = true;
+				}
+				int torn = 0;
+				for (int lat = 1; lat < latDiv; lat++)
+				{
+					torn += used[lat * (longDiv + 1)] != used[lat * (longDiv + 1) + longDiv] ? 1 : 0;
+				}
+
+				std::ostringstream what;
+				what << std::fixed << std::setprecision(4) << "target " << target << " -> " << result.indices.size() / 3u
+						<< " tris, error " << result.error << ", measured " << deviation;
+				check(result.indices.size() / 3u <= target && result.error <= maxError && deviation <= result.error && torn == 0, what.str());
+			}
+		}
+
+		// plane: only the border can hold it in place, so the simplified plane has to cover exactly the same area
+		{
+			const int                 n = 64;
+			RawVertexBufferWithLayout vertices(std::move(DynamicVertexLayout{}.Append(Type::Position3D)));
+			for (int y = 0; y <= n; y++)
+			{
+				for (int x = 0; x <= n; x++)
+				{
+					vertices.EmplaceBack(DirectX::XMFLOAT3{(float)x, (float)y, 0.0f});
+				}
+			}
+			std::vector<unsigned int> indices;
+			for (int y = 0; y < n; y++)
+			{
+				for (int x = 0; x < n; x++)
+				{
+					const auto i = (unsigned int)(y * (n + 1) + x);
+					indices.insert(indices.end(), {i, i + n + 1u, i + 1u, i + 1u, i + n + 1u, i + n + 2u});
+				}
+			}
+			const auto result = MeshSimplifier::Simplify(vertices, indices, 6u, 0.01f);
+			float      area   = 0.0f;
+			for (size_t i = 0; i < result.indices.size(); i += 3)
+			{
+				const auto& a = vertices[result.indices[i]].Attr<Type::Position3D>();
+				const auto& b = vertices[result.indices[i + 1]].Attr<Type::Position3D>();
+				const auto& c = vertices[result.indices[i + 2]].Attr<Type::Position3D>();
+				area += 0.5f * std::abs((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x));
+			}
+			std::ostringstream what;
+			what << std::fixed << std::setprecision(1) << "plane " << indices.size() / 3u << " -> " << result.indices.size() / 3u
+					<< " tris, area " << area << " of " << n * n;
+			oss << "bordered plane\n";
+			check(result.indices.size() / 3u <= 6u && std::abs(area - (float)(n * n)) < 0.01f, what.str());
+		}
+
+		// selection: full detail up close, coarser (never finer) with distance, culled once smaller than a pixel
+		{
+			const std::vector<Mesh::Lod> lods = {{{}, 0.01f}, {{}, 0.05f}, {{}, 0.2f}};
+			const Mesh::LodSettings      settings;
+			const float                  pixelScale = 1000.0f;
+
+			bool   monotonic = true;
+			size_t previous  = 0u;
+			float  cullAt    = 0.0f;
+			for (float distance = 1.5f; distance < 10000.0f; distance *= 1.1f)
+			{
+				const auto lod = Mesh::SelectLod(lods, 1.0f, 1.0f, distance, pixelScale, settings);
+				if (lod == Mesh::culled)
+				{
+					cullAt = distance;
+					break;
+				}
+				monotonic = monotonic && lod >= previous;
+				previous  = lod;
+			}
+			oss << "LOD selection\n";
+			check(Mesh::SelectLod(lods, 1.0f, 1.0f, 0.5f, pixelScale, settings) == 0u, "inside the bounds draws full detail");
+			check(monotonic && previous == lods.size(), "LOD only gets coarser with distance, down to the last one");
+			// 2 * radius * pixelScale / (distance - radius) drops below one pixel at distance 2001
+			check(cullAt > 2001.0f && cullAt < 2001.0f * 1.1f, "culled once smaller than a pixel");
+			check(Mesh::SelectLod(lods, 1.0f, 2.0f, 10.0f, pixelScale, settings) <=
+			      Mesh::SelectLod(lods, 1.0f, 1.0f, 10.0f, pixelScale, settings), "scaling a mesh up never coarsens its LOD");
+		}
+
+		// the chains generated for real models
+		for (const auto& model : models)
+		{
+			auto options    = MeshSimplifier::LodOptions{};
+			auto lodOptions = options;
+			lodOptions.maxLods = 0u;
+			Model::SetLodOptions(lodOptions);
+			const auto data = Model::Import(model.path, model.scale);
+			Model::SetLodOptions(options);
+
+			std::vector<size_t> triangles(options.maxLods + 1u, 0u);
+			float               maxError = 0.0f;
+			const auto          ms       = TimeBestOf(1, [&]
+			{
+				for (const auto& mesh : data.meshes)
+				{
+					const auto lods = MeshSimplifier::GenerateLods(mesh.vertices, mesh.indices, options);
+					triangles[0] += mesh.indices.size() / 3u;
+					for (size_t l = 0; l < options.maxLods; l++)
+					{
+						// meshes that ran out of LODs keep drawing their coarsest one
+						triangles[l + 1u] += (l < lods.size() ? lods[l].indices.size() : lods.empty() ? mesh.indices.size() : lods.back().indices.size()) / 3u;
+					}
+					for (const auto& lod : lods)
+					{
+						maxError = std::max(maxError, lod.error);
+					}
+				}
+			});
+			oss << model.path << " (" << data.meshes.size() << " meshes, " << std::setprecision(2) << ms << " ms)\n  triangles per LOD:";
+			for (const auto t : triangles)
+			{
+				oss << " " << t;
+			}
+			oss << "\n  largest LOD error: " << std::setprecision(4) << maxError << "\n";
+		}
+
+		return Report("Mesh LODs", oss, check);
+	}
+
+	Benchmarks::Result Benchmarks::Meshlets(const std::vector<ModelSpec>& models)
+	{
+		using Type = DynamicVertexLayout::ElementType;
+		namespace dx = DirectX;
+
+		std::ostringstream oss;
+		oss << std::fixed << std::setprecision(1);
+		Checker check{oss};
+
+		// 90 degree frustum from eye along dir (planes pointing inwards, normalized), without a far plane to speak of
+		const auto makeFrustum = [](dx::FXMVECTOR eye, dx::FXMVECTOR dir, dx::FXMVECTOR up, dx::XMFLOAT4 (&planes)[6])
+		{
+			const auto right = dx::XMVector3Cross(up, dir);
+			const auto plane = [&eye](dx::FXMVECTOR normal, float offset)
+			{
+				dx::XMFLOAT4 p;
+				const auto   n = dx::XMVector3Normalize(normal);
+				dx::XMStoreFloat4(&p, n);
+				p.w = -dx::XMVectorGetX(dx::XMVector3Dot(n, eye)) - offset;
+				return p;
+			};
+			planes[0] = plane(dx::XMVectorAdd(dir, right), 0.0f);
+			planes[1] = plane(dx::XMVectorSubtract(dir, right), 0.0f);
+			planes[2] = plane(dx::XMVectorAdd(dir, up), 0.0f);
+			planes[3] = plane(dx::XMVectorSubtract(dir, up), 0.0f);
+			planes[4] = plane(dir, 0.1f);
+			planes[5] = plane(dx::XMVectorScale(dir, -1.0f), -1.0e6f);
+		};
+
+		// cull stats of one mesh: triangles the culled meshlets hold, and whether every one of them really was invisible
+		struct CullResult
+		{
+			size_t triangles    = 0u;
+			size_t culled       = 0u;
+			size_t ranges       = 0u;
+			bool   conservative = true;
+		};
+		const auto cull = [](const RawVertexBufferWithLayout& vertices, const std::vector<unsigned int>& indices,
+		                     const std::vector<Meshlet>& meshlets, const dx::XMFLOAT3& eye, const dx::XMFLOAT4 (&planes)[6])
+		{
+			CullResult                        result;
+			std::vector<Drawable::IndexRange> ranges;
+			Mesh::CullMeshlets(meshlets, eye, planes, true, 0u, ranges);
+			std::vector<bool> drawn(indices.size() / 3u, false);
+			for (const auto& range : ranges)
+			{
+				std::fill(drawn.begin() + range.start / 3u, drawn.begin() + (range.start + range.count) / 3u, true);
+			}
+			result.ranges = ranges.size();
+
+			const auto e = dx::XMLoadFloat3(&eye);
+			for (size_t t = 0; t < drawn.size(); t++)
+			{
+				result.triangles++;
+				if (drawn[t])
+				{
+					continue;
+				}
+				result.culled++;
+				dx::XMVECTOR p[3];
+				for (size_t k = 0; k < 3; k++)
+				{
+					p[k] = dx::XMLoadFloat3(&vertices[indices[t * 3u + k]].Attr<Type::Position3D>());
+				}
+				const auto normal     = dx::XMVector3Cross(dx::XMVectorSubtract(p[1], p[0]), dx::XMVectorSubtract(p[2], p[0]));
+				const bool backFacing = dx::XMVectorGetX(dx::XMVector3Dot(normal, dx::XMVectorSubtract(p[0], e))) >= -1e-5f;
+				bool       outside    = false;
+				for (const auto& plane : planes)
+				{
+					const auto n = dx::XMLoadFloat4(&plane);
+					bool       all = true;
+					for (const auto& v : p)
+					{
+						all = all && dx::XMVectorGetX(dx::XMVector3Dot(n, v)) + plane.w < 0.0f;
+					}
+					outside = outside || all;
+				}
+				result.conservative = result.conservative && (backFacing || outside);
+			}
+			return result;
+		};
+
+		// sphere: partition invariants, then half of it faces away from any outside eye
+		{
+			const auto sphere   = MakeSeamedSphere(60, 120);
+			auto       indices  = sphere.indices;
+			const auto options  = MeshletBuilder::Options{};
+			const auto meshlets = MeshletBuilder::Build(sphere.vertices, indices, options);
+			oss << "sphere (" << indices.size() / 3u << " tris, " << meshlets.size() << " meshlets)\n";
+
+			bool   contiguous = !meshlets.empty();
+			bool   limits     = true;
+			size_t next       = 0u;
+			for (const auto& m : meshlets)
+			{
+				contiguous = contiguous && m.indexOffset == next && m.indexCount % 3u == 0u;
+				next       = m.indexOffset + m.indexCount;
+				std::set<unsigned int> unique(indices.begin() + m.indexOffset, indices.begin() + m.indexOffset + m.indexCount);
+				limits = limits && unique.size() <= options.maxVertices && m.indexCount / 3u <= options.maxTriangles;
+			}
+			const auto triangles = [](const std::vector<unsigned int>& list)
+			{
+				std::vector<std::array<unsigned int, 3>> t;
+				for (size_t i = 0; i < list.size(); i += 3)
+				{
+					t.push_back({list[i], list[i + 1u], list[i + 2u]});
+				}
+				std::sort(t.begin(), t.end());
+				return t;
+			};
+			check(contiguous && next == indices.size(), "meshlets cover the index list back to back");
+			check(limits, "no meshlet exceeds the vertex or triangle limit");
+			check(triangles(indices) == triangles(sphere.indices), "same triangles as before, each exactly once");
+
+			dx::XMFLOAT4 planes[6];
+			const auto   eye = dx::XMVectorSet(0.0f, 0.0f, -3.0f, 1.0f);
+			makeFrustum(eye, dx::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), dx::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), planes);
+			dx::XMFLOAT3 e;
+			dx::XMStoreFloat3(&e, eye);
+			const auto   facing = cull(sphere.vertices, indices, meshlets, e, planes);
+
+			std::ostringstream what;
+			what << std::fixed << std::setprecision(1) << "whole sphere in view: " << 100.0f * facing.culled / facing.triangles << "% of triangles culled as back-facing";
+			check(facing.conservative && facing.culled * 4u >= facing.triangles, what.str());
+
+			// turning the view until the sphere's center sits on its edge leaves half of it outside the frustum
+			makeFrustum(eye, dx::XMVector3Normalize(dx::XMVectorSet(-1.0f, 0.0f, 1.0f, 0.0f)), dx::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), planes);
+			const auto aside = cull(sphere.vertices, indices, meshlets, e, planes);
+			what.str("");
+			what << "sphere at the edge of the view: " << 100.0f * aside.culled / aside.triangles << "% culled";
+			check(aside.conservative && aside.culled > facing.culled, what.str());
+
+			// merging over short culled stretches never drops a survivor
+			std::vector<Drawable::IndexRange> exact, merged;
+			const auto                        visible = Mesh::CullMeshlets(meshlets, e, planes, true, 0u, exact);
+			Mesh::CullMeshlets(meshlets, e, planes, true, Mesh::MeshletSettings{}.minSkipTriangles, merged);
+			size_t exactIndices = 0u, mergedIndices = 0u;
+			for (const auto& r : exact)
+			{
+				exactIndices += r.count;
+			}
+			for (const auto& r : merged)
+			{
+				mergedIndices += r.count;
+			}
+			what.str("");
+			what << visible << " meshlets in " << exact.size() << " ranges, " << merged.size() << " after merging short gaps";
+			check(merged.size() <= exact.size() && mergedIndices >= exactIndices, what.str());
+		}
+
+		// real models seen from their center, along each axis
+		for (const auto& model : models)
+		{
+			ModelData  data;
+			const auto ms = TimeBestOf(1, [&]
+			{
+				data = Model::Import(model.path, model.scale);
+			});
+
+			size_t meshes = 0u, meshletCount = 0u, meshletTriangles = 0u, total = 0u;
+			auto   lo     = dx::XMVectorReplicate(std::numeric_limits<float>::max());
+			auto   hi     = dx::XMVectorReplicate(-std::numeric_limits<float>::max());
+			for (const auto& mesh : data.meshes)
+			{
+				total += mesh.indices.size() / 3u;
+				for (size_t v = 0; v < mesh.vertices.Size(); v++)
+				{
+					const auto p = dx::XMLoadFloat3(&mesh.vertices[v].Attr<Type::Position3D>());
+					lo           = dx::XMVectorMin(lo, p);
+					hi           = dx::XMVectorMax(hi, p);
+				}
+				if (!mesh.meshlets.empty())
+				{
+					meshes++;
+					meshletCount += mesh.meshlets.size();
+					meshletTriangles += mesh.indices.size() / 3u;
+				}
+			}
+			const auto center = dx::XMVectorScale(dx::XMVectorAdd(lo, hi), 0.5f);
+			dx::XMFLOAT3 e;
+			dx::XMStoreFloat3(&e, center);
+
+			oss << model.path << " (import " << ms << " ms)\n  " << meshes << " of " << data.meshes.size() << " meshes in "
+					<< meshletCount << " meshlets, " << 100.0f * meshletTriangles / std::max<size_t>(total, 1u) << "% of "
+					<< total << " triangles\n";
+
+			bool               conservative = true;
+			const dx::XMFLOAT3 axes[]       = {{1, 0, 0}, {-1, 0, 0}, {0, 0, 1}, {0, 0, -1}, {0, 1, 0}, {0, -1, 0}};
+			for (const auto& axis : axes)
+			{
+				const auto   dir = dx::XMLoadFloat3(&axis);
+				const auto   up  = axis.y != 0.0f ? dx::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f) : dx::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+				dx::XMFLOAT4 planes[6];
+				makeFrustum(center, dir, up, planes);
+
+				CullResult sum;
+				for (const auto& mesh : data.meshes)
+				{
+					if (mesh.meshlets.empty())
+					{
+						continue;
+					}
+					const auto r = cull(mesh.vertices, mesh.indices, mesh.meshlets, e, planes);
+					sum.triangles += r.triangles;
+					sum.culled += r.culled;
+					sum.ranges += r.ranges;
+					conservative = conservative && r.conservative;
+				}
+				oss << "  view (" << axis.x << ", " << axis.y << ", " << axis.z << "): "
+						<< 100.0f * sum.culled / std::max<size_t>(sum.triangles, 1u) << "% of meshlet triangles culled, "
+						<< sum.ranges << " draw ranges\n";
+			}
+			check(conservative, "no culled triangle was front-facing inside the frustum");
+		}
+
+		return Report("Meshlets", oss, check);
+	}
+
+	Benchmarks::Result Benchmarks::GeometryArenas(const std::vector<ModelSpec>& models)
+	{
+		std::ostringstream oss;
+		oss << std::fixed << std::setprecision(2);
+		Checker check{oss};
+
+		for (const auto& model : models)
+		{
+			const auto data = Model::Import(model.path, model.scale);
+
+			// meshes in the order the node tree draws them
+			std::vector<unsigned> drawOrder;
+			const auto            collect = [&drawOrder](auto& self, const NodeData& node) -> void
+			{
+				drawOrder.insert(drawOrder.end(), node.meshIndices.begin(), node.meshIndices.end());
+				for (const auto& child : node.children)
+				{
+					self(self, child);
+				}
+			};
+			collect(collect, data.root);
+
+			// every mesh binds its vertex and index buffer, the input assembler only sees the ones that change
+			const auto binds = [&drawOrder](const GeometryArena& arena)
+			{
+				size_t count = 0u;
+				size_t bound = std::numeric_limits<size_t>::max();
+				for (const auto i : drawOrder)
+				{
+					if (arena.slices[i].arena != bound)
+					{
+						bound = arena.slices[i].arena;
+						count += 2u;
+					}
+				}
+				return count;
+			};
+
+			GeometryArena perMesh, shared;
+			const auto    perMeshMs = TimeBestOf(1, [&] { perMesh = GeometryArena::Build(data, model.path, {false}); });
+			const auto    sharedMs  = TimeBestOf(1, [&] { shared = GeometryArena::Build(data, model.path, {true}); });
+
+			std::set<std::string> layouts;
+			size_t                largeMeshes = 0u;
+			for (const auto& mesh : data.meshes)
+			{
+				layouts.insert(mesh.vertices.GetLayout().GetCode());
+				largeMeshes += mesh.vertices.Size() > 0x10000u ? 1u : 0u;
+			}
+
+			const auto perMeshBinds = binds(perMesh);
+			const auto sharedBinds  = binds(shared);
+			oss << model.path << " (" << data.meshes.size() << " meshes, " << drawOrder.size() << " draws, " << layouts.size() << " layouts)\n"
+					<< "  buffer pair per mesh: " << perMesh.arenas.size() << " pairs, " << perMeshBinds << " IA binds per frame (" << 2u * drawOrder.size()
+					<< " without redundant bind elision), built in " << perMeshMs << " ms\n"
+					<< "  shared arenas:        " << shared.arenas.size() << " pairs, " << sharedBinds << " IA binds per frame, built in " << sharedMs << " ms\n";
+
+			// every slice has to give back exactly the mesh it came from
+			bool intact = true;
+			for (size_t i = 0; i < data.meshes.size(); i++)
+			{
+				const auto& mesh   = data.meshes[i];
+				const auto& slice  = shared.slices[i];
+				const auto& arena  = shared.arenas[slice.arena];
+				const auto  stride = mesh.vertices.GetLayout().Size();
+				const auto  range  = [&arena](const GeometryArena::Range& r)
+				{
+					return std::vector<unsigned int>(arena.indices.begin() + r.start, arena.indices.begin() + r.start + r.count);
+				};
+				intact = intact && arena.vertices.GetLayout().GetCode() == mesh.vertices.GetLayout().GetCode() &&
+				         memcmp(arena.vertices.GetData() + slice.baseVertex * stride, mesh.vertices.GetData(), mesh.vertices.SizeBytes()) == 0 &&
+				         range(slice.indices) == mesh.indices && slice.lods.size() == mesh.lods.size();
+				for (size_t k = 0; intact && k < mesh.lods.size(); k++)
+				{
+					intact = range(slice.lods[k]) == mesh.lods[k].indices;
+				}
+			}
+			check(intact, "every mesh draws the same vertices and indices (full detail and LODs) from its slice");
+
+			size_t wideArenas = 0u;
+			for (const auto& arena : shared.arenas)
+			{
+				wideArenas += IndexBuffer::ChooseFormat(arena.indices) == DXGI_FORMAT_R32_UINT ? 1u : 0u;
+			}
+			check(shared.arenas.size() <= 2u * layouts.size() && wideArenas <= largeMeshes,
+			      "one arena per layout and index width, 32-bit indices only where a mesh has more than 65536 vertices");
+			check(sharedBinds <= perMeshBinds, "shared arenas never bind more often than a buffer pair per mesh");
+		}
+
+		return Report("Geometry arenas", oss, check);
+	}
+
+	Benchmarks::Result Benchmarks::Materials(const std::vector<ModelSpec>& models)
+	{
+		std::ostringstream oss;
+		oss << std::fixed << std::setprecision(2);
+		Checker check{oss};
+
+		// one object per material; the ones sharing a group are identical apart from their name, every other pair differs
+		// in exactly one parameter
+		struct Expected
+		{
+			const char* name;
+			int         group;
+		};
+		const std::vector<Expected> expected = {
+			{"plainA", 0}, {"plainB", 0}, {"shinier", 1}, {"greener", 2}, {"glossier", 3},
+			{"texA", 4}, {"texB", 4}, {"texC", 5}, {"texD", 6},
+		};
+		const auto directory = std::filesystem::temp_directory_path() / "D3DEngineMaterials";
+		std::filesystem::create_directories(directory);
+		std::ofstream(directory / "materials.mtl") <<
+				"newmtl plainA\nKd 0.5 0.25 0.125\nKs 0.5 0.5 0.5\nNs 20\n"
+				"newmtl plainB\nKd 0.5 0.25 0.125\nKs 0.5 0.5 0.5\nNs 20\n"
+				"newmtl shinier\nKd 0.5 0.25 0.125\nKs 0.5 0.5 0.5\nNs 40\n"
+				"newmtl greener\nKd 0.5 0.75 0.125\nKs 0.5 0.5 0.5\nNs 20\n"
+				"newmtl glossier\nKd 0.5 0.25 0.125\nKs 0.25 0.25 0.25\nNs 20\n"
+				"newmtl texA\nKs 0.5 0.5 0.5\nNs 20\nmap_Kd a.png\n"
+				"newmtl texB\nKs 0.5 0.5 0.5\nNs 20\nmap_Kd a.png\n"
+				"newmtl texC\nKs 0.5 0.5 0.5\nNs 20\nmap_Kd b.png\n"
+				"newmtl texD\nKs 0.5 0.5 0.5\nNs 30\nmap_Kd a.png\n";
+		{
+			std::ofstream obj(directory / "materials.obj");
+			obj << "# D3DEngine Materials benchmark\nmtllib materials.mtl\nv 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\nvt 1 0\nvt 0 1\nvn 0 0 1\n";
+			for (const auto& e : expected)
+			{
+				obj << "o " << e.name << "\nusemtl " << e.name << "\nf 1/1/1 2/2/1 3/3/1\n";
+			}
+		}
+		const auto path = (directory / "materials.obj").string();
+
+		const auto checkFile = [&](const char* importer, const ModelData& data)
+		{
+			oss << importer << "\n";
+			if (data.meshes.size() != expected.size())
+			{
+				check(false, std::to_string(data.meshes.size()) + " meshes parsed, " + std::to_string(expected.size()) + " expected");
+				return;
+			}
+			std::vector<MaterialTable::Id> ids;
+			for (const auto& mesh : data.meshes)
+			{
+				ids.push_back(MaterialTable::Intern(Material::FromDesc(mesh.material)));
+			}
+			for (size_t i = 0; i < expected.size(); i++)
+			{
+				for (size_t j = i + 1; j < expected.size(); j++)
+				{
+					const bool same = expected[i].group == expected[j].group;
+					if (same != (ids[i] == ids[j]))
+					{
+						check(false, std::string(expected[i].name) + " and " + expected[j].name + (same ? " should share" : " should not share")
+						             + " a material");
+					}
+				}
+			}
+			std::vector<MaterialTable::Id> unique(ids);
+			std::sort(unique.begin(), unique.end());
+			unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+			check(unique.size() == 7u, std::to_string(ids.size()) + " meshes interned as " + std::to_string(unique.size())
+			                           + " materials (7 expected), identical ones collapsed and the rest kept apart");
+
+			// the constants are what the permutation used to be given per mesh
+			const auto& shinier = MaterialTable::Get(ids[2]).constants;
+			const auto& greener = MaterialTable::Get(ids[3]).constants;
+			const auto& texD    = MaterialTable::Get(ids[8]).constants;
+			check(std::holds_alternative<PhongConstants::Untextured>(shinier) &&
+			      std::get<PhongConstants::Untextured>(shinier).specularPower == 40.0f &&
+			      std::get<PhongConstants::Untextured>(greener).materialColor.y == 0.75f,
+			      "untextured constants carry Ns and Kd");
+			check(std::holds_alternative<PhongConstants::Diffuse>(texD) &&
+			      std::get<PhongConstants::Diffuse>(texD).specularPower == 30.0f &&
+			      MaterialTable::Get(ids[7]).diffusePath != MaterialTable::Get(ids[5]).diffusePath,
+			      "diffuse-mapped constants carry Ns and the map path");
+		};
+		checkFile("Assimp", Model::Parse(path, 1.0f, true));
+		checkFile("ObjImporter", Model::Parse(path));
+
+		// alpha flags are only known once the images are decoded, so these are lower bounds on the unique materials
+		for (const auto& model : models)
+		{
+			const auto                  data = Model::Import(model.path, model.scale);
+			std::set<MaterialTable::Id> ids;
+			// unique materials by the alternative they hold
+			std::array<size_t, std::variant_size_v<Material::Constants>> permutations{};
+			for (const auto& mesh : data.meshes)
+			{
+				const auto id = MaterialTable::Intern(Material::FromDesc(mesh.material));
+				if (ids.insert(id).second)
+				{
+					permutations[MaterialTable::Get(id).constants.index()]++;
+				}
+			}
+			oss << model.path << "\n"
+					<< "  " << data.meshes.size() << " meshes, " << ids.size() << " unique materials (one constant buffer each)\n"
+					<< "  by permutation: " << permutations[0] << " diffuse+specular+normal, " << permutations[1] << " diffuse+normal, "
+					<< permutations[2] << " diffuse+specular, " << permutations[3] << " diffuse, " << permutations[4] << " untextured\n";
+		}
+
+		return Report("Materials", oss, check);
+	}
+}
@@ -0,0 +1,945 @@
+#include "Benchmarks.h"
+#include "Drawable/Complex/Mesh.h"
+#include "Drawable/Complex/VertexConversion.h"
+#include "Drawable/Geometry/IndexedTriangleList.h"
+#include <thread>
+
+namespace D3DEngine
+{
+	Benchmarks::Result Benchmarks::VertexCompression(const std::vector<ModelSpec>& models)
+	{
+		using Type = DynamicVertexLayout::ElementType;
+		namespace dx = DirectX;
+		namespace pv = DirectX::PackedVector;
+
+		std::ostringstream oss;
+		oss << std::scientific << std::setprecision(2);
+		Checker check{oss};
+		const auto angle = [](const dx::XMFLOAT3& a, const dx::XMFLOAT3& b)
+		{
+			const auto va = dx::XMVector3Normalize(dx::XMLoadFloat3(&a));
+			const auto vb = dx::XMVector3Normalize(dx::XMLoadFloat3(&b));
+			// atan2 stays accurate for tiny angles, where acos of a float dot product cannot resolve anything below ~5e-4
+			return std::atan2(dx::XMVectorGetX(dx::XMVector3Length(dx::XMVector3Cross(va, vb))), dx::XMVectorGetX(dx::XMVector3Dot(va, vb)));
+		};
+		// n points spread evenly over the unit sphere (Fibonacci lattice)
+		const auto spherePoint = [](size_t i, size_t n)
+		{
+			const float z   = 1.0f - 2.0f * ((float)i + 0.5f) / (float)n;
+			const float r   = std::sqrt(std::max(1.0f - z * z, 0.0f));
+			const float phi = 2.39996323f * (float)i;
+			return dx::XMFLOAT3{r * std::cos(phi), r * std::sin(phi), z};
+		};
+
+		// a 16-bit half keeps 11 significant bits, so anything in its normal range comes back within 2^-11 relative
+		oss << "codecs\n";
+		{
+			float worst = 0.0f;
+			for (float v = 1.25e-4f; v < 65000.0f; v *= 1.0001f)
+			{
+				for (const float s : {v, -v})
+				{
+					const auto d = VertexPacking::DecodePosition(VertexPacking::EncodePosition({s, s * 0.5f, -s}));
+					worst        = std::max({worst, std::abs(d.x - s) / v, std::abs(d.y - s * 0.5f) / (v * 0.5f), std::abs(d.z + s) / v});
+				}
+			}
+			std::ostringstream what;
+			what << std::scientific << std::setprecision(2) << "half positions: worst relative error " << worst;
+			check(worst <= 1.0f / 2048.0f, what.str());
+
+			float worstTc = 0.0f;
+			for (int i = 0; i <= 4096; i++)
+			{
+				const dx::XMFLOAT2 tc = {(float)i / 4096.0f, 1.0f - (float)i / 4096.0f * 0.999f};
+				const auto         d  = VertexPacking::DecodeTexcoord(VertexPacking::EncodeTexcoord(tc));
+				worstTc               = std::max({worstTc, std::abs(d.x - tc.x), std::abs(d.y - tc.y)});
+			}
+			what.str("");
+			what << "half texture coordinates in [0, 1]: worst error " << worstTc;
+			check(worstTc <= 1.0f / 4096.0f, what.str());
+		}
+		{
+			// the lattice plus the poles, the axes and the octahedron's folds, where the encoding is most likely to go wrong
+			std::vector<dx::XMFLOAT3> normals;
+			for (size_t i = 0; i < 200000u; i++)
+			{
+				normals.push_back(spherePoint(i, 200000u));
+			}
+			normals.insert(normals.end(), {
+				               {0, 0, 1}, {0, 0, -1}, {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0},
+				               {1, 1, -1}, {-1, 1, -1}, {1, -1, -1}, {-1, -1, -1}, {1, 1, 0}, {-1, -1, -1e-7f}, {0.5f, 0, -0.5f}
+			               });
+			float worst = 0.0f;
+			for (const auto& n : normals)
+			{
+				worst = std::max(worst, angle(n, VertexPacking::DecodeNormal(VertexPacking::EncodeNormal(n))));
+			}
+			std::ostringstream what;
+			what << std::scientific << std::setprecision(2) << "octahedral SNORM16 normals: worst error " << worst << " rad over " << normals.size() << " directions";
+			check(worst <= 1.0e-4f, what.str());
+
+			// tangent frames of both handedness, rebuilding the bitangent like the vertex shader does
+			float worstTangent = 0.0f;
+			bool  handedness   = true;
+			for (size_t i = 0; i < 20000u; i++)
+			{
+				const auto  n    = spherePoint(i, 20000u);
+				const auto  vn   = dx::XMLoadFloat3(&n);
+				const auto  seed = std::abs(n.y) < 0.9f ? dx::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f) : dx::XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
+				const auto  vt   = dx::XMVector3Normalize(dx::XMVector3Cross(seed, vn));
+				const float sign = i % 2u ? -1.0f : 1.0f;
+				const auto  vb   = dx::XMVectorScale(dx::XMVector3Cross(vn, vt), sign);
+				dx::XMFLOAT4 t;
+				dx::XMStoreFloat4(&t, vt);
+				t.w = sign;
+
+				const auto dn = VertexPacking::DecodeNormal(VertexPacking::EncodeNormal(n));
+				const auto dt = VertexPacking::DecodeTangent(VertexPacking::EncodeTangent(t));
+				const auto db = dx::XMVectorScale(dx::XMVector3Cross(dx::XMLoadFloat3(&dn), dx::XMVectorSet(dt.x, dt.y, dt.z, 0.0f)), dt.w);
+				worstTangent  = std::max(worstTangent, angle({t.x, t.y, t.z}, {dt.x, dt.y, dt.z}));
+				handedness    = handedness && dt.w == sign && dx::XMVectorGetX(dx::XMVector3Dot(db, vb)) > 0.999f;
+			}
+			what.str("");
+			what << "signed SNORM16 tangents: worst error " << worstTangent << " rad, handedness kept";
+			check(worstTangent <= 1.0e-4f && handedness, what.str());
+		}
+
+		// EmplaceBack fills compact elements straight from floats
+		{
+			DynamicVertexLayout layout;
+			layout.Append(Type::Position3DHalf).Append(Type::NormalOct).Append(Type::TangentSigned).Append(Type::Texture2DHalf);
+			RawVertexBufferWithLayout vertices(std::move(layout));
+			const dx::XMFLOAT3        p  = {1.5f, -2.25f, 100.0f};
+			const dx::XMFLOAT3        n  = {0.0f, -0.6f, -0.8f};
+			const dx::XMFLOAT4        t  = {1.0f, 0.0f, 0.0f, -1.0f};
+			const dx::XMFLOAT2        tc = {0.25f, 0.75f};
+			vertices.EmplaceBack(p, n, t, tc);
+
+			auto       v  = vertices[0];
+			const auto dp = v.Position();
+			const auto dt = DynamicVertexLayout::Map<Type::TangentSigned>::Decode(v.Attr<Type::TangentSigned>());
+			const auto dc = DynamicVertexLayout::Map<Type::Texture2DHalf>::Decode(v.Attr<Type::Texture2DHalf>());
+			check(vertices.GetLayout().Size() == 24u &&
+			      dp.x == p.x && dp.y == p.y && dp.z == p.z &&
+			      angle(n, DynamicVertexLayout::Map<Type::NormalOct>::Decode(v.Attr<Type::NormalOct>())) <= 1.0e-4f &&
+			      dt.x == 1.0f && dt.w == -1.0f && dc.x == tc.x && dc.y == tc.y,
+			      "EmplaceBack encodes float inputs into a 24 byte position/normal/tangent/texcoord vertex");
+		}
+
+		// VertexPacking on a normal-mapped sphere (mirrored texture on one half), then the cases it has to leave alone
+		oss << "synthetic meshes\n";
+		{
+			const auto makeSphere = [&spherePoint](float radius, dx::XMFLOAT3 center, float tiling)
+			{
+				DynamicVertexLayout layout;
+				layout.Append(Type::Position3D).Append(Type::Normal).Append(Type::Tangent).Append(Type::Bitangent).Append(Type::Texture2D);
+				RawVertexBufferWithLayout vertices(std::move(layout));
+				for (size_t i = 0; i < 10000u; i++)
+				{
+					const auto   n    = spherePoint(i, 10000u);
+					const auto   vn   = dx::XMLoadFloat3(&n);
+					const auto   vt   = dx::XMVector3Normalize(dx::XMVector3Cross(dx::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), vn));
+					const float  sign = n.x < 0.0f ? -1.0f : 1.0f;
+					dx::XMFLOAT3 t, b;
+					dx::XMStoreFloat3(&t, vt);
+					dx::XMStoreFloat3(&b, dx::XMVectorScale(dx::XMVector3Cross(vn, vt), sign));
+					vertices.EmplaceBack(
+					                     dx::XMFLOAT3{center.x + n.x * radius, center.y + n.y * radius, center.z + n.z * radius},
+					                     n, t, b,
+					                     dx::XMFLOAT2{(n.x * 0.5f + 0.5f) * tiling, (n.y * 0.5f + 0.5f) * tiling}
+					                    );
+				}
+				return vertices;
+			};
+
+			const auto              sphere = makeSphere(2.0f, {0.0f, 1.0f, 0.0f}, 1.0f);
+			VertexPacking::Stats    stats;
+			const auto              packed = VertexPacking::Compress(sphere, {}, &stats);
+			const auto&             layout = packed.GetLayout();
+
+			float worstPosition = 0.0f, worstNormal = 0.0f;
+			bool  handedness    = true;
+			for (size_t i = 0; i < sphere.Size(); i++)
+			{
+				const auto  src = sphere[i];
+				const auto  dst = packed[i];
+				const auto& p   = src.Attr<Type::Position3D>();
+				const auto  dp  = dst.Position();
+				worstPosition   = std::max(worstPosition, dx::XMVectorGetX(dx::XMVector3Length(dx::XMLoadFloat3(&dp) - dx::XMLoadFloat3(&p))));
+				const auto  dn  = DynamicVertexLayout::Map<Type::NormalOct>::Decode(dst.Attr<Type::NormalOct>());
+				worstNormal     = std::max(worstNormal, angle(src.Attr<Type::Normal>(), dn));
+				const auto  dt  = DynamicVertexLayout::Map<Type::TangentSigned>::Decode(dst.Attr<Type::TangentSigned>());
+				const auto  db  = dx::XMVectorScale(dx::XMVector3Cross(dx::XMLoadFloat3(&dn), dx::XMVectorSet(dt.x, dt.y, dt.z, 0.0f)), dt.w);
+				handedness      = handedness && dx::XMVectorGetX(dx::XMVector3Dot(db, dx::XMLoadFloat3(&src.Attr<Type::Bitangent>()))) > 0.999f;
+			}
+
+			std::ostringstream what;
+			what << "sphere: " << sphere.GetLayout().GetCode() << " -> " << layout.GetCode() << ", " << stats.bytesBefore << " -> "
+					<< stats.bytesAfter << " bytes (" << std::fixed << std::setprecision(1) << 100.0f * stats.bytesAfter / stats.bytesBefore << "%)";
+			check(stats.bytesAfter * 2u <= stats.bytesBefore && !layout.Has(Type::Bitangent) && layout.Has(Type::Position3DHalf) &&
+			      layout.Has(Type::Texture2DHalf), what.str());
+			what.str("");
+			what << std::scientific << std::setprecision(2) << "sphere: decoded positions within " << worstPosition << " (reported "
+					<< stats.positionError << "), normals within " << worstNormal << " rad, bitangents rebuilt with the right handedness";
+			check(worstPosition == stats.positionError && worstPosition <= 2.0f / 1024.0f && worstNormal <= 1.0e-4f && handedness, what.str());
+
+			// far from the origin half floats are too coarse for a small mesh, and heavily tiled texcoords lose too much
+			const auto far = VertexPacking::Compress(makeSphere(1.0f, {5000.0f, 0.0f, 0.0f}, 1.0f), {});
+			check(far.GetLayout().Has(Type::Position3D) && far.GetLayout().Has(Type::NormalOct), "small mesh 5000 units out keeps float positions");
+			const auto tiled = VertexPacking::Compress(makeSphere(1.0f, {0.0f, 0.0f, 0.0f}, 64.0f), {});
+			check(tiled.GetLayout().Has(Type::Texture2D) && tiled.GetLayout().Has(Type::Position3DHalf), "texture tiled 64 times keeps float texcoords");
+		}
+
+		// real models, mesh by mesh as Model would pack them
+		for (const auto& model : models)
+		{
+			const auto data = Model::Import(model.path, model.scale);
+
+			VertexPacking::Stats total;
+			size_t               floatPositions = 0u, floatTexcoords = 0u;
+			float                worstNormal    = 0.0f;
+			const auto           ms             = TimeBestOf(1, [&]
+			{
+				for (const auto& mesh : data.meshes)
+				{
+					VertexPacking::Stats stats;
+					const auto           packed = VertexPacking::Compress(mesh.vertices, {}, &stats);
+					total.bytesBefore += stats.bytesBefore;
+					total.bytesAfter += stats.bytesAfter;
+					total.positionError = std::max(total.positionError, stats.positionError);
+					total.texcoordError = std::max(total.texcoordError, stats.texcoordError);
+					worstNormal         = std::max(worstNormal, stats.normalError);
+					floatPositions += packed.GetLayout().Has(Type::Position3D) ? 1u : 0u;
+					floatTexcoords += packed.GetLayout().Has(Type::Texture2D) ? 1u : 0u;
+				}
+			});
+
+			oss << model.path << " (" << data.meshes.size() << " meshes, packed in " << std::fixed << std::setprecision(1) << ms << " ms)\n  "
+					<< total.bytesBefore / 1024u << " KiB -> " << total.bytesAfter / 1024u << " KiB of vertices ("
+					<< 100.0f * total.bytesAfter / std::max<size_t>(total.bytesBefore, 1u) << "%), " << floatPositions
+					<< " meshes kept float positions, " << floatTexcoords << " float texcoords\n  " << std::scientific << std::setprecision(2)
+					<< "worst position error " << total.positionError << ", texcoord error " << total.texcoordError << ", normal error "
+					<< worstNormal << " rad\n";
+			check(total.bytesAfter * 2u <= total.bytesBefore, "vertex memory at least halved");
+		}
+
+		return Report("Vertex compression", oss, check);
+	}
+
+	Benchmarks::Result Benchmarks::VertexLayouts(size_t vertexCount, int repetitions)
+	{
+		std::ostringstream oss;
+		oss << std::fixed << std::setprecision(2);
+		Checker check{oss};
+		using Type   = DynamicVertexLayout::ElementType;
+		using Layout = StaticVertexLayout<Type::Position3D, Type::Normal, Type::Texture2D>;
+		using Packed = StaticVertexLayout<Type::Position3DHalf, Type::NormalOct, Type::TangentSigned, Type::Texture2DHalf>;
+
+		// all known to the compiler
+		static_assert(Layout::stride == 32u && Layout::Offset<Type::Normal>() == 12u && Layout::Offset<Type::Texture2D>() == 24u);
+		static_assert(Layout::code == "P3NT2" && Layout::d3dLayout[2].AlignedByteOffset == 24u);
+		static_assert(Packed::stride == 24u && !Packed::Has<Type::Normal>());
+
+		// the same as the dynamic layouts with the same elements
+		oss << "static vs. dynamic layouts\n";
+		const auto same = [](auto layout, const DynamicVertexLayout& dynamic)
+		{
+			using L          = decltype(layout);
+			const auto descs = dynamic.GetD3DLayout();
+			bool       equal = L::Matches(dynamic) && dynamic.Size() == L::stride && dynamic.GetCode() == L::code && descs.size() == L::count;
+			for (size_t i = 0; equal && i < descs.size(); i++)
+			{
+				const auto& a = descs[i];
+				const auto& b = L::d3dLayout[i];
+				equal         = strcmp(a.SemanticName, b.SemanticName) == 0 && a.SemanticIndex == b.SemanticIndex && a.Format == b.Format &&
+				                a.InputSlot == b.InputSlot && a.AlignedByteOffset == b.AlignedByteOffset && a.InputSlotClass == b.InputSlotClass;
+			}
+			return equal;
+		};
+		check(same(Layout{}, DynamicVertexLayout{}.Append(Type::Position3D).Append(Type::Normal).Append(Type::Texture2D)),
+		      "float layout: same stride, code, offsets and input descriptors");
+		check(same(Packed{}, Packed::Dynamic()), "packed layout: the same, through Dynamic()");
+		check(!Layout::Matches(DynamicVertexLayout{}.Append(Type::Position3D).Append(Type::Texture2D).Append(Type::Normal)),
+		      "a layout with the same elements in another order does not match");
+
+		// the same vertices transformed three ways
+		RawVertexBufferWithLayout buffer{Layout::Dynamic(), vertexCount};
+		{
+			const auto view = Layout::View(buffer);
+			for (size_t i = 0; i < view.Size(); i++)
+			{
+				const auto f                     = (float)i;
+				view[i].Attr<Type::Position3D>() = {std::sin(f), f * 0.001f, std::cos(f)};
+				view[i].Attr<Type::Normal>()     = {0.0f, 1.0f, 0.0f};
+				view[i].Attr<Type::Texture2D>()  = {f, -f};
+			}
+		}
+		check(buffer[vertexCount / 2].Attr<Type::Texture2D>().x == (float)(vertexCount / 2), "what View() writes VertexView reads");
+
+		const auto          matrix           = DirectX::XMMatrixRotationRollPitchYaw(0.1f, 0.2f, 0.3f);
+		auto                dynamicPerAccess = buffer;
+		IndexedTriangleList dynamicResolved{buffer, {0u, 1u, 2u}};
+		IndexedTriangleList fixedOffset{buffer, {0u, 1u, 2u}};
+
+		const auto tPerAccess = TimeBestOf(repetitions, [&]
+		{
+			// what IndexedTriangleList::Transform did per vertex: look the element up in the layout every time
+			for (size_t i = 0; i < dynamicPerAccess.Size(); i++)
+			{
+				auto& pos = dynamicPerAccess[i].Attr<Type::Position3D>();
+				DirectX::XMStoreFloat3(&pos, DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&pos), matrix));
+			}
+		});
+		const auto tResolved = TimeBestOf(repetitions, [&] { dynamicResolved.Transform(matrix); });
+		const auto tStatic   = TimeBestOf(repetitions, [&] { fixedOffset.Transform<Layout>(matrix); });
+
+		oss << "transform of " << vertexCount << " vertices (best of " << repetitions << ")\n";
+		const auto line = [&](const char* name, float ms)
+		{
+			oss << "  " << name << ms << " ms, " << ms * 1e6f / (float)vertexCount << " ns/vertex, "
+					<< (float)vertexCount / (ms * 1000.0f) << " Mvertices/s, x" << tPerAccess / ms << "\n";
+		};
+		line("dynamic, resolved per access: ", tPerAccess);
+		line("dynamic, resolved once:       ", tResolved);
+		line("static layout:                ", tStatic);
+		check(memcmp(dynamicPerAccess.GetData(), dynamicResolved.vertices.GetData(), buffer.SizeBytes()) == 0 &&
+		      memcmp(dynamicPerAccess.GetData(), fixedOffset.vertices.GetData(), buffer.SizeBytes()) == 0,
+		      "all three give the same bytes");
+		check(tStatic < tPerAccess, "the static layout is faster than resolving per access");
+
+		return Report("Vertex Layouts", oss, check);
+	}
+
+	Benchmarks::Result Benchmarks::VertexStorage(const std::vector<ModelSpec>& models, size_t vertexCount, int repetitions)
+	{
+		std::ostringstream oss;
+		oss << std::fixed << std::setprecision(2);
+		Checker check{oss};
+		using Type = DynamicVertexLayout::ElementType;
+
+		// the same kernels run on both: only the distance from one position to the next differs (the vertex vs. one float3)
+		struct Box
+		{
+			DirectX::XMFLOAT3 lo;
+			DirectX::XMFLOAT3 hi;
+		};
+		const auto boundingBox = [](const char* pPositions, size_t stride, size_t count)
+		{
+			auto lo = DirectX::XMLoadFloat3(reinterpret_cast<const DirectX::XMFLOAT3*>(pPositions));
+			auto hi = lo;
+			for (size_t i = 1; i < count; i++)
+			{
+				const auto p = DirectX::XMLoadFloat3(reinterpret_cast<const DirectX::XMFLOAT3*>(pPositions + i * stride));
+				lo           = DirectX::XMVectorMin(lo, p);
+				hi           = DirectX::XMVectorMax(hi, p);
+			}
+			Box box;
+			DirectX::XMStoreFloat3(&box.lo, lo);
+			DirectX::XMStoreFloat3(&box.hi, hi);
+			return box;
+		};
+		const auto matrix    = DirectX::XMMatrixRotationRollPitchYaw(0.1f, 0.2f, 0.3f);
+		const auto transform = [&matrix](char* pPositions, size_t stride, size_t count)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				auto& pos = *reinterpret_cast<DirectX::XMFLOAT3*>(pPositions + i * stride);
+				DirectX::XMStoreFloat3(&pos, DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&pos), matrix));
+			}
+		};
+
+		// both passes over a set of interleaved buffers and over their streams, checking both agree
+		const auto compare = [&](const std::string& name, std::vector<RawVertexBufferWithLayout> interleaved)
+		{
+			std::vector<VertexStreams> streams;
+			size_t                     vertices = 0u;
+			size_t                     bytes    = 0u;
+			for (const auto& buffer : interleaved)
+			{
+				streams.emplace_back(buffer);
+				vertices += buffer.Size();
+				bytes += buffer.SizeBytes();
+			}
+			oss << name << ": " << vertices << " vertices in " << interleaved.size() << " buffers, " << (float)bytes / (float)vertices
+					<< " bytes per vertex (best of " << repetitions << ")\n";
+
+			std::vector<Box> aosBoxes(interleaved.size());
+			std::vector<Box> soaBoxes(streams.size());
+			const auto       tBoxAos = TimeBestOf(repetitions, [&]
+			{
+				for (size_t i = 0; i < interleaved.size(); i++)
+				{
+					const auto& b = interleaved[i];
+					aosBoxes[i]   = boundingBox(b.GetData() + b.GetLayout().Resolve<Type::Position3D>().GetOffset(), b.GetLayout().Size(), b.Size());
+				}
+			});
+			const auto tBoxSoa = TimeBestOf(repetitions, [&]
+			{
+				for (size_t i = 0; i < streams.size(); i++)
+				{
+					const auto& s = streams[i];
+					soaBoxes[i]   = boundingBox(reinterpret_cast<const char*>(s.Stream<Type::Position3D>()), sizeof(DirectX::XMFLOAT3), s.Size());
+				}
+			});
+			const auto tTransformAos = TimeBestOf(repetitions, [&]
+			{
+				for (auto& b : interleaved)
+				{
+					transform(b.GetData() + b.GetLayout().Resolve<Type::Position3D>().GetOffset(), b.GetLayout().Size(), b.Size());
+				}
+			});
+			const auto tTransformSoa = TimeBestOf(repetitions, [&]
+			{
+				for (auto& s : streams)
+				{
+					transform(reinterpret_cast<char*>(s.Stream<Type::Position3D>()), sizeof(DirectX::XMFLOAT3), s.Size());
+				}
+			});
+
+			const auto line = [&](const char* pass, float aos, float soa)
+			{
+				oss << "  " << pass << "interleaved " << aos << " ms, streams " << soa << " ms (x" << aos / soa << "), "
+						<< (float)vertices / (soa * 1000.0f) << " Mvertices/s\n";
+			};
+			line("bounding box: ", tBoxAos, tBoxSoa);
+			line("transform:    ", tTransformAos, tTransformSoa);
+
+			bool same = memcmp(aosBoxes.data(), soaBoxes.data(), aosBoxes.size() * sizeof(Box)) == 0;
+			for (size_t i = 0; same && i < interleaved.size(); i++)
+			{
+				const auto back = streams[i].Interleave();
+				same            = memcmp(back.GetData(), interleaved[i].GetData(), back.SizeBytes()) == 0;
+			}
+			check(same, "both give the same boxes and transformed vertices");
+			return tBoxSoa + tTransformSoa < tBoxAos + tTransformAos;
+		};
+
+		oss << "streams\n";
+		{
+			const auto layout = DynamicVertexLayout{}.Append(Type::Position3D).Append(Type::Normal).Append(Type::Texture2D);
+			RawVertexBufferWithLayout vertices{layout};
+			vertices.EmplaceBack(DirectX::XMFLOAT3{1.0f, 2.0f, 3.0f}, DirectX::XMFLOAT3{0.0f, 1.0f, 0.0f}, DirectX::XMFLOAT2{0.5f, 0.25f});
+			vertices.EmplaceBack(DirectX::XMFLOAT3{4.0f, 5.0f, 6.0f}, DirectX::XMFLOAT3{1.0f, 0.0f, 0.0f}, DirectX::XMFLOAT2{0.75f, 1.0f});
+			const VertexStreams streams{vertices};
+			check(streams.GetStreamCount() == 3u && streams.GetStreamStride(1) == sizeof(DirectX::XMFLOAT3) &&
+			      streams.Stream<Type::Position3D>()[1].y == 5.0f && streams.Stream<Type::Texture2D>()[0].y == 0.25f,
+			      "every element ends up tightly packed in a stream of its own");
+			const auto back = streams.Interleave();
+			check(back.GetLayout().GetCode() == layout.GetCode() && memcmp(back.GetData(), vertices.GetData(), vertices.SizeBytes()) == 0,
+			      "and interleaves back to the same bytes");
+
+			const auto descs = streams.GetLayout().GetD3DLayout();
+			bool       slots = descs.size() == 3u;
+			for (size_t i = 0; slots && i < descs.size(); i++)
+			{
+				slots = descs[i].InputSlot == i && descs[i].AlignedByteOffset == 0u;
+			}
+			check(slots, "the input layout reads element i from slot i, at offset 0");
+			check(streams.GetLayout().GetCode() != layout.GetCode(), "and is told apart from the interleaved one");
+		}
+
+		// a typical normal mapped layout, 56 bytes a vertex of which a position-only pass needs 12
+		{
+			RawVertexBufferWithLayout vertices{
+				DynamicVertexLayout{}.Append(Type::Position3D).Append(Type::Normal).Append(Type::Tangent).Append(Type::Bitangent).Append(Type::Texture2D),
+				vertexCount
+			};
+			for (size_t i = 0; i < vertexCount; i++)
+			{
+				const auto f                         = (float)i;
+				vertices[i].Attr<Type::Position3D>() = {std::sin(f) * f, std::cos(f), f * 0.001f};
+			}
+			std::vector<RawVertexBufferWithLayout> buffers;
+			buffers.push_back(std::move(vertices));
+			check(compare("synthetic (P3 N Nt Nb T2)", std::move(buffers)), "streams make the position-only passes faster");
+		}
+
+		for (const auto& model : models)
+		{
+			// a model's arenas: every vertex of the model, grouped by layout
+			const auto                             data  = Model::Import(model.path, model.scale);
+			auto                                   arena = GeometryArena::Build(data, model.path, {});
+			std::vector<RawVertexBufferWithLayout> buffers;
+			for (auto& a : arena.arenas)
+			{
+				if (a.vertices.GetLayout().Has(Type::Position3D))
+				{
+					buffers.push_back(std::move(a.vertices));
+				}
+			}
+			compare(model.path, std::move(buffers));
+		}
+
+		return Report("Vertex Storage", oss, check);
+	}
+
+	Benchmarks::Result Benchmarks::VertexConversions(size_t vertexCount, int repetitions)
+	{
+		namespace dx = DirectX;
+		std::ostringstream oss;
+		oss << std::fixed << std::setprecision(2);
+		Checker check{oss};
+		using Type = DynamicVertexLayout::ElementType;
+
+		// the reference side: what one element holds as float4, and how many of the components it keeps
+		const auto family = [](Type t)
+		{
+			switch (t)
+			{
+				case Type::Texture2D:
+				case Type::Texture2DHalf:
+					return 1;
+				case Type::Normal:
+				case Type::NormalOct:
+					return 2;
+				case Type::Tangent:
+				case Type::TangentSigned:
+					return 3;
+				case Type::Bitangent:
+					return 4;
+				case Type::Float3Color:
+				case Type::Float4Color:
+				case Type::BGRAColor:
+					return 5;
+				default:
+					return 0;
+			}
+		};
+		const auto components = [](Type t)
+		{
+			switch (t)
+			{
+				case Type::Position2D:
+				case Type::Texture2D:
+				case Type::Texture2DHalf:
+					return 2;
+				case Type::TangentSigned:
+				case Type::Float4Color:
+				case Type::BGRAColor:
+					return 4;
+				default:
+					return 3;
+			}
+		};
+		const auto tolerance = [](Type t)
+		{
+			switch (t)
+			{
+				case Type::Position3DHalf:
+					return 4e-3f; // half precision at |v| < 16
+				case Type::Texture2DHalf:
+					return 1e-3f;
+				case Type::NormalOct:
+				case Type::TangentSigned:
+					return 1e-3f;
+				case Type::BGRAColor:
+					return 1.0f / 255.0f;
+				default:
+					return 1e-6f;
+			}
+		};
+		// components an element doesn't have read as what a conversion fills them with
+		const auto truncate = [&](Type t, dx::XMFLOAT4 v)
+		{
+			const dx::XMFLOAT4 fill = family(t) == 0 || family(t) == 3 || family(t) == 5 ? dx::XMFLOAT4{0.0f, 0.0f, 0.0f, 1.0f} : dx::XMFLOAT4{};
+			if (components(t) < 3)
+			{
+				v.z = fill.z;
+			}
+			if (components(t) < 4)
+			{
+				v.w = fill.w;
+			}
+			return v;
+		};
+		const auto write = [](Type t, char* p, const dx::XMFLOAT4& v)
+		{
+			switch (t)
+			{
+				case Type::Position2D:
+				case Type::Texture2D:
+					return (void)memcpy(p, &v, sizeof(dx::XMFLOAT2));
+				case Type::Float4Color:
+					return (void)memcpy(p, &v, sizeof(dx::XMFLOAT4));
+				case Type::Position3DHalf:
+				{
+					const auto e = VertexPacking::EncodePosition({v.x, v.y, v.z});
+					return (void)memcpy(p, &e, sizeof(e));
+				}
+				case Type::Texture2DHalf:
+				{
+					const auto e = VertexPacking::EncodeTexcoord({v.x, v.y});
+					return (void)memcpy(p, &e, sizeof(e));
+				}
+				case Type::NormalOct:
+				{
+					const auto e = VertexPacking::EncodeNormal({v.x, v.y, v.z});
+					return (void)memcpy(p, &e, sizeof(e));
+				}
+				case Type::TangentSigned:
+				{
+					const auto e = VertexPacking::EncodeTangent(v);
+					return (void)memcpy(p, &e, sizeof(e));
+				}
+				case Type::BGRAColor:
+				{
+					const auto     u = [](float f) { return (unsigned char)std::lround(f * 255.0f); };
+					const BGRAColor c{u(v.w), u(v.x), u(v.y), u(v.z)};
+					return (void)memcpy(p, &c, sizeof(c));
+				}
+				default:
+					return (void)memcpy(p, &v, sizeof(dx::XMFLOAT3));
+			}
+		};
+		const auto read = [&](Type t, const char* p)
+		{
+			dx::XMFLOAT4 v{};
+			switch (t)
+			{
+				case Type::Position3DHalf:
+				{
+					dx::PackedVector::XMHALF4 e;
+					memcpy(&e, p, sizeof(e));
+					const auto d = VertexPacking::DecodePosition(e);
+					v            = {d.x, d.y, d.z, 0.0f};
+					break;
+				}
+				case Type::Texture2DHalf:
+				{
+					dx::PackedVector::XMHALF2 e;
+					memcpy(&e, p, sizeof(e));
+					const auto d = VertexPacking::DecodeTexcoord(e);
+					v            = {d.x, d.y, 0.0f, 0.0f};
+					break;
+				}
+				case Type::NormalOct:
+				{
+					dx::PackedVector::XMSHORTN2 e;
+					memcpy(&e, p, sizeof(e));
+					const auto d = VertexPacking::DecodeNormal(e);
+					v            = {d.x, d.y, d.z, 0.0f};
+					break;
+				}
+				case Type::TangentSigned:
+				{
+					dx::PackedVector::XMSHORTN4 e;
+					memcpy(&e, p, sizeof(e));
+					v = VertexPacking::DecodeTangent(e);
+					break;
+				}
+				case Type::BGRAColor:
+				{
+					BGRAColor c;
+					memcpy(&c, p, sizeof(c));
+					v = {c.r / 255.0f, c.g / 255.0f, c.b / 255.0f, c.a / 255.0f};
+					break;
+				}
+				default:
+					memcpy(&v, p, (size_t)components(t) * sizeof(float));
+					break;
+			}
+			return v;
+		};
+		// a value every element of the family can hold: positions within half range, unit normals and tangents, colors in [0, 1]
+		const auto sample = [&](Type t, size_t i)
+		{
+			const auto f = (float)i;
+			switch (family(t))
+			{
+				case 0:
+					return dx::XMFLOAT4{10.0f * std::sin(f), 5.0f * std::cos(f), std::fmod(f * 0.1f, 12.0f), 1.0f};
+				case 5:
+					return dx::XMFLOAT4{std::fmod(f * 0.37f, 1.0f), std::fmod(f * 0.61f, 1.0f), std::fmod(f * 0.13f, 1.0f), std::fmod(f * 0.29f, 1.0f)};
+				case 1:
+					return dx::XMFLOAT4{std::sin(f) * 0.9f, std::cos(f) * 0.5f, 0.0f, 0.0f};
+				default:
+				{
+					dx::XMFLOAT4 v;
+					dx::XMStoreFloat4(&v, dx::XMVector3Normalize(dx::XMVectorSet(std::sin(f), std::cos(f * 1.3f), std::sin(f * 0.7f) + 0.1f, 0.0f)));
+					v.w = i % 2 ? -1.0f : 1.0f;
+					return v;
+				}
+			}
+		};
+
+		// every pair of element types, one element per layout
+		oss << "every pair of elements (" << (int)Type::Count << " x " << (int)Type::Count << ")\n";
+		{
+			constexpr size_t count     = 257u;
+			size_t           wrong     = 0u;
+			float            worst     = 0.0f;
+			std::string      firstBad;
+			for (int f = 0; f < (int)Type::Count; f++)
+			{
+				for (int t = 0; t < (int)Type::Count; t++)
+				{
+					const auto                from = (Type)f;
+					const auto                to   = (Type)t;
+					RawVertexBufferWithLayout source{DynamicVertexLayout{}.Append(from), count};
+					for (size_t i = 0; i < count; i++)
+					{
+						write(from, source.GetData() + i * source.GetLayout().Size(), truncate(from, sample(from, i)));
+					}
+					const auto converted = source.ConvertTo(DynamicVertexLayout{}.Append(to));
+					const auto stride    = converted.GetLayout().Size();
+					const auto fill      = VertexConversion::DefaultValue(to);
+					bool       good      = true;
+					for (size_t i = 0; i < count && good; i++)
+					{
+						const char* p = converted.GetData() + i * stride;
+						if (family(from) != family(to))
+						{
+							good = memcmp(p, fill.data(), stride) == 0;
+							continue;
+						}
+						// through the source's own format first, then the target's
+						const auto expected = truncate(to, truncate(from, read(from, source.GetData() + i * source.GetLayout().Size())));
+						const auto actual   = read(to, p);
+						const float e[4]    = {expected.x, expected.y, expected.z, expected.w};
+						const float a[4]    = {actual.x, actual.y, actual.z, actual.w};
+						for (int c = 0; c < components(to); c++)
+						{
+							const float error = std::abs(e[c] - a[c]);
+							worst             = std::max(worst, error / tolerance(to));
+							good              = good && error <= tolerance(to);
+						}
+					}
+					if (!good)
+					{
+						wrong++;
+						firstBad = firstBad.empty() ? std::string{DynamicVertexLayout::Element{from, 0u}.GetCode()} + " -> " +
+						                              DynamicVertexLayout::Element{to, 0u}.GetCode() : firstBad;
+					}
+				}
+			}
+			oss << "  worst error " << worst << " of the target's tolerance\n";
+			check(wrong == 0u, "same kind converts within tolerance, other kinds give the default" +
+			                   (wrong ? " (" + std::to_string(wrong) + " pairs wrong, first " + firstBad + ")" : std::string{}));
+		}
+
+		// full vertices with a tangent frame, some of the bitangents mirrored
+		const auto full = DynamicVertexLayout{}.Append(Type::Position3D).Append(Type::Normal).Append(Type::Tangent).Append(Type::Bitangent)
+		                                       .Append(Type::Texture2D);
+		RawVertexBufferWithLayout vertices{full};
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			const auto         p = sample(Type::Position3D, i);
+			const auto         n = sample(Type::Normal, i);
+			const auto         u = sample(Type::Texture2D, i);
+			const auto         nv = dx::XMLoadFloat4(&n);
+			const auto         tv = dx::XMVector3Normalize(dx::XMVector3Cross(nv, dx::XMVectorSet(0.3f, 1.0f, 0.2f, 0.0f)));
+			dx::XMFLOAT3       t, b;
+			dx::XMStoreFloat3(&t, tv);
+			dx::XMStoreFloat3(&b, dx::XMVector3Cross(nv, tv) * (i % 3 ? 1.0f : -1.0f));
+			vertices.EmplaceBack(dx::XMFLOAT3{p.x, p.y, p.z}, dx::XMFLOAT3{n.x, n.y, n.z}, t, b, dx::XMFLOAT2{u.x, u.y});
+		}
+
+		oss << "tangent frames\n";
+		{
+			const auto packed = vertices.ConvertTo(DynamicVertexLayout{}.Append(Type::NormalOct).Append(Type::TangentSigned));
+			const auto back   = packed.ConvertTo(DynamicVertexLayout{}.Append(Type::Normal).Append(Type::Bitangent));
+			float      worst  = 1.0f;
+			for (size_t i = 0; i < vertices.Size(); i++)
+			{
+				const auto& b = vertices[i].Attr<Type::Bitangent>();
+				const auto& d = back[i].Attr<Type::Bitangent>();
+				worst         = std::min(worst, dx::XMVectorGetX(dx::XMVector3Dot(dx::XMLoadFloat3(&b), dx::XMLoadFloat3(&d))));
+			}
+			oss << "  worst cos(original, derived bitangent) " << std::setprecision(6) << worst << std::setprecision(2) << "\n";
+			check(worst > 0.999f, "No Nts keeps the handedness, the bitangent derived from it points the original way");
+		}
+
+		// the per-vertex rebuilds ConvertTo replaces
+		const auto byHand = [&](const DynamicVertexLayout& target)
+		{
+			RawVertexBufferWithLayout out{target};
+			for (size_t i = 0; i < vertices.Size(); i++)
+			{
+				auto        v  = vertices[i];
+				const auto& p  = v.Attr<Type::Position3D>();
+				const auto& n  = v.Attr<Type::Normal>();
+				const auto& t  = v.Attr<Type::Tangent>();
+				const auto& b  = v.Attr<Type::Bitangent>();
+				const auto& tc = v.Attr<Type::Texture2D>();
+				if (target.Has(Type::Position3DHalf))
+				{
+					const float w = dx::XMVectorGetX(dx::XMVector3Dot(dx::XMVector3Cross(dx::XMLoadFloat3(&n), dx::XMLoadFloat3(&t)), dx::XMLoadFloat3(&b)));
+					out.EmplaceBack(VertexPacking::EncodePosition(p), VertexPacking::EncodeNormal(n), VertexPacking::EncodeTangent({t.x, t.y, t.z, w}),
+					                VertexPacking::EncodeTexcoord(tc));
+				}
+				else if (target.Has(Type::BGRAColor))
+				{
+					out.EmplaceBack(p, n, t, tc, BGRAColor{255, 255, 255, 255});
+				}
+				else
+				{
+					out.EmplaceBack(tc, n, p);
+				}
+			}
+			return out;
+		};
+		struct Case
+		{
+			const char*         name;
+			DynamicVertexLayout target;
+		};
+		const std::vector<Case> cases = {
+			{"reorder, drop Nt Nb", DynamicVertexLayout{}.Append(Type::Texture2D).Append(Type::Normal).Append(Type::Position3D)},
+			{"drop Nb, add C8    ",
+			 DynamicVertexLayout{}.Append(Type::Position3D).Append(Type::Normal).Append(Type::Tangent).Append(Type::Texture2D).Append(Type::BGRAColor)},
+			{"pack               ",
+			 DynamicVertexLayout{}.Append(Type::Position3DHalf).Append(Type::NormalOct).Append(Type::TangentSigned).Append(Type::Texture2DHalf)},
+		};
+
+		oss << "conversion of " << vertexCount << " " << full.GetCode() << " vertices (best of " << repetitions << ", "
+				<< std::thread::hardware_concurrency() << " hardware threads)\n";
+		for (const auto& c : cases)
+		{
+			RawVertexBufferWithLayout reference{c.target}, serial{c.target}, parallel{c.target};
+			const auto                tHand     = TimeBestOf(repetitions, [&] { reference = byHand(c.target); });
+			const auto                tSerial   = TimeBestOf(repetitions, [&] { serial = vertices.ConvertTo(c.target, 1u); });
+			const auto                tParallel = TimeBestOf(repetitions, [&] { parallel = vertices.ConvertTo(c.target); });
+			const auto                mb        = (float)(vertices.SizeBytes() + reference.SizeBytes()) / (1024.0f * 1024.0f);
+			oss << "  " << c.name << " -> " << c.target.GetCode() << ": per vertex " << tHand << " ms, ConvertTo " << tSerial << " ms (x"
+					<< tHand / tSerial << "), on all threads " << tParallel << " ms (x" << tHand / tParallel << ", " << mb / tParallel * 1000.0f
+					<< " MB/s)\n";
+			const auto same = [&](const RawVertexBufferWithLayout& a)
+			{
+				return a.SizeBytes() == reference.SizeBytes() && memcmp(a.GetData(), reference.GetData(), a.SizeBytes()) == 0;
+			};
+			check(same(serial) && same(parallel), std::string{"the same bytes as the per-vertex rebuild ("} + c.target.GetCode() + ")");
+			check(tParallel < tHand, std::string{"ConvertTo is faster than the per-vertex rebuild ("} + c.target.GetCode() + ")");
+		}
+
+		const auto plan = VertexConversion::Get(full, cases.back().target);
+		check(plan == VertexConversion::Get(full, cases.back().target), "the plan is made once per pair of layouts");
+		oss << "plan " << full.GetCode() << " -> " << cases.back().target.GetCode() << ":\n" << plan->Describe();
+
+		return Report("Vertex Conversion", oss, check);
+	}
+
+	Benchmarks::Result Benchmarks::VertexIngestion(const std::vector<ModelSpec>& models, int repetitions)
+	{
+		namespace dx = DirectX;
+		std::ostringstream oss;
+		oss << std::fixed << std::setprecision(2);
+		Checker check{oss};
+		using Type = DynamicVertexLayout::ElementType;
+
+		for (const auto& model : models)
+		{
+			const auto data = Model::Parse(model.path, model.scale);
+
+			// the parsed vertices back in the shape Assimp hands them to ParseMesh: one array per attribute, texcoords as 3D
+			struct Arrays
+			{
+				DynamicVertexLayout       layout;
+				std::vector<dx::XMFLOAT3> positions, normals, tangents, bitangents, texcoords;
+			};
+			std::vector<Arrays> meshes;
+			size_t              vertexCount = 0u;
+			for (const auto& mesh : data.meshes)
+			{
+				auto& arrays  = meshes.emplace_back();
+				arrays.layout = mesh.vertices.GetLayout();
+				for (size_t i = 0; i < mesh.vertices.Size(); i++)
+				{
+					const auto v = mesh.vertices[i];
+					const auto p = v.Attr<Type::Position3D>();
+					arrays.positions.push_back({p.x / model.scale, p.y / model.scale, p.z / model.scale});
+					arrays.normals.push_back(v.Attr<Type::Normal>());
+					if (arrays.layout.Has(Type::Tangent))
+					{
+						arrays.tangents.push_back(v.Attr<Type::Tangent>());
+						arrays.bitangents.push_back(v.Attr<Type::Bitangent>());
+					}
+					if (arrays.layout.Has(Type::Texture2D))
+					{
+						const auto& tc = v.Attr<Type::Texture2D>();
+						arrays.texcoords.push_back({tc.x, tc.y, 0.0f});
+					}
+				}
+				vertexCount += mesh.vertices.Size();
+			}
+
+			std::vector<RawVertexBufferWithLayout> before, after;
+			const auto                             tBefore = TimeBestOf(repetitions, [&]
+			{
+				// what ParseMesh did: grow the buffer and switch over the elements once per vertex
+				before.clear();
+				for (const auto& m : meshes)
+				{
+					auto&       vbuf  = before.emplace_back(m.layout);
+					const float scale = model.scale;
+					for (size_t i = 0; i < m.positions.size(); i++)
+					{
+						const dx::XMFLOAT3 p{m.positions[i].x * scale, m.positions[i].y * scale, m.positions[i].z * scale};
+						if (m.layout.Has(Type::Tangent))
+						{
+							vbuf.EmplaceBack(p, m.normals[i], m.tangents[i], m.bitangents[i], *reinterpret_cast<const dx::XMFLOAT2*>(&m.texcoords[i]));
+						}
+						else if (m.layout.Has(Type::Texture2D))
+						{
+							vbuf.EmplaceBack(p, m.normals[i], *reinterpret_cast<const dx::XMFLOAT2*>(&m.texcoords[i]));
+						}
+						else
+						{
+							vbuf.EmplaceBack(p, m.normals[i]);
+						}
+					}
+				}
+			});
+			const auto tAfter = TimeBestOf(repetitions, [&]
+			{
+				after.clear();
+				for (const auto& m : meshes)
+				{
+					auto&      vbuf  = after.emplace_back(m.layout);
+					const auto count = m.positions.size();
+					if (m.layout.Has(Type::Tangent))
+					{
+						vbuf.Append(count, {
+							{Type::Position3D, m.positions.data(), 0u, model.scale},
+							{Type::Normal, m.normals.data()},
+							{Type::Tangent, m.tangents.data()},
+							{Type::Bitangent, m.bitangents.data()},
+							{Type::Texture2D, m.texcoords.data(), sizeof(dx::XMFLOAT3)},
+						});
+					}
+					else if (m.layout.Has(Type::Texture2D))
+					{
+						vbuf.Append(count, {
+							{Type::Position3D, m.positions.data(), 0u, model.scale},
+							{Type::Normal, m.normals.data()},
+							{Type::Texture2D, m.texcoords.data(), sizeof(dx::XMFLOAT3)},
+						});
+					}
+					else
+					{
+						vbuf.Append(count, {{Type::Position3D, m.positions.data(), 0u, model.scale}, {Type::Normal, m.normals.data()}});
+					}
+				}
+			});
+
+			// every element here is made of floats; compared as floats, so 0 and -0 out of the scaling are the same
+			bool same = before.size() == after.size();
+			for (size_t m = 0; same && m < before.size(); m++)
+			{
+				same = before[m].SizeBytes() == after[m].SizeBytes();
+				for (size_t f = 0; same && f < before[m].SizeBytes() / sizeof(float); f++)
+				{
+					same = reinterpret_cast<const float*>(before[m].GetData())[f] == reinterpret_cast<const float*>(after[m].GetData())[f];
+				}
+			}
+
+			const auto rate = [&](float ms) { return (float)vertexCount / (ms * 1000.0f); };
+			oss << model.path << " (" << meshes.size() << " meshes, " << vertexCount << " vertices, best of " << repetitions << ")\n"
+					<< "  EmplaceBack per vertex: " << tBefore << " ms, " << rate(tBefore) << " Mvertices/s\n"
+					<< "  Append per mesh:        " << tAfter << " ms, " << rate(tAfter) << " Mvertices/s (x" << tBefore / tAfter << ")\n";
+			check(same, "the same vertices either way");
+			check(tAfter < tBefore, "Append is faster");
+		}
+
+		return Report("Vertex Ingestion", oss, check);
+	}
+}
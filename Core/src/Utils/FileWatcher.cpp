@@ -0,0 +1,145 @@
+#include "FileWatcher.h"
+#include <algorithm>
+#include <cwctype>
+#include <filesystem>
+
+namespace D3DEngine
+{
+	// one outstanding ReadDirectoryChangesW per watched directory tree
+	struct FileWatcher::Directory
+	{
+		std::filesystem::path root;
+		HANDLE                hDirectory = INVALID_HANDLE_VALUE;
+		OVERLAPPED            overlapped = {};
+		bool                  reading    = false;
+		// DWORD aligned, as ReadDirectoryChangesW wants it
+		alignas(DWORD) BYTE   buffer[32 * 1024];
+
+		static constexpr DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE;
+
+		bool Read() noexcept
+		{
+			reading = ReadDirectoryChangesW(hDirectory, buffer, sizeof(buffer), TRUE, filter, nullptr, &overlapped, nullptr) != FALSE;
+			return reading;
+		}
+
+		~Directory()
+		{
+			if (hDirectory == INVALID_HANDLE_VALUE)
+			{
+				return;
+			}
+			// the pending read writes into buffer, so it has to be over before the buffer goes away
+			if (reading && CancelIoEx(hDirectory, &overlapped))
+			{
+				DWORD bytes;
+				GetOverlappedResult(hDirectory, &overlapped, &bytes, TRUE);
+			}
+			CloseHandle(hDirectory);
+		}
+	};
+
+	FileWatcher::FileWatcher(Clock::duration settleTime) noexcept
+		: settleTime_(settleTime)
+	{
+	}
+
+	FileWatcher::~FileWatcher() = default;
+
+	bool FileWatcher::Watch(const std::string& directory) noexcept
+	{
+		try
+		{
+			// reported paths are built on the normalized root, the directory is opened by its own name
+			auto pDirectory        = std::make_unique<Directory>();
+			pDirectory->root       = Normalize(directory);
+			pDirectory->hDirectory = CreateFileW(std::filesystem::absolute(directory).wstring().c_str(),
+			                                     FILE_LIST_DIRECTORY,
+			                                     FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			                                     nullptr,
+			                                     OPEN_EXISTING,
+			                                     FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+			                                     nullptr);
+			if (pDirectory->hDirectory == INVALID_HANDLE_VALUE || !pDirectory->Read())
+			{
+				return false;
+			}
+			directories_.push_back(std::move(pDirectory));
+			return true;
+		}
+		catch (...)
+		{
+			return false;
+		}
+	}
+
+	void FileWatcher::Notify(const std::string& path, Clock::time_point time)
+	{
+		// a later write restarts the wait
+		pending_[Normalize(path)] = time;
+	}
+
+	std::vector<std::string> FileWatcher::Poll(Clock::time_point now)
+	{
+		for (auto& pDirectory : directories_)
+		{
+			auto& d = *pDirectory;
+			// a read that failed to restart is retried every poll, and only a later poll can collect what it reads
+			if (!d.reading)
+			{
+				d.Read();
+				continue;
+			}
+			DWORD bytes = 0u;
+			if (!GetOverlappedResult(d.hDirectory, &d.overlapped, &bytes, FALSE))
+			{
+				// still pending, the kernel may write into the buffer any time; any other error ended the read
+				if (GetLastError() != ERROR_IO_INCOMPLETE)
+				{
+					d.reading = false;
+				}
+				continue;
+			}
+			d.reading = false;
+
+			// bytes == 0: more changed than the buffer holds, those changes are lost
+			for (DWORD offset = 0; bytes != 0u;)
+			{
+				const auto& info = *reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(d.buffer + offset);
+				Notify((d.root / std::wstring{info.FileName, info.FileNameLength / sizeof(WCHAR)}).string(), now);
+				if (info.NextEntryOffset == 0u)
+				{
+					break;
+				}
+				offset += info.NextEntryOffset;
+			}
+			d.Read();
+		}
+
+		std::vector<std::string> settled;
+		for (auto i = pending_.begin(); i != pending_.end();)
+		{
+			if (now - i->second >= settleTime_)
+			{
+				settled.push_back(i->first);
+				i = pending_.erase(i);
+			}
+			else
+			{
+				++i;
+			}
+		}
+		// in a stable order, the map's depends on its history
+		std::ranges::sort(settled);
+		return settled;
+	}
+
+	std::string FileWatcher::Normalize(const std::string& path)
+	{
+		auto normal = std::filesystem::absolute(path).lexically_normal();
+		normal.make_preferred();
+		auto wide = normal.wstring();
+		std::ranges::transform(wide, wide.begin(), [](wchar_t c) { return (wchar_t)std::towlower(c); });
+		return std::filesystem::path{wide}.string();
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Utils/WinHelper.h"
+
+namespace D3DEngine
+{
+	/**
+	 * \brief Reports files that were written to below a set of watched directories (through ReadDirectoryChangesW).
+	 * Tools save a file in bursts of writes, so a file is only reported once it has been left alone for settleTime,
+	 * and every burst is reported once. Nothing blocks: the directories are polled, typically once per frame.
+	 */
+	class FileWatcher
+	{
+		public:
+			using Clock = std::chrono::steady_clock;
+
+			FileWatcher(Clock::duration settleTime = std::chrono::milliseconds(250)) noexcept;
+			FileWatcher(const FileWatcher&)            = delete;
+			FileWatcher& operator=(const FileWatcher&) = delete;
+			~FileWatcher();
+			// watch a directory and everything below it; returns false if it cannot be watched (e.g. it does not exist)
+			bool Watch(const std::string& directory) noexcept;
+			// record that a file changed at time (what the directory watches do for every change they see)
+			void Notify(const std::string& path, Clock::time_point time);
+			/**
+			 * \brief Collect what the directories saw since the last call and hand out the files that have settled.
+			 * \return normalized paths of the files that changed, each once
+			 */
+			std::vector<std::string> Poll(Clock::time_point now = Clock::now());
+			// the form paths are reported in: absolute, lexically normal, backslashes and lower case (file names are case-insensitive here)
+			static std::string Normalize(const std::string& path);
+		private:
+			struct Directory;
+
+			Clock::duration                                    settleTime_;
+			std::vector<std::unique_ptr<Directory>>            directories_;
+			std::unordered_map<std::string, Clock::time_point> pending_; // changed files and when they changed last
+	};
+}
@@ -0,0 +1,221 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace D3DEngine
+{
+	/**
+	 * \brief Open-addressing hash map with linear probing: keys and values sit in one array, so a lookup is one hash and a short
+	 * run of neighbouring slots instead of a bucket list walk. Each slot keeps the full hash of its key, and keys are only compared
+	 * when the hashes agree. Erase shifts the following slots back instead of leaving tombstones.
+	 * \tparam Hash callable giving a 64-bit hash of a Key (its low bits pick the slot, so it has to mix well)
+	 */
+	template <class Key, class Value, class Hash>
+	class FlatHashMap
+	{
+		private:
+			struct Slot
+			{
+				Key      key{};
+				Value    value{};
+				uint64_t hash     = 0u;
+				bool     occupied = false;
+			};
+
+			template <class SlotType, class ValueType>
+			class Iterator
+			{
+				public:
+					Iterator(SlotType* pSlot, SlotType* pEnd) noexcept
+						: pSlot(pSlot),
+						  pEnd(pEnd)
+					{
+						Skip();
+					}
+
+					std::pair<const Key&, ValueType&> operator*() const noexcept
+					{
+						return {pSlot->key, pSlot->value};
+					}
+
+					Iterator& operator++() noexcept
+					{
+						++pSlot;
+						Skip();
+						return *this;
+					}
+
+					bool operator==(const Iterator& other) const noexcept
+					{
+						return pSlot == other.pSlot;
+					}
+				private:
+					void Skip() noexcept
+					{
+						while (pSlot != pEnd && !pSlot->occupied)
+						{
+							++pSlot;
+						}
+					}
+
+				private:
+					SlotType* pSlot;
+					SlotType* pEnd;
+			};
+
+		public:
+			using iterator       = Iterator<Slot, Value>;
+			using const_iterator = Iterator<const Slot, const Value>;
+
+			// nullptr if key is not in the map
+			Value* Find(const Key& key) noexcept
+			{
+				const auto i = Locate(key, Hash{}(key));
+				return i != npos ? &slots[i].value : nullptr;
+			}
+
+			const Value* Find(const Key& key) const noexcept
+			{
+				return const_cast<FlatHashMap*>(this)->Find(key);
+			}
+
+			bool Contains(const Key& key) const noexcept
+			{
+				return Find(key) != nullptr;
+			}
+
+			// the value under key, default constructed first if key was not in the map (true in second)
+			std::pair<Value&, bool> TryEmplace(const Key& key)
+			{
+				const auto hash = Hash{}(key);
+				if (const auto i = Locate(key, hash); i != npos)
+				{
+					return {slots[i].value, false};
+				}
+				if ((count + 1u) * maxLoadDen > slots.size() * maxLoadNum)
+				{
+					Rehash(slots.empty() ? 16u : slots.size() * 2u);
+				}
+				auto& slot    = slots[Probe(hash)];
+				slot.key      = key;
+				slot.hash     = hash;
+				slot.occupied = true;
+				count++;
+				return {slot.value, true};
+			}
+
+			Value& operator[](const Key& key)
+			{
+				return TryEmplace(key).first;
+			}
+
+			bool Erase(const Key& key) noexcept
+			{
+				auto hole = Locate(key, Hash{}(key));
+				if (hole == npos)
+				{
+					return false;
+				}
+				// pull later slots of the run back into the hole unless that would move them before their home slot
+				const auto mask = slots.size() - 1u;
+				for (auto i = (hole + 1u) & mask; slots[i].occupied; i = (i + 1u) & mask)
+				{
+					const auto home = slots[i].hash & mask;
+					if (((i - home) & mask) >= ((i - hole) & mask))
+					{
+						slots[hole] = std::move(slots[i]);
+						hole        = i;
+					}
+				}
+				slots[hole] = Slot{};
+				count--;
+				return true;
+			}
+
+			void Clear() noexcept
+			{
+				slots.clear();
+				count = 0u;
+			}
+
+			size_t Size() const noexcept
+			{
+				return count;
+			}
+
+			iterator begin() noexcept
+			{
+				return {slots.data(), slots.data() + slots.size()};
+			}
+
+			iterator end() noexcept
+			{
+				return {slots.data() + slots.size(), slots.data() + slots.size()};
+			}
+
+			const_iterator begin() const noexcept
+			{
+				return {slots.data(), slots.data() + slots.size()};
+			}
+
+			const_iterator end() const noexcept
+			{
+				return {slots.data() + slots.size(), slots.data() + slots.size()};
+			}
+
+		private:
+			static constexpr size_t npos = ~size_t(0);
+			// grow beyond 7/8 full; linear probing stays short up to there as long as the hash mixes well
+			static constexpr size_t maxLoadNum = 7u;
+			static constexpr size_t maxLoadDen = 8u;
+
+			size_t Locate(const Key& key, uint64_t hash) const noexcept
+			{
+				if (slots.empty())
+				{
+					return npos;
+				}
+				const auto mask = slots.size() - 1u;
+				for (auto i = size_t(hash & mask); slots[i].occupied; i = (i + 1u) & mask)
+				{
+					if (slots[i].hash == hash && slots[i].key == key)
+					{
+						return i;
+					}
+				}
+				return npos;
+			}
+
+			// first free slot of the run starting at hash's home slot
+			size_t Probe(uint64_t hash) const noexcept
+			{
+				const auto mask = slots.size() - 1u;
+				auto       i    = size_t(hash & mask);
+				while (slots[i].occupied)
+				{
+					i = (i + 1u) & mask;
+				}
+				return i;
+			}
+
+			void Rehash(size_t capacity)
+			{
+				assert((capacity & (capacity - 1u)) == 0u && "Capacity must be a power of two");
+				auto old = std::exchange(slots, std::vector<Slot>(capacity));
+				for (auto& slot : old)
+				{
+					if (slot.occupied)
+					{
+						slots[Probe(slot.hash)] = std::move(slot);
+					}
+				}
+			}
+
+		private:
+			std::vector<Slot> slots;
+			size_t            count = 0u;
+	};
+}
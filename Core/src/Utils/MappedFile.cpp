@@ -0,0 +1,63 @@
+#include "MappedFile.h"
+
+namespace D3DEngine
+{
+	MappedFile::MappedFile(const std::string& path) noexcept
+	{
+		hFile_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (hFile_ == INVALID_HANDLE_VALUE)
+		{
+			return;
+		}
+
+		LARGE_INTEGER fileSize;
+		// mapping an empty file fails, so there is nothing to view in that case
+		if (!GetFileSizeEx(hFile_, &fileSize) || fileSize.QuadPart == 0)
+		{
+			return;
+		}
+
+		hMapping_ = CreateFileMappingA(hFile_, nullptr, PAGE_READONLY, 0u, 0u, nullptr);
+		if (hMapping_ == nullptr)
+		{
+			return;
+		}
+
+		pData_ = static_cast<const char*>(MapViewOfFile(hMapping_, FILE_MAP_READ, 0u, 0u, 0u));
+		if (pData_ != nullptr)
+		{
+			size_ = (size_t)fileSize.QuadPart;
+		}
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (pData_ != nullptr)
+		{
+			UnmapViewOfFile(pData_);
+		}
+		if (hMapping_ != nullptr)
+		{
+			CloseHandle(hMapping_);
+		}
+		if (hFile_ != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(hFile_);
+		}
+	}
+
+	bool MappedFile::IsOpen() const noexcept
+	{
+		return pData_ != nullptr;
+	}
+
+	const char* MappedFile::GetData() const noexcept
+	{
+		return pData_;
+	}
+
+	size_t MappedFile::GetSize() const noexcept
+	{
+		return size_;
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include "Utils/WinHelper.h"
+
+namespace D3DEngine
+{
+	/**
+	 * \brief Read-only view of an entire file mapped into our address space.
+	 * If the file cannot be opened the view is simply empty (IsOpen() returns false)
+	 */
+	class MappedFile
+	{
+		public:
+			MappedFile(const std::string& path) noexcept;
+			MappedFile(const MappedFile&)            = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+			~MappedFile();
+			bool        IsOpen() const noexcept;
+			const char* GetData() const noexcept;
+			size_t      GetSize() const noexcept;
+		private:
+			HANDLE      hFile_    = INVALID_HANDLE_VALUE;
+			HANDLE      hMapping_ = nullptr;
+			const char* pData_    = nullptr;
+			size_t      size_     = 0u;
+	};
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace D3DEngine
+{
+	// 0 means "as many workers as the machine has hardware threads"
+	inline size_t ResolveWorkerCount(size_t requested) noexcept
+	{
+		if (requested != 0u)
+		{
+			return requested;
+		}
+		const auto hardwareThreads = std::thread::hardware_concurrency();
+		return hardwareThreads != 0u ? hardwareThreads : 1u;
+	}
+
+	/**
+	 * \brief Calls func(i) for every i in [0, count) on up to nWorkers threads (the calling thread is one of them).
+	 * Indices are handed out one at a time, so a mix of big and small work items still balances.
+	 * The first exception thrown by func stops the remaining work and is rethrown on the calling thread.
+	 */
+	template <typename F>
+	void ParallelFor(size_t count, size_t nWorkers, F&& func)
+	{
+		nWorkers = std::min(ResolveWorkerCount(nWorkers), count);
+		if (nWorkers <= 1u)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				func(i);
+			}
+			return;
+		}
+
+		std::atomic<size_t> next   = 0u;
+		std::atomic<bool>   failed = false;
+		std::exception_ptr  pError;
+		std::mutex          errorMutex;
+
+		const auto worker = [&]
+		{
+			for (size_t i = next++; i < count && !failed; i = next++)
+			{
+				try
+				{
+					func(i);
+				}
+				catch (...)
+				{
+					std::lock_guard lock(errorMutex);
+					if (!pError)
+					{
+						pError = std::current_exception();
+					}
+					failed = true;
+				}
+			}
+		};
+
+		std::vector<std::thread> threads;
+		threads.reserve(nWorkers - 1u);
+		for (size_t i = 0; i < nWorkers - 1u; i++)
+		{
+			threads.emplace_back(worker);
+		}
+		worker();
+		for (auto& t : threads)
+		{
+			t.join();
+		}
+
+		if (pError)
+		{
+			std::rethrow_exception(pError);
+		}
+	}
+}
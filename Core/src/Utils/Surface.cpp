@@ -23,6 +23,7 @@ Surface& Surface::operator=(Surface&& donor) noexcept
 {
 	width_         = donor.width_;
 	height_        = donor.height_;
+	alphaLoaded    = donor.alphaLoaded;
 	pBuffer_       = std::move(donor.pBuffer_);
 	donor.pBuffer_ = nullptr;
 	return *this;
@@ -32,7 +33,8 @@ Surface::Surface(Surface&& source) noexcept
 	:
 	pBuffer_(std::move(source.pBuffer_)),
 	width_(source.width_),
-	height_(source.height_)
+	height_(source.height_),
+	alphaLoaded(source.alphaLoaded)
 {
 }
 
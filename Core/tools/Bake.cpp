@@ -0,0 +1,64 @@
+#include <iostream>
+#include <string>
+#include "Utils/AssetBaker.h"
+#include "Utils/GDIPlusManager.h"
+
+// Standalone asset baker: fills the model cache of every model below a directory, redoing only what changed since the last run.
+//
+//   Bake [directory] [--scale <s>] [--manifest <path>] [--workers <n>]
+//
+// directory defaults to Models, the manifest to bake.manifest inside it; run it from the directory the engine runs from
+// (Core/src), so the cache remembers the paths the engine loads the models by
+int main(int argc, char* argv[])
+{
+	// images are decoded through GDI+, to learn whether they have alpha
+	GDIPlusManager gdipm;
+
+	std::string                     directory = "Models";
+	std::string                     manifest;
+	D3DEngine::AssetBaker::Settings settings;
+	try
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const std::string arg = argv[i];
+			if (arg == "--scale" && i + 1 < argc)
+			{
+				settings.scale = std::stof(argv[++i]);
+			}
+			else if (arg == "--manifest" && i + 1 < argc)
+			{
+				manifest = argv[++i];
+			}
+			else if (arg == "--workers" && i + 1 < argc)
+			{
+				settings.nWorkers = std::stoul(argv[++i]);
+			}
+			else
+			{
+				directory = arg;
+			}
+		}
+		if (manifest.empty())
+		{
+			manifest = directory + "\\bake.manifest";
+		}
+
+		const auto report = D3DEngine::AssetBaker::Bake(D3DEngine::AssetBaker::FindModels(directory), manifest, settings);
+		std::cout << report.models << " models: " << report.baked << " baked, " << report.restamped << " restamped, "
+				<< report.upToDate << " up to date\n"
+				<< report.filesChecked << " files checked, " << report.filesHashed << " hashed (" << report.bytesHashed / (1024 * 1024)
+				<< " MB), " << report.imagesDecoded << " images decoded\n"
+				<< "done in " << report.seconds * 1000.0f << " ms\n";
+		for (const auto& failure : report.failures)
+		{
+			std::cerr << "failed: " << failure << "\n";
+		}
+		return report.failures.empty() ? 0 : 1;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << "\n";
+		return 1;
+	}
+}